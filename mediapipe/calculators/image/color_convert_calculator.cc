@@ -18,11 +18,13 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/graph_executor_service.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/util/parallel_for.h"
 
 namespace mediapipe {
 namespace {
@@ -147,6 +149,8 @@ absl::Status ColorConvertCalculator::GetContract(CalculatorContract* cc) {
     cc->Outputs().Tag(kBgraOutTag).Set<ImageFrame>();
   }
 
+  cc->UseService(kGraphExecutorService).Optional();
+
   return absl::OkStatus();
 }
 
@@ -156,16 +160,23 @@ absl::Status ColorConvertCalculator::ConvertAndOutput(
     CalculatorContext* cc) {
   const cv::Mat& input_mat =
       formats::MatView(&cc->Inputs().Tag(input_tag).Get<ImageFrame>());
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(output_format, input_mat.cols, input_mat.rows));
+  std::unique_ptr<ImageFrame> output_frame =
+      cc->AllocateImageFrame(output_format, input_mat.cols, input_mat.rows);
   cv::Mat output_mat = formats::MatView(output_frame.get());
-  cv::cvtColor(input_mat, output_mat, open_cv_convert_code);
-
-  // cv::cvtColor will leave the alpha channel set to 0, which is a bizarre
-  // design choice. Instead, let's set alpha to 255.
-  if (open_cv_convert_code == cv::COLOR_RGB2RGBA) {
-    SetColorChannel(3, 255, &output_mat);
-  }
+  // Converts the rows in place, each range while it is still in the cache.
+  ParallelForRows(
+      GetGraphExecutor(cc), input_mat.rows, input_mat.cols,
+      [&](int begin, int end) {
+        cv::Mat output_rows = output_mat.rowRange(begin, end);
+        cv::cvtColor(input_mat.rowRange(begin, end), output_rows,
+                     open_cv_convert_code);
+
+        // cv::cvtColor will leave the alpha channel set to 0, which is a
+        // bizarre design choice. Instead, let's set alpha to 255.
+        if (open_cv_convert_code == cv::COLOR_RGB2RGBA) {
+          SetColorChannel(3, 255, &output_rows);
+        }
+      });
   cc->Outputs()
       .Tag(output_tag)
       .Add(output_frame.release(), cc->InputTimestamp());
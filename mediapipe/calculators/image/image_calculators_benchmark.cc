@@ -0,0 +1,164 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmarks for the CPU paths of the image calculators splitting their rows
+// across the graph's executor, at 1080p and 4K.
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns a frame filled with a gradient, so that no calculator can take a
+// shortcut for uniform images.
+Packet MakeFrame(ImageFormat::Format format, int width, int height) {
+  auto frame = std::make_unique<ImageFrame>(format, width, height);
+  const int row_size = width * frame->NumberOfChannels() * frame->ByteDepth();
+  for (int y = 0; y < height; ++y) {
+    uint8_t* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < row_size; ++x) {
+      row[x] = static_cast<uint8_t>(x + y);
+    }
+  }
+  return Adopt(frame.release());
+}
+
+// Runs a graph with a single `node` reading `inputs`, sending the same input
+// packets at each iteration.
+void RunNode(benchmark::State& state, const std::string& node,
+             const std::vector<std::pair<std::string, Packet>>& inputs) {
+  std::string config_text;
+  for (const auto& [stream, packet] : inputs) {
+    absl::StrAppend(&config_text, "input_stream: \"", stream, "\"\n");
+  }
+  absl::StrAppend(&config_text, "output_stream: \"output\"\n", node);
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(
+      ParseTextProtoOrDie<CalculatorGraphConfig>(config_text)));
+  ABSL_CHECK_OK(graph.ObserveOutputStream(
+      "output", [](const Packet&) { return absl::OkStatus(); }));
+  ABSL_CHECK_OK(graph.StartRun({}));
+
+  int64_t timestamp = 0;
+  for (auto _ : state) {
+    for (const auto& [stream, packet] : inputs) {
+      ABSL_CHECK_OK(
+          graph.AddPacketToInputStream(stream, packet.At(Timestamp(timestamp))));
+    }
+    ABSL_CHECK_OK(graph.WaitUntilIdle());
+    ++timestamp;
+  }
+  ABSL_CHECK_OK(graph.CloseAllInputStreams());
+  ABSL_CHECK_OK(graph.WaitUntilDone());
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+
+void BM_ImageTransformationRotateAndFlip(benchmark::State& state) {
+  RunNode(state, R"pb(
+            node {
+              calculator: "ImageTransformationCalculator"
+              input_stream: "IMAGE:image"
+              output_stream: "IMAGE:output"
+              options {
+                [mediapipe.ImageTransformationCalculatorOptions.ext] {
+                  rotation_mode: ROTATION_90
+                  flip_horizontally: true
+                }
+              }
+            }
+          )pb",
+          {{"image", MakeFrame(ImageFormat::SRGB, state.range(0),
+                               state.range(1))}});
+}
+BENCHMARK(BM_ImageTransformationRotateAndFlip)
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->UseRealTime();
+
+void BM_ColorConvertRgbToRgba(benchmark::State& state) {
+  RunNode(state, R"pb(
+            node {
+              calculator: "ColorConvertCalculator"
+              input_stream: "RGB_IN:image"
+              output_stream: "RGBA_OUT:output"
+            }
+          )pb",
+          {{"image", MakeFrame(ImageFormat::SRGB, state.range(0),
+                               state.range(1))}});
+}
+BENCHMARK(BM_ColorConvertRgbToRgba)
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->UseRealTime();
+
+void BM_RecolorWithHalfResolutionMask(benchmark::State& state) {
+  RunNode(state, R"pb(
+            node {
+              calculator: "RecolorCalculator"
+              input_stream: "IMAGE:image"
+              input_stream: "MASK:mask"
+              output_stream: "IMAGE:output"
+              options {
+                [mediapipe.RecolorCalculatorOptions.ext] {
+                  color { r: 0 g: 0 b: 255 }
+                  mask_channel: RED
+                }
+              }
+            }
+          )pb",
+          {{"image",
+            MakeFrame(ImageFormat::SRGB, state.range(0), state.range(1))},
+           {"mask", MakeFrame(ImageFormat::GRAY8, state.range(0) / 2,
+                              state.range(1) / 2)}});
+}
+BENCHMARK(BM_RecolorWithHalfResolutionMask)
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->UseRealTime();
+
+void BM_SetAlphaFromMask(benchmark::State& state) {
+  RunNode(state, R"pb(
+            node {
+              calculator: "SetAlphaCalculator"
+              input_stream: "IMAGE:image"
+              input_stream: "ALPHA:alpha"
+              output_stream: "IMAGE:output"
+            }
+          )pb",
+          {{"image",
+            MakeFrame(ImageFormat::SRGB, state.range(0), state.range(1))},
+           {"alpha",
+            MakeFrame(ImageFormat::GRAY8, state.range(0), state.range(1))}});
+}
+BENCHMARK(BM_SetAlphaFromMask)
+    ->Args({1920, 1080})
+    ->Args({3840, 2160})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
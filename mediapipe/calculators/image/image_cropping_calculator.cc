@@ -267,16 +267,15 @@ absl::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
   const cv::Mat shift_dst = cv::Mat(3, 3, CV_64F, shift_dst_vec);
   const cv::Mat adjusted_projection_matrix =
       shift_dst * projection_matrix * shift_src;
-  cv::Mat cropped_image;
-  cv::warpPerspective(input_mat, cropped_image, adjusted_projection_matrix,
+  // Warp straight into the pooled output frame: `output_mat` already has the
+  // destination size and type, so OpenCV does not reallocate it.
+  std::unique_ptr<ImageFrame> output_frame =
+      cc->AllocateImageFrame(input_img.Format(), output_width, output_height);
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+  cv::warpPerspective(input_mat, output_mat, adjusted_projection_matrix,
                       cv::Size(output_width, output_height),
                       /* flags = */ 0,
                       /* borderMode = */ border_mode);
-
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
-      input_img.Format(), cropped_image.cols, cropped_image.rows));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
-  cropped_image.copyTo(output_mat);
   cc->Outputs().Tag(kImageTag).Add(output_frame.release(),
                                    cc->InputTimestamp());
   return absl::OkStatus();
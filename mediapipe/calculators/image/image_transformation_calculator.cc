@@ -12,6 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
 #include "absl/status/status.h"
 #include "mediapipe/calculators/image/image_transformation_calculator.pb.h"
 #include "mediapipe/calculators/image/rotation_mode.pb.h"
@@ -19,6 +24,7 @@
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/graph_executor_service.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
@@ -26,6 +32,7 @@
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/timestamp.h"
 #include "mediapipe/gpu/scale_mode.pb.h"
+#include "mediapipe/util/parallel_for.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_base.h"
@@ -103,6 +110,116 @@ mediapipe::ScaleMode_Mode ParseScaleMode(
       return default_mode;
   }
 }
+
+// Fills the `top`, `bottom`, `left` and `right` borders around the image in
+// the middle of `mat` like cv::copyMakeBorder, either with `color` or by
+// replicating the edge pixels of the image.
+void FillBorder(int top, int bottom, int left, int right, bool constant,
+                const cv::Scalar& color, cv::Mat& mat) {
+  if (top == 0 && bottom == 0 && left == 0 && right == 0) return;
+  const int image_rows = mat.rows - top - bottom;
+  const int image_cols = mat.cols - left - right;
+  if (constant) {
+    mat.rowRange(0, top).setTo(color);
+    mat.rowRange(top + image_rows, mat.rows).setTo(color);
+    mat(cv::Rect(0, top, left, image_rows)).setTo(color);
+    mat(cv::Rect(left + image_cols, top, right, image_rows)).setTo(color);
+    return;
+  }
+  const size_t pixel_size = mat.elemSize();
+  for (int y = top; y < top + image_rows; ++y) {
+    uint8_t* row = mat.ptr(y);
+    const uint8_t* first = row + left * pixel_size;
+    const uint8_t* last = row + (left + image_cols - 1) * pixel_size;
+    for (int x = 0; x < left; ++x) {
+      std::memcpy(row + x * pixel_size, first, pixel_size);
+    }
+    for (int x = left + image_cols; x < mat.cols; ++x) {
+      std::memcpy(row + x * pixel_size, last, pixel_size);
+    }
+  }
+  const size_t row_size = mat.cols * pixel_size;
+  for (int y = 0; y < top; ++y) {
+    std::memcpy(mat.ptr(y), mat.ptr(top), row_size);
+  }
+  for (int y = top + image_rows; y < mat.rows; ++y) {
+    std::memcpy(mat.ptr(y), mat.ptr(top + image_rows - 1), row_size);
+  }
+}
+
+// Copies `count` pixels of `pixel_size` bytes, `src_step` bytes apart in
+// `src`, to consecutive pixels of `dst`. `kPixelSize` is `pixel_size` for the
+// common formats, letting the compiler inline the copies, and 0 otherwise.
+template <int kPixelSize>
+void CopyPixels(const uint8_t* src, std::ptrdiff_t src_step, int count,
+                int pixel_size, uint8_t* dst) {
+  const int size = kPixelSize > 0 ? kPixelSize : pixel_size;
+  for (int x = 0; x < count; ++x, src += src_step, dst += size) {
+    std::memcpy(dst, src, size);
+  }
+}
+
+// Writes `input` rotated counterclockwise by `rotation` and then flipped into
+// `output` in a single pass, splitting the output rows across `executor`.
+// Equivalent to cv::rotate followed by cv::flip.
+void RotateAndFlip(const cv::Mat& input, mediapipe::RotationMode_Mode rotation,
+                   bool flip_horizontally, bool flip_vertically,
+                   const GraphExecutor* executor, cv::Mat& output) {
+  const int pixel_size = input.elemSize();
+  // Returns the byte offset in `input` of the pixel written to (x, y) in
+  // `output`.
+  auto source_offset = [&](int x, int y) -> std::ptrdiff_t {
+    if (flip_horizontally) x = output.cols - 1 - x;
+    if (flip_vertically) y = output.rows - 1 - y;
+    int src_x = x;
+    int src_y = y;
+    switch (rotation) {
+      case mediapipe::RotationMode::ROTATION_90:
+        src_x = input.cols - 1 - y;
+        src_y = x;
+        break;
+      case mediapipe::RotationMode::ROTATION_180:
+        src_x = input.cols - 1 - x;
+        src_y = input.rows - 1 - y;
+        break;
+      case mediapipe::RotationMode::ROTATION_270:
+        src_x = y;
+        src_y = input.rows - 1 - x;
+        break;
+      default:
+        break;
+    }
+    return static_cast<std::ptrdiff_t>(src_y) * input.step[0] +
+           static_cast<std::ptrdiff_t>(src_x) * pixel_size;
+  };
+  ParallelForRows(executor, output.rows, output.cols, [&](int begin, int end) {
+    for (int y = begin; y < end; ++y) {
+      const uint8_t* src = input.data + source_offset(0, y);
+      // The source offset is affine in x.
+      const std::ptrdiff_t src_step =
+          output.cols > 1 ? source_offset(1, y) - source_offset(0, y) : 0;
+      uint8_t* dst = output.ptr(y);
+      if (src_step == pixel_size) {
+        std::memcpy(dst, src, output.cols * pixel_size);
+        continue;
+      }
+      switch (pixel_size) {
+        case 1:
+          CopyPixels<1>(src, src_step, output.cols, pixel_size, dst);
+          break;
+        case 3:
+          CopyPixels<3>(src, src_step, output.cols, pixel_size, dst);
+          break;
+        case 4:
+          CopyPixels<4>(src, src_step, output.cols, pixel_size, dst);
+          break;
+        default:
+          CopyPixels<0>(src, src_step, output.cols, pixel_size, dst);
+          break;
+      }
+    }
+  });
+}
 }  // namespace
 
 // Scales, rotates, and flips images horizontally or vertically.
@@ -234,6 +351,7 @@ absl::Status ImageTransformationCalculator::GetContract(
     RET_CHECK(cc->Outputs().HasTag(kImageFrameTag));
     cc->Inputs().Tag(kImageFrameTag).Set<ImageFrame>();
     cc->Outputs().Tag(kImageFrameTag).Set<ImageFrame>();
+    cc->UseService(kGraphExecutorService).Optional();
   }
 #if !MEDIAPIPE_DISABLE_GPU
   if (cc->Inputs().HasTag(kGpuBufferTag)) {
@@ -466,9 +584,15 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
   ComputeOutputDimensions(input_width, input_height, &output_width,
                           &output_height);
 
+  const bool rotate = rotation_ != mediapipe::RotationMode::UNKNOWN &&
+                      rotation_ != mediapipe::RotationMode::ROTATION_0;
+  const bool flip = flip_horizontally_ || flip_vertically_;
+
+  std::unique_ptr<ImageFrame> output_frame;
   int opencv_interpolation_mode = cv::INTER_LINEAR;
   if (output_width_ > 0 && output_height_ > 0) {
-    cv::Mat scaled_mat;
+    int target_width = output_width_;
+    int target_height = output_height_;
     if (scale_mode_ == mediapipe::ScaleMode::STRETCH) {
       if (interpolation_mode_ == ImageTransformationCalculatorOptions::LINEAR) {
         // Use INTER_AREA for downscaling if interpolation mode is set to
@@ -482,14 +606,12 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
       } else {
         opencv_interpolation_mode = cv::INTER_NEAREST;
       }
-      cv::resize(input_mat, scaled_mat, cv::Size(output_width_, output_height_),
-                 0, 0, opencv_interpolation_mode);
     } else {
       const float scale =
           std::min(static_cast<float>(output_width_) / input_width,
                    static_cast<float>(output_height_) / input_height);
-      const int target_width = std::round(input_width * scale);
-      const int target_height = std::round(input_height * scale);
+      target_width = std::round(input_width * scale);
+      target_height = std::round(input_height * scale);
 
       if (interpolation_mode_ == ImageTransformationCalculatorOptions::LINEAR) {
         // Use INTER_AREA for downscaling if interpolation mode is set to
@@ -503,28 +625,31 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
         opencv_interpolation_mode = cv::INTER_NEAREST;
       }
 
-      if (scale_mode_ == mediapipe::ScaleMode::FIT) {
-        cv::Mat intermediate_mat;
-        cv::resize(input_mat, intermediate_mat,
-                   cv::Size(target_width, target_height), 0, 0,
-                   opencv_interpolation_mode);
-        const int top = (output_height_ - target_height) / 2;
-        const int bottom = output_height_ - target_height - top;
-        const int left = (output_width_ - target_width) / 2;
-        const int right = output_width_ - target_width - left;
-        cv::copyMakeBorder(intermediate_mat, scaled_mat, top, bottom, left,
-                           right,
-                           options_.constant_padding() ? cv::BORDER_CONSTANT
-                                                       : cv::BORDER_REPLICATE,
-                           padding_color_);
-      } else {
-        cv::resize(input_mat, scaled_mat, cv::Size(target_width, target_height),
-                   0, 0, opencv_interpolation_mode);
+      if (scale_mode_ != mediapipe::ScaleMode::FIT) {
         output_width = target_width;
         output_height = target_height;
       }
     }
+
+    // Without rotation and flipping the image is scaled straight into the
+    // output frame.
+    output_frame = cc->AllocateImageFrame(format, output_width, output_height);
+    cv::Mat scaled_mat =
+        rotate || flip ? cv::Mat(output_height, output_width, input_mat.type())
+                       : formats::MatView(output_frame.get());
+    const int top = (output_height - target_height) / 2;
+    const int bottom = output_height - target_height - top;
+    const int left = (output_width - target_width) / 2;
+    const int right = output_width - target_width - left;
+    cv::Mat target_mat =
+        scaled_mat(cv::Rect(left, top, target_width, target_height));
+    cv::resize(input_mat, target_mat, target_mat.size(), 0, 0,
+               opencv_interpolation_mode);
+    FillBorder(top, bottom, left, right, options_.constant_padding(),
+               padding_color_, scaled_mat);
     input_mat = scaled_mat;
+  } else {
+    output_frame = cc->AllocateImageFrame(format, output_width, output_height);
   }
 
   if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
@@ -536,44 +661,29 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
         .Add(padding.release(), cc->InputTimestamp());
   }
 
-  cv::Mat rotated_mat;
-  cv::Size rotated_size(output_width, output_height);
-  if (input_mat.size() == rotated_size) {
-    const int angle = RotationModeToDegrees(rotation_);
-    cv::Point2f src_center(input_mat.cols / 2.0, input_mat.rows / 2.0);
-    cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
-    cv::warpAffine(input_mat, rotated_mat, rotation_mat, rotated_size);
-  } else {
-    switch (rotation_) {
-      case mediapipe::RotationMode::UNKNOWN:
-      case mediapipe::RotationMode::ROTATION_0:
-        rotated_mat = input_mat;
-        break;
-      case mediapipe::RotationMode::ROTATION_90:
-        cv::rotate(input_mat, rotated_mat, cv::ROTATE_90_COUNTERCLOCKWISE);
-        break;
-      case mediapipe::RotationMode::ROTATION_180:
-        cv::rotate(input_mat, rotated_mat, cv::ROTATE_180);
-        break;
-      case mediapipe::RotationMode::ROTATION_270:
-        cv::rotate(input_mat, rotated_mat, cv::ROTATE_90_CLOCKWISE);
-        break;
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+  if (input_mat.data != output_mat.data) {
+    const cv::Size rotated_size(output_width, output_height);
+    if (rotate && input_mat.size() == rotated_size) {
+      // Rotates about the image center, cropping the corners of non-square
+      // images.
+      const int angle = RotationModeToDegrees(rotation_);
+      cv::Point2f src_center(input_mat.cols / 2.0, input_mat.rows / 2.0);
+      cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
+      if (flip) {
+        cv::Mat rotated_mat;
+        cv::warpAffine(input_mat, rotated_mat, rotation_mat, rotated_size);
+        const int flip_code =
+            flip_horizontally_ && flip_vertically_ ? -1 : flip_horizontally_;
+        cv::flip(rotated_mat, output_mat, flip_code);
+      } else {
+        cv::warpAffine(input_mat, output_mat, rotation_mat, rotated_size);
+      }
+    } else {
+      RotateAndFlip(input_mat, rotation_, flip_horizontally_, flip_vertically_,
+                    GetGraphExecutor(cc), output_mat);
     }
   }
-
-  cv::Mat flipped_mat;
-  if (flip_horizontally_ || flip_vertically_) {
-    const int flip_code =
-        flip_horizontally_ && flip_vertically_ ? -1 : flip_horizontally_;
-    cv::flip(rotated_mat, flipped_mat, flip_code);
-  } else {
-    flipped_mat = rotated_mat;
-  }
-
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(format, output_width, output_height));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
-  flipped_mat.copyTo(output_mat);
   cc->Outputs()
       .Tag(kImageFrameTag)
       .Add(output_frame.release(), cc->InputTimestamp());
@@ -91,7 +91,7 @@ absl::Status OpenCvEncodedImageToImageFrameCalculator::Process(
       return mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
              << "Unsupported number of channels: " << decoded_mat.channels();
   }
-  std::unique_ptr<ImageFrame> output_frame = absl::make_unique<ImageFrame>(
+  std::unique_ptr<ImageFrame> output_frame = cc->AllocateImageFrame(
       image_format, decoded_mat.size().width, decoded_mat.size().height,
       ImageFrame::kGlDefaultAlignmentBoundary);
   output_mat.copyTo(formats::MatView(output_frame.get()));
@@ -12,18 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <type_traits>
 #include <vector>
 
 #include "mediapipe/calculators/image/recolor_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/graph_executor_service.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/color.pb.h"
+#include "mediapipe/util/parallel_for.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -54,6 +59,78 @@ inline cv::Vec3b Blend(const cv::Vec3b& color1, const cv::Vec3b& color2,
   return color1 * (1.0 - mix_value) + color2 * mix_value;
 }
 
+// The mask pixels an image pixel is interpolated from along one axis, like
+// cv::resize with cv::INTER_LINEAR.
+struct MaskTap {
+  int index0;
+  int index1;
+  // Weight of index1.
+  float fraction;
+};
+
+std::vector<MaskTap> MakeMaskTaps(int image_size, int mask_size) {
+  std::vector<MaskTap> taps(image_size);
+  const float scale = static_cast<float>(mask_size) / image_size;
+  for (int i = 0; i < image_size; ++i) {
+    const float src = (i + 0.5f) * scale - 0.5f;
+    int index = std::floor(src);
+    float fraction = src - index;
+    if (index < 0) {
+      index = 0;
+      fraction = 0.0f;
+    } else if (index >= mask_size - 1) {
+      index = mask_size - 1;
+      fraction = 0.0f;
+    }
+    taps[i] = {index, std::min(index + 1, mask_size - 1), fraction};
+  }
+  return taps;
+}
+
+// Recolors rows [begin, end) of `input` into `output`, weighted by `channel`
+// of `mask` sampled at `row_taps` and `col_taps`. Reads the mask channel in
+// place, without splitting or resizing the mask first.
+template <typename MaskType>
+void RecolorRows(const cv::Mat& input, const cv::Mat& mask, int channel,
+                 const std::vector<MaskTap>& row_taps,
+                 const std::vector<MaskTap>& col_taps,
+                 const cv::Vec3b& recolor, int invert_mask,
+                 int adjust_with_luminance, int begin, int end,
+                 cv::Mat& output) {
+  const int mask_channels = mask.channels();
+  const bool same_size = mask.size() == input.size();
+  for (int i = begin; i < end; ++i) {
+    const cv::Vec3b* input_row = input.ptr<cv::Vec3b>(i);
+    cv::Vec3b* output_row = output.ptr<cv::Vec3b>(i);
+    const MaskTap& row_tap = row_taps[i];
+    const MaskType* mask_row0 = mask.ptr<MaskType>(row_tap.index0);
+    const MaskType* mask_row1 = mask.ptr<MaskType>(row_tap.index1);
+    for (int j = 0; j < output.cols; ++j) {
+      float value;
+      if (same_size) {
+        value = mask_row0[j * mask_channels + channel];
+      } else {
+        const MaskTap& col_tap = col_taps[j];
+        const int k0 = col_tap.index0 * mask_channels + channel;
+        const int k1 = col_tap.index1 * mask_channels + channel;
+        const float top =
+            mask_row0[k0] + (mask_row0[k1] - mask_row0[k0]) * col_tap.fraction;
+        const float bottom =
+            mask_row1[k0] + (mask_row1[k1] - mask_row1[k0]) * col_tap.fraction;
+        value = top + (bottom - top) * row_tap.fraction;
+        if constexpr (std::is_same_v<MaskType, uchar>) {
+          value = std::round(value);
+        }
+      }
+      // uint8 masks hold weights in [0, 255].
+      const float weight =
+          std::is_same_v<MaskType, uchar> ? value * (1.0 / 255.0) : value;
+      output_row[j] = Blend(input_row[j], recolor, weight, invert_mask,
+                            adjust_with_luminance);
+    }
+  }
+}
+
 }  // namespace
 
 namespace mediapipe {
@@ -162,6 +239,7 @@ absl::Status RecolorCalculator::GetContract(CalculatorContract* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   if (cc->Outputs().HasTag(kImageFrameTag)) {
     cc->Outputs().Tag(kImageFrameTag).Set<ImageFrame>();
+    cc->UseService(mediapipe::kGraphExecutorService).Optional();
   }
 
   // Confirm only one of the input streams is present.
@@ -241,20 +319,21 @@ absl::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
 
   RET_CHECK(input_mat.channels() == 3);  // RGB only.
 
-  if (mask_mat.channels() > 1) {
-    std::vector<cv::Mat> channels;
-    cv::split(mask_mat, channels);
-    if (mask_channel_ == mediapipe::RecolorCalculatorOptions_MaskChannel_ALPHA)
-      mask_mat = channels[3];
-    else
-      mask_mat = channels[0];
+  RET_CHECK(mask_mat.depth() == CV_32F || mask_mat.depth() == CV_8U);
+  int mask_channel = 0;
+  if (mask_mat.channels() > 1 &&
+      mask_channel_ == mediapipe::RecolorCalculatorOptions_MaskChannel_ALPHA) {
+    RET_CHECK_EQ(mask_mat.channels(), 4);
+    mask_channel = 3;
   }
-  cv::Mat mask_full;
-  cv::resize(mask_mat, mask_full, input_mat.size());
+  const std::vector<MaskTap> row_taps =
+      MakeMaskTaps(input_mat.rows, mask_mat.rows);
+  const std::vector<MaskTap> col_taps =
+      MakeMaskTaps(input_mat.cols, mask_mat.cols);
   const cv::Vec3b recolor = {color_[0], color_[1], color_[2]};
 
-  auto output_img = absl::make_unique<ImageFrame>(
-      input_img.Format(), input_mat.cols, input_mat.rows);
+  auto output_img = cc->AllocateImageFrame(input_img.Format(), input_mat.cols,
+                                           input_mat.rows);
   cv::Mat output_mat = mediapipe::formats::MatView(output_img.get());
 
   const int invert_mask = invert_mask_ ? 1 : 0;
@@ -271,25 +350,20 @@ absl::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
 
       fragColor = mix(color1, color2, mix_value);
   */
-  if (mask_img.Format() == ImageFormat::VEC32F1) {
-    for (int i = 0; i < output_mat.rows; ++i) {
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const float weight = mask_full.at<float>(i, j);
-        output_mat.at<cv::Vec3b>(i, j) =
-            Blend(input_mat.at<cv::Vec3b>(i, j), recolor, weight, invert_mask,
-                  adjust_with_luminance);
-      }
-    }
-  } else {
-    for (int i = 0; i < output_mat.rows; ++i) {
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const float weight = mask_full.at<uchar>(i, j) * (1.0 / 255.0);
-        output_mat.at<cv::Vec3b>(i, j) =
-            Blend(input_mat.at<cv::Vec3b>(i, j), recolor, weight, invert_mask,
-                  adjust_with_luminance);
-      }
-    }
-  }
+  ParallelForRows(GetGraphExecutor(cc), output_mat.rows, output_mat.cols,
+                  [&](int begin, int end) {
+                    if (mask_mat.depth() == CV_32F) {
+                      RecolorRows<float>(input_mat, mask_mat, mask_channel,
+                                         row_taps, col_taps, recolor,
+                                         invert_mask, adjust_with_luminance,
+                                         begin, end, output_mat);
+                    } else {
+                      RecolorRows<uchar>(input_mat, mask_mat, mask_channel,
+                                         row_taps, col_taps, recolor,
+                                         invert_mask, adjust_with_luminance,
+                                         begin, end, output_mat);
+                    }
+                  });
 
   cc->Outputs()
       .Tag(kImageFrameTag)
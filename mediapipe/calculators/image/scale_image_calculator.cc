@@ -638,8 +638,8 @@ absl::Status ScaleImageCalculator::Process(CalculatorContext* cc) {
   if (crop_width_ < input_width_ || crop_height_ < input_height_) {
     cc->GetCounter("Crops")->Increment();
     // TODO Do the crop as a range restrict inside OpenCV code below.
-    cropped_image.reset(new ImageFrame(image_frame->Format(), crop_width_,
-                                       crop_height_, alignment_boundary_));
+    cropped_image = cc->AllocateImageFrame(image_frame->Format(), crop_width_,
+                                           crop_height_, alignment_boundary_);
     if (image_frame->ByteDepth() == 1 || image_frame->ByteDepth() == 2) {
       CropImageFrame(*image_frame, col_start_, row_start_, crop_width_,
                      crop_height_, cropped_image.get());
@@ -677,8 +677,11 @@ absl::Status ScaleImageCalculator::Process(CalculatorContext* cc) {
             .AddPacket(cc->Inputs().Get(input_data_id_).Value());
       } else {
         // Make a copy with the correct alignment.
-        std::unique_ptr<ImageFrame> output_frame(new ImageFrame());
-        output_frame->CopyFrom(*image_frame, alignment_boundary_);
+        std::unique_ptr<ImageFrame> output_frame = cc->AllocateImageFrame(
+            image_frame->Format(), image_frame->Width(), image_frame->Height(),
+            alignment_boundary_);
+        cv::Mat output_mat = ::mediapipe::formats::MatView(output_frame.get());
+        ::mediapipe::formats::MatView(image_frame).copyTo(output_mat);
         if (options_.set_alignment_padding()) {
           output_frame->SetAlignmentPaddingAreas();
         }
@@ -700,22 +703,24 @@ absl::Status ScaleImageCalculator::Process(CalculatorContext* cc) {
   }
 
   // Rescale the image frame.
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame());
+  std::unique_ptr<ImageFrame> output_frame = cc->AllocateImageFrame(
+      image_frame->Format(), output_width_, output_height_,
+      alignment_boundary_);
+  cv::Mat input_mat = ::mediapipe::formats::MatView(image_frame);
+  cv::Mat output_mat = ::mediapipe::formats::MatView(output_frame.get());
   if (image_frame->Width() >= output_width_ &&
       image_frame->Height() >= output_height_) {
     // Downscale.
     cc->GetCounter("Downscales")->Increment();
-    cv::Mat input_mat = ::mediapipe::formats::MatView(image_frame);
-    output_frame->Reset(image_frame->Format(), output_width_, output_height_,
-                        alignment_boundary_);
-    cv::Mat output_mat = ::mediapipe::formats::MatView(output_frame.get());
     downscaler_->Resize(input_mat, &output_mat);
   } else {
     // Upscale. If upscaling is disallowed, output_width_ and output_height_ are
-    // the same as the input/crop width and height.
-    image_frame_util::RescaleImageFrame(
-        *image_frame, output_width_, output_height_, alignment_boundary_,
-        interpolation_algorithm_, output_frame.get());
+    // the same as the input/crop width and height. Rescales into the pooled
+    // frame, as image_frame_util::RescaleImageFrame would reallocate it.
+    RET_CHECK_EQ(image_frame->Format(), ImageFormat::SRGB);
+    image_frame_util::RescaleSrgbImage(input_mat, output_width_,
+                                       output_height_, interpolation_algorithm_,
+                                       &output_mat);
     if (interpolation_algorithm_ != -1) {
       cc->GetCounter("Upscales")->Increment();
     }
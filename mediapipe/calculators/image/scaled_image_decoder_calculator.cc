@@ -0,0 +1,408 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/image/scaled_image_decoder_calculator.pb.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+extern "C" {
+#include "jerror.h"   // from @libjpeg_turbo
+#include "jpeglib.h"  // from @libjpeg_turbo
+}
+
+namespace mediapipe {
+namespace api2 {
+
+namespace {
+
+// A rectangle in pixels, [x0, x1) x [y0, y1).
+struct PixelBox {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+bool IsJpeg(const std::string& contents) {
+  return contents.size() > 3 && static_cast<uint8_t>(contents[0]) == 0xFF &&
+         static_cast<uint8_t>(contents[1]) == 0xD8 &&
+         static_cast<uint8_t>(contents[2]) == 0xFF;
+}
+
+// Returns the axis-aligned bounding box of `rect` in a `width` x `height`
+// image, clipped to the image.
+PixelBox BoundingBox(const NormalizedRect& rect, int width, int height) {
+  const float half_width = rect.width() * width / 2;
+  const float half_height = rect.height() * height / 2;
+  const float cos_r = std::abs(std::cos(rect.rotation()));
+  const float sin_r = std::abs(std::sin(rect.rotation()));
+  const float extent_x = half_width * cos_r + half_height * sin_r;
+  const float extent_y = half_width * sin_r + half_height * cos_r;
+  const float center_x = rect.x_center() * width;
+  const float center_y = rect.y_center() * height;
+  return {std::clamp(static_cast<int>(std::floor(center_x - extent_x)), 0,
+                     width),
+          std::clamp(static_cast<int>(std::floor(center_y - extent_y)), 0,
+                     height),
+          std::clamp(static_cast<int>(std::ceil(center_x + extent_x)), 0,
+                     width),
+          std::clamp(static_cast<int>(std::ceil(center_y + extent_y)), 0,
+                     height)};
+}
+
+// Returns the largest of 8, 4, 2 and 1 by which a `roi_width` x `roi_height`
+// region can be downscaled and still hold `target_width` x `target_height`
+// pixels. Returns 1 (full scale) if either target is unset.
+int ScaleDenominator(float roi_width, float roi_height, int target_width,
+                     int target_height) {
+  if (target_width <= 0 || target_height <= 0) {
+    return 1;
+  }
+  for (int denominator : {8, 4, 2}) {
+    if (roi_width / denominator >= target_width &&
+        roi_height / denominator >= target_height) {
+      return denominator;
+    }
+  }
+  return 1;
+}
+
+// libjpeg reports errors by calling `error_exit`, which must not return.
+// JpegDecoder jumps back into the failing method and turns the error into a
+// status.
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  std::jmp_buf jump_buffer;
+  char message[JMSG_LENGTH_MAX];
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  auto* error = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+  (*cinfo->err->format_message)(cinfo, error->message);
+  std::longjmp(error->jump_buffer, 1);
+}
+
+// Drops libjpeg warnings, e.g. about truncated data, which are common in the
+// wild and still decode to a usable image.
+void JpegOutputMessage(j_common_ptr cinfo) {}
+
+// Decodes a JPEG with libjpeg-turbo, scaled in the DCT domain and cropped to a
+// region of interest.
+//
+// Each method sets the jump target for libjpeg errors, so none creates objects
+// with non-trivial destructors after its setjmp call.
+class JpegDecoder {
+ public:
+  JpegDecoder() {
+    cinfo_.err = jpeg_std_error(&error_.pub);
+    error_.pub.error_exit = JpegErrorExit;
+    error_.pub.output_message = JpegOutputMessage;
+  }
+  ~JpegDecoder() {
+    if (created_) jpeg_destroy_decompress(&cinfo_);
+  }
+  JpegDecoder(const JpegDecoder&) = delete;
+  JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+  // Reads the header of `contents`, which must outlive the decoder.
+  absl::Status ReadHeader(const std::string& contents) {
+    if (setjmp(error_.jump_buffer)) return Error();
+    jpeg_create_decompress(&cinfo_);
+    created_ = true;
+    // Older libjpeg versions take a non-const buffer but never write to it.
+    jpeg_mem_src(&cinfo_,
+                 const_cast<unsigned char*>(
+                     reinterpret_cast<const unsigned char*>(contents.data())),
+                 contents.size());
+    jpeg_read_header(&cinfo_, TRUE);
+    return absl::OkStatus();
+  }
+
+  int width() const { return cinfo_.image_width; }
+  int height() const { return cinfo_.image_height; }
+
+  // Color JPEGs are decoded to RGB. CMYK and YCCK JPEGs are not supported.
+  bool IsSupported() const {
+    return cinfo_.jpeg_color_space == JCS_GRAYSCALE ||
+           cinfo_.jpeg_color_space == JCS_YCbCr ||
+           cinfo_.jpeg_color_space == JCS_RGB;
+  }
+  bool IsGrayscale() const { return cinfo_.jpeg_color_space == JCS_GRAYSCALE; }
+
+  // Starts decoding at 1/`denominator` scale, and returns the scaled size.
+  absl::Status Start(int denominator, int* scaled_width, int* scaled_height) {
+    if (setjmp(error_.jump_buffer)) return Error();
+    cinfo_.scale_num = 1;
+    cinfo_.scale_denom = denominator;
+    cinfo_.out_color_space = IsGrayscale() ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_start_decompress(&cinfo_);
+    *scaled_width = cinfo_.output_width;
+    *scaled_height = cinfo_.output_height;
+    return absl::OkStatus();
+  }
+
+  // Restricts decoding to the columns [`*x`, `*x` + `*width`) of the scaled
+  // image. libjpeg widens them to the nearest iMCU boundaries, and updates `x`
+  // and `width` accordingly.
+  absl::Status CropColumns(int* x, int* width) {
+    if (setjmp(error_.jump_buffer)) return Error();
+    JDIMENSION crop_x = *x;
+    JDIMENSION crop_width = *width;
+    jpeg_crop_scanline(&cinfo_, &crop_x, &crop_width);
+    *x = crop_x;
+    *width = crop_width;
+    return absl::OkStatus();
+  }
+
+  // Decodes the scaled rows [`y`, `y` + `frame->Height()`) into `frame`.
+  absl::Status ReadRows(int y, ImageFrame* frame) {
+    if (setjmp(error_.jump_buffer)) return Error();
+    if (y > 0) jpeg_skip_scanlines(&cinfo_, y);
+    uint8_t* pixel_data = frame->MutablePixelData();
+    const int width_step = frame->WidthStep();
+    for (int row = 0; row < frame->Height();) {
+      JSAMPROW row_pointer = pixel_data + row * width_step;
+      const JDIMENSION rows_read =
+          jpeg_read_scanlines(&cinfo_, &row_pointer, 1);
+      if (rows_read == 0) {
+        return absl::DataLossError("JPEG data ended before the last row.");
+      }
+      row += rows_read;
+    }
+    // The remaining rows are not needed, so the decoder is aborted instead of
+    // finished.
+    jpeg_abort_decompress(&cinfo_);
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Status Error() const {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Failed to decode JPEG: ", error_.message));
+  }
+
+  jpeg_decompress_struct cinfo_;
+  JpegErrorManager error_;
+  bool created_ = false;
+};
+
+}  // namespace
+
+// Decodes encoded images into ImageFrames, at the lowest resolution that an
+// image model downstream needs.
+//
+// JPEGs are decoded with libjpeg-turbo, scaled down in the DCT domain by up to
+// 8x, cropped to the region of interest, and written straight into a frame
+// from the graph's frame pool (see CalculatorContext::AllocateImageFrame).
+// Downscaling stops once the region of interest would get smaller than
+// `target_width` x `target_height`, so that the model input keeps its quality
+// while most of the decoding work is skipped. Other formats, e.g. PNG, as well
+// as CMYK JPEGs, are decoded at full resolution with OpenCV.
+//
+// EXIF orientation is not applied. Grayscale images are decoded to GRAY8, color
+// images to SRGB, or to SRGBA if they have an alpha channel.
+//
+// Inputs:
+//   ENCODED_IMAGE: A std::string holding the encoded image.
+//   NORM_RECT (optional): A NormalizedRect of the region of interest in the
+//     encoded image, e.g. the one a downstream ImageToTensorCalculator
+//     samples. Defaults to the whole image.
+//
+// Outputs:
+//   IMAGE: The decoded ImageFrame.
+//   NORM_RECT (optional): The region of interest in the decoded image. Feed it
+//     to the calculator consuming IMAGE in place of the input NORM_RECT.
+//     Requires the input NORM_RECT.
+//
+// Example config:
+// node {
+//   calculator: "ScaledImageDecoderCalculator"
+//   input_stream: "ENCODED_IMAGE:encoded_image"
+//   input_stream: "NORM_RECT:roi"
+//   output_stream: "IMAGE:image"
+//   output_stream: "NORM_RECT:decoded_roi"
+//   options {
+//     [mediapipe.ScaledImageDecoderCalculatorOptions.ext] {
+//       target_width: 256
+//       target_height: 256
+//     }
+//   }
+// }
+class ScaledImageDecoderCalculator : public Node {
+ public:
+  static constexpr Input<std::string> kInEncodedImage{"ENCODED_IMAGE"};
+  static constexpr Input<NormalizedRect>::Optional kInNormRect{"NORM_RECT"};
+  static constexpr Output<ImageFrame> kOutImage{"IMAGE"};
+  static constexpr Output<NormalizedRect>::Optional kOutNormRect{"NORM_RECT"};
+
+  MEDIAPIPE_NODE_CONTRACT(kInEncodedImage, kInNormRect, kOutImage,
+                          kOutNormRect);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    RET_CHECK(!kOutNormRect(cc).IsConnected() || kInNormRect(cc).IsConnected())
+        << "The NORM_RECT output requires the NORM_RECT input.";
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    options_ = cc->Options<ScaledImageDecoderCalculatorOptions>();
+    RET_CHECK_GE(options_.target_width(), 0);
+    RET_CHECK_GE(options_.target_height(), 0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (kInEncodedImage(cc).IsEmpty()) return absl::OkStatus();
+    const std::string& contents = *kInEncodedImage(cc);
+    NormalizedRect roi;
+    if (kInNormRect(cc).IsConnected() && !kInNormRect(cc).IsEmpty()) {
+      roi = *kInNormRect(cc);
+    } else {
+      roi.set_x_center(0.5f);
+      roi.set_y_center(0.5f);
+      roi.set_width(1.0f);
+      roi.set_height(1.0f);
+    }
+
+    std::unique_ptr<ImageFrame> frame;
+    if (IsJpeg(contents)) {
+      JpegDecoder decoder;
+      MP_RETURN_IF_ERROR(decoder.ReadHeader(contents));
+      if (decoder.IsSupported()) {
+        MP_ASSIGN_OR_RETURN(frame, DecodeJpeg(cc, decoder, roi));
+      }
+    }
+    if (frame == nullptr) {
+      MP_ASSIGN_OR_RETURN(frame, DecodeWithOpenCv(cc, contents));
+    }
+
+    if (kOutNormRect(cc).IsConnected()) kOutNormRect(cc).Send(roi);
+    kOutImage(cc).Send(std::move(frame));
+    return absl::OkStatus();
+  }
+
+ private:
+  // Decodes the part of the JPEG covering `roi`, and maps `roi` to the
+  // decoded frame.
+  absl::StatusOr<std::unique_ptr<ImageFrame>> DecodeJpeg(
+      CalculatorContext* cc, JpegDecoder& decoder, NormalizedRect& roi) {
+    const int width = decoder.width();
+    const int height = decoder.height();
+    PixelBox box = BoundingBox(roi, width, height);
+    if (box.x0 >= box.x1 || box.y0 >= box.y1) {
+      // Nothing to crop to: the region lies outside of the image.
+      box = {0, 0, width, height};
+    }
+
+    const int denominator =
+        ScaleDenominator(roi.width() * width, roi.height() * height,
+                         options_.target_width(), options_.target_height());
+    int scaled_width, scaled_height;
+    MP_RETURN_IF_ERROR(
+        decoder.Start(denominator, &scaled_width, &scaled_height));
+    const float scale_x = static_cast<float>(scaled_width) / width;
+    const float scale_y = static_cast<float>(scaled_height) / height;
+
+    // The box in the scaled image, which libjpeg may widen further.
+    int x = std::floor(box.x0 * scale_x);
+    int crop_width =
+        std::min<int>(std::ceil(box.x1 * scale_x), scaled_width) - x;
+    const int y = std::floor(box.y0 * scale_y);
+    const int crop_height =
+        std::min<int>(std::ceil(box.y1 * scale_y), scaled_height) - y;
+    if (x > 0 || crop_width < scaled_width) {
+      MP_RETURN_IF_ERROR(decoder.CropColumns(&x, &crop_width));
+    }
+
+    std::unique_ptr<ImageFrame> frame = cc->AllocateImageFrame(
+        decoder.IsGrayscale() ? ImageFormat::GRAY8 : ImageFormat::SRGB,
+        crop_width, crop_height);
+    MP_RETURN_IF_ERROR(decoder.ReadRows(y, frame.get()));
+
+    roi.set_x_center((roi.x_center() * scaled_width - x) / crop_width);
+    roi.set_y_center((roi.y_center() * scaled_height - y) / crop_height);
+    roi.set_width(roi.width() * scaled_width / crop_width);
+    roi.set_height(roi.height() * scaled_height / crop_height);
+    return frame;
+  }
+
+  absl::StatusOr<std::unique_ptr<ImageFrame>> DecodeWithOpenCv(
+      CalculatorContext* cc, const std::string& contents) {
+    const cv::Mat encoded_mat(1, static_cast<int>(contents.size()), CV_8UC1,
+                              const_cast<char*>(contents.data()));
+    cv::Mat decoded_mat = cv::imdecode(encoded_mat, cv::IMREAD_UNCHANGED);
+    RET_CHECK(!decoded_mat.empty()) << "Failed to decode image.";
+    if (decoded_mat.depth() == CV_16U) {
+      decoded_mat.convertTo(decoded_mat, CV_8U, 1.0 / 257);
+    }
+    RET_CHECK_EQ(decoded_mat.depth(), CV_8U)
+        << "Unsupported image depth: " << decoded_mat.depth();
+
+    ImageFormat::Format format;
+    int conversion;
+    switch (decoded_mat.channels()) {
+      case 1:
+        format = ImageFormat::GRAY8;
+        conversion = -1;
+        break;
+      case 3:
+        format = ImageFormat::SRGB;
+        conversion = cv::COLOR_BGR2RGB;
+        break;
+      case 4:
+        format = ImageFormat::SRGBA;
+        conversion = cv::COLOR_BGRA2RGBA;
+        break;
+      default:
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Unsupported number of channels: ", decoded_mat.channels()));
+    }
+    std::unique_ptr<ImageFrame> frame =
+        cc->AllocateImageFrame(format, decoded_mat.cols, decoded_mat.rows);
+    cv::Mat output_mat = formats::MatView(frame.get());
+    if (conversion < 0) {
+      decoded_mat.copyTo(output_mat);
+    } else {
+      cv::cvtColor(decoded_mat, output_mat, conversion);
+    }
+    return frame;
+  }
+
+  ScaledImageDecoderCalculatorOptions options_;
+};
+MEDIAPIPE_REGISTER_NODE(ScaledImageDecoderCalculator);
+
+}  // namespace api2
+}  // namespace mediapipe
@@ -0,0 +1,217 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kDinoJpeg[] = "/mediapipe/calculators/image/testdata/dino.jpg";
+constexpr char kMaskPng[] =
+    "/mediapipe/calculators/image/testdata/binary_mask.png";
+
+std::string GetContents(const std::string& path) {
+  std::string contents;
+  MP_EXPECT_OK(file::GetContents(file::JoinPath("./", path), &contents));
+  return contents;
+}
+
+// Returns the maximum absolute pixel difference between `frame` and the BGR
+// `expected` image.
+double MaxDifference(const ImageFrame& frame, const cv::Mat& expected) {
+  cv::Mat rgb_expected;
+  cv::cvtColor(expected, rgb_expected, cv::COLOR_BGR2RGB);
+  cv::Mat diff;
+  cv::absdiff(formats::MatView(&frame), rgb_expected, diff);
+  double max_val;
+  cv::minMaxLoc(diff.reshape(1), nullptr, &max_val);
+  return max_val;
+}
+
+TEST(ScaledImageDecoderCalculatorTest, DecodesJpegAtScaleCoveringTarget) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "ScaledImageDecoderCalculator"
+    input_stream: "ENCODED_IMAGE:encoded_image"
+    output_stream: "IMAGE:image"
+    options {
+      [mediapipe.ScaledImageDecoderCalculatorOptions.ext] {
+        target_width: 256
+        target_height: 256
+      }
+    }
+  )pb"));
+  runner.MutableInputs()
+      ->Tag("ENCODED_IMAGE")
+      .packets.push_back(
+          MakePacket<std::string>(GetContents(kDinoJpeg)).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& packets = runner.Outputs().Tag("IMAGE").packets;
+  ASSERT_EQ(packets.size(), 1);
+  const ImageFrame& frame = packets[0].Get<ImageFrame>();
+  // The 2876x1699 image is decoded at 1/4 scale, as 1/8 scale would make it
+  // shorter than 256 rows.
+  EXPECT_EQ(frame.Format(), ImageFormat::SRGB);
+  EXPECT_EQ(frame.Width(), 719);
+  EXPECT_EQ(frame.Height(), 425);
+
+  const cv::Mat expected = cv::imread(file::JoinPath("./", kDinoJpeg),
+                                      cv::IMREAD_REDUCED_COLOR_4);
+  EXPECT_LE(MaxDifference(frame, expected), 10);
+}
+
+TEST(ScaledImageDecoderCalculatorTest, DecodesJpegAtFullScaleByDefault) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "ScaledImageDecoderCalculator"
+    input_stream: "ENCODED_IMAGE:encoded_image"
+    output_stream: "IMAGE:image"
+  )pb"));
+  runner.MutableInputs()
+      ->Tag("ENCODED_IMAGE")
+      .packets.push_back(
+          MakePacket<std::string>(GetContents(kDinoJpeg)).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& packets = runner.Outputs().Tag("IMAGE").packets;
+  ASSERT_EQ(packets.size(), 1);
+  const ImageFrame& frame = packets[0].Get<ImageFrame>();
+  EXPECT_EQ(frame.Width(), 2876);
+  EXPECT_EQ(frame.Height(), 1699);
+
+  const cv::Mat expected =
+      cv::imread(file::JoinPath("./", kDinoJpeg), cv::IMREAD_COLOR);
+  EXPECT_LE(MaxDifference(frame, expected), 10);
+}
+
+TEST(ScaledImageDecoderCalculatorTest, DecodesJpegRegionOfInterest) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "ScaledImageDecoderCalculator"
+    input_stream: "ENCODED_IMAGE:encoded_image"
+    input_stream: "NORM_RECT:roi"
+    output_stream: "IMAGE:image"
+    output_stream: "NORM_RECT:decoded_roi"
+    options {
+      [mediapipe.ScaledImageDecoderCalculatorOptions.ext] {
+        target_width: 64
+        target_height: 64
+      }
+    }
+  )pb"));
+  NormalizedRect roi;
+  roi.set_x_center(0.25f);
+  roi.set_y_center(0.5f);
+  roi.set_width(0.2f);
+  roi.set_height(0.4f);
+  runner.MutableInputs()
+      ->Tag("ENCODED_IMAGE")
+      .packets.push_back(
+          MakePacket<std::string>(GetContents(kDinoJpeg)).At(Timestamp(0)));
+  runner.MutableInputs()->Tag("NORM_RECT").packets.push_back(
+      MakePacket<NormalizedRect>(roi).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& images = runner.Outputs().Tag("IMAGE").packets;
+  const std::vector<Packet>& rects = runner.Outputs().Tag("NORM_RECT").packets;
+  ASSERT_EQ(images.size(), 1);
+  ASSERT_EQ(rects.size(), 1);
+  const ImageFrame& frame = images[0].Get<ImageFrame>();
+  const NormalizedRect& decoded_roi = rects[0].Get<NormalizedRect>();
+
+  // The 575x680 region is decoded at 1/8 scale out of a 360x213 image, and
+  // cropped around the region.
+  const cv::Mat expected_image = cv::imread(file::JoinPath("./", kDinoJpeg),
+                                            cv::IMREAD_REDUCED_COLOR_8);
+  ASSERT_EQ(expected_image.cols, 360);
+  ASSERT_EQ(expected_image.rows, 213);
+  EXPECT_LT(frame.Width(), 360);
+  EXPECT_LT(frame.Height(), 213);
+  EXPECT_GE(frame.Width(), std::floor(0.2f * 360));
+  EXPECT_GE(frame.Height(), std::floor(0.4f * 213));
+
+  // The decoded region covers the same pixels as the input one.
+  EXPECT_NEAR(decoded_roi.width() * frame.Width(), 0.2f * 360, 1e-3);
+  EXPECT_NEAR(decoded_roi.height() * frame.Height(), 0.4f * 213, 1e-3);
+  const int x =
+      std::lround(0.25f * 360 - decoded_roi.x_center() * frame.Width());
+  const int y =
+      std::lround(0.5f * 213 - decoded_roi.y_center() * frame.Height());
+  ASSERT_GE(x, 0);
+  ASSERT_GE(y, 0);
+  EXPECT_LE(MaxDifference(frame, expected_image(cv::Rect(
+                                     x, y, frame.Width(), frame.Height()))),
+            10);
+}
+
+TEST(ScaledImageDecoderCalculatorTest, DecodesPngAtFullScale) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "ScaledImageDecoderCalculator"
+    input_stream: "ENCODED_IMAGE:encoded_image"
+    output_stream: "IMAGE:image"
+    options {
+      [mediapipe.ScaledImageDecoderCalculatorOptions.ext] {
+        target_width: 16
+        target_height: 16
+      }
+    }
+  )pb"));
+  runner.MutableInputs()
+      ->Tag("ENCODED_IMAGE")
+      .packets.push_back(
+          MakePacket<std::string>(GetContents(kMaskPng)).At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& packets = runner.Outputs().Tag("IMAGE").packets;
+  ASSERT_EQ(packets.size(), 1);
+  const ImageFrame& frame = packets[0].Get<ImageFrame>();
+  const cv::Mat expected =
+      cv::imread(file::JoinPath("./", kMaskPng), cv::IMREAD_UNCHANGED);
+  EXPECT_EQ(frame.Width(), expected.cols);
+  EXPECT_EQ(frame.Height(), expected.rows);
+  EXPECT_EQ(frame.NumberOfChannels(), expected.channels());
+}
+
+TEST(ScaledImageDecoderCalculatorTest, FailsOnCorruptJpeg) {
+  std::string contents = GetContents(kDinoJpeg);
+  contents.resize(64);
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "ScaledImageDecoderCalculator"
+    input_stream: "ENCODED_IMAGE:encoded_image"
+    output_stream: "IMAGE:image"
+  )pb"));
+  runner.MutableInputs()
+      ->Tag("ENCODED_IMAGE")
+      .packets.push_back(MakePacket<std::string>(contents).At(Timestamp(0)));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
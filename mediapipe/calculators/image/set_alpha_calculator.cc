@@ -21,10 +21,12 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/graph_executor_service.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/vector.h"
+#include "mediapipe/util/parallel_for.h"
 
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -48,17 +50,15 @@ constexpr int kNumChannelsRGBA = 4;
 
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 
-// Combines an RGB cv::Mat and an alpha cv::Mat of the same dimensions into an
-// RGBA cv::Mat. Alpha may be read as uint8 or as another numeric type; in the
-// latter case, it is upscaled to values between 0 and 255 from an assumed input
-// range of [0, 1). Only the first channel of Alpha is used. Input & output Mat
-// must be uchar.
+// Copies rows [begin, end) of an alpha cv::Mat into the alpha channel of an
+// RGBA cv::Mat of the same dimensions. Alpha may be read as uint8 or as another
+// numeric type; in the latter case, it is upscaled to values between 0 and 255
+// from an assumed input range of [0, 1). Only the first channel of Alpha is
+// used. Output Mat must be uchar.
 template <typename AlphaType>
-absl::Status CopyAlphaImage(const cv::Mat& alpha_mat, cv::Mat& output_mat) {
-  RET_CHECK_EQ(output_mat.rows, alpha_mat.rows);
-  RET_CHECK_EQ(output_mat.cols, alpha_mat.cols);
-
-  for (int i = 0; i < output_mat.rows; ++i) {
+void CopyAlphaRows(const cv::Mat& alpha_mat, int begin, int end,
+                   cv::Mat& output_mat) {
+  for (int i = begin; i < end; ++i) {
     const AlphaType* alpha_ptr = alpha_mat.ptr<AlphaType>(i);
     uchar* out_ptr = output_mat.ptr<uchar>(i);
     for (int j = 0; j < output_mat.cols; ++j) {
@@ -72,7 +72,6 @@ absl::Status CopyAlphaImage(const cv::Mat& alpha_mat, cv::Mat& output_mat) {
       }
     }
   }
-  return absl::OkStatus();
 }
 }  // namespace
 
@@ -186,6 +185,7 @@ absl::Status SetAlphaCalculator::GetContract(CalculatorContract* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   if (cc->Outputs().HasTag(kOutputFrameTag)) {
     cc->Outputs().Tag(kOutputFrameTag).Set<ImageFrame>();
+    cc->UseService(kGraphExecutorService).Optional();
   }
 
   if (use_gpu) {
@@ -272,44 +272,55 @@ absl::Status SetAlphaCalculator::RenderCpu(CalculatorContext* cc) {
   }
 
   // Setup destination image
-  auto output_frame = absl::make_unique<ImageFrame>(
-      ImageFormat::SRGBA, input_mat.cols, input_mat.rows);
+  auto output_frame = cc->AllocateImageFrame(ImageFormat::SRGBA,
+                                             input_mat.cols, input_mat.rows);
   cv::Mat output_mat = formats::MatView(output_frame.get());
 
   const bool has_alpha_mask = cc->Inputs().HasTag(kInputAlphaTag) &&
                               !cc->Inputs().Tag(kInputAlphaTag).IsEmpty();
   const bool use_alpha_mask = alpha_value_ < 0 && has_alpha_mask;
 
-  // Copy rgb part of the image in CPU
-  if (input_mat.channels() == 3) {
-    cv::cvtColor(input_mat, output_mat, cv::COLOR_RGB2RGBA);
-  } else {
-    input_mat.copyTo(output_mat);
-  }
-
-  // Setup alpha image in CPU.
+  cv::Mat alpha_mat;
   if (use_alpha_mask) {
-    const auto& alpha_mask = cc->Inputs().Tag(kInputAlphaTag).Get<ImageFrame>();
-    cv::Mat alpha_mat = formats::MatView(&alpha_mask);
-
-    const bool alpha_is_float = CV_MAT_DEPTH(alpha_mat.type()) == CV_32F;
-    RET_CHECK(alpha_is_float || CV_MAT_DEPTH(alpha_mat.type()) == CV_8U);
-
-    if (alpha_is_float) {
-      MP_RETURN_IF_ERROR(CopyAlphaImage<float>(alpha_mat, output_mat));
-    } else {
-      MP_RETURN_IF_ERROR(CopyAlphaImage<uchar>(alpha_mat, output_mat));
-    }
-  } else {
-    const uchar alpha_value = std::min(std::max(0.0f, alpha_value_), 255.0f);
-    for (int i = 0; i < output_mat.rows; ++i) {
-      uchar* out_ptr = output_mat.ptr<uchar>(i);
-      for (int j = 0; j < output_mat.cols; ++j) {
-        const int out_idx = j * kNumChannelsRGBA;
-        out_ptr[out_idx + 3] = alpha_value;  // use value from options
-      }
-    }
+    alpha_mat =
+        formats::MatView(&cc->Inputs().Tag(kInputAlphaTag).Get<ImageFrame>());
+    RET_CHECK_EQ(output_mat.rows, alpha_mat.rows);
+    RET_CHECK_EQ(output_mat.cols, alpha_mat.cols);
+    RET_CHECK(CV_MAT_DEPTH(alpha_mat.type()) == CV_32F ||
+              CV_MAT_DEPTH(alpha_mat.type()) == CV_8U);
   }
+  const bool alpha_is_float = CV_MAT_DEPTH(alpha_mat.type()) == CV_32F;
+  const uchar alpha_value = std::min(std::max(0.0f, alpha_value_), 255.0f);
+
+  // Copies the rgb part and then sets the alpha channel of each range of rows
+  // while it is still in the cache.
+  ParallelForRows(
+      GetGraphExecutor(cc), output_mat.rows, output_mat.cols,
+      [&](int begin, int end) {
+        cv::Mat output_rows = output_mat.rowRange(begin, end);
+        if (input_mat.channels() == 3) {
+          cv::cvtColor(input_mat.rowRange(begin, end), output_rows,
+                       cv::COLOR_RGB2RGBA);
+        } else {
+          input_mat.rowRange(begin, end).copyTo(output_rows);
+        }
+
+        if (use_alpha_mask) {
+          if (alpha_is_float) {
+            CopyAlphaRows<float>(alpha_mat, begin, end, output_mat);
+          } else {
+            CopyAlphaRows<uchar>(alpha_mat, begin, end, output_mat);
+          }
+        } else {
+          for (int i = begin; i < end; ++i) {
+            uchar* out_ptr = output_mat.ptr<uchar>(i);
+            for (int j = 0; j < output_mat.cols; ++j) {
+              const int out_idx = j * kNumChannelsRGBA;
+              out_ptr[out_idx + 3] = alpha_value;  // use value from options
+            }
+          }
+        }
+      });
 
   cc->Outputs()
       .Tag(kOutputFrameTag)
@@ -68,9 +68,9 @@ class YUVToImageCalculator : public Node {
                           "YV12 and I420 (aka YV21) are supported.",
                           FourCCToString(format)));
     }
-    // Build a transient ImageFrameSharedPtr with default alignment to host
-    // conversion results.
-    ImageFrameSharedPtr image_frame = std::make_shared<ImageFrame>(
+    // Take an ImageFrame with default alignment from the graph's frame pool to
+    // host conversion results.
+    ImageFrameSharedPtr image_frame = cc->AllocateImageFrame(
         ImageFormat::SRGB, yuv_image.width(), yuv_image.height());
     // Perform actual conversion.
     switch (format) {
@@ -0,0 +1,109 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for CPU inference followed by segmentation postprocessing, as run
+// by the selfie segmentation graph, with and without output tensor aliasing.
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_replace.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kGraph[] = R"pb(
+  input_stream: "tensors"
+  input_stream: "output_size"
+  output_stream: "mask"
+  node {
+    calculator: "TfLiteCustomOpResolverCalculator"
+    output_side_packet: "OP_RESOLVER:op_resolver"
+  }
+  node {
+    calculator: "InferenceCalculatorCpu"
+    input_stream: "TENSORS:tensors"
+    output_stream: "TENSORS:output_tensors"
+    input_side_packet: "OP_RESOLVER:op_resolver"
+    options {
+      [mediapipe.InferenceCalculatorOptions.ext] {
+        model_path: "mediapipe/modules/selfie_segmentation/selfie_segmentation.tflite"
+        delegate { xnnpack {} }
+        alias_output_tensors: $alias
+      }
+    }
+  }
+  node {
+    calculator: "TensorsToSegmentationCalculator"
+    input_stream: "TENSORS:output_tensors"
+    input_stream: "OUTPUT_SIZE:output_size"
+    output_stream: "MASK:mask"
+    options {
+      [mediapipe.TensorsToSegmentationCalculatorOptions.ext] {
+        activation: NONE
+      }
+    }
+  }
+)pb";
+
+void BM_SelfieSegmentationCpu(benchmark::State& state) {
+  const bool alias_output_tensors = state.range(0) != 0;
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(
+      absl::StrReplaceAll(kGraph, {{"$alias", alias_output_tensors
+                                                  ? "true"
+                                                  : "false"}}));
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(config));
+  ABSL_CHECK_OK(graph.ObserveOutputStream(
+      "mask", [](const Packet&) { return absl::OkStatus(); }));
+  ABSL_CHECK_OK(graph.StartRun({}));
+
+  int64_t timestamp = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Tensor> tensors;
+    tensors.emplace_back(Tensor::ElementType::kFloat32,
+                         Tensor::Shape{1, 256, 256, 3});
+    {
+      auto view = tensors.back().GetCpuWriteView();
+      float* buffer = view.buffer<float>();
+      for (int i = 0; i < tensors.back().shape().num_elements(); ++i) {
+        buffer[i] = (i % 256) / 255.0f;
+      }
+    }
+    state.ResumeTiming();
+
+    ABSL_CHECK_OK(graph.AddPacketToInputStream(
+        "tensors", MakePacket<std::vector<Tensor>>(std::move(tensors))
+                       .At(Timestamp(timestamp))));
+    ABSL_CHECK_OK(graph.AddPacketToInputStream(
+        "output_size",
+        MakePacket<std::pair<int, int>>(640, 480).At(Timestamp(timestamp))));
+    ABSL_CHECK_OK(graph.WaitUntilIdle());
+    ++timestamp;
+  }
+  ABSL_CHECK_OK(graph.CloseAllInputStreams());
+  ABSL_CHECK_OK(graph.WaitUntilDone());
+}
+BENCHMARK(BM_SelfieSegmentationCpu)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -214,6 +214,22 @@ TEST(InferenceCalculatorTest, SmokeTestXnnpackMultithread) {
               /*use_vectors=*/true,
               /*apply_default_tflite_tensor_alignment=*/false);
 }
+TEST(InferenceCalculatorTest, SmokeTestTfliteInterpreterPool) {
+  DoSmokeTest(absl::StrReplaceAll(
+                  kGraphWithModelPathInOption,
+                  {{"$delegate", "delegate { tflite {} } num_interpreters: 2"},
+                   {"$mmap", "false"}}),
+              /*use_vectors=*/true,
+              /*apply_default_tflite_tensor_alignment=*/false);
+}
+TEST(InferenceCalculatorTest, SmokeTestXnnpackInterpreterPool) {
+  DoSmokeTest(absl::StrReplaceAll(
+                  kGraphWithModelPathInOption,
+                  {{"$delegate", "delegate { xnnpack {} } num_interpreters: 2"},
+                   {"$mmap", "false"}}),
+              /*use_vectors=*/true,
+              /*apply_default_tflite_tensor_alignment=*/false);
+}
 
 // Run our above CPU inference SmokeTests, but with graphs altered to use the
 // new `TENSOR` inputs and outputs.
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,9 +26,14 @@
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/calculators/tensor/xnnpack_on_disk_cache_helper.h"
+#include "mediapipe/calculators/tensor/xnnpack_weights_cache.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
@@ -50,6 +57,14 @@ class InferenceCalculatorXnnpackImpl
       CalculatorContext* cc);
   absl::StatusOr<TfLiteDelegatePtr> CreateDelegate(CalculatorContext* cc);
 
+  // Packed weights shared by the interpreters of the pool and, optionally,
+  // other calculators. Must outlive the delegates owned by
+  // `inference_runner_`.
+  std::shared_ptr<XnnpackWeightsCache> weights_cache_;
+  // Packed weights persisted on disk, preferred over `weights_cache_`.
+  std::unique_ptr<XnnpackOnDiskCacheHelper> on_disk_cache_helper_;
+  int num_interpreters_ = 1;
+  std::atomic<bool> ran_inference_{false};
   std::unique_ptr<InferenceRunner> inference_runner_;
 };
 
@@ -60,6 +75,7 @@ absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
   const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
+  cc->UseService(kMemoryManagerService).Optional();
 
   return absl::OkStatus();
 }
@@ -74,11 +90,23 @@ absl::StatusOr<std::vector<Tensor>> InferenceCalculatorXnnpackImpl::Process(
     CalculatorContext* cc, const TensorSpan& tensor_span) {
   MP_ASSIGN_OR_RETURN(std::vector<Tensor> output_tensors,
                       inference_runner_->Run(cc, tensor_span));
+  ran_inference_ = true;
+  // With a single interpreter, the delegate building the on-disk cache has
+  // finalized it now. With a pool, it is only known to be finalized on Close.
+  if (num_interpreters_ == 1 && on_disk_cache_helper_ &&
+      on_disk_cache_helper_->IsBuilding()) {
+    MP_RETURN_IF_ERROR(on_disk_cache_helper_->SaveCacheIfBuilt());
+  }
   return output_tensors;
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Close(CalculatorContext* cc) {
+  if (on_disk_cache_helper_ && ran_inference_) {
+    MP_RETURN_IF_ERROR(on_disk_cache_helper_->SaveCacheIfBuilt());
+  }
   inference_runner_ = nullptr;
+  weights_cache_ = nullptr;
+  on_disk_cache_helper_ = nullptr;
   return absl::OkStatus();
 }
 
@@ -89,12 +117,58 @@ InferenceCalculatorXnnpackImpl::CreateInferenceRunner(CalculatorContext* cc) {
   const auto& calculator_opts =
       cc->Options<mediapipe::InferenceCalculatorOptions>();
   const int interpreter_num_threads = calculator_opts.cpu_num_thread();
-  MP_ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, CreateDelegate(cc));
-  return CreateInferenceInterpreterDelegateRunner(
-      std::move(model_packet), std::move(op_resolver_packet),
-      std::move(delegate), interpreter_num_threads,
-      &calculator_opts.input_output_config(),
-      calculator_opts.delegate().xnnpack().enable_zero_copy_tensor_io());
+  num_interpreters_ = std::max(calculator_opts.num_interpreters(), 1);
+  RET_CHECK(num_interpreters_ == 1 || calculator_opts.input_output_config()
+                                         .feedback_tensor_links()
+                                         .empty())
+      << "num_interpreters > 1 is not supported with feedback tensors.";
+  auto xnnpack_options = calculator_opts.delegate().xnnpack();
+  if (!kDelegate(cc).IsEmpty()) {
+    xnnpack_options.MergeFrom(kDelegate(cc).Get().xnnpack());
+  }
+  const tflite::FlatBufferModel& model = *model_packet.Get();
+  if (xnnpack_options.has_weight_cache_dir()) {
+    on_disk_cache_helper_ = std::make_unique<XnnpackOnDiskCacheHelper>();
+    MP_RETURN_IF_ERROR(on_disk_cache_helper_->Init(
+        xnnpack_options.weight_cache_dir(),
+        xnnpack_options.weight_cache_max_size_bytes(), model));
+  }
+  if (xnnpack_options.share_packed_weights()) {
+    MP_ASSIGN_OR_RETURN(weights_cache_,
+                        XnnpackWeightsCache::GetOrCreateShared(model));
+  } else if (num_interpreters_ > 1) {
+    MP_ASSIGN_OR_RETURN(weights_cache_, XnnpackWeightsCache::Create());
+  }
+
+  MemoryManager* memory_manager = nullptr;
+  if (cc->Service(kMemoryManagerService).IsAvailable()) {
+    memory_manager = &cc->Service(kMemoryManagerService).GetObject();
+  }
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  runners.reserve(num_interpreters_);
+  auto create_runners = [&]() -> absl::Status {
+    for (int i = 0; i < num_interpreters_; ++i) {
+      MP_ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, CreateDelegate(cc));
+      MP_ASSIGN_OR_RETURN(
+          auto runner, CreateInferenceInterpreterDelegateRunner(
+                           model_packet, op_resolver_packet,
+                           std::move(delegate), interpreter_num_threads,
+                           &calculator_opts.input_output_config(),
+                           calculator_opts.delegate()
+                               .xnnpack()
+                               .enable_zero_copy_tensor_io(),
+                           calculator_opts.alias_output_tensors(),
+                           memory_manager));
+      runners.push_back(std::move(runner));
+    }
+    return absl::OkStatus();
+  };
+  if (weights_cache_) {
+    MP_RETURN_IF_ERROR(weights_cache_->Populate(create_runners));
+  } else {
+    MP_RETURN_IF_ERROR(create_runners());
+  }
+  return CreateInferenceRunnerPool(std::move(runners));
 }
 
 absl::StatusOr<TfLiteDelegatePtr>
@@ -119,6 +193,15 @@ InferenceCalculatorXnnpackImpl::CreateDelegate(CalculatorContext* cc) {
   auto xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
   xnnpack_opts.num_threads =
       GetXnnpackNumThreads(opts_has_delegate, opts_delegate);
+  const char* weight_cache_file_path =
+      on_disk_cache_helper_
+          ? on_disk_cache_helper_->GetFilePathForNewDelegate()
+          : nullptr;
+  if (weight_cache_file_path != nullptr) {
+    xnnpack_opts.weight_cache_file_path = weight_cache_file_path;
+  } else if (weights_cache_) {
+    xnnpack_opts.weights_cache = weights_cache_->Get();
+  }
   return TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
                            &TfLiteXNNPackDelegateDelete);
 }
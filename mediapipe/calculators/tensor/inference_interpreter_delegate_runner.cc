@@ -14,15 +14,20 @@
 
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_feedback_manager.h"
 #include "mediapipe/calculators/tensor/inference_io_mapper.h"
@@ -32,6 +37,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/c/c_api_types.h"
@@ -71,7 +77,7 @@ absl::Status VerifyModelTensorsForCustomAllocation(
 
 absl::StatusOr<std::vector<Tensor>> AllocateOutputTensors(
     const std::vector<int>& model_output_indexes,
-    const Interpreter& interpreter) {
+    const Interpreter& interpreter, MemoryManager* memory_manager) {
   std::vector<Tensor> output_tensors;
   output_tensors.reserve(model_output_indexes.size());
   for (int i = 0; i < model_output_indexes.size(); ++i) {
@@ -79,13 +85,94 @@ absl::StatusOr<std::vector<Tensor>> AllocateOutputTensors(
         interpreter.tensor(interpreter.outputs()[model_output_indexes[i]]);
     MP_ASSIGN_OR_RETURN(Tensor output_tensor,
                         CreateTensorWithTfLiteTensorSpecs(
-                            *reference_tensor, /*memory_manager=*/nullptr,
+                            *reference_tensor, memory_manager,
                             tflite::kDefaultTensorAlignment));
     output_tensors.push_back(std::move(output_tensor));
   }
   return output_tensors;
 }
 
+// Output buffers the interpreter writes into when output tensor aliasing is
+// enabled. Output tensors alias the buffers of one buffer set, which is only
+// handed out again once all tensors aliasing it have been released. This starts
+// out as a double buffer (one set written by the interpreter, one held
+// downstream) and grows while downstream calculators hold on to more outputs.
+//
+// Buffer sets are acquired by the thread running the interpreter only, while
+// aliasing tensors may be released on any thread.
+class OutputBufferRing
+    : public std::enable_shared_from_this<OutputBufferRing> {
+ public:
+  struct BufferSet {
+    BufferSet() = default;
+    BufferSet(const BufferSet&) = delete;
+    BufferSet& operator=(const BufferSet&) = delete;
+    ~BufferSet() {
+      for (void* buffer : buffers) aligned_free(buffer);
+    }
+
+    std::vector<void*> buffers;
+    std::vector<size_t> sizes;
+    // Number of output tensors aliasing this set.
+    int num_aliasing_tensors = 0;
+  };
+
+  // Returns a buffer set not aliased by any tensor with buffers of at least
+  // `sizes` bytes. Prefers `preferred_set`, the set the interpreter currently
+  // writes into, to avoid changing the interpreter's custom allocations.
+  absl::StatusOr<BufferSet*> AcquireBufferSet(const std::vector<size_t>& sizes,
+                                              const BufferSet* preferred_set) {
+    absl::MutexLock lock(&mutex_);
+    BufferSet* free_set = nullptr;
+    for (const auto& set : buffer_sets_) {
+      if (set->num_aliasing_tensors > 0) continue;
+      if (free_set == nullptr || set.get() == preferred_set) {
+        free_set = set.get();
+      }
+    }
+    if (free_set == nullptr) {
+      buffer_sets_.push_back(std::make_unique<BufferSet>());
+      free_set = buffer_sets_.back().get();
+    }
+    free_set->buffers.resize(sizes.size(), nullptr);
+    free_set->sizes.resize(sizes.size(), 0);
+    for (int i = 0; i < sizes.size(); ++i) {
+      if (free_set->sizes[i] >= sizes[i]) continue;
+      aligned_free(free_set->buffers[i]);
+      free_set->sizes[i] = 0;
+      // TfLite custom allocations require at least
+      // tflite::kDefaultTensorAlignment bytes.
+      const size_t size = std::max(
+          sizes[i], static_cast<size_t>(tflite::kDefaultTensorAlignment));
+      free_set->buffers[i] =
+          aligned_malloc(size, tflite::kDefaultTensorAlignment);
+      RET_CHECK(free_set->buffers[i]) << "Failed to allocate output buffer.";
+      free_set->sizes[i] = size;
+    }
+    return free_set;
+  }
+
+  // Returns a tensor aliasing `buffer_set->buffers[index]`, which keeps the
+  // buffer set from being handed out until it is released.
+  Tensor CreateAliasingTensor(BufferSet* buffer_set, int index,
+                              const Tensor& spec) {
+    {
+      absl::MutexLock lock(&mutex_);
+      ++buffer_set->num_aliasing_tensors;
+    }
+    return Tensor(spec.element_type(), spec.shape(),
+                  spec.quantization_parameters(), buffer_set->buffers[index],
+                  [ring = shared_from_this(), buffer_set] {
+                    absl::MutexLock lock(&ring->mutex_);
+                    --buffer_set->num_aliasing_tensors;
+                  });
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<BufferSet>> buffer_sets_ ABSL_GUARDED_BY(mutex_);
+};
+
 absl::Status CopyCpuInputIntoInterpreterTensor(const Tensor& input_tensor,
                                                tflite::Interpreter& interpreter,
                                                int input_tensor_index) {
@@ -116,13 +203,18 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
       std::unique_ptr<Interpreter> interpreter, TfLiteDelegatePtr delegate,
       InputOutputTensorNames&& input_output_tensor_names,
       std::unique_ptr<InferenceFeedbackManager> feedback_manager,
-      bool enable_zero_copy_tensor_io)
+      bool enable_zero_copy_tensor_io, bool enable_output_tensor_aliasing,
+      MemoryManager* memory_manager)
       : model_(std::move(model)),
+        output_buffer_ring_(enable_output_tensor_aliasing
+                                ? std::make_shared<OutputBufferRing>()
+                                : nullptr),
         interpreter_(std::move(interpreter)),
         delegate_(std::move(delegate)),
         input_output_tensor_names_(std::move(input_output_tensor_names)),
         feedback_manager_(std::move(feedback_manager)),
-        enable_zero_copy_tensor_io_(enable_zero_copy_tensor_io) {}
+        enable_zero_copy_tensor_io_(enable_zero_copy_tensor_io),
+        memory_manager_(memory_manager) {}
 
   absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
@@ -132,14 +224,56 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
   }
 
  private:
+  // Binds the interpreter outputs to a buffer set of `output_buffer_ring_`
+  // that fits their current byte sizes. Returns true if the custom allocations
+  // of the interpreter changed.
+  absl::StatusOr<bool> BindOutputBufferSet(
+      const std::vector<int>& output_indices);
+
   api2::Packet<TfLiteModelPtr> model_;
+  // Declared before the interpreter, which may hold custom allocations into
+  // its buffers.
+  std::shared_ptr<OutputBufferRing> output_buffer_ring_;
+  OutputBufferRing::BufferSet* bound_output_buffer_set_ = nullptr;
+  // The buffers and sizes of the interpreter's output custom allocations. A
+  // grown buffer may be reallocated at the same address.
+  std::vector<void*> bound_output_buffers_;
+  std::vector<size_t> bound_output_sizes_;
   std::unique_ptr<Interpreter> interpreter_;
   TfLiteDelegatePtr delegate_;
   InputOutputTensorNames input_output_tensor_names_;
   std::unique_ptr<InferenceFeedbackManager> feedback_manager_;
   bool enable_zero_copy_tensor_io_ = false;
+  // Not owned, may be null.
+  MemoryManager* memory_manager_ = nullptr;
 };
 
+absl::StatusOr<bool> InferenceInterpreterDelegateRunner::BindOutputBufferSet(
+    const std::vector<int>& output_indices) {
+  std::vector<size_t> sizes;
+  sizes.reserve(output_indices.size());
+  for (const int output_index : output_indices) {
+    sizes.push_back(
+        interpreter_->tensor(interpreter_->outputs()[output_index])->bytes);
+  }
+  MP_ASSIGN_OR_RETURN(bound_output_buffer_set_,
+                      output_buffer_ring_->AcquireBufferSet(
+                          sizes, /*preferred_set=*/bound_output_buffer_set_));
+  if (bound_output_buffer_set_->buffers == bound_output_buffers_ &&
+      bound_output_buffer_set_->sizes == bound_output_sizes_) {
+    return false;
+  }
+  bound_output_buffers_ = bound_output_buffer_set_->buffers;
+  bound_output_sizes_ = bound_output_buffer_set_->sizes;
+  for (int i = 0; i < output_indices.size(); ++i) {
+    MP_RETURN_IF_ERROR(SetTfLiteCustomAllocation(
+        *interpreter_, bound_output_buffers_[i],
+        bound_output_buffer_set_->sizes[i],
+        interpreter_->outputs()[output_indices[i]]));
+  }
+  return true;
+}
+
 absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     CalculatorContext* cc, const TensorSpan& tensor_span) {
   const int num_feedback_tensors =
@@ -195,7 +329,10 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
       }
     }
   }
-  // Reallocation is needed for memory sanity.
+  // Reallocation is needed for memory sanity. With output tensor aliasing,
+  // this fails if the resized outputs outgrow their bound buffers, but it still
+  // resizes the outputs, which are then bound to large enough buffers and
+  // reallocated below.
   if (resized_tensor_shapes) interpreter_->AllocateTensors();
 
   // TODO: Replace this using the util function in
@@ -222,13 +359,21 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
         input_tensor, *interpreter_, input_tensor_index));
   }
 
-  MP_ASSIGN_OR_RETURN(
-      std::vector<Tensor> output_tensors,
-      AllocateOutputTensors(output_indices_excluding_feedback_tensors,
-                            *interpreter_));
-
+  std::vector<Tensor> output_tensors;
   std::vector<Tensor::CpuWriteView> output_tensor_views;
-  if (enable_zero_copy_tensor_io_) {
+  bool output_buffers_changed = false;
+  if (output_buffer_ring_) {
+    // Output tensors are created after inference, aliasing the bound buffers.
+    MP_ASSIGN_OR_RETURN(
+        output_buffers_changed,
+        BindOutputBufferSet(output_indices_excluding_feedback_tensors));
+  } else {
+    MP_ASSIGN_OR_RETURN(
+        output_tensors,
+        AllocateOutputTensors(output_indices_excluding_feedback_tensors,
+                              *interpreter_, memory_manager_));
+  }
+  if (enable_zero_copy_tensor_io_ && !output_buffer_ring_) {
     for (int i = 0; i < output_indices_excluding_feedback_tensors.size(); ++i) {
       const int output_tensor_index =
           output_indices_excluding_feedback_tensors[i];
@@ -243,8 +388,12 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
 
   // Reallocation is needed for memory sanity.
   if (resized_tensor_shapes || !input_tensor_views.empty() ||
-      !output_tensor_views.empty()) {
-    interpreter_->AllocateTensors();
+      !output_tensor_views.empty() || output_buffers_changed) {
+    const TfLiteStatus status = interpreter_->AllocateTensors();
+    if (output_buffer_ring_) {
+      RET_CHECK_EQ(status, kTfLiteOk)
+          << "Failed to allocate tensors with the bound output buffers.";
+    }
   }
 
   // Run inference.
@@ -255,7 +404,23 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
   input_tensor_views.clear();
   output_tensor_views.clear();
 
-  if (enable_zero_copy_tensor_io_) {
+  if (output_buffer_ring_) {
+    output_tensors.reserve(output_indices_excluding_feedback_tensors.size());
+    for (int i = 0; i < output_indices_excluding_feedback_tensors.size(); ++i) {
+      const int output_tensor_index =
+          interpreter_->outputs()[output_indices_excluding_feedback_tensors[i]];
+      const TfLiteTensor* tflite_tensor =
+          interpreter_->tensor(output_tensor_index);
+      MP_ASSIGN_OR_RETURN(Tensor spec,
+                          CreateTensorWithTfLiteTensorSpecs(*tflite_tensor));
+      RET_CHECK_EQ(spec.bytes(), tflite_tensor->bytes)
+          << "Output tensor aliasing is not supported for the type of output "
+             "tensor at index "
+          << output_tensor_index;
+      output_tensors.push_back(output_buffer_ring_->CreateAliasingTensor(
+          bound_output_buffer_set_, i, spec));
+    }
+  } else if (enable_zero_copy_tensor_io_) {
     // TODO b/340643988 -To avoid dangling pointers to Tensors that are not
     // owned anymore by the InferenceRunner (once output tensors are passed to
     // downstream calculators), we should invalidate TfLiteCustomAllocation
@@ -282,7 +447,8 @@ CreateInferenceInterpreterDelegateRunner(
     int interpreter_num_threads,
     const mediapipe::InferenceCalculatorOptions::InputOutputConfig*
         input_output_config,
-    bool enable_zero_copy_tensor_io) {
+    bool enable_zero_copy_tensor_io, bool enable_output_tensor_aliasing,
+    MemoryManager* memory_manager) {
   InterpreterBuilder interpreter_builder(*model.Get(), op_resolver.Get());
   if (delegate) {
     interpreter_builder.AddDelegate(delegate.get());
@@ -307,13 +473,14 @@ CreateInferenceInterpreterDelegateRunner(
     MP_RETURN_IF_ERROR(inference_feedback_manager->Init(
         *input_output_config, input_output_tensor_names, interpreter.get()));
   }
-  if (enable_zero_copy_tensor_io) {
+  if (enable_zero_copy_tensor_io || enable_output_tensor_aliasing) {
     MP_RETURN_IF_ERROR(VerifyModelTensorsForCustomAllocation(*interpreter));
   }
   return std::make_unique<InferenceInterpreterDelegateRunner>(
       std::move(model), std::move(interpreter), std::move(delegate),
       std::move(input_output_tensor_names),
-      std::move(inference_feedback_manager), enable_zero_copy_tensor_io);
+      std::move(inference_feedback_manager), enable_zero_copy_tensor_io,
+      enable_output_tensor_aliasing, memory_manager);
 }
 
 }  // namespace mediapipe
@@ -22,6 +22,7 @@
 #include "mediapipe/calculators/tensor/inference_runner.h"
 #include "mediapipe/calculators/tensor/tflite_delegate_ptr.h"
 #include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/memory_manager.h"
 #include "mediapipe/util/tflite/tflite_model_loader.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/api/op_resolver.h"
@@ -43,6 +44,16 @@ namespace mediapipe {
 // output tensors (tensors with identical TfLite tensor indices) and no
 // passthrough input->output tensors (input and output tensors with identical
 // TfLite tensor indices).
+//
+// `enable_output_tensor_aliasing` makes output tensors alias buffers the
+// interpreter writes into instead of copying them. A buffer is written again
+// only once all output tensors aliasing it have been released, so output
+// tensors stay valid for as long as they are held. It has the same model
+// requirements as `enable_zero_copy_tensor_output` and takes precedence over it
+// for output tensors.
+//
+// If `memory_manager` is set, output tensors that are not aliased take their
+// CPU storage from its buffer pool instead of allocating it for every call.
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
@@ -50,7 +61,9 @@ CreateInferenceInterpreterDelegateRunner(
     int interpreter_num_threads,
     const mediapipe::InferenceCalculatorOptions::InputOutputConfig*
         input_output_config = nullptr,
-    bool enable_zero_copy_tensor_io = false);
+    bool enable_zero_copy_tensor_io = false,
+    bool enable_output_tensor_aliasing = false,
+    MemoryManager* memory_manager = nullptr);
 
 }  // namespace mediapipe
 
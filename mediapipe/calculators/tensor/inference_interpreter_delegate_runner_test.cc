@@ -1,5 +1,6 @@
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -8,6 +9,8 @@
 
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "flatbuffers/flatbuffers.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
 #include "mediapipe/calculators/tensor/tflite_delegate_ptr.h"
 #include "mediapipe/framework/api2/builder.h"
@@ -26,6 +29,8 @@
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
 #include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/util.h"
 
 namespace mediapipe {
@@ -54,6 +59,51 @@ constexpr char k3In3OutSwaps2And0ModelPath[] =
     "mediapipe/calculators/tensor/testdata/"
     "3in3out_model_swaps_input_2_and_0.tflite";
 
+// Returns a model squaring a float32 input of shape [1, N] for any N.
+api2::Packet<TfLiteModelPtr> CreateDynamicSquareModel() {
+  flatbuffers::FlatBufferBuilder builder;
+  const std::vector<int32_t> shape = {1, 1};
+  const std::vector<int32_t> shape_signature = {1, -1};
+  std::vector<flatbuffers::Offset<tflite::Buffer>> buffers = {
+      tflite::CreateBuffer(builder)};
+  std::vector<flatbuffers::Offset<tflite::Tensor>> tensors;
+  for (const char* name : {"input", "output"}) {
+    tensors.push_back(tflite::CreateTensorDirect(
+        builder, &shape, tflite::TensorType_FLOAT32, /*buffer=*/0, name,
+        /*quantization=*/0, /*is_variable=*/false, /*sparsity=*/0,
+        &shape_signature));
+  }
+  const std::vector<int32_t> op_inputs = {0, 0};
+  const std::vector<int32_t> op_outputs = {1};
+  std::vector<flatbuffers::Offset<tflite::Operator>> operators = {
+      tflite::CreateOperatorDirect(builder, /*opcode_index=*/0, &op_inputs,
+                                   &op_outputs,
+                                   tflite::BuiltinOptions_MulOptions,
+                                   tflite::CreateMulOptions(builder).Union())};
+  const std::vector<int32_t> subgraph_inputs = {0};
+  const std::vector<int32_t> subgraph_outputs = {1};
+  std::vector<flatbuffers::Offset<tflite::SubGraph>> subgraphs = {
+      tflite::CreateSubGraphDirect(builder, &tensors, &subgraph_inputs,
+                                   &subgraph_outputs, &operators)};
+  std::vector<flatbuffers::Offset<tflite::OperatorCode>> operator_codes = {
+      tflite::CreateOperatorCode(
+          builder, static_cast<int8_t>(tflite::BuiltinOperator_MUL),
+          /*custom_code=*/0, /*version=*/1, tflite::BuiltinOperator_MUL)};
+  builder.Finish(tflite::CreateModelDirect(builder, TFLITE_SCHEMA_VERSION,
+                                           &operator_codes, &subgraphs,
+                                           /*description=*/nullptr, &buffers));
+
+  // The model must not outlive its buffer.
+  auto buffer = std::make_shared<std::string>(
+      reinterpret_cast<const char*>(builder.GetBufferPointer()),
+      builder.GetSize());
+  auto model =
+      tflite::FlatBufferModel::BuildFromBuffer(buffer->data(), buffer->size());
+  return api2::MakePacket<TfLiteModelPtr>(
+      model.release(),
+      [buffer](tflite::FlatBufferModel* model) { delete model; });
+}
+
 class AnyInvocableCalculator : public Node {
  public:
   static constexpr Input<
@@ -348,6 +398,112 @@ TEST_F(InferenceCalculatorDelegateRunnnerTest,
                          "input->output passthrough tensors")));
 }
 
+TEST_F(InferenceCalculatorDelegateRunnnerTest,
+       AliasedOutputTensorsAreNotOverwrittenWhileHeld) {
+  std::unique_ptr<Resources> resources = CreateDefaultResources();
+  MP_ASSERT_OK_AND_ASSIGN(auto model, TfLiteModelLoader::LoadFromPath(
+                                          *resources, kFloat32ModelFile));
+  auto op_resolver = PacketAdopting<tflite::OpResolver>(
+      std::make_unique<
+          tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates>());
+  auto xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
+  auto delegate = TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
+                                    &TfLiteXNNPackDelegateDelete);
+  MP_EXPECT_OK(ExecuteAnyInvocableInGraphCalculator(
+      [&](CalculatorContext* cc) -> absl::Status {
+        MP_ASSIGN_OR_RETURN(
+            auto inference_runner,
+            CreateInferenceInterpreterDelegateRunner(
+                std::move(model), std::move(op_resolver), std::move(delegate),
+                /*interpreter_num_threads=*/-1,
+                /*input_output_config=*/nullptr,
+                /*enable_zero_copy_tensor_io=*/false,
+                /*enable_output_tensor_aliasing=*/true));
+        auto run = [&](float value) -> absl::StatusOr<std::vector<Tensor>> {
+          std::vector<Tensor> input_tensors;
+          input_tensors.emplace_back(Tensor::ElementType::kFloat32,
+                                     Tensor::Shape{1, 3});
+          {
+            auto view = input_tensors.back().GetCpuWriteView();
+            std::fill_n(view.buffer<float>(), 3, value);
+          }
+          return inference_runner->Run(cc, MakeTensorSpan(input_tensors));
+        };
+        auto output_value = [](const std::vector<Tensor>& tensors) {
+          return tensors[0].GetCpuReadView().buffer<float>()[0];
+        };
+
+        MP_ASSIGN_OR_RETURN(std::vector<Tensor> first, run(2.f));
+        const void* first_buffer =
+            first[0].GetCpuReadView().buffer<void>();
+        // `first` is held, so the second output must use another buffer.
+        MP_ASSIGN_OR_RETURN(std::vector<Tensor> second, run(3.f));
+        EXPECT_NE(second[0].GetCpuReadView().buffer<void>(), first_buffer);
+        EXPECT_EQ(output_value(first), 4.f);
+        EXPECT_EQ(output_value(second), 9.f);
+
+        // Once released, the buffer is reused.
+        first.clear();
+        MP_ASSIGN_OR_RETURN(std::vector<Tensor> third, run(4.f));
+        EXPECT_EQ(third[0].GetCpuReadView().buffer<void>(), first_buffer);
+        EXPECT_EQ(output_value(second), 9.f);
+        EXPECT_EQ(output_value(third), 16.f);
+        return absl::OkStatus();
+      }));
+}
+
+TEST_F(InferenceCalculatorDelegateRunnnerTest,
+       AliasedOutputTensorsFollowInputResizes) {
+  auto op_resolver = PacketAdopting<tflite::OpResolver>(
+      std::make_unique<
+          tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates>());
+  MP_EXPECT_OK(ExecuteAnyInvocableInGraphCalculator(
+      [&](CalculatorContext* cc) -> absl::Status {
+        MP_ASSIGN_OR_RETURN(
+            auto inference_runner,
+            CreateInferenceInterpreterDelegateRunner(
+                CreateDynamicSquareModel(), std::move(op_resolver),
+                /*delegate=*/nullptr,
+                /*interpreter_num_threads=*/-1,
+                /*input_output_config=*/nullptr,
+                /*enable_zero_copy_tensor_io=*/false,
+                /*enable_output_tensor_aliasing=*/true));
+        auto run = [&](int size,
+                       float value) -> absl::StatusOr<std::vector<Tensor>> {
+          std::vector<Tensor> input_tensors;
+          input_tensors.emplace_back(
+              Tensor::ElementType::kFloat32,
+              Tensor::Shape({1, size}, /*is_dynamic=*/true));
+          {
+            auto view = input_tensors.back().GetCpuWriteView();
+            std::fill_n(view.buffer<float>(), size, value);
+          }
+          return inference_runner->Run(cc, MakeTensorSpan(input_tensors));
+        };
+        auto expect_output = [](const std::vector<Tensor>& tensors, int size,
+                                float value) {
+          ASSERT_EQ(tensors.size(), 1);
+          EXPECT_EQ(tensors[0].shape().dims, std::vector<int>({1, size}));
+          auto view = tensors[0].GetCpuReadView();
+          EXPECT_TRUE(std::all_of(view.buffer<float>(),
+                                  view.buffer<float>() + size,
+                                  [value](float x) { return x == value; }));
+        };
+
+        MP_ASSIGN_OR_RETURN(std::vector<Tensor> first, run(3, 2.f));
+        expect_output(first, 3, 4.f);
+        first.clear();
+        // The outputs outgrow the buffers they were bound to.
+        MP_ASSIGN_OR_RETURN(std::vector<Tensor> second, run(100, 3.f));
+        expect_output(second, 100, 9.f);
+        // And shrink again, into another buffer set while `second` is held.
+        MP_ASSIGN_OR_RETURN(std::vector<Tensor> third, run(3, 4.f));
+        expect_output(second, 100, 9.f);
+        expect_output(third, 3, 16.f);
+        return absl::OkStatus();
+      }));
+}
+
 }  // namespace
 }  // namespace api2
 }  // namespace mediapipe
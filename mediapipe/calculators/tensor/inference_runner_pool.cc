@@ -0,0 +1,99 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/inference_io_mapper.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+namespace {
+
+class InferenceRunnerPool : public InferenceRunner {
+ public:
+  explicit InferenceRunnerPool(
+      std::vector<std::unique_ptr<InferenceRunner>> runners)
+      : runners_(std::move(runners)) {
+    // Runners are taken from the back, so the first runner serves the first
+    // invocation.
+    idle_runners_.reserve(runners_.size());
+    for (auto it = runners_.rbegin(); it != runners_.rend(); ++it) {
+      idle_runners_.push_back(it->get());
+    }
+  }
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    InferenceRunner* runner = AcquireRunner();
+    absl::StatusOr<std::vector<Tensor>> output_tensors =
+        runner->Run(cc, tensor_span);
+    ReleaseRunner(runner);
+    return output_tensors;
+  }
+
+  const InputOutputTensorNames& GetInputOutputTensorNames() const override {
+    return runners_.front()->GetInputOutputTensorNames();
+  }
+
+ private:
+  InferenceRunner* AcquireRunner() {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](std::vector<InferenceRunner*>* idle_runners) {
+          return !idle_runners->empty();
+        },
+        &idle_runners_));
+    InferenceRunner* runner = idle_runners_.back();
+    idle_runners_.pop_back();
+    return runner;
+  }
+
+  void ReleaseRunner(InferenceRunner* runner) {
+    absl::MutexLock lock(&mutex_);
+    idle_runners_.push_back(runner);
+  }
+
+  const std::vector<std::unique_ptr<InferenceRunner>> runners_;
+  absl::Mutex mutex_;
+  std::vector<InferenceRunner*> idle_runners_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunnerPool(
+    std::vector<std::unique_ptr<InferenceRunner>> runners) {
+  RET_CHECK(!runners.empty()) << "Inference runner pool cannot be empty.";
+  if (runners.size() == 1) {
+    return std::move(runners.front());
+  }
+  for (const auto& runner : runners) {
+    RET_CHECK(runner != nullptr);
+  }
+  return std::make_unique<InferenceRunnerPool>(std::move(runners));
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,40 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_POOL_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_POOL_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+
+namespace mediapipe {
+
+// Creates an inference runner which dispatches each `Run` call to one of the
+// provided `runners` that is not currently busy, blocking until one becomes
+// available. The first invocation is always served by `runners[0]`. This
+// allows an inference calculator configured with `max_in_flight > 1` to invoke
+// several interpreters concurrently.
+//
+// All `runners` must be created for the same model (in particular, they must
+// report identical input/output tensor names) and must not carry per-runner
+// state across invocations (e.g. feedback tensors).
+absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunnerPool(
+    std::vector<std::unique_ptr<InferenceRunner>> runners);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_POOL_H_
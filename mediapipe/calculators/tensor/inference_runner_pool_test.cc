@@ -0,0 +1,128 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/calculators/tensor/inference_io_mapper.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+namespace {
+
+// Counts concurrent invocations shared by all fake runners of a pool.
+struct InvocationStats {
+  std::atomic<int> active{0};
+  std::atomic<int> max_active{0};
+  std::atomic<int> total{0};
+};
+
+class FakeInferenceRunner : public InferenceRunner {
+ public:
+  explicit FakeInferenceRunner(InvocationStats* stats) : stats_(stats) {}
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    EXPECT_FALSE(busy_.exchange(true)) << "Runner invoked concurrently.";
+    const int active = ++stats_->active;
+    int max_active = stats_->max_active.load();
+    while (active > max_active &&
+           !stats_->max_active.compare_exchange_weak(max_active, active)) {
+    }
+    absl::SleepFor(absl::Milliseconds(20));
+    --stats_->active;
+    ++stats_->total;
+    busy_ = false;
+    return std::vector<Tensor>();
+  }
+
+  const InputOutputTensorNames& GetInputOutputTensorNames() const override {
+    return tensor_names_;
+  }
+
+ private:
+  InvocationStats* stats_;
+  std::atomic<bool> busy_{false};
+  InputOutputTensorNames tensor_names_;
+};
+
+std::vector<std::unique_ptr<InferenceRunner>> CreateFakeRunners(
+    int num_runners, InvocationStats* stats) {
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  for (int i = 0; i < num_runners; ++i) {
+    runners.push_back(std::make_unique<FakeInferenceRunner>(stats));
+  }
+  return runners;
+}
+
+void RunConcurrently(InferenceRunner& runner, int num_invocations) {
+  ThreadPool thread_pool("inference_runner_pool_test", num_invocations);
+  thread_pool.StartWorkers();
+  for (int i = 0; i < num_invocations; ++i) {
+    thread_pool.Schedule([&runner]() {
+      const std::vector<Tensor> inputs;
+      MP_EXPECT_OK(runner.Run(/*cc=*/nullptr, MakeTensorSpan(inputs)));
+    });
+  }
+}
+
+TEST(InferenceRunnerPoolTest, FailsOnEmptyPool) {
+  EXPECT_FALSE(CreateInferenceRunnerPool({}).ok());
+}
+
+TEST(InferenceRunnerPoolTest, ReturnsSingleRunnerAsIs) {
+  InvocationStats stats;
+  auto runners = CreateFakeRunners(/*num_runners=*/1, &stats);
+  const InferenceRunner* runner = runners.front().get();
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          CreateInferenceRunnerPool(std::move(runners)));
+  EXPECT_EQ(pool.get(), runner);
+}
+
+TEST(InferenceRunnerPoolTest, RunsInvocationsInParallel) {
+  InvocationStats stats;
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto pool, CreateInferenceRunnerPool(
+                     CreateFakeRunners(/*num_runners=*/4, &stats)));
+  RunConcurrently(*pool, /*num_invocations=*/16);
+  EXPECT_EQ(stats.total, 16);
+  EXPECT_GT(stats.max_active, 1);
+  EXPECT_LE(stats.max_active, 4);
+}
+
+TEST(InferenceRunnerPoolTest, NeverExceedsPoolSize) {
+  InvocationStats stats;
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto pool, CreateInferenceRunnerPool(
+                     CreateFakeRunners(/*num_runners=*/2, &stats)));
+  RunConcurrently(*pool, /*num_invocations=*/8);
+  EXPECT_EQ(stats.total, 8);
+  EXPECT_LE(stats.max_active, 2);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -107,44 +107,53 @@ absl::Status TensorsToSegmentationOpenCvConverter::ApplyActivation(
   // Configure activation function.
   const int output_layer_index = options_.output_layer_index();
   using Options = ::mediapipe::TensorsToSegmentationCalculatorOptions;
-  const auto activation_fn = [&](const cv::Vec2f& mask_value) {
-    float new_mask_value = 0;
-    // TODO consider moving switch out of the loop,
-    // and also avoid float/Vec2f casting.
-    switch (options_.activation()) {
-      case Options::NONE: {
-        new_mask_value = mask_value[0];
-        break;
-      }
-      case Options::SIGMOID: {
-        const float pixel0 = mask_value[0];
-        new_mask_value = 1.0 / (std::exp(-pixel0) + 1.0);
-        break;
-      }
-      case Options::SOFTMAX: {
-        const float pixel0 = mask_value[0];
-        const float pixel1 = mask_value[1];
-        const float max_pixel = std::max(pixel0, pixel1);
-        const float min_pixel = std::min(pixel0, pixel1);
-        const float softmax_denom =
-            /*exp(max_pixel - max_pixel)=*/1.0f +
-            std::exp(min_pixel - max_pixel);
-        new_mask_value = std::exp(mask_value[output_layer_index] - max_pixel) /
-                         softmax_denom;
-        break;
+  constexpr int kChannels = sizeof(T) / sizeof(float);
+  if (options_.activation() == Options::SOFTMAX) {
+    RET_CHECK_EQ(kChannels, 2) << "SOFTMAX activation requires 2 channels.";
+    RET_CHECK(output_layer_index >= 0 && output_layer_index < kChannels)
+        << "Invalid output_layer_index " << output_layer_index;
+  }
+
+  // Process mask tensor. The activation is selected once per row so that the
+  // inner loops only read contiguous rows, and rows are processed in parallel.
+  const auto activation = options_.activation();
+  cv::parallel_for_(cv::Range(0, tensor_mat.rows), [&](const cv::Range& range) {
+    for (int i = range.start; i < range.end; ++i) {
+      const float* input_row = tensor_mat.ptr<float>(i);
+      float* mask_row = small_mask_mat->ptr<float>(i);
+      switch (activation) {
+        case Options::NONE: {
+          for (int j = 0; j < tensor_mat.cols; ++j) {
+            mask_row[j] = input_row[j * kChannels];
+          }
+          break;
+        }
+        case Options::SIGMOID: {
+          for (int j = 0; j < tensor_mat.cols; ++j) {
+            const float pixel0 = input_row[j * kChannels];
+            mask_row[j] = 1.0 / (std::exp(-pixel0) + 1.0);
+          }
+          break;
+        }
+        case Options::SOFTMAX: {
+          for (int j = 0; j < tensor_mat.cols; ++j) {
+            const float pixel0 = input_row[j * kChannels];
+            const float pixel1 = input_row[j * kChannels + 1];
+            const float max_pixel = std::max(pixel0, pixel1);
+            const float min_pixel = std::min(pixel0, pixel1);
+            const float softmax_denom =
+                /*exp(max_pixel - max_pixel)=*/1.0f +
+                std::exp(min_pixel - max_pixel);
+            mask_row[j] =
+                std::exp(input_row[j * kChannels + output_layer_index] -
+                         max_pixel) /
+                softmax_denom;
+          }
+          break;
+        }
       }
     }
-    return new_mask_value;
-  };
-
-  // Process mask tensor.
-  for (int i = 0; i < tensor_mat.rows; ++i) {
-    for (int j = 0; j < tensor_mat.cols; ++j) {
-      const T& input_pix = tensor_mat.at<T>(i, j);
-      const float mask_value = activation_fn(input_pix);
-      small_mask_mat->at<float>(i, j) = mask_value;
-    }
-  }
+  });
 
   return absl::OkStatus();
 }
@@ -0,0 +1,264 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/xnnpack_on_disk_cache_helper.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <utime.h>
+#endif  // _WIN32
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/xnnpack_weights_cache.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kCacheFileSuffix[] = ".xnnpack_cache";
+constexpr char kMetadataFileSuffix[] = ".metadata";
+constexpr char kLockFileName[] = ".lock";
+
+// Exclusive lock on "<dir>/.lock", held for the lifetime of the object. It
+// serializes publishing and eviction of cache files between processes.
+// Locking is best effort: if the lock file cannot be opened (or on Windows),
+// atomic renames still keep cache files consistent.
+class ScopedDirectoryLock {
+ public:
+  explicit ScopedDirectoryLock(const std::string& dir) {
+#ifndef _WIN32
+    const std::string lock_path = file::JoinPath(dir, kLockFileName);
+    fd_ = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0 || flock(fd_, LOCK_EX) != 0) {
+      ABSL_LOG_FIRST_N(WARNING, 1)
+          << "Failed to lock XNNPACK cache directory: " << lock_path;
+    }
+#endif  // !_WIN32
+  }
+
+  ~ScopedDirectoryLock() {
+#ifndef _WIN32
+    // Closing the file descriptor releases the lock.
+    if (fd_ >= 0) close(fd_);
+#endif  // !_WIN32
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+int GetProcessId() {
+#ifdef _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif  // _WIN32
+}
+
+// Returns a build file path unique across processes and helpers.
+std::string MakeBuildFilePath(const std::string& cache_path) {
+  static std::atomic<int> build_counter{0};
+  return absl::StrCat(cache_path, ".", GetProcessId(), "_", build_counter++,
+                      ".tmp");
+}
+
+std::string MakeMetadataFilePath(const std::string& cache_path) {
+  return absl::StrCat(cache_path, kMetadataFileSuffix);
+}
+
+// Returns the size of the file at `path`, or -1 if it cannot be read.
+int64_t GetFileSize(const std::string& path) {
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0) return -1;
+  return static_cast<int64_t>(file_stat.st_size);
+}
+
+// Returns the contents of the metadata file published next to a cache file of
+// `cache_size` bytes built for a model of `model_size` bytes which starts with
+// `model_header`.
+std::string MakeMetadata(int64_t cache_size, size_t model_size,
+                         const std::string& model_header) {
+  return absl::StrCat(cache_size, "\n", model_size, "\n", model_header);
+}
+
+struct CacheFileInfo {
+  std::string path;
+  int64_t size;
+  int64_t last_used;
+};
+
+}  // namespace
+
+XnnpackOnDiskCacheHelper::~XnnpackOnDiskCacheHelper() {
+  absl::MutexLock lock(&mutex_);
+  if (building_ && build_path_taken_) {
+    // Never published, e.g. no inference ran; the file may be incomplete.
+    std::remove(build_path_.c_str());
+  }
+}
+
+absl::Status XnnpackOnDiskCacheHelper::Init(
+    const std::string& cache_dir, int64_t max_cache_size_bytes,
+    const tflite::FlatBufferModel& model) {
+  cache_dir_ = cache_dir;
+  max_cache_size_bytes_ = max_cache_size_bytes;
+  cache_path_ = file::JoinPath(
+      cache_dir_, absl::StrCat(GetTfLiteModelContentKey(model),
+                               kCacheFileSuffix));
+  model_size_ = model.allocation()->bytes();
+  model_header_ = GetTfLiteModelHeader(model);
+  if (!file::IsDirectory(cache_dir_).ok()) {
+    MP_RETURN_IF_ERROR(file::RecursivelyCreateDir(cache_dir_));
+  }
+
+  build_path_ = MakeBuildFilePath(cache_path_);
+
+  ScopedDirectoryLock directory_lock(cache_dir_);
+  absl::MutexLock lock(&mutex_);
+  building_ = !file::Exists(cache_path_).ok();
+  build_path_taken_ = false;
+  if (!building_ && !IsPublishedCacheValid()) {
+    // Truncated, or published for another model (or by a version without
+    // metadata). Processes mapping the file keep their mapping.
+    ABSL_LOG(WARNING) << "Rebuilding invalid XNNPACK cache file "
+                      << cache_path_;
+    std::remove(cache_path_.c_str());
+    std::remove(MakeMetadataFilePath(cache_path_).c_str());
+    building_ = true;
+  }
+#ifndef _WIN32
+  if (!building_) {
+    // Refresh the modification time, which eviction uses as last use time.
+    utime(cache_path_.c_str(), nullptr);
+  }
+#endif  // !_WIN32
+  return absl::OkStatus();
+}
+
+bool XnnpackOnDiskCacheHelper::IsPublishedCacheValid() const {
+  std::string metadata;
+  if (!file::GetContents(MakeMetadataFilePath(cache_path_), &metadata).ok()) {
+    return false;
+  }
+  return metadata ==
+         MakeMetadata(GetFileSize(cache_path_), model_size_, model_header_);
+}
+
+const char* XnnpackOnDiskCacheHelper::GetFilePathForNewDelegate() {
+  absl::MutexLock lock(&mutex_);
+  if (!building_) {
+    return cache_path_.c_str();
+  }
+  if (build_path_taken_) {
+    return nullptr;
+  }
+  build_path_taken_ = true;
+  return build_path_.c_str();
+}
+
+bool XnnpackOnDiskCacheHelper::IsBuilding() const {
+  absl::MutexLock lock(&mutex_);
+  return building_;
+}
+
+absl::Status XnnpackOnDiskCacheHelper::SaveCacheIfBuilt() {
+  absl::MutexLock lock(&mutex_);
+  if (!building_) {
+    return absl::OkStatus();
+  }
+  building_ = false;
+  if (!build_path_taken_ || !file::Exists(build_path_).ok()) {
+    // No delegate was configured to build the file (e.g. no XNNPACK delegate
+    // has been created).
+    return absl::OkStatus();
+  }
+
+  ScopedDirectoryLock directory_lock(cache_dir_);
+  if (file::Exists(cache_path_).ok()) {
+    // Another process published the same content meanwhile. The delegate keeps
+    // its memory mapping, so the private file can be unlinked right away.
+    std::remove(build_path_.c_str());
+  } else {
+    // The metadata is written first, so that a published cache file always has
+    // one.
+    MP_RETURN_IF_ERROR(file::SetContents(
+        MakeMetadataFilePath(cache_path_),
+        MakeMetadata(GetFileSize(build_path_), model_size_, model_header_)));
+    RET_CHECK_EQ(std::rename(build_path_.c_str(), cache_path_.c_str()), 0)
+        << "Failed to publish XNNPACK cache file " << cache_path_;
+  }
+  return EvictLeastRecentlyUsed();
+}
+
+absl::Status XnnpackOnDiskCacheHelper::EvictLeastRecentlyUsed() {
+  if (max_cache_size_bytes_ <= 0) {
+    return absl::OkStatus();
+  }
+  std::vector<std::string> paths;
+  MP_RETURN_IF_ERROR(
+      file::MatchFileTypeInDirectory(cache_dir_, kCacheFileSuffix, &paths));
+  std::vector<CacheFileInfo> files;
+  int64_t total_size = 0;
+  for (const std::string& path : paths) {
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0) continue;
+    files.push_back({path, static_cast<int64_t>(file_stat.st_size),
+                     static_cast<int64_t>(file_stat.st_mtime)});
+    total_size += file_stat.st_size;
+  }
+  std::sort(files.begin(), files.end(),
+            [](const CacheFileInfo& a, const CacheFileInfo& b) {
+              return a.last_used < b.last_used;
+            });
+  for (const CacheFileInfo& file : files) {
+    if (total_size <= max_cache_size_bytes_) break;
+    // The file just published is in use, and evicting it would only force
+    // rebuilding it on next start.
+    if (file.path == cache_path_) continue;
+    // Processes mapping an evicted file keep their mapping.
+    if (std::remove(file.path.c_str()) == 0) {
+      std::remove(MakeMetadataFilePath(file.path).c_str());
+      total_size -= file.size;
+    }
+  }
+  if (total_size > max_cache_size_bytes_) {
+    ABSL_LOG_FIRST_N(WARNING, 1)
+        << "XNNPACK cache directory " << cache_dir_ << " exceeds "
+        << max_cache_size_bytes_ << " bytes after eviction.";
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,94 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_XNNPACK_ON_DISK_CACHE_HELPER_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_XNNPACK_ON_DISK_CACHE_HELPER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace mediapipe {
+
+// Helper class that manages XNNPACK packed weights persisted on disk, the CPU
+// counterpart of `InferenceOnDiskCacheHelper`.
+//
+// Cache files live in a content-addressed directory which can be shared by
+// several processes: "<cache_dir>/<model content key>.xnnpack_cache". A missing
+// cache file is built by the XNNPACK delegate into a file private to this
+// helper and only published (atomically renamed) by `SaveCacheIfBuilt` once
+// complete, so other processes never map a partially written file. Publishing
+// and eviction are serialized across processes with a lock file in
+// `cache_dir`.
+//
+// Each cache file is published with a "<cache file>.metadata" file recording
+// its size and the size and header of the model. A cache file which does not
+// match them on lookup is rebuilt.
+class XnnpackOnDiskCacheHelper {
+ public:
+  XnnpackOnDiskCacheHelper() = default;
+  ~XnnpackOnDiskCacheHelper();
+  XnnpackOnDiskCacheHelper(const XnnpackOnDiskCacheHelper&) = delete;
+  XnnpackOnDiskCacheHelper& operator=(const XnnpackOnDiskCacheHelper&) = delete;
+
+  // Looks up the cache file for `model` in `cache_dir`, creating the directory
+  // if needed. If `max_cache_size_bytes` > 0, least recently used cache files
+  // are evicted when publishing a new one would exceed it.
+  absl::Status Init(const std::string& cache_dir, int64_t max_cache_size_bytes,
+                    const tflite::FlatBufferModel& model);
+
+  // Returns the path to set as `TfLiteXNNPackDelegateOptions::
+  // weight_cache_file_path` for a new delegate, or nullptr if the delegate
+  // should not use the on-disk cache. While the cache file is being built, only
+  // the first delegate gets a path: concurrent builders would overwrite each
+  // other's file.
+  const char* GetFilePathForNewDelegate();
+
+  // Returns true while the cache file has not been published yet.
+  bool IsBuilding() const;
+
+  // Publishes the cache file built by the delegate and evicts old cache files
+  // if needed. Must only be called once the building delegate has completed an
+  // inference: the XNNPACK delegate finalizes the file on first invocation.
+  // No-op if the cache file is already published.
+  absl::Status SaveCacheIfBuilt();
+
+ private:
+  // Whether the published cache file matches its metadata.
+  bool IsPublishedCacheValid() const;
+  absl::Status EvictLeastRecentlyUsed() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  std::string cache_dir_;
+  // Published cache file.
+  std::string cache_path_;
+  // File private to this helper the cache is built into if `cache_path_` does
+  // not exist yet.
+  std::string build_path_;
+  int64_t max_cache_size_bytes_ = 0;
+  size_t model_size_ = 0;
+  std::string model_header_;
+
+  mutable absl::Mutex mutex_;
+  bool building_ ABSL_GUARDED_BY(mutex_) = false;
+  bool build_path_taken_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_XNNPACK_ON_DISK_CACHE_HELPER_H_
@@ -0,0 +1,230 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/xnnpack_on_disk_cache_helper.h"
+
+#include <utime.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/resources.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kFloat32ModelFile[] =
+    "mediapipe/calculators/tensor/testdata/1x3_square_float32.tflite";
+constexpr char kInt32ModelFile[] =
+    "mediapipe/calculators/tensor/testdata/1x3_square_int32.tflite";
+
+api2::Packet<TfLiteModelPtr> LoadModel(const char* path) {
+  std::unique_ptr<Resources> resources = CreateDefaultResources();
+  auto model = TfLiteModelLoader::LoadFromPath(*resources, path);
+  EXPECT_TRUE(model.ok()) << model.status();
+  return *model;
+}
+
+std::string MakeCacheDir(const std::string& name) {
+  return file::JoinPath(std::getenv("TEST_TMPDIR"), name);
+}
+
+// Simulates the XNNPACK delegate writing the cache file on first invocation.
+void WriteCacheFile(const char* path, const std::string& contents) {
+  ASSERT_NE(path, nullptr);
+  MP_ASSERT_OK(file::SetContents(path, contents));
+}
+
+// Builds and publishes the cache file of `model` in `cache_dir`, and returns
+// its path.
+std::string PublishCacheFile(const std::string& cache_dir,
+                             const tflite::FlatBufferModel& model) {
+  XnnpackOnDiskCacheHelper helper;
+  MP_EXPECT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0, model));
+  WriteCacheFile(helper.GetFilePathForNewDelegate(), "packed weights");
+  MP_EXPECT_OK(helper.SaveCacheIfBuilt());
+  return helper.GetFilePathForNewDelegate();
+}
+
+std::string MetadataPath(const std::string& cache_path) {
+  return absl::StrCat(cache_path, ".metadata");
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, BuildsThenReusesCacheFile) {
+  const std::string cache_dir = MakeCacheDir("build_then_reuse");
+  auto model = LoadModel(kFloat32ModelFile);
+
+  std::string published_path;
+  {
+    XnnpackOnDiskCacheHelper helper;
+    MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                             *model.Get()));
+    EXPECT_TRUE(helper.IsBuilding());
+    const char* build_path = helper.GetFilePathForNewDelegate();
+    // Only a single delegate may build the cache file.
+    EXPECT_EQ(helper.GetFilePathForNewDelegate(), nullptr);
+    WriteCacheFile(build_path, "packed weights");
+    MP_ASSERT_OK(helper.SaveCacheIfBuilt());
+    EXPECT_FALSE(helper.IsBuilding());
+    EXPECT_FALSE(file::Exists(build_path).ok());
+    published_path = helper.GetFilePathForNewDelegate();
+  }
+  EXPECT_TRUE(file::Exists(MetadataPath(published_path)).ok());
+
+  XnnpackOnDiskCacheHelper helper;
+  MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                           *model.Get()));
+  EXPECT_FALSE(helper.IsBuilding());
+  // Every delegate maps the published file.
+  EXPECT_EQ(helper.GetFilePathForNewDelegate(), published_path);
+  EXPECT_EQ(helper.GetFilePathForNewDelegate(), published_path);
+  std::string contents;
+  MP_ASSERT_OK(file::GetContents(published_path, &contents));
+  EXPECT_EQ(contents, "packed weights");
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, RemovesUnpublishedBuildFile) {
+  const std::string cache_dir = MakeCacheDir("remove_unpublished");
+  auto model = LoadModel(kFloat32ModelFile);
+
+  std::string build_path;
+  {
+    XnnpackOnDiskCacheHelper helper;
+    MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                             *model.Get()));
+    build_path = helper.GetFilePathForNewDelegate();
+    WriteCacheFile(build_path.c_str(), "incomplete");
+  }
+  EXPECT_FALSE(file::Exists(build_path).ok());
+
+  XnnpackOnDiskCacheHelper helper;
+  MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                           *model.Get()));
+  EXPECT_TRUE(helper.IsBuilding());
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, KeepsFirstPublishedFile) {
+  const std::string cache_dir = MakeCacheDir("keep_first_published");
+  auto model = LoadModel(kFloat32ModelFile);
+
+  XnnpackOnDiskCacheHelper first;
+  XnnpackOnDiskCacheHelper second;
+  MP_ASSERT_OK(first.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                          *model.Get()));
+  MP_ASSERT_OK(second.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                           *model.Get()));
+  const char* first_build_path = first.GetFilePathForNewDelegate();
+  const char* second_build_path = second.GetFilePathForNewDelegate();
+  EXPECT_STRNE(first_build_path, second_build_path);
+  WriteCacheFile(first_build_path, "first");
+  WriteCacheFile(second_build_path, "second");
+
+  MP_ASSERT_OK(first.SaveCacheIfBuilt());
+  MP_ASSERT_OK(second.SaveCacheIfBuilt());
+  EXPECT_FALSE(file::Exists(second_build_path).ok());
+
+  std::string contents;
+  MP_ASSERT_OK(
+      file::GetContents(first.GetFilePathForNewDelegate(), &contents));
+  EXPECT_EQ(contents, "first");
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, RebuildsTruncatedCacheFile) {
+  const std::string cache_dir = MakeCacheDir("rebuild_truncated");
+  auto model = LoadModel(kFloat32ModelFile);
+  const std::string published_path = PublishCacheFile(cache_dir, *model.Get());
+  MP_ASSERT_OK(file::SetContents(published_path, "packed"));
+
+  XnnpackOnDiskCacheHelper helper;
+  MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                           *model.Get()));
+  EXPECT_TRUE(helper.IsBuilding());
+  EXPECT_FALSE(file::Exists(published_path).ok());
+  EXPECT_FALSE(file::Exists(MetadataPath(published_path)).ok());
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, RebuildsCacheFileOfOtherModel) {
+  const std::string cache_dir = MakeCacheDir("rebuild_other_model");
+  auto model = LoadModel(kFloat32ModelFile);
+  auto other_model = LoadModel(kInt32ModelFile);
+  const std::string published_path = PublishCacheFile(cache_dir, *model.Get());
+  // Simulates a content key collision with `other_model`.
+  const std::string other_path =
+      PublishCacheFile(MakeCacheDir("rebuild_other_model_source"),
+                       *other_model.Get());
+  std::string other_metadata;
+  MP_ASSERT_OK(file::GetContents(MetadataPath(other_path), &other_metadata));
+  MP_ASSERT_OK(file::SetContents(MetadataPath(published_path), other_metadata));
+
+  XnnpackOnDiskCacheHelper helper;
+  MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                           *model.Get()));
+  EXPECT_TRUE(helper.IsBuilding());
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, RebuildsCacheFileWithoutMetadata) {
+  const std::string cache_dir = MakeCacheDir("rebuild_without_metadata");
+  auto model = LoadModel(kFloat32ModelFile);
+  const std::string published_path = PublishCacheFile(cache_dir, *model.Get());
+  ASSERT_EQ(std::remove(MetadataPath(published_path).c_str()), 0);
+
+  XnnpackOnDiskCacheHelper helper;
+  MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/0,
+                           *model.Get()));
+  EXPECT_TRUE(helper.IsBuilding());
+  EXPECT_FALSE(file::Exists(published_path).ok());
+}
+
+TEST(XnnpackOnDiskCacheHelperTest, EvictsLeastRecentlyUsedFiles) {
+  const std::string cache_dir = MakeCacheDir("evict_lru");
+  MP_ASSERT_OK(file::RecursivelyCreateDir(cache_dir));
+  const std::string old_file =
+      file::JoinPath(cache_dir, "old.xnnpack_cache");
+  const std::string recent_file =
+      file::JoinPath(cache_dir, "recent.xnnpack_cache");
+  const std::string unrelated_file = file::JoinPath(cache_dir, "unrelated");
+  MP_ASSERT_OK(file::SetContents(old_file, std::string(100, 'o')));
+  MP_ASSERT_OK(file::SetContents(MetadataPath(old_file), "metadata"));
+  MP_ASSERT_OK(file::SetContents(recent_file, std::string(100, 'r')));
+  MP_ASSERT_OK(file::SetContents(unrelated_file, std::string(100, 'u')));
+  struct utimbuf old_time = {/*actime=*/1000, /*modtime=*/1000};
+  struct utimbuf recent_time = {/*actime=*/2000, /*modtime=*/2000};
+  ASSERT_EQ(utime(old_file.c_str(), &old_time), 0);
+  ASSERT_EQ(utime(recent_file.c_str(), &recent_time), 0);
+
+  auto model = LoadModel(kInt32ModelFile);
+  XnnpackOnDiskCacheHelper helper;
+  MP_ASSERT_OK(helper.Init(cache_dir, /*max_cache_size_bytes=*/250,
+                           *model.Get()));
+  WriteCacheFile(helper.GetFilePathForNewDelegate(), std::string(100, 'n'));
+  MP_ASSERT_OK(helper.SaveCacheIfBuilt());
+
+  EXPECT_FALSE(file::Exists(old_file).ok());
+  EXPECT_FALSE(file::Exists(MetadataPath(old_file)).ok());
+  EXPECT_TRUE(file::Exists(recent_file).ok());
+  EXPECT_TRUE(file::Exists(unrelated_file).ok());
+  EXPECT_TRUE(file::Exists(helper.GetFilePathForNewDelegate()).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
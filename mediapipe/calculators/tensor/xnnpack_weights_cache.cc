@@ -0,0 +1,142 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/xnnpack_weights_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "farmhash.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace mediapipe {
+
+namespace {
+
+class SharedCacheRegistry {
+ public:
+  absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>> GetOrCreate(
+      const std::string& key, const std::string& model_header,
+      absl::FunctionRef<absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>>()>
+          create) {
+    absl::MutexLock lock(&mutex_);
+    Entry& entry = caches_[key];
+    if (auto cache = entry.cache.lock()) {
+      // The key already covers the model size.
+      RET_CHECK(entry.model_header == model_header)
+          << "Different models share the content key " << key;
+      return cache;
+    }
+    MP_ASSIGN_OR_RETURN(auto cache, create());
+    entry = {cache, model_header};
+    return cache;
+  }
+
+ private:
+  struct Entry {
+    std::weak_ptr<XnnpackWeightsCache> cache;
+    std::string model_header;
+  };
+
+  absl::Mutex mutex_;
+  // Caches are dropped together with the last delegate using them; expired
+  // entries are replaced on next lookup.
+  absl::flat_hash_map<std::string, Entry> caches_ ABSL_GUARDED_BY(mutex_);
+};
+
+SharedCacheRegistry& GetSharedCacheRegistry() {
+  static auto* registry = new SharedCacheRegistry();
+  return *registry;
+}
+
+}  // namespace
+
+std::string GetTfLiteModelContentKey(const tflite::FlatBufferModel& model) {
+  const tflite::Allocation* allocation = model.allocation();
+  const auto* data = static_cast<const char*>(allocation->base());
+  const size_t size = allocation->bytes();
+  const util::uint128_t fingerprint = util::Fingerprint128(data, size);
+  return absl::StrFormat("%016x%016x_%d", util::Uint128High64(fingerprint),
+                         util::Uint128Low64(fingerprint), size);
+}
+
+std::string GetTfLiteModelHeader(const tflite::FlatBufferModel& model) {
+  const tflite::Allocation* allocation = model.allocation();
+  return std::string(static_cast<const char*>(allocation->base()),
+                     std::min(allocation->bytes(), kTfLiteModelHeaderSize));
+}
+
+XnnpackWeightsCache::XnnpackWeightsCache(
+    TfLiteXNNPackDelegateWeightsCache* cache, bool shared)
+    : cache_(cache), shared_(shared) {}
+
+XnnpackWeightsCache::~XnnpackWeightsCache() {
+  TfLiteXNNPackDelegateWeightsCacheDelete(cache_);
+}
+
+absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>>
+XnnpackWeightsCache::Create() {
+  TfLiteXNNPackDelegateWeightsCache* cache =
+      TfLiteXNNPackDelegateWeightsCacheCreate();
+  RET_CHECK(cache) << "Failed to create XNNPACK weights cache.";
+  return std::shared_ptr<XnnpackWeightsCache>(
+      new XnnpackWeightsCache(cache, /*shared=*/false));
+}
+
+absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>>
+XnnpackWeightsCache::GetOrCreateShared(const tflite::FlatBufferModel& model) {
+  return GetSharedCacheRegistry().GetOrCreate(
+      GetTfLiteModelContentKey(model), GetTfLiteModelHeader(model),
+      []() -> absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>> {
+        TfLiteXNNPackDelegateWeightsCache* cache =
+            TfLiteXNNPackDelegateWeightsCacheCreate();
+        RET_CHECK(cache) << "Failed to create XNNPACK weights cache.";
+        return std::shared_ptr<XnnpackWeightsCache>(
+            new XnnpackWeightsCache(cache, /*shared=*/true));
+      });
+}
+
+absl::Status XnnpackWeightsCache::Populate(
+    absl::FunctionRef<absl::Status()> create_interpreters) {
+  absl::MutexLock lock(&mutex_);
+  MP_RETURN_IF_ERROR(create_interpreters());
+  if (!used_) {
+    return absl::OkStatus();
+  }
+  if (finalized_) {
+    // Delegates created for the same model only looked up packed weights.
+    return absl::OkStatus();
+  }
+  const bool finalized =
+      shared_ ? TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(cache_)
+              : TfLiteXNNPackDelegateWeightsCacheFinalizeHard(cache_);
+  RET_CHECK(finalized) << "Failed to finalize XNNPACK weights cache.";
+  finalized_ = true;
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,102 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_XNNPACK_WEIGHTS_CACHE_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_XNNPACK_WEIGHTS_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace mediapipe {
+
+// Returns a key which identifies the content of `model`: the hex 128-bit
+// FarmHash fingerprint of the model buffer and its size in bytes. The key is
+// stable across processes and can therefore be used to name on-disk caches.
+// The fingerprint is not cryptographic, so caches also keep the model header
+// to verify a hit.
+std::string GetTfLiteModelContentKey(const tflite::FlatBufferModel& model);
+
+// Size of the header returned by `GetTfLiteModelHeader`.
+inline constexpr size_t kTfLiteModelHeaderSize = 64;
+
+// Returns the first `kTfLiteModelHeaderSize` bytes of `model` (or all of them
+// for smaller models), which caches keyed by `GetTfLiteModelContentKey` keep to
+// verify a hit.
+std::string GetTfLiteModelHeader(const tflite::FlatBufferModel& model);
+
+// Packed XNNPACK weights which can be shared between several XNNPACK delegates
+// (and therefore interpreters) created for the same model.
+//
+// Example usage:
+//   MP_ASSIGN_OR_RETURN(auto weights_cache,
+//                       XnnpackWeightsCache::GetOrCreateShared(model));
+//   MP_RETURN_IF_ERROR(weights_cache->Populate([&]() -> absl::Status {
+//     xnnpack_opts.weights_cache = weights_cache->Get();
+//     ... create delegates and interpreters ...
+//   }));
+//
+// NOTE: the cache must outlive all delegates created with it.
+class XnnpackWeightsCache {
+ public:
+  ~XnnpackWeightsCache();
+  XnnpackWeightsCache(const XnnpackWeightsCache&) = delete;
+  XnnpackWeightsCache& operator=(const XnnpackWeightsCache&) = delete;
+
+  // Creates a cache which is used by the caller only. It is hard-finalized by
+  // the first `Populate` call and cannot accept new weights afterwards.
+  static absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>> Create();
+
+  // Returns the process-wide cache for the content of `model`, creating it if
+  // no other user currently holds it. Weights packed for a model are kept in
+  // memory once, no matter how many calculators (or graphs) run it.
+  static absl::StatusOr<std::shared_ptr<XnnpackWeightsCache>> GetOrCreateShared(
+      const tflite::FlatBufferModel& model);
+
+  // Runs `create_interpreters`, which may pack new weights into the cache, and
+  // finalizes the cache afterwards so packed weights can be used for
+  // inference. Calls are serialized per cache. Finalization is skipped if
+  // `Get` has never been called, i.e. no delegate was configured to use it.
+  absl::Status Populate(absl::FunctionRef<absl::Status()> create_interpreters);
+
+  // Returns the cache to set as `TfLiteXNNPackDelegateOptions::weights_cache`.
+  TfLiteXNNPackDelegateWeightsCache* Get() {
+    used_ = true;
+    return cache_;
+  }
+
+ private:
+  XnnpackWeightsCache(TfLiteXNNPackDelegateWeightsCache* cache, bool shared);
+
+  TfLiteXNNPackDelegateWeightsCache* const cache_;
+  // Shared caches are soft-finalized so that delegates created later for the
+  // same model can still look up (and, if needed, add) packed weights.
+  const bool shared_;
+  std::atomic<bool> used_{false};
+  absl::Mutex mutex_;
+  bool finalized_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_XNNPACK_WEIGHTS_CACHE_H_
@@ -0,0 +1,134 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/xnnpack_weights_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/tensor/tflite_delegate_ptr.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/resources.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::MatchesRegex;
+
+constexpr char kFloat32ModelFile[] =
+    "mediapipe/calculators/tensor/testdata/1x3_square_float32.tflite";
+constexpr char kInt32ModelFile[] =
+    "mediapipe/calculators/tensor/testdata/1x3_square_int32.tflite";
+
+api2::Packet<TfLiteModelPtr> LoadModel(const char* path) {
+  std::unique_ptr<Resources> resources = CreateDefaultResources();
+  auto model = TfLiteModelLoader::LoadFromPath(*resources, path);
+  EXPECT_TRUE(model.ok()) << model.status();
+  return *model;
+}
+
+TEST(XnnpackWeightsCacheTest, ContentKeyDependsOnModelContentOnly) {
+  auto model = LoadModel(kFloat32ModelFile);
+  auto same_model = LoadModel(kFloat32ModelFile);
+  auto other_model = LoadModel(kInt32ModelFile);
+  EXPECT_EQ(GetTfLiteModelContentKey(*model.Get()),
+            GetTfLiteModelContentKey(*same_model.Get()));
+  EXPECT_NE(GetTfLiteModelContentKey(*model.Get()),
+            GetTfLiteModelContentKey(*other_model.Get()));
+}
+
+TEST(XnnpackWeightsCacheTest, ContentKeyHoldsFingerprintAndSize) {
+  auto model = LoadModel(kFloat32ModelFile);
+  const std::string key = GetTfLiteModelContentKey(*model.Get());
+  EXPECT_THAT(key, MatchesRegex("[0-9a-f]{32}_[0-9]+"));
+  EXPECT_TRUE(absl::EndsWith(
+      key, absl::StrCat("_", model.Get()->allocation()->bytes())));
+}
+
+TEST(XnnpackWeightsCacheTest, SharesCacheForIdenticalModels) {
+  auto model = LoadModel(kFloat32ModelFile);
+  auto same_model = LoadModel(kFloat32ModelFile);
+  auto other_model = LoadModel(kInt32ModelFile);
+  MP_ASSERT_OK_AND_ASSIGN(auto cache,
+                          XnnpackWeightsCache::GetOrCreateShared(*model.Get()));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto same_cache,
+      XnnpackWeightsCache::GetOrCreateShared(*same_model.Get()));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto other_cache,
+      XnnpackWeightsCache::GetOrCreateShared(*other_model.Get()));
+  EXPECT_EQ(cache, same_cache);
+  EXPECT_NE(cache, other_cache);
+}
+
+TEST(XnnpackWeightsCacheTest, ReleasesSharedCacheWithLastUser) {
+  auto model = LoadModel(kFloat32ModelFile);
+  MP_ASSERT_OK_AND_ASSIGN(auto cache,
+                          XnnpackWeightsCache::GetOrCreateShared(*model.Get()));
+  std::weak_ptr<XnnpackWeightsCache> weak_cache = cache;
+  cache = nullptr;
+  EXPECT_TRUE(weak_cache.expired());
+}
+
+TEST(XnnpackWeightsCacheTest, CreatesInterpretersWithSharedCache) {
+  auto model = LoadModel(kFloat32ModelFile);
+  tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates op_resolver;
+  // Declared first to outlive `delegates` and `interpreters`.
+  std::vector<std::shared_ptr<XnnpackWeightsCache>> caches;
+  std::vector<TfLiteDelegatePtr> delegates;
+  std::vector<std::unique_ptr<tflite::Interpreter>> interpreters;
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto cache, XnnpackWeightsCache::GetOrCreateShared(*model.Get()));
+    MP_ASSERT_OK(cache->Populate([&]() -> absl::Status {
+      auto xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
+      xnnpack_opts.weights_cache = cache->Get();
+      delegates.emplace_back(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
+                             &TfLiteXNNPackDelegateDelete);
+      tflite::InterpreterBuilder builder(*model.Get(), op_resolver);
+      builder.AddDelegate(delegates.back().get());
+      interpreters.emplace_back();
+      EXPECT_EQ(builder(&interpreters.back()), kTfLiteOk);
+      return absl::OkStatus();
+    }));
+    caches.push_back(cache);
+  }
+  for (auto& interpreter : interpreters) {
+    ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    float* input = interpreter->typed_input_tensor<float>(0);
+    input[0] = 1.f;
+    input[1] = 2.f;
+    input[2] = 3.f;
+    ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+    const float* output = interpreter->typed_output_tensor<float>(0);
+    EXPECT_EQ(output[0], 1.f);
+    EXPECT_EQ(output[1], 4.f);
+    EXPECT_EQ(output[2], 9.f);
+  }
+  EXPECT_EQ(caches.front(), caches.back());
+}
+
+}  // namespace
+}  // namespace mediapipe
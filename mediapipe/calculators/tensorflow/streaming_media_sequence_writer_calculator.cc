@@ -0,0 +1,393 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "mediapipe/calculators/image/opencv_image_encoder_calculator.pb.h"
+#include "mediapipe/calculators/tensorflow/streaming_media_sequence_writer_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/sequence/media_sequence.h"
+#include "mediapipe/util/sequence/media_sequence_util.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+
+namespace tf = ::tensorflow;
+namespace mpms = mediapipe::mediasequence;
+
+namespace {
+
+constexpr char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+constexpr char kTFRecordPathTag[] = "TFRECORD_PATH";
+constexpr char kImageTag[] = "IMAGE";
+constexpr char kImagePrefixTag[] = "IMAGE_";
+constexpr char kFloatFeaturePrefixTag[] = "FLOAT_FEATURE_";
+constexpr char kIntFeaturePrefixTag[] = "INT_FEATURE_";
+constexpr char kBytesFeaturePrefixTag[] = "BYTES_FEATURE_";
+
+// Approximate serialized size of the keys and lengths of a feature entry.
+constexpr int64_t kFeatureOverheadBytes = 16;
+
+// Tags of length-delimited fields 1 and 2 in the protobuf wire format.
+constexpr char kField1Tag = (1 << 3) | 2;
+constexpr char kField2Tag = (2 << 3) | 2;
+
+int VarintSize(uint64_t value) {
+  int size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+void AppendVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+// Returns the size of a length-delimited field holding `size` bytes.
+uint64_t FieldSize(uint64_t size) { return 1 + VarintSize(size) + size; }
+
+void AppendFieldHeader(char tag, uint64_t size, std::string* output) {
+  output->push_back(tag);
+  AppendVarint(size, output);
+}
+
+// Appends the feature list `key` of encoded images to `record`, a serialized
+// tf.SequenceExample, without copying the images.
+//
+// A serialized tf.SequenceExample holding only
+//   feature_lists { feature_list { key: `key` value { feature { bytes_list {
+//     value: `image` } } ... } } }
+// is appended, which parsers merge with the preceding message. The images
+// are referenced from their packets, which `record` keeps alive.
+void AppendImageFeatureList(const std::string& key,
+                            const std::vector<Packet>& images,
+                            absl::Cord* record) {
+  uint64_t feature_list_size = 0;
+  for (const Packet& image : images) {
+    const uint64_t encoded_size =
+        image.Get<OpenCvImageEncoderCalculatorResults>().encoded_image().size();
+    feature_list_size += FieldSize(FieldSize(FieldSize(encoded_size)));
+  }
+  const uint64_t entry_size =
+      FieldSize(key.size()) + FieldSize(feature_list_size);
+  const uint64_t feature_lists_size = FieldSize(entry_size);
+
+  std::string header;
+  AppendFieldHeader(kField2Tag, feature_lists_size, &header);
+  AppendFieldHeader(kField1Tag, entry_size, &header);
+  AppendFieldHeader(kField1Tag, key.size(), &header);
+  header.append(key);
+  AppendFieldHeader(kField2Tag, feature_list_size, &header);
+  record->Append(std::move(header));
+
+  for (const Packet& image : images) {
+    const std::string& encoded =
+        image.Get<OpenCvImageEncoderCalculatorResults>().encoded_image();
+    const uint64_t bytes_list_size = FieldSize(encoded.size());
+    std::string feature_header;
+    AppendFieldHeader(kField1Tag, FieldSize(bytes_list_size), &feature_header);
+    AppendFieldHeader(kField1Tag, bytes_list_size, &feature_header);
+    AppendFieldHeader(kField1Tag, encoded.size(), &feature_header);
+    record->Append(std::move(feature_header));
+    record->Append(absl::MakeCordFromExternal(
+        encoded, [image](absl::string_view) {}));
+  }
+}
+
+}  // namespace
+
+// Sink calculator to write long media sequences as a series of bounded
+// tf.SequenceExample chunks, as they are produced.
+//
+// PackMediaSequenceCalculator holds the whole sequence in memory until Close,
+// which takes gigabytes for long videos. This calculator instead starts a new
+// chunk once the current one reaches max_frames_per_chunk timestamps or
+// max_chunk_bytes, so memory use is bounded by the chunk size. Each chunk
+// conforms to media_sequence.h, holds the context of the SEQUENCE_EXAMPLE
+// input side packet, if any, and has its clip start and end timestamps set to
+// its first and last input timestamps.
+//
+// Encoded images are not copied into the chunk: their packets are held until
+// the chunk is serialized, and are referenced by the serialized chunk.
+//
+// The supported input stream tags are:
+// * "IMAGE" and "IMAGE_${NAME}", which store the encoded images from the
+//   OpenCvImageEncoderCalculator,
+// * "FLOAT_FEATURE_${NAME}", "INT_FEATURE_${NAME}" and "BYTES_FEATURE_${NAME}",
+//   which store the values of vector<float>, vector<int64_t> and
+//   vector<std::string> packets associated with the name ${NAME}.
+// Annotations that need the whole sequence to be reconciled, e.g. bounding
+// boxes, are only supported by PackMediaSequenceCalculator.
+//
+// The chunks are appended to the TFRecord file, or shards, at TFRECORD_PATH
+// and/or output on the SEQUENCE_EXAMPLE stream at their first timestamp.
+//
+// Example config:
+// node {
+//   calculator: "StreamingMediaSequenceWriterCalculator"
+//   input_side_packet: "SEQUENCE_EXAMPLE:metadata"
+//   input_side_packet: "TFRECORD_PATH:output_path"
+//   input_stream: "IMAGE:encoded_frames"
+//   input_stream: "FLOAT_FEATURE_EMBEDDING:embeddings"
+//   options {
+//     [mediapipe.StreamingMediaSequenceWriterCalculatorOptions.ext]: {
+//       max_frames_per_chunk: 900
+//       max_chunks_per_shard: 10
+//     }
+//   }
+// }
+class StreamingMediaSequenceWriterCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    if (cc->InputSidePackets().HasTag(kSequenceExampleTag)) {
+      cc->InputSidePackets()
+          .Tag(kSequenceExampleTag)
+          .Set<tf::SequenceExample>();
+    }
+    if (cc->InputSidePackets().HasTag(kTFRecordPathTag)) {
+      cc->InputSidePackets().Tag(kTFRecordPathTag).Set<std::string>();
+    }
+    RET_CHECK(cc->InputSidePackets().HasTag(kTFRecordPathTag) ||
+              cc->Outputs().HasTag(kSequenceExampleTag))
+        << "StreamingMediaSequenceWriterCalculator must write to a TFRecord "
+           "file or output a stream of sequence examples.";
+    if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+      cc->Outputs().Tag(kSequenceExampleTag).Set<tf::SequenceExample>();
+    }
+
+    for (const auto& tag : cc->Inputs().GetTags()) {
+      if (tag == kImageTag || absl::StartsWith(tag, kImagePrefixTag)) {
+        cc->Inputs().Tag(tag).Set<OpenCvImageEncoderCalculatorResults>();
+      } else if (absl::StartsWith(tag, kFloatFeaturePrefixTag)) {
+        cc->Inputs().Tag(tag).Set<std::vector<float>>();
+      } else if (absl::StartsWith(tag, kIntFeaturePrefixTag)) {
+        cc->Inputs().Tag(tag).Set<std::vector<int64_t>>();
+      } else if (absl::StartsWith(tag, kBytesFeaturePrefixTag)) {
+        cc->Inputs().Tag(tag).Set<std::vector<std::string>>();
+      } else {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Unsupported input stream tag: ", tag));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    options_ = cc->Options<StreamingMediaSequenceWriterCalculatorOptions>();
+    RET_CHECK_GT(options_.max_frames_per_chunk(), 0);
+    RET_CHECK_GT(options_.max_chunk_bytes(), 0);
+
+    if (cc->InputSidePackets().HasTag(kSequenceExampleTag)) {
+      *context_.mutable_context() = cc->InputSidePackets()
+                                        .Tag(kSequenceExampleTag)
+                                        .Get<tf::SequenceExample>()
+                                        .context();
+    }
+    for (const auto& [key, feature] :
+         options_.context_feature_map().feature()) {
+      (*context_.mutable_context()->mutable_feature())[key] = feature;
+    }
+    if (cc->InputSidePackets().HasTag(kTFRecordPathTag)) {
+      path_ = cc->InputSidePackets().Tag(kTFRecordPathTag).Get<std::string>();
+    }
+    StartChunk();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const int64_t timestamp = cc->InputTimestamp().Value();
+    int64_t frame_bytes = 0;
+    for (const auto& tag : cc->Inputs().GetTags()) {
+      const Packet& packet = cc->Inputs().Tag(tag).Value();
+      if (packet.IsEmpty()) continue;
+      frame_bytes += kFeatureOverheadBytes;
+      if (tag == kImageTag || absl::StartsWith(tag, kImagePrefixTag)) {
+        frame_bytes += packet.Get<OpenCvImageEncoderCalculatorResults>()
+                           .encoded_image()
+                           .size();
+      } else if (absl::StartsWith(tag, kFloatFeaturePrefixTag)) {
+        frame_bytes += packet.Get<std::vector<float>>().size() * sizeof(float);
+      } else if (absl::StartsWith(tag, kIntFeaturePrefixTag)) {
+        frame_bytes +=
+            packet.Get<std::vector<int64_t>>().size() * sizeof(int64_t);
+      } else {
+        for (const auto& value : packet.Get<std::vector<std::string>>()) {
+          frame_bytes += value.size();
+        }
+      }
+    }
+    if (frame_bytes == 0) return absl::OkStatus();
+
+    if (num_frames_ > 0 &&
+        (num_frames_ >= options_.max_frames_per_chunk() ||
+         chunk_bytes_ + frame_bytes > options_.max_chunk_bytes())) {
+      MP_RETURN_IF_ERROR(EmitChunk(cc));
+    }
+    if (num_frames_ == 0) {
+      mpms::SetClipStartTimestamp(timestamp, &chunk_);
+      start_timestamp_ = cc->InputTimestamp();
+    }
+    mpms::SetClipEndTimestamp(timestamp, &chunk_);
+    ++num_frames_;
+    chunk_bytes_ += frame_bytes;
+
+    for (const auto& tag : cc->Inputs().GetTags()) {
+      const Packet& packet = cc->Inputs().Tag(tag).Value();
+      if (packet.IsEmpty()) continue;
+      if (tag == kImageTag || absl::StartsWith(tag, kImagePrefixTag)) {
+        const std::string key =
+            tag == kImageTag ? "" : std::string(absl::StripPrefix(
+                                        tag, kImagePrefixTag));
+        const auto& image = packet.Get<OpenCvImageEncoderCalculatorResults>();
+        RET_CHECK(image.has_encoded_image()) << "No encoded image";
+        if (!mpms::HasImageHeight(key, chunk_)) {
+          mpms::SetImageHeight(key, image.height(), &chunk_);
+          mpms::SetImageWidth(key, image.width(), &chunk_);
+        }
+        mpms::AddImageTimestamp(key, timestamp, &chunk_);
+        images_[mpms::GetImageEncodedKey(key)].push_back(packet);
+      } else if (absl::StartsWith(tag, kFloatFeaturePrefixTag)) {
+        const std::string key(absl::StripPrefix(tag, kFloatFeaturePrefixTag));
+        mpms::AddFeatureTimestamp(key, timestamp, &chunk_);
+        mpms::AddFeatureFloats(key, packet.Get<std::vector<float>>(), &chunk_);
+      } else if (absl::StartsWith(tag, kIntFeaturePrefixTag)) {
+        const std::string key(absl::StripPrefix(tag, kIntFeaturePrefixTag));
+        mpms::AddFeatureTimestamp(key, timestamp, &chunk_);
+        mpms::AddFeatureInts(key, packet.Get<std::vector<int64_t>>(), &chunk_);
+      } else {
+        const std::string key(absl::StripPrefix(tag, kBytesFeaturePrefixTag));
+        mpms::AddFeatureTimestamp(key, timestamp, &chunk_);
+        mpms::AddFeatureBytes(key, packet.Get<std::vector<std::string>>(),
+                              &chunk_);
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Close(CalculatorContext* cc) override {
+    if (num_frames_ > 0) {
+      MP_RETURN_IF_ERROR(EmitChunk(cc));
+    }
+    return CloseShard();
+  }
+
+ private:
+  void StartChunk() {
+    chunk_ = context_;
+    images_.clear();
+    num_frames_ = 0;
+    chunk_bytes_ = chunk_.ByteSizeLong();
+  }
+
+  absl::Status EmitChunk(CalculatorContext* cc) {
+    absl::Cord record(chunk_.SerializeAsString());
+    for (const auto& [key, images] : images_) {
+      AppendImageFeatureList(key, images, &record);
+    }
+    // Copies the chunk once, so that it can be written and parsed.
+    const absl::string_view serialized = record.Flatten();
+
+    if (!path_.empty()) {
+      MP_RETURN_IF_ERROR(WriteRecord(serialized));
+    }
+    if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+      auto sequence = std::make_unique<tf::SequenceExample>();
+      RET_CHECK(sequence->ParseFromArray(serialized.data(), serialized.size()));
+      cc->Outputs()
+          .Tag(kSequenceExampleTag)
+          .Add(sequence.release(), start_timestamp_);
+    }
+    StartChunk();
+    return absl::OkStatus();
+  }
+
+  absl::Status WriteRecord(absl::string_view record) {
+    if (!writer_) {
+      const std::string shard_path =
+          options_.max_chunks_per_shard() > 0
+              ? absl::StrFormat("%s-%05d", path_, shard_index_)
+              : path_;
+      auto tf_status = tf::Env::Default()->NewWritableFile(shard_path, &file_);
+      RET_CHECK(tf_status.ok()) << "Failed to open tfrecord file "
+                                << shard_path << ": " << tf_status.ToString();
+      writer_ = std::make_unique<tf::io::RecordWriter>(file_.get());
+      ++shard_index_;
+      chunks_in_shard_ = 0;
+    }
+    auto tf_status = writer_->WriteRecord(record);
+    RET_CHECK(tf_status.ok())
+        << "Failed to write tfrecord: " << tf_status.ToString();
+    ++chunks_in_shard_;
+    if (options_.max_chunks_per_shard() > 0 &&
+        chunks_in_shard_ >= options_.max_chunks_per_shard()) {
+      return CloseShard();
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status CloseShard() {
+    if (!writer_) return absl::OkStatus();
+    auto tf_status = writer_->Close();
+    if (tf_status.ok()) tf_status = file_->Close();
+    writer_.reset();
+    file_.reset();
+    RET_CHECK(tf_status.ok())
+        << "Failed to close tfrecord file: " << tf_status.ToString();
+    return absl::OkStatus();
+  }
+
+  StreamingMediaSequenceWriterCalculatorOptions options_;
+  // The context copied into every chunk.
+  tf::SequenceExample context_;
+
+  // The chunk being built, without its encoded images.
+  tf::SequenceExample chunk_;
+  // The encoded image packets of the chunk, by feature list key.
+  std::map<std::string, std::vector<Packet>> images_;
+  Timestamp start_timestamp_;
+  int num_frames_ = 0;
+  int64_t chunk_bytes_ = 0;
+
+  std::string path_;
+  std::unique_ptr<tf::WritableFile> file_;
+  std::unique_ptr<tf::io::RecordWriter> writer_;
+  int shard_index_ = 0;
+  int chunks_in_shard_ = 0;
+};
+REGISTER_CALCULATOR(StreamingMediaSequenceWriterCalculator);
+
+}  // namespace mediapipe
@@ -0,0 +1,172 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/image/opencv_image_encoder_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/sequence/media_sequence.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+namespace {
+
+namespace tf = ::tensorflow;
+namespace mpms = mediapipe::mediasequence;
+
+constexpr char kImageTag[] = "IMAGE";
+constexpr char kFloatFeatureTestTag[] = "FLOAT_FEATURE_TEST";
+constexpr char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+constexpr char kTFRecordPathTag[] = "TFRECORD_PATH";
+
+// Returns an encoded image of `size` bytes, distinct for each `index`.
+OpenCvImageEncoderCalculatorResults MakeEncodedImage(int index, int size) {
+  OpenCvImageEncoderCalculatorResults image;
+  image.set_encoded_image(std::string(size, 'a' + index % 26));
+  image.set_width(4);
+  image.set_height(2);
+  return image;
+}
+
+std::unique_ptr<CalculatorRunner> MakeRunner(const std::string& options,
+                                             int num_frames, int image_size) {
+  auto runner = std::make_unique<CalculatorRunner>(
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::StrCat(
+          R"pb(
+            calculator: "StreamingMediaSequenceWriterCalculator"
+            input_side_packet: "SEQUENCE_EXAMPLE:metadata"
+            input_stream: "IMAGE:images"
+            input_stream: "FLOAT_FEATURE_TEST:features"
+            output_stream: "SEQUENCE_EXAMPLE:chunks"
+            options {
+              [mediapipe.StreamingMediaSequenceWriterCalculatorOptions.ext] {)pb",
+          options, "}}")));
+  tf::SequenceExample metadata;
+  mpms::SetClipMediaId("test_video", &metadata);
+  runner->MutableSidePackets()->Tag(kSequenceExampleTag) =
+      MakePacket<tf::SequenceExample>(metadata);
+  for (int i = 0; i < num_frames; ++i) {
+    runner->MutableInputs()->Tag(kImageTag).packets.push_back(
+        MakePacket<OpenCvImageEncoderCalculatorResults>(
+            MakeEncodedImage(i, image_size))
+            .At(Timestamp(i * 100)));
+    runner->MutableInputs()->Tag(kFloatFeatureTestTag).packets.push_back(
+        MakePacket<std::vector<float>>(std::vector<float>{1.0f * i, 2.0f})
+            .At(Timestamp(i * 100)));
+  }
+  return runner;
+}
+
+// Checks that `chunk` holds frames [first, first + size) of MakeRunner().
+void ExpectChunk(const tf::SequenceExample& chunk, int first, int size,
+                 int image_size) {
+  EXPECT_EQ(mpms::GetClipMediaId(chunk), "test_video");
+  EXPECT_EQ(mpms::GetClipStartTimestamp(chunk), first * 100);
+  EXPECT_EQ(mpms::GetClipEndTimestamp(chunk), (first + size - 1) * 100);
+  EXPECT_EQ(mpms::GetImageHeight(chunk), 2);
+  EXPECT_EQ(mpms::GetImageWidth(chunk), 4);
+  ASSERT_EQ(mpms::GetImageEncodedSize(chunk), size);
+  ASSERT_EQ(mpms::GetImageTimestampSize(chunk), size);
+  ASSERT_EQ(mpms::GetFeatureFloatsSize("TEST", chunk), size);
+  for (int i = 0; i < size; ++i) {
+    EXPECT_EQ(mpms::GetImageEncodedAt(chunk, i),
+              MakeEncodedImage(first + i, image_size).encoded_image());
+    EXPECT_EQ(mpms::GetImageTimestampAt(chunk, i), (first + i) * 100);
+    EXPECT_THAT(mpms::GetFeatureFloatsAt("TEST", chunk, i),
+                ::testing::ElementsAre(1.0f * (first + i), 2.0f));
+  }
+}
+
+TEST(StreamingMediaSequenceWriterCalculatorTest, ChunksByFrameCount) {
+  auto runner = MakeRunner("max_frames_per_chunk: 2", /*num_frames=*/5,
+                           /*image_size=*/100);
+  MP_ASSERT_OK(runner->Run());
+
+  const std::vector<Packet>& chunks =
+      runner->Outputs().Tag(kSequenceExampleTag).packets;
+  ASSERT_EQ(chunks.size(), 3);
+  for (int i = 0; i < chunks.size(); ++i) {
+    EXPECT_EQ(chunks[i].Timestamp(), Timestamp(i * 200));
+    ExpectChunk(chunks[i].Get<tf::SequenceExample>(), i * 2,
+                i < 2 ? 2 : 1, 100);
+  }
+}
+
+TEST(StreamingMediaSequenceWriterCalculatorTest, ChunksByBytes) {
+  // Each frame takes somewhat more than its 1000 bytes image.
+  auto runner = MakeRunner("max_chunk_bytes: 2500", /*num_frames=*/6,
+                           /*image_size=*/1000);
+  MP_ASSERT_OK(runner->Run());
+
+  const std::vector<Packet>& chunks =
+      runner->Outputs().Tag(kSequenceExampleTag).packets;
+  ASSERT_EQ(chunks.size(), 3);
+  for (int i = 0; i < chunks.size(); ++i) {
+    const tf::SequenceExample& chunk = chunks[i].Get<tf::SequenceExample>();
+    EXPECT_LE(chunk.ByteSizeLong(), 2500);
+    ExpectChunk(chunk, i * 2, 2, 1000);
+  }
+}
+
+TEST(StreamingMediaSequenceWriterCalculatorTest, WritesTFRecordShards) {
+  const std::string path =
+      file::JoinPath(std::getenv("TEST_TMPDIR"), "chunks.tfrecord");
+  auto runner = MakeRunner(R"pb(
+                             max_frames_per_chunk: 1 max_chunks_per_shard: 2
+                           )pb",
+                           /*num_frames=*/5, /*image_size=*/100);
+  runner->MutableSidePackets()->Tag(kTFRecordPathTag) =
+      MakePacket<std::string>(path);
+  MP_ASSERT_OK(runner->Run());
+
+  int frame = 0;
+  for (int shard = 0; shard < 3; ++shard) {
+    std::unique_ptr<tf::RandomAccessFile> file;
+    ASSERT_TRUE(tf::Env::Default()
+                    ->NewRandomAccessFile(absl::StrCat(path, "-0000", shard),
+                                          &file)
+                    .ok());
+    tf::io::RecordReader reader(file.get());
+    uint64_t offset = 0;
+    tf::tstring record;
+    while (reader.ReadRecord(&offset, &record).ok()) {
+      tf::SequenceExample chunk;
+      ASSERT_TRUE(chunk.ParseFromString(record));
+      ExpectChunk(chunk, frame, 1, 100);
+      ++frame;
+    }
+    EXPECT_EQ(frame, std::min(5, 2 * (shard + 1)));
+  }
+  EXPECT_FALSE(tf::Env::Default()
+                   ->FileExists(absl::StrCat(path, "-00003"))
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -157,8 +157,8 @@ FlatColorImageCalculator::CreateOutputFrame(CalculatorContext* cc) {
     return std::nullopt;
   }
 
-  auto output_frame = std::make_shared<ImageFrame>(ImageFormat::SRGB,
-                                                   output_width, output_height);
+  std::shared_ptr<ImageFrame> output_frame =
+      cc->AllocateImageFrame(ImageFormat::SRGB, output_width, output_height);
   cv::Mat output_mat = mediapipe::formats::MatView(output_frame.get());
 
   output_mat.setTo(cv::Scalar(color.r(), color.g(), color.b()));
@@ -0,0 +1,82 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+namespace api2 {
+
+// Converts a LandmarkArray back to a NormalizedLandmarkList or LandmarkList,
+// see LandmarksToLandmarkArrayCalculator.
+//
+// Inputs:
+//   LANDMARK_ARRAY: A LandmarkArray.
+//
+// Outputs:
+//   NORM_LANDMARKS (optional): A NormalizedLandmarkList with the same
+//     landmarks.
+//   LANDMARKS (optional): A LandmarkList with the same landmarks.
+//
+//   Exactly one of the outputs must be connected.
+//
+// Example config:
+//   node {
+//     calculator: "LandmarkArrayToLandmarksCalculator"
+//     input_stream: "LANDMARK_ARRAY:landmark_array"
+//     output_stream: "NORM_LANDMARKS:landmarks"
+//   }
+class LandmarkArrayToLandmarksCalculator : public Node {
+ public:
+  static constexpr Input<LandmarkArray> kInLandmarkArray{"LANDMARK_ARRAY"};
+  static constexpr Output<NormalizedLandmarkList>::Optional kOutNormLandmarks{
+      "NORM_LANDMARKS"};
+  static constexpr Output<LandmarkList>::Optional kOutLandmarks{"LANDMARKS"};
+
+  MEDIAPIPE_NODE_CONTRACT(kInLandmarkArray, kOutNormLandmarks, kOutLandmarks);
+
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    RET_CHECK(kOutNormLandmarks(cc).IsConnected() ^
+              kOutLandmarks(cc).IsConnected())
+        << "One and only one of NORM_LANDMARKS and LANDMARKS output is allowed";
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (kInLandmarkArray(cc).IsEmpty()) {
+      return absl::OkStatus();
+    }
+    const LandmarkArray& landmarks = kInLandmarkArray(cc).Get();
+    if (kOutNormLandmarks(cc).IsConnected()) {
+      kOutNormLandmarks(cc).Send(ToNormalizedLandmarkList(landmarks));
+    } else {
+      kOutLandmarks(cc).Send(ToLandmarkList(landmarks));
+    }
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(LandmarkArrayToLandmarksCalculator);
+
+}  // namespace api2
+}  // namespace mediapipe
@@ -12,12 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/tool/type_util.h"
 
 namespace mediapipe {
 
@@ -26,6 +32,22 @@ namespace {
 constexpr char kLandmarksTag[] = "LANDMARKS";
 constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 
+// Adjusts landmark coordinates in place, see the calculator description.
+void RemoveLetterbox(const std::array<float, 4>& letterbox_padding,
+                     absl::Span<float> xs, absl::Span<float> ys,
+                     absl::Span<float> zs) {
+  const float left = letterbox_padding[0];
+  const float top = letterbox_padding[1];
+  const float left_and_right = letterbox_padding[0] + letterbox_padding[2];
+  const float top_and_bottom = letterbox_padding[1] + letterbox_padding[3];
+
+  for (size_t i = 0; i < xs.size(); ++i) {
+    xs[i] = (xs[i] - left) / (1.0f - left_and_right);
+    ys[i] = (ys[i] - top) / (1.0f - top_and_bottom);
+    zs[i] = zs[i] / (1.0f - left_and_right);  // Scale Z coordinate as X.
+  }
+}
+
 }  // namespace
 
 // Adjusts landmark locations on a letterboxed image to the corresponding
@@ -35,16 +57,17 @@ constexpr char kLetterboxPaddingTag[] = "LETTERBOX_PADDING";
 // corresponding input image before letterboxing.
 //
 // Input:
-//   LANDMARKS: A NormalizedLandmarkList representing landmarks on an
-//   letterboxed image.
+//   LANDMARKS: A NormalizedLandmarkList or LandmarkArray representing landmarks
+//   on an letterboxed image.
 //
 //   LETTERBOX_PADDING: An std::array<float, 4> representing the letterbox
 //   padding from the 4 sides ([left, top, right, bottom]) of the letterboxed
 //   image, normalized to [0.f, 1.f] by the letterboxed image dimensions.
 //
 // Output:
-//   LANDMARKS: An NormalizedLandmarkList proto representing landmarks with
-//   their locations adjusted to the letterbox-removed (non-padded) image.
+//   LANDMARKS: A NormalizedLandmarkList or LandmarkArray, same as the input,
+//   representing landmarks with their locations adjusted to the
+//   letterbox-removed (non-padded) image.
 //
 // Usage example:
 // node {
@@ -75,13 +98,13 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
 
     for (CollectionItemId id = cc->Inputs().BeginId(kLandmarksTag);
          id != cc->Inputs().EndId(kLandmarksTag); ++id) {
-      cc->Inputs().Get(id).Set<NormalizedLandmarkList>();
+      cc->Inputs().Get(id).SetOneOf<NormalizedLandmarkList, LandmarkArray>();
     }
     cc->Inputs().Tag(kLetterboxPaddingTag).Set<std::array<float, 4>>();
 
     for (CollectionItemId id = cc->Outputs().BeginId(kLandmarksTag);
          id != cc->Outputs().EndId(kLandmarksTag); ++id) {
-      cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
+      cc->Outputs().Get(id).SetOneOf<NormalizedLandmarkList, LandmarkArray>();
     }
 
     return absl::OkStatus();
@@ -99,10 +122,6 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
     }
     const auto& letterbox_padding =
         cc->Inputs().Tag(kLetterboxPaddingTag).Get<std::array<float, 4>>();
-    const float left = letterbox_padding[0];
-    const float top = letterbox_padding[1];
-    const float left_and_right = letterbox_padding[0] + letterbox_padding[2];
-    const float top_and_bottom = letterbox_padding[1] + letterbox_padding[3];
 
     CollectionItemId input_id = cc->Inputs().BeginId(kLandmarksTag);
     CollectionItemId output_id = cc->Outputs().BeginId(kLandmarksTag);
@@ -114,24 +133,35 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
         continue;
       }
 
+      if (input_packet.Value().GetTypeId() == kTypeId<LandmarkArray>) {
+        LandmarkArray output_landmarks = input_packet.Get<LandmarkArray>();
+        RemoveLetterbox(letterbox_padding, output_landmarks.x(),
+                        output_landmarks.y(), output_landmarks.z());
+        cc->Outputs().Get(output_id).AddPacket(
+            MakePacket<LandmarkArray>(std::move(output_landmarks))
+                .At(cc->InputTimestamp()));
+        continue;
+      }
+
       const NormalizedLandmarkList& input_landmarks =
           input_packet.Get<NormalizedLandmarkList>();
       NormalizedLandmarkList output_landmarks;
       for (int i = 0; i < input_landmarks.landmark_size(); ++i) {
         const NormalizedLandmark& landmark = input_landmarks.landmark(i);
         NormalizedLandmark* new_landmark = output_landmarks.add_landmark();
-        const float new_x = (landmark.x() - left) / (1.0f - left_and_right);
-        const float new_y = (landmark.y() - top) / (1.0f - top_and_bottom);
-        const float new_z =
-            landmark.z() / (1.0f - left_and_right);  // Scale Z coordinate as X.
+        float x = landmark.x();
+        float y = landmark.y();
+        float z = landmark.z();
+        RemoveLetterbox(letterbox_padding, absl::MakeSpan(&x, 1),
+                        absl::MakeSpan(&y, 1), absl::MakeSpan(&z, 1));
         *new_landmark = landmark;
-        new_landmark->set_x(new_x);
-        new_landmark->set_y(new_y);
-        new_landmark->set_z(new_z);
+        new_landmark->set_x(x);
+        new_landmark->set_y(y);
+        new_landmark->set_z(z);
       }
 
       cc->Outputs().Get(output_id).AddPacket(
-          MakePacket<NormalizedLandmarkList>(output_landmarks)
+          MakePacket<NormalizedLandmarkList>(std::move(output_landmarks))
               .At(cc->InputTimestamp()));
     }
     return absl::OkStatus();
@@ -15,6 +15,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
@@ -113,4 +114,45 @@ TEST(LandmarkLetterboxRemovalCalculatorTest, PaddingTopBottom) {
   EXPECT_THAT(output_landmarks.landmark(2).y(), testing::FloatNear(1.0f, 1e-5));
 }
 
+TEST(LandmarkLetterboxRemovalCalculatorTest, PaddingLandmarkArray) {
+  CalculatorRunner runner(GetDefaultNode());
+
+  LandmarkArray landmarks(3, /*has_visibility=*/true);
+  landmarks.x()[0] = 0.5f;
+  landmarks.y()[0] = 0.5f;
+  landmarks.x()[1] = 0.2f;
+  landmarks.y()[1] = 0.2f;
+  landmarks.z()[1] = 0.5f;
+  landmarks.x()[2] = 0.7f;
+  landmarks.y()[2] = 0.7f;
+  landmarks.visibility()[2] = 0.9f;
+  runner.MutableInputs()
+      ->Tag(kLandmarksTag)
+      .packets.push_back(MakePacket<LandmarkArray>(std::move(landmarks))
+                             .At(Timestamp::PostStream()));
+
+  auto padding = absl::make_unique<std::array<float, 4>>(
+      std::array<float, 4>{0.2f, 0.f, 0.3f, 0.f});
+  runner.MutableInputs()
+      ->Tag(kLetterboxPaddingTag)
+      .packets.push_back(Adopt(padding.release()).At(Timestamp::PostStream()));
+
+  MP_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const std::vector<Packet>& output =
+      runner.Outputs().Tag(kLandmarksTag).packets;
+  ASSERT_EQ(1, output.size());
+  const auto& output_landmarks = output[0].Get<LandmarkArray>();
+
+  EXPECT_EQ(output_landmarks.size(), 3);
+
+  EXPECT_THAT(output_landmarks.x()[0], testing::FloatNear(0.6f, 1e-5));
+  EXPECT_THAT(output_landmarks.y()[0], testing::FloatNear(0.5f, 1e-5));
+  EXPECT_THAT(output_landmarks.x()[1], testing::FloatNear(0.0f, 1e-5));
+  EXPECT_THAT(output_landmarks.y()[1], testing::FloatNear(0.2f, 1e-5));
+  EXPECT_THAT(output_landmarks.z()[1], testing::FloatNear(1.0f, 1e-5));
+  EXPECT_THAT(output_landmarks.x()[2], testing::FloatNear(1.0f, 1e-5));
+  EXPECT_THAT(output_landmarks.y()[2], testing::FloatNear(0.7f, 1e-5));
+  EXPECT_FLOAT_EQ(output_landmarks.visibility()[2], 0.9f);
+}
+
 }  // namespace mediapipe
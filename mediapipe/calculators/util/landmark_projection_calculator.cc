@@ -14,18 +14,22 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <functional>
 #include <utility>
 
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/calculators/util/landmark_projection_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/tool/type_util.h"
 
 namespace mediapipe {
 
@@ -42,7 +46,7 @@ constexpr char kImageDimensionsTag[] = "IMAGE_DIMENSIONS";
 
 // Projects normalized landmarks to its original coordinates.
 // Input:
-//   NORM_LANDMARKS - NormalizedLandmarkList
+//   NORM_LANDMARKS - NormalizedLandmarkList or LandmarkArray
 //     Represents landmarks in a normalized rectangle if NORM_RECT is specified
 //     or landmarks that should be projected using PROJECTION_MATRIX if
 //     specified. (Prefer using PROJECTION_MATRIX as it eliminates need of
@@ -65,8 +69,9 @@ constexpr char kImageDimensionsTag[] = "IMAGE_DIMENSIONS";
 //     the normalized region of interest used during landmarks detection.
 //
 // Output:
-//   NORM_LANDMARKS - NormalizedLandmarkList
-//     Landmarks with their locations adjusted according to the inputs.
+//   NORM_LANDMARKS - NormalizedLandmarkList or LandmarkArray
+//     Landmarks with their locations adjusted according to the inputs, of the
+//     same type as the corresponding input landmarks.
 //
 // Usage example:
 // node {
@@ -112,7 +117,7 @@ class LandmarkProjectionCalculator : public CalculatorBase {
 
     for (CollectionItemId id = cc->Inputs().BeginId(kLandmarksTag);
          id != cc->Inputs().EndId(kLandmarksTag); ++id) {
-      cc->Inputs().Get(id).Set<NormalizedLandmarkList>();
+      cc->Inputs().Get(id).SetOneOf<NormalizedLandmarkList, LandmarkArray>();
     }
     RET_CHECK(cc->Inputs().HasTag(kRectTag) ^
               cc->Inputs().HasTag(kProjectionMatrix))
@@ -131,7 +136,7 @@ class LandmarkProjectionCalculator : public CalculatorBase {
 
     for (CollectionItemId id = cc->Outputs().BeginId(kLandmarksTag);
          id != cc->Outputs().EndId(kLandmarksTag); ++id) {
-      cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
+      cc->Outputs().Get(id).SetOneOf<NormalizedLandmarkList, LandmarkArray>();
     }
 
     return absl::OkStatus();
@@ -143,13 +148,18 @@ class LandmarkProjectionCalculator : public CalculatorBase {
     return absl::OkStatus();
   }
 
-  static void ProjectXY(const NormalizedLandmark& lm,
-                        const std::array<float, 16>& matrix,
-                        NormalizedLandmark* out) {
-    out->set_x(lm.x() * matrix[0] + lm.y() * matrix[1] + lm.z() * matrix[2] +
-               matrix[3]);
-    out->set_y(lm.x() * matrix[4] + lm.y() * matrix[5] + lm.z() * matrix[6] +
-               matrix[7]);
+  // Projects landmark coordinates in place.
+  static void ProjectXYZ(const std::array<float, 16>& matrix, float z_scale,
+                         absl::Span<float> xs, absl::Span<float> ys,
+                         absl::Span<float> zs) {
+    for (size_t i = 0; i < xs.size(); ++i) {
+      const float x = xs[i];
+      const float y = ys[i];
+      const float z = zs[i];
+      xs[i] = x * matrix[0] + y * matrix[1] + z * matrix[2] + matrix[3];
+      ys[i] = x * matrix[4] + y * matrix[5] + z * matrix[6] + matrix[7];
+      zs[i] = z_scale * z;
+    }
   }
 
   /**
@@ -159,22 +169,18 @@ class LandmarkProjectionCalculator : public CalculatorBase {
    * 2. Calculate length of the projected segment.
    */
   static float CalculateZScale(const std::array<float, 16>& matrix) {
-    NormalizedLandmark a;
-    a.set_x(0.0f);
-    a.set_y(0.0f);
-    NormalizedLandmark b;
-    b.set_x(1.0f);
-    b.set_y(0.0f);
-    NormalizedLandmark a_projected;
-    ProjectXY(a, matrix, &a_projected);
-    NormalizedLandmark b_projected;
-    ProjectXY(b, matrix, &b_projected);
-    return std::sqrt(std::pow(b_projected.x() - a_projected.x(), 2) +
-                     std::pow(b_projected.y() - a_projected.y(), 2));
+    float xs[] = {0.0f, 1.0f};
+    float ys[] = {0.0f, 0.0f};
+    float zs[] = {0.0f, 0.0f};
+    ProjectXYZ(matrix, /*z_scale=*/1.0f, absl::MakeSpan(xs),
+               absl::MakeSpan(ys), absl::MakeSpan(zs));
+    return std::sqrt(std::pow(xs[1] - xs[0], 2) + std::pow(ys[1] - ys[0], 2));
   }
 
   absl::Status Process(CalculatorContext* cc) override {
-    std::function<void(const NormalizedLandmark&, NormalizedLandmark*)>
+    // Projects landmark coordinates in place.
+    std::function<void(absl::Span<float> xs, absl::Span<float> ys,
+                       absl::Span<float> zs)>
         project_fn;
     std::array<float, 16> project_mat;
     const bool has_rect = cc->Inputs().HasTag(kRectTag);
@@ -190,24 +196,27 @@ class LandmarkProjectionCalculator : public CalculatorBase {
       const auto& input_rect = cc->Inputs().Tag(kRectTag).Get<NormalizedRect>();
       const auto& options =
           cc->Options<mediapipe::LandmarkProjectionCalculatorOptions>();
-      project_fn = [&input_rect, &options](const NormalizedLandmark& landmark,
-                                           NormalizedLandmark* new_landmark) {
-        const float x = landmark.x() - 0.5f;
-        const float y = landmark.y() - 0.5f;
+      project_fn = [&input_rect, &options](absl::Span<float> xs,
+                                           absl::Span<float> ys,
+                                           absl::Span<float> zs) {
         const float angle =
             options.ignore_rotation() ? 0 : input_rect.rotation();
-        float new_x = std::cos(angle) * x - std::sin(angle) * y;
-        float new_y = std::sin(angle) * x + std::cos(angle) * y;
-
-        new_x = new_x * input_rect.width() + input_rect.x_center();
-        new_y = new_y * input_rect.height() + input_rect.y_center();
-        const float new_z =
-            landmark.z() * input_rect.width();  // Scale Z coordinate as X.
+        const float cos_angle = std::cos(angle);
+        const float sin_angle = std::sin(angle);
+        const float width = input_rect.width();
+        const float height = input_rect.height();
+        const float x_center = input_rect.x_center();
+        const float y_center = input_rect.y_center();
+        for (size_t i = 0; i < xs.size(); ++i) {
+          const float x = xs[i] - 0.5f;
+          const float y = ys[i] - 0.5f;
+          float new_x = cos_angle * x - sin_angle * y;
+          float new_y = sin_angle * x + cos_angle * y;
 
-        *new_landmark = landmark;
-        new_landmark->set_x(new_x);
-        new_landmark->set_y(new_y);
-        new_landmark->set_z(new_z);
+          xs[i] = new_x * width + x_center;
+          ys[i] = new_y * height + y_center;
+          zs[i] = zs[i] * width;  // Scale Z coordinate as X.
+        }
       };
     } else if (has_rect && has_image_dims) {
       if (cc->Inputs().Tag(kRectTag).IsEmpty() ||
@@ -230,11 +239,10 @@ class LandmarkProjectionCalculator : public CalculatorBase {
           rotated_rect, image_dimensions.first, image_dimensions.second,
           /*flip_horizontaly=*/false, &project_mat);
       const float z_scale = CalculateZScale(project_mat);
-      project_fn = [&project_mat, z_scale](const NormalizedLandmark& lm,
-                                           NormalizedLandmark* new_landmark) {
-        *new_landmark = lm;
-        ProjectXY(lm, project_mat, new_landmark);
-        new_landmark->set_z(z_scale * lm.z());
+      project_fn = [&project_mat, z_scale](absl::Span<float> xs,
+                                           absl::Span<float> ys,
+                                           absl::Span<float> zs) {
+        ProjectXYZ(project_mat, z_scale, xs, ys, zs);
       };
     } else if (cc->Inputs().HasTag(kProjectionMatrix)) {
       if (cc->Inputs().Tag(kProjectionMatrix).IsEmpty()) {
@@ -243,11 +251,10 @@ class LandmarkProjectionCalculator : public CalculatorBase {
       project_mat =
           cc->Inputs().Tag(kProjectionMatrix).Get<std::array<float, 16>>();
       const float z_scale = CalculateZScale(project_mat);
-      project_fn = [&project_mat, z_scale](const NormalizedLandmark& lm,
-                                           NormalizedLandmark* new_landmark) {
-        *new_landmark = lm;
-        ProjectXY(lm, project_mat, new_landmark);
-        new_landmark->set_z(z_scale * lm.z());
+      project_fn = [&project_mat, z_scale](absl::Span<float> xs,
+                                           absl::Span<float> ys,
+                                           absl::Span<float> zs) {
+        ProjectXYZ(project_mat, z_scale, xs, ys, zs);
       };
     } else {
       return absl::InternalError("Either rect or matrix must be specified.");
@@ -263,12 +270,30 @@ class LandmarkProjectionCalculator : public CalculatorBase {
         continue;
       }
 
+      if (input_packet.Value().GetTypeId() == kTypeId<LandmarkArray>) {
+        LandmarkArray output_landmarks = input_packet.Get<LandmarkArray>();
+        project_fn(output_landmarks.x(), output_landmarks.y(),
+                   output_landmarks.z());
+        cc->Outputs().Get(output_id).AddPacket(
+            MakePacket<LandmarkArray>(std::move(output_landmarks))
+                .At(cc->InputTimestamp()));
+        continue;
+      }
+
       const auto& input_landmarks = input_packet.Get<NormalizedLandmarkList>();
       NormalizedLandmarkList output_landmarks;
       for (int i = 0; i < input_landmarks.landmark_size(); ++i) {
         const NormalizedLandmark& landmark = input_landmarks.landmark(i);
         NormalizedLandmark* new_landmark = output_landmarks.add_landmark();
-        project_fn(landmark, new_landmark);
+        float x = landmark.x();
+        float y = landmark.y();
+        float z = landmark.z();
+        project_fn(absl::MakeSpan(&x, 1), absl::MakeSpan(&y, 1),
+                   absl::MakeSpan(&z, 1));
+        *new_landmark = landmark;
+        new_landmark->set_x(x);
+        new_landmark->set_y(y);
+        new_landmark->set_z(z);
       }
 
       cc->Outputs().Get(output_id).AddPacket(
@@ -7,6 +7,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -336,5 +337,79 @@ TEST(LandmarkProjectionCalculatorTest, ProjectingWithRotationMatrix) {
       )pb")));
 }
 
+TEST(LandmarkProjectionCalculatorTest, KeepsFieldsOfMixedLandmarkList) {
+  mediapipe::NormalizedLandmarkList landmarks =
+      ParseTextProtoOrDie<mediapipe::NormalizedLandmarkList>(R"pb(
+        landmark { x: 10, y: 20, z: -0.5 visibility: 0.5 presence: 0.75 }
+        landmark { x: 5, y: 6, z: 7 }
+      )pb");
+  // clang-format off
+  std::array<float, 16> matrix = {
+    2.0f, 0.0f, 0.0f, 1.0f,
+    0.0f, 3.0f, 0.0f, 2.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f,
+  };
+  // clang-format on
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto result, RunCalculator(std::move(landmarks), std::move(matrix)));
+
+  // Landmarks without visibility and presence keep them unset.
+  EXPECT_THAT(
+      result,
+      EqualsProto(ParseTextProtoOrDie<mediapipe::NormalizedLandmarkList>(R"pb(
+        landmark { x: 21, y: 62, z: -1 visibility: 0.5 presence: 0.75 }
+        landmark { x: 11, y: 20, z: 14 }
+      )pb")));
+}
+
+TEST(LandmarkProjectionCalculatorTest, ProjectingLandmarkArrayWithMatrix) {
+  mediapipe::NormalizedLandmarkList landmarks =
+      ParseTextProtoOrDie<mediapipe::NormalizedLandmarkList>(R"pb(
+        landmark { x: 10, y: 20, z: -0.5 visibility: 0.5 }
+        landmark { x: 5, y: 6, z: 7 visibility: 0.25 }
+      )pb");
+  // clang-format off
+  std::array<float, 16> matrix = {
+    2.0f, 0.0f, 0.0f, 1.0f,
+    0.0f, 3.0f, 0.0f, 2.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f,
+  };
+  // clang-format on
+
+  mediapipe::CalculatorRunner runner(
+      ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig::Node>(R"pb(
+        calculator: "LandmarkProjectionCalculator"
+        input_stream: "NORM_LANDMARKS:landmarks"
+        input_stream: "PROJECTION_MATRIX:matrix"
+        output_stream: "NORM_LANDMARKS:projected_landmarks"
+      )pb"));
+  runner.MutableInputs()
+      ->Tag(kNormLandmarksTag)
+      .packets.push_back(
+          MakePacket<LandmarkArray>(ToLandmarkArray(landmarks))
+              .At(Timestamp(1)));
+  runner.MutableInputs()
+      ->Tag(kProjectionMatrixTag)
+      .packets.push_back(
+          MakePacket<std::array<float, 16>>(matrix).At(Timestamp(1)));
+  MP_ASSERT_OK(runner.Run());
+
+  // Landmark arrays are projected the same way as landmark lists.
+  const auto& output_packets = runner.Outputs().Tag(kNormLandmarksTag).packets;
+  ASSERT_EQ(output_packets.size(), 1);
+  MP_ASSERT_OK_AND_ASSIGN(auto expected,
+                          RunCalculator(landmarks, std::move(matrix)));
+  EXPECT_THAT(ToNormalizedLandmarkList(output_packets[0].Get<LandmarkArray>()),
+              EqualsProto(expected));
+  EXPECT_THAT(
+      expected,
+      EqualsProto(ParseTextProtoOrDie<mediapipe::NormalizedLandmarkList>(R"pb(
+        landmark { x: 21, y: 62, z: -1 visibility: 0.5 }
+        landmark { x: 11, y: 20, z: 14 visibility: 0.25 }
+      )pb")));
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -16,14 +16,18 @@
 
 #include <algorithm>
 #include <set>
+#include <type_traits>
 #include <utility>
 
 #include "absl/log/absl_check.h"
 #include "absl/memory/memory.h"
 #include "mediapipe/calculators/util/landmarks_refinement_calculator.pb.h"
 #include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/packet.h"
 #include "mediapipe/framework/api2/port.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/port/proto_ns.h"
 #include "mediapipe/framework/port/ret_check.h"
 
@@ -61,46 +65,85 @@ absl::StatusOr<int> GetNumberOfRefinedLandmarks(
   return n_idxs;
 }
 
-void RefineXY(const proto_ns::RepeatedField<int>& indexes_mapping,
-              const NormalizedLandmarkList& landmarks,
-              NormalizedLandmarkList* refined_landmarks) {
-  for (int i = 0; i < landmarks.landmark_size(); ++i) {
-    const auto& landmark = landmarks.landmark(i);
-    auto* refined_landmark =
-        refined_landmarks->mutable_landmark(indexes_mapping.Get(i));
+// Accessors of both LANDMARKS input types, NormalizedLandmarkList and
+// LandmarkArray.
+template <typename LandmarksT>
+int GetNumLandmarks(const LandmarksT& landmarks) {
+  if constexpr (std::is_same_v<LandmarksT, LandmarkArray>) {
+    return landmarks.size();
+  } else {
+    return landmarks.landmark_size();
+  }
+}
+
+template <typename LandmarksT>
+float GetZ(const LandmarksT& landmarks, int index) {
+  if constexpr (std::is_same_v<LandmarksT, LandmarkArray>) {
+    return landmarks.z()[index];
+  } else {
+    return landmarks.landmark(index).z();
+  }
+}
+
+template <typename LandmarksT>
+void SetZ(float z, int index, LandmarksT* landmarks) {
+  if constexpr (std::is_same_v<LandmarksT, LandmarkArray>) {
+    landmarks->z()[index] = z;
+  } else {
+    landmarks->mutable_landmark(index)->set_z(z);
+  }
+}
+
+// Copies X and Y of landmark `index` to landmark `refined_index`.
+template <typename LandmarksT>
+void CopyXY(const LandmarksT& landmarks, int index, int refined_index,
+            LandmarksT* refined_landmarks) {
+  if constexpr (std::is_same_v<LandmarksT, LandmarkArray>) {
+    refined_landmarks->x()[refined_index] = landmarks.x()[index];
+    refined_landmarks->y()[refined_index] = landmarks.y()[index];
+  } else {
+    const auto& landmark = landmarks.landmark(index);
+    auto* refined_landmark = refined_landmarks->mutable_landmark(refined_index);
     refined_landmark->set_x(landmark.x());
     refined_landmark->set_y(landmark.y());
   }
 }
 
-float GetZAverage(const NormalizedLandmarkList& landmarks,
+template <typename LandmarksT>
+void RefineXY(const proto_ns::RepeatedField<int>& indexes_mapping,
+              const LandmarksT& landmarks, LandmarksT* refined_landmarks) {
+  for (int i = 0; i < GetNumLandmarks(landmarks); ++i) {
+    CopyXY(landmarks, i, indexes_mapping.Get(i), refined_landmarks);
+  }
+}
+
+template <typename LandmarksT>
+float GetZAverage(const LandmarksT& landmarks,
                   const proto_ns::RepeatedField<int>& indexes) {
   double z_sum = 0;
   for (int i = 0; i < indexes.size(); ++i) {
-    z_sum += landmarks.landmark(indexes.Get(i)).z();
+    z_sum += GetZ(landmarks, indexes.Get(i));
   }
   return z_sum / indexes.size();
 }
 
+template <typename LandmarksT>
 void RefineZ(
     const proto_ns::RepeatedField<int>& indexes_mapping,
     const LandmarksRefinementCalculatorOptions::ZRefinement& z_refinement,
-    const NormalizedLandmarkList& landmarks,
-    NormalizedLandmarkList* refined_landmarks) {
+    const LandmarksT& landmarks, LandmarksT* refined_landmarks) {
   if (z_refinement.has_none()) {
     // Do nothing and keep Z that is already in refined landmarks.
   } else if (z_refinement.has_copy()) {
-    for (int i = 0; i < landmarks.landmark_size(); ++i) {
-      refined_landmarks->mutable_landmark(indexes_mapping.Get(i))
-          ->set_z(landmarks.landmark(i).z());
+    for (int i = 0; i < GetNumLandmarks(landmarks); ++i) {
+      SetZ(GetZ(landmarks, i), indexes_mapping.Get(i), refined_landmarks);
     }
   } else if (z_refinement.has_assign_average()) {
     const float z_average =
         GetZAverage(*refined_landmarks,
                     z_refinement.assign_average().indexes_for_average());
     for (int i = 0; i < indexes_mapping.size(); ++i) {
-      refined_landmarks->mutable_landmark(indexes_mapping.Get(i))
-          ->set_z(z_average);
+      SetZ(z_average, indexes_mapping.Get(i), refined_landmarks);
     }
   } else {
     ABSL_CHECK(false)
@@ -108,6 +151,17 @@ void RefineZ(
   }
 }
 
+// Converts landmarks of the other LANDMARKS input type.
+void ConvertLandmarks(const LandmarkArray& landmarks,
+                      NormalizedLandmarkList& converted_landmarks) {
+  converted_landmarks = ToNormalizedLandmarkList(landmarks);
+}
+
+void ConvertLandmarks(const NormalizedLandmarkList& landmarks,
+                      LandmarkArray& converted_landmarks) {
+  converted_landmarks = ToLandmarkArray(landmarks);
+}
+
 }  // namespace
 
 class LandmarksRefinementCalculatorImpl
@@ -156,39 +210,66 @@ class LandmarksRefinementCalculatorImpl
       }
     }
 
+    // The refined landmarks are of the type of the first LANDMARKS input.
+    if (kLandmarks(cc)[0].Has<LandmarkArray>()) {
+      LandmarkArray refined_landmarks(n_refined_landmarks_);
+      MP_RETURN_IF_ERROR(Refine(cc, refined_landmarks));
+      kRefinedLandmarks(cc).Send(
+          MakePacket<LandmarkArray>(std::move(refined_landmarks))
+              .At(cc->InputTimestamp()));
+      return absl::OkStatus();
+    }
+
     // Initialize refined landmarks list.
     auto refined_landmarks = absl::make_unique<NormalizedLandmarkList>();
     for (int i = 0; i < n_refined_landmarks_; ++i) {
       refined_landmarks->add_landmark();
     }
+    MP_RETURN_IF_ERROR(Refine(cc, *refined_landmarks));
+    kRefinedLandmarks(cc).Send(
+        PacketAdopting(std::move(refined_landmarks)).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
 
-    // Apply input landmarks to outpu refined landmarks in provided order.
+ private:
+  // Applies input landmarks to `refined_landmarks` in provided order.
+  template <typename LandmarksT>
+  absl::Status Refine(CalculatorContext* cc, LandmarksT& refined_landmarks) {
     for (int i = 0; i < kLandmarks(cc).Count(); ++i) {
-      const auto& landmarks = kLandmarks(cc)[i].Get();
+      const auto& landmarks_packet = kLandmarks(cc)[i];
+      LandmarksT converted_landmarks;
+      const LandmarksT* landmarks = &converted_landmarks;
+      if (landmarks_packet.Has<LandmarksT>()) {
+        landmarks = &landmarks_packet.Get<LandmarksT>();
+      } else if constexpr (std::is_same_v<LandmarksT, LandmarkArray>) {
+        ConvertLandmarks(landmarks_packet.Get<NormalizedLandmarkList>(),
+                         converted_landmarks);
+      } else {
+        ConvertLandmarks(landmarks_packet.Get<LandmarkArray>(),
+                         converted_landmarks);
+      }
       const auto& refinement = options_.refinement(i);
 
       // Check number of landmarks in mapping and stream are the same.
-      RET_CHECK_EQ(landmarks.landmark_size(), refinement.indexes_mapping_size())
-          << "There are " << landmarks.landmark_size()
+      RET_CHECK_EQ(GetNumLandmarks(*landmarks),
+                   refinement.indexes_mapping_size())
+          << "There are " << GetNumLandmarks(*landmarks)
           << " refinement landmarks while mapping has "
           << refinement.indexes_mapping_size();
 
       // Refine X and Y.
-      RefineXY(refinement.indexes_mapping(), landmarks,
-               refined_landmarks.get());
+      RefineXY(refinement.indexes_mapping(), *landmarks, &refined_landmarks);
 
       // Refine Z.
       RefineZ(refinement.indexes_mapping(), refinement.z_refinement(),
-              landmarks, refined_landmarks.get());
+              *landmarks, &refined_landmarks);
 
-      // Visibility and presence are not currently refined and are left as `0`.
+      // Visibility and presence are not currently refined and are left as `0`
+      // (unset for LandmarkArray).
     }
-
-    kRefinedLandmarks(cc).Send(std::move(refined_landmarks));
     return absl::OkStatus();
   }
 
- private:
   LandmarksRefinementCalculatorOptions options_;
   int n_refined_landmarks_ = 0;
 };
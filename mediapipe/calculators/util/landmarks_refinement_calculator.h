@@ -18,6 +18,7 @@
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/api2/port.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 
 namespace mediapipe {
 
@@ -26,14 +27,15 @@ namespace api2 {
 // A calculator to refine one set of landmarks with another.
 //
 // Inputs:
-//   LANDMARKS: Multiple NormalizedLandmarkList to use for
+//   LANDMARKS: Multiple NormalizedLandmarkList or LandmarkArray to use for
 //     refinement. They will be applied to the resulting REFINED_LANDMARKS in
 //     the provided order. Each list should be non empty and contain the same
 //     amount of landmarks as indexes in mapping. Number of lists should be the
 //     same as number of refinements in options.
 //
 // Outputs:
-//   REFINED_LANDMARKS: A NormalizedLandmarkList with refined landmarks. Number
+//   REFINED_LANDMARKS: A NormalizedLandmarkList with refined landmarks, or a
+//     LandmarkArray if the first LANDMARKS input is a LandmarkArray. Number
 //     of produced landmarks is equal to to the maximum index mapping number in
 //     calculator options (calculator verifies that there are no gaps in the
 //     mapping).
@@ -70,9 +72,11 @@ namespace api2 {
 //
 class LandmarksRefinementCalculator : public NodeIntf {
  public:
-  static constexpr Input<::mediapipe::NormalizedLandmarkList>::Multiple
+  static constexpr Input<OneOf<::mediapipe::NormalizedLandmarkList,
+                                ::mediapipe::LandmarkArray>>::Multiple
       kLandmarks{"LANDMARKS"};
-  static constexpr Output<::mediapipe::NormalizedLandmarkList>
+  static constexpr Output<OneOf<::mediapipe::NormalizedLandmarkList,
+                                ::mediapipe::LandmarkArray>>
       kRefinedLandmarks{"REFINED_LANDMARKS"};
 
   MEDIAPIPE_NODE_INTERFACE(LandmarksRefinementCalculator, kLandmarks,
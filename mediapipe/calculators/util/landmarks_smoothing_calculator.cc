@@ -15,12 +15,15 @@
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator.h"
 
 #include <memory>
+#include <utility>
 
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator.pb.h"
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator_utils.h"
 #include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/packet.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/timestamp.h"
 
@@ -64,8 +67,6 @@ class LandmarksSmoothingCalculatorImpl
         absl::Microseconds(cc->InputTimestamp().Microseconds());
 
     if (kInNormLandmarks(cc).IsConnected()) {
-      const auto& in_norm_landmarks = kInNormLandmarks(cc).Get();
-
       int image_width;
       int image_height;
       std::tie(image_width, image_height) = kImageSize(cc).Get();
@@ -76,6 +77,31 @@ class LandmarksSmoothingCalculatorImpl
         object_scale = GetObjectScale(roi, image_width, image_height);
       }
 
+      if (kInNormLandmarks(cc).Has<LandmarkArray>()) {
+        const auto& in_norm_landmarks =
+            kInNormLandmarks(cc).Get<LandmarkArray>();
+
+        LandmarkArray in_landmarks;
+        NormalizedLandmarksToLandmarks(in_norm_landmarks, image_width,
+                                       image_height, in_landmarks);
+
+        LandmarkArray out_landmarks;
+        MP_RETURN_IF_ERROR(landmarks_filter_->Apply(
+            in_landmarks, timestamp, object_scale, out_landmarks));
+
+        LandmarkArray out_norm_landmarks;
+        LandmarksToNormalizedLandmarks(out_landmarks, image_width,
+                                       image_height, out_norm_landmarks);
+
+        kOutNormLandmarks(cc).Send(
+            MakePacket<LandmarkArray>(std::move(out_norm_landmarks))
+                .At(cc->InputTimestamp()));
+        return absl::OkStatus();
+      }
+
+      const auto& in_norm_landmarks =
+          kInNormLandmarks(cc).Get<NormalizedLandmarkList>();
+
       auto in_landmarks = absl::make_unique<LandmarkList>();
       NormalizedLandmarksToLandmarks(in_norm_landmarks, image_width,
                                      image_height, *in_landmarks.get());
@@ -88,21 +114,35 @@ class LandmarksSmoothingCalculatorImpl
       LandmarksToNormalizedLandmarks(*out_landmarks, image_width, image_height,
                                      *out_norm_landmarks.get());
 
-      kOutNormLandmarks(cc).Send(std::move(out_norm_landmarks));
+      kOutNormLandmarks(cc).Send(PacketAdopting(std::move(out_norm_landmarks))
+                                     .At(cc->InputTimestamp()));
     } else {
-      const auto& in_landmarks = kInLandmarks(cc).Get();
-
       absl::optional<float> object_scale;
       if (kObjectScaleRoi(cc).IsConnected() && !kObjectScaleRoi(cc).IsEmpty()) {
         auto& roi = kObjectScaleRoi(cc).Get<Rect>();
         object_scale = GetObjectScale(roi);
       }
 
+      if (kInLandmarks(cc).Has<LandmarkArray>()) {
+        LandmarkArray out_landmarks;
+        MP_RETURN_IF_ERROR(landmarks_filter_->Apply(
+            kInLandmarks(cc).Get<LandmarkArray>(), timestamp, object_scale,
+            out_landmarks));
+
+        kOutLandmarks(cc).Send(
+            MakePacket<LandmarkArray>(std::move(out_landmarks))
+                .At(cc->InputTimestamp()));
+        return absl::OkStatus();
+      }
+
+      const auto& in_landmarks = kInLandmarks(cc).Get<LandmarkList>();
+
       auto out_landmarks = absl::make_unique<LandmarkList>();
       MP_RETURN_IF_ERROR(landmarks_filter_->Apply(
           in_landmarks, timestamp, object_scale, *out_landmarks));
 
-      kOutLandmarks(cc).Send(std::move(out_landmarks));
+      kOutLandmarks(cc).Send(
+          PacketAdopting(std::move(out_landmarks)).At(cc->InputTimestamp()));
     }
 
     return absl::OkStatus();
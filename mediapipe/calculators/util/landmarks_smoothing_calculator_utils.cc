@@ -14,24 +14,29 @@
 
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator_utils.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator.pb.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
-#include "mediapipe/util/filtering/one_euro_filter.h"
-#include "mediapipe/util/filtering/relative_velocity_filter.h"
+#include "mediapipe/util/filtering/batch_one_euro_filter.h"
+#include "mediapipe/util/filtering/batch_relative_velocity_filter.h"
 
 namespace mediapipe {
 namespace landmarks_smoothing {
 
 namespace {
 
+using ::mediapipe::BatchOneEuroFilter;
+using ::mediapipe::BatchRelativeVelocityFilter;
 using ::mediapipe::NormalizedRect;
-using ::mediapipe::OneEuroFilter;
 using ::mediapipe::Rect;
-using ::mediapipe::RelativeVelocityFilter;
 
 // Estimate object scale to use its inverse value as velocity scale for
 // RelativeVelocityFilter. If value will be too small (less than
@@ -58,6 +63,24 @@ float GetObjectScale(const LandmarkList& landmarks) {
   return (object_width + object_height) / 2.0f;
 }
 
+float GetObjectScale(const LandmarkArray& landmarks) {
+  const auto x_minmax = std::minmax_element(landmarks.x().begin(),
+                                            landmarks.x().end());
+  const auto y_minmax = std::minmax_element(landmarks.y().begin(),
+                                            landmarks.y().end());
+
+  const float object_width = *x_minmax.second - *x_minmax.first;
+  const float object_height = *y_minmax.second - *y_minmax.first;
+
+  return (object_width + object_height) / 2.0f;
+}
+
+int GetNumLandmarks(const LandmarkList& landmarks) {
+  return landmarks.landmark_size();
+}
+
+int GetNumLandmarks(const LandmarkArray& landmarks) { return landmarks.size(); }
+
 // Returns landmarks as is without smoothing.
 class NoFilter : public LandmarksFilter {
  public:
@@ -68,8 +91,75 @@ class NoFilter : public LandmarksFilter {
     out_landmarks = in_landmarks;
     return absl::OkStatus();
   }
+
+  absl::Status Apply(const LandmarkArray& in_landmarks,
+                     const absl::Duration& timestamp,
+                     const absl::optional<float> object_scale_opt,
+                     LandmarkArray& out_landmarks) override {
+    out_landmarks = in_landmarks;
+    return absl::OkStatus();
+  }
 };
 
+// Copies landmark coordinates into `coordinates` as three planes: all x, all
+// y, then all z coordinates.
+void LandmarksToCoordinates(const LandmarkList& landmarks,
+                            std::vector<float>& coordinates) {
+  const int n_landmarks = landmarks.landmark_size();
+  coordinates.resize(3 * n_landmarks);
+  float* x = coordinates.data();
+  float* y = x + n_landmarks;
+  float* z = y + n_landmarks;
+  for (int i = 0; i < n_landmarks; ++i) {
+    const auto& landmark = landmarks.landmark(i);
+    x[i] = landmark.x();
+    y[i] = landmark.y();
+    z[i] = landmark.z();
+  }
+}
+
+// Outputs `in_landmarks` with coordinates replaced by the filtered
+// `coordinates`.
+void CoordinatesToLandmarks(const std::vector<float>& coordinates,
+                            const LandmarkList& in_landmarks,
+                            LandmarkList& out_landmarks) {
+  const int n_landmarks = in_landmarks.landmark_size();
+  const float* x = coordinates.data();
+  const float* y = x + n_landmarks;
+  const float* z = y + n_landmarks;
+  for (int i = 0; i < n_landmarks; ++i) {
+    auto* out_landmark = out_landmarks.add_landmark();
+    *out_landmark = in_landmarks.landmark(i);
+    out_landmark->set_x(x[i]);
+    out_landmark->set_y(y[i]);
+    out_landmark->set_z(z[i]);
+  }
+}
+
+// Filters the x, y and z coordinates of all landmarks in one pass over
+// contiguous coordinates. `coordinates` is a scratch buffer.
+template <typename BatchFilterT, typename ValueScaleT>
+void FilterCoordinates(const LandmarkList& in_landmarks,
+                       const absl::Duration& timestamp, ValueScaleT value_scale,
+                       BatchFilterT& filter, std::vector<float>& coordinates,
+                       LandmarkList& out_landmarks) {
+  LandmarksToCoordinates(in_landmarks, coordinates);
+  filter.Apply(timestamp, value_scale, absl::MakeSpan(coordinates));
+  CoordinatesToLandmarks(coordinates, in_landmarks, out_landmarks);
+}
+
+// Landmark arrays already store coordinates as planes, so they are filtered in
+// place.
+template <typename BatchFilterT, typename ValueScaleT>
+void FilterCoordinates(const LandmarkArray& in_landmarks,
+                       const absl::Duration& timestamp, ValueScaleT value_scale,
+                       BatchFilterT& filter,
+                       std::vector<float>& /*coordinates*/,
+                       LandmarkArray& out_landmarks) {
+  out_landmarks = in_landmarks;
+  filter.Apply(timestamp, value_scale, out_landmarks.coordinates());
+}
+
 // Please check RelativeVelocityFilter documentation for details.
 class VelocityFilter : public LandmarksFilter {
  public:
@@ -81,9 +171,7 @@ class VelocityFilter : public LandmarksFilter {
         disable_value_scaling_(disable_value_scaling) {}
 
   absl::Status Reset() override {
-    x_filters_.clear();
-    y_filters_.clear();
-    z_filters_.clear();
+    filter_ = nullptr;
     return absl::OkStatus();
   }
 
@@ -91,6 +179,24 @@ class VelocityFilter : public LandmarksFilter {
                      const absl::Duration& timestamp,
                      const absl::optional<float> object_scale_opt,
                      LandmarkList& out_landmarks) override {
+    return ApplyFilter(in_landmarks, timestamp, object_scale_opt,
+                       out_landmarks);
+  }
+
+  absl::Status Apply(const LandmarkArray& in_landmarks,
+                     const absl::Duration& timestamp,
+                     const absl::optional<float> object_scale_opt,
+                     LandmarkArray& out_landmarks) override {
+    return ApplyFilter(in_landmarks, timestamp, object_scale_opt,
+                       out_landmarks);
+  }
+
+ private:
+  template <typename LandmarksT>
+  absl::Status ApplyFilter(const LandmarksT& in_landmarks,
+                           const absl::Duration& timestamp,
+                           const absl::optional<float> object_scale_opt,
+                           LandmarksT& out_landmarks) {
     // Get value scale as inverse value of the object scale.
     // If value is too small smoothing will be disabled and landmarks will be
     // returned as is.
@@ -106,42 +212,26 @@ class VelocityFilter : public LandmarksFilter {
     }
 
     // Initialize filters once.
-    MP_RETURN_IF_ERROR(InitializeFiltersIfEmpty(in_landmarks.landmark_size()));
+    MP_RETURN_IF_ERROR(
+        InitializeFiltersIfEmpty(GetNumLandmarks(in_landmarks)));
 
     // Filter landmarks. Every axis of every landmark is filtered separately.
-    for (int i = 0; i < in_landmarks.landmark_size(); ++i) {
-      const auto& in_landmark = in_landmarks.landmark(i);
-
-      auto* out_landmark = out_landmarks.add_landmark();
-      *out_landmark = in_landmark;
-      out_landmark->set_x(
-          x_filters_[i].Apply(timestamp, value_scale, in_landmark.x()));
-      out_landmark->set_y(
-          y_filters_[i].Apply(timestamp, value_scale, in_landmark.y()));
-      out_landmark->set_z(
-          z_filters_[i].Apply(timestamp, value_scale, in_landmark.z()));
-    }
+    FilterCoordinates(in_landmarks, timestamp, value_scale, *filter_,
+                      coordinates_, out_landmarks);
 
     return absl::OkStatus();
   }
 
- private:
   // Initializes filters for the first time or after Reset. If initialized then
   // check the size.
   absl::Status InitializeFiltersIfEmpty(const int n_landmarks) {
-    if (!x_filters_.empty()) {
-      RET_CHECK_EQ(x_filters_.size(), n_landmarks);
-      RET_CHECK_EQ(y_filters_.size(), n_landmarks);
-      RET_CHECK_EQ(z_filters_.size(), n_landmarks);
+    if (filter_ && filter_->size() > 0) {
+      RET_CHECK_EQ(filter_->size(), 3 * n_landmarks);
       return absl::OkStatus();
     }
 
-    x_filters_.resize(n_landmarks,
-                      RelativeVelocityFilter(window_size_, velocity_scale_));
-    y_filters_.resize(n_landmarks,
-                      RelativeVelocityFilter(window_size_, velocity_scale_));
-    z_filters_.resize(n_landmarks,
-                      RelativeVelocityFilter(window_size_, velocity_scale_));
+    filter_ = std::make_unique<BatchRelativeVelocityFilter>(
+        3 * n_landmarks, window_size_, velocity_scale_);
 
     return absl::OkStatus();
   }
@@ -151,9 +241,10 @@ class VelocityFilter : public LandmarksFilter {
   float min_allowed_object_scale_;
   bool disable_value_scaling_;
 
-  std::vector<RelativeVelocityFilter> x_filters_;
-  std::vector<RelativeVelocityFilter> y_filters_;
-  std::vector<RelativeVelocityFilter> z_filters_;
+  // Filters the x, y and z coordinates of all landmarks.
+  std::unique_ptr<BatchRelativeVelocityFilter> filter_;
+  // Scratch buffer for the coordinates of landmark lists.
+  std::vector<float> coordinates_;
 };
 
 // Please check OneEuroFilter documentation for details.
@@ -170,9 +261,7 @@ class OneEuroFilterImpl : public LandmarksFilter {
         disable_value_scaling_(disable_value_scaling) {}
 
   absl::Status Reset() override {
-    x_filters_.clear();
-    y_filters_.clear();
-    z_filters_.clear();
+    filter_ = nullptr;
     return absl::OkStatus();
   }
 
@@ -180,8 +269,27 @@ class OneEuroFilterImpl : public LandmarksFilter {
                      const absl::Duration& timestamp,
                      const absl::optional<float> object_scale_opt,
                      LandmarkList& out_landmarks) override {
+    return ApplyFilter(in_landmarks, timestamp, object_scale_opt,
+                       out_landmarks);
+  }
+
+  absl::Status Apply(const LandmarkArray& in_landmarks,
+                     const absl::Duration& timestamp,
+                     const absl::optional<float> object_scale_opt,
+                     LandmarkArray& out_landmarks) override {
+    return ApplyFilter(in_landmarks, timestamp, object_scale_opt,
+                       out_landmarks);
+  }
+
+ private:
+  template <typename LandmarksT>
+  absl::Status ApplyFilter(const LandmarksT& in_landmarks,
+                           const absl::Duration& timestamp,
+                           const absl::optional<float> object_scale_opt,
+                           LandmarksT& out_landmarks) {
     // Initialize filters once.
-    MP_RETURN_IF_ERROR(InitializeFiltersIfEmpty(in_landmarks.landmark_size()));
+    MP_RETURN_IF_ERROR(
+        InitializeFiltersIfEmpty(GetNumLandmarks(in_landmarks)));
 
     // Get value scale as inverse value of the object scale.
     // If value is too small smoothing will be disabled and landmarks will be
@@ -198,41 +306,22 @@ class OneEuroFilterImpl : public LandmarksFilter {
     }
 
     // Filter landmarks. Every axis of every landmark is filtered separately.
-    for (int i = 0; i < in_landmarks.landmark_size(); ++i) {
-      const auto& in_landmark = in_landmarks.landmark(i);
-
-      auto* out_landmark = out_landmarks.add_landmark();
-      *out_landmark = in_landmark;
-      out_landmark->set_x(
-          x_filters_[i].Apply(timestamp, value_scale, in_landmark.x()));
-      out_landmark->set_y(
-          y_filters_[i].Apply(timestamp, value_scale, in_landmark.y()));
-      out_landmark->set_z(
-          z_filters_[i].Apply(timestamp, value_scale, in_landmark.z()));
-    }
+    FilterCoordinates(in_landmarks, timestamp, value_scale, *filter_,
+                      coordinates_, out_landmarks);
 
     return absl::OkStatus();
   }
 
- private:
   // Initializes filters for the first time or after Reset. If initialized then
   // check the size.
   absl::Status InitializeFiltersIfEmpty(const int n_landmarks) {
-    if (!x_filters_.empty()) {
-      RET_CHECK_EQ(x_filters_.size(), n_landmarks);
-      RET_CHECK_EQ(y_filters_.size(), n_landmarks);
-      RET_CHECK_EQ(z_filters_.size(), n_landmarks);
+    if (filter_ && filter_->size() > 0) {
+      RET_CHECK_EQ(filter_->size(), 3 * n_landmarks);
       return absl::OkStatus();
     }
 
-    for (int i = 0; i < n_landmarks; ++i) {
-      x_filters_.push_back(
-          OneEuroFilter(frequency_, min_cutoff_, beta_, derivate_cutoff_));
-      y_filters_.push_back(
-          OneEuroFilter(frequency_, min_cutoff_, beta_, derivate_cutoff_));
-      z_filters_.push_back(
-          OneEuroFilter(frequency_, min_cutoff_, beta_, derivate_cutoff_));
-    }
+    filter_ = std::make_unique<BatchOneEuroFilter>(
+        3 * n_landmarks, frequency_, min_cutoff_, beta_, derivate_cutoff_);
 
     return absl::OkStatus();
   }
@@ -244,9 +333,10 @@ class OneEuroFilterImpl : public LandmarksFilter {
   double min_allowed_object_scale_;
   bool disable_value_scaling_;
 
-  std::vector<OneEuroFilter> x_filters_;
-  std::vector<OneEuroFilter> y_filters_;
-  std::vector<OneEuroFilter> z_filters_;
+  // Filters the x, y and z coordinates of all landmarks.
+  std::unique_ptr<BatchOneEuroFilter> filter_;
+  // Scratch buffer for the coordinates of landmark lists.
+  std::vector<float> coordinates_;
 };
 
 }  // namespace
@@ -304,6 +394,28 @@ void LandmarksToNormalizedLandmarks(const LandmarkList& landmarks,
   }
 }
 
+void NormalizedLandmarksToLandmarks(const LandmarkArray& norm_landmarks,
+                                    const int image_width,
+                                    const int image_height,
+                                    LandmarkArray& landmarks) {
+  landmarks = norm_landmarks;
+  for (float& x : landmarks.x()) x *= image_width;
+  for (float& y : landmarks.y()) y *= image_height;
+  // Scale Z the same way as X (using image width).
+  for (float& z : landmarks.z()) z *= image_width;
+}
+
+void LandmarksToNormalizedLandmarks(const LandmarkArray& landmarks,
+                                    const int image_width,
+                                    const int image_height,
+                                    LandmarkArray& norm_landmarks) {
+  norm_landmarks = landmarks;
+  for (float& x : norm_landmarks.x()) x /= image_width;
+  for (float& y : norm_landmarks.y()) y /= image_height;
+  // Scale Z the same way as X (using image width).
+  for (float& z : norm_landmarks.z()) z /= image_width;
+}
+
 float GetObjectScale(const NormalizedRect& roi, const int image_width,
                      const int image_height) {
   const float object_width = roi.width() * image_width;
@@ -18,6 +18,7 @@
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/util/filtering/one_euro_filter.h"
 #include "mediapipe/util/filtering/relative_velocity_filter.h"
@@ -34,6 +35,17 @@ void LandmarksToNormalizedLandmarks(
     const mediapipe::LandmarkList& landmarks, const int image_width,
     const int image_height, mediapipe::NormalizedLandmarkList& norm_landmarks);
 
+// Same as above for landmark arrays.
+void NormalizedLandmarksToLandmarks(const LandmarkArray& norm_landmarks,
+                                    const int image_width,
+                                    const int image_height,
+                                    LandmarkArray& landmarks);
+
+void LandmarksToNormalizedLandmarks(const LandmarkArray& landmarks,
+                                    const int image_width,
+                                    const int image_height,
+                                    LandmarkArray& norm_landmarks);
+
 float GetObjectScale(const NormalizedRect& roi, const int image_width,
                      const int image_height);
 
@@ -50,6 +62,13 @@ class LandmarksFilter {
                              const absl::Duration& timestamp,
                              const absl::optional<float> object_scale_opt,
                              mediapipe::LandmarkList& out_landmarks) = 0;
+
+  // Same as above for landmark arrays. Coordinates are filtered in place in
+  // `out_landmarks`, without converting them to and from protos.
+  virtual absl::Status Apply(const LandmarkArray& in_landmarks,
+                             const absl::Duration& timestamp,
+                             const absl::optional<float> object_scale_opt,
+                             LandmarkArray& out_landmarks) = 0;
 };
 
 absl::StatusOr<std::unique_ptr<LandmarksFilter>> InitializeLandmarksFilter(
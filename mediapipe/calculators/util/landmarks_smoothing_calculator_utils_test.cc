@@ -15,9 +15,18 @@ limitations under the License.
 
 #include "mediapipe/calculators/util/landmarks_smoothing_calculator_utils.h"
 
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "mediapipe/calculators/util/landmarks_smoothing_calculator.pb.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/filtering/one_euro_filter.h"
+#include "mediapipe/util/filtering/relative_velocity_filter.h"
 
 namespace mediapipe {
 namespace landmarks_smoothing {
@@ -113,6 +122,137 @@ TEST(LandmarksSmoothingCalculatorUtilsTest,
   EXPECT_FALSE(norm_landmark.has_presence());
 }
 
+TEST(LandmarksSmoothingCalculatorUtilsTest,
+     OneEuroFilterMatchesPerCoordinateFilters) {
+  LandmarksSmoothingCalculatorOptions options;
+  auto* one_euro_options = options.mutable_one_euro_filter();
+  one_euro_options->set_min_cutoff(0.05);
+  one_euro_options->set_beta(80.0);
+  one_euro_options->set_disable_value_scaling(true);
+  MP_ASSERT_OK_AND_ASSIGN(auto filter, InitializeLandmarksFilter(options));
+
+  constexpr int kNumLandmarks = 3;
+  std::vector<OneEuroFilter> coordinate_filters;
+  for (int i = 0; i < 3 * kNumLandmarks; ++i) {
+    coordinate_filters.emplace_back(
+        one_euro_options->frequency(), one_euro_options->min_cutoff(),
+        one_euro_options->beta(), one_euro_options->derivate_cutoff());
+  }
+
+  for (int t = 0; t < 5; ++t) {
+    const absl::Duration timestamp = absl::Milliseconds(33 * t);
+    LandmarkList in_landmarks;
+    for (int i = 0; i < kNumLandmarks; ++i) {
+      Landmark* landmark = in_landmarks.add_landmark();
+      landmark->set_x(i + 0.1f * t * t);
+      landmark->set_y(i - 0.2f * t);
+      landmark->set_z(0.05f * t * i);
+      landmark->set_visibility(0.5);
+    }
+    LandmarkList out_landmarks;
+    MP_ASSERT_OK(filter->Apply(in_landmarks, timestamp,
+                               /*object_scale_opt=*/absl::nullopt,
+                               out_landmarks));
+
+    ASSERT_EQ(out_landmarks.landmark_size(), kNumLandmarks);
+    for (int i = 0; i < kNumLandmarks; ++i) {
+      const Landmark& in_landmark = in_landmarks.landmark(i);
+      const Landmark& out_landmark = out_landmarks.landmark(i);
+      EXPECT_FLOAT_EQ(out_landmark.x(), coordinate_filters[3 * i].Apply(
+                                            timestamp, 1.0, in_landmark.x()));
+      EXPECT_FLOAT_EQ(
+          out_landmark.y(),
+          coordinate_filters[3 * i + 1].Apply(timestamp, 1.0, in_landmark.y()));
+      EXPECT_FLOAT_EQ(
+          out_landmark.z(),
+          coordinate_filters[3 * i + 2].Apply(timestamp, 1.0, in_landmark.z()));
+      EXPECT_FLOAT_EQ(out_landmark.visibility(), 0.5);
+    }
+  }
+}
+
+TEST(LandmarksSmoothingCalculatorUtilsTest,
+     VelocityFilterMatchesPerCoordinateFilters) {
+  LandmarksSmoothingCalculatorOptions options;
+  auto* velocity_options = options.mutable_velocity_filter();
+  velocity_options->set_window_size(3);
+  velocity_options->set_velocity_scale(10.0);
+  MP_ASSERT_OK_AND_ASSIGN(auto filter, InitializeLandmarksFilter(options));
+
+  constexpr int kNumLandmarks = 3;
+  std::vector<RelativeVelocityFilter> coordinate_filters(
+      3 * kNumLandmarks,
+      RelativeVelocityFilter(velocity_options->window_size(),
+                             velocity_options->velocity_scale()));
+
+  for (int t = 0; t < 5; ++t) {
+    const absl::Duration timestamp = absl::Milliseconds(33 * t);
+    LandmarkList in_landmarks;
+    for (int i = 0; i < kNumLandmarks; ++i) {
+      Landmark* landmark = in_landmarks.add_landmark();
+      landmark->set_x(10 * i + t * t);
+      landmark->set_y(10 * i - 2 * t);
+      landmark->set_z(0.5f * t * i);
+    }
+    const float object_scale = 20.0f + t;
+    LandmarkList out_landmarks;
+    MP_ASSERT_OK(
+        filter->Apply(in_landmarks, timestamp, object_scale, out_landmarks));
+
+    ASSERT_EQ(out_landmarks.landmark_size(), kNumLandmarks);
+    const float value_scale = 1.0f / object_scale;
+    for (int i = 0; i < kNumLandmarks; ++i) {
+      const Landmark& in_landmark = in_landmarks.landmark(i);
+      const Landmark& out_landmark = out_landmarks.landmark(i);
+      EXPECT_FLOAT_EQ(out_landmark.x(),
+                      coordinate_filters[3 * i].Apply(timestamp, value_scale,
+                                                      in_landmark.x()));
+      EXPECT_FLOAT_EQ(out_landmark.y(),
+                      coordinate_filters[3 * i + 1].Apply(
+                          timestamp, value_scale, in_landmark.y()));
+      EXPECT_FLOAT_EQ(out_landmark.z(),
+                      coordinate_filters[3 * i + 2].Apply(
+                          timestamp, value_scale, in_landmark.z()));
+    }
+  }
+}
+
+TEST(LandmarksSmoothingCalculatorUtilsTest,
+     LandmarkArrayIsFilteredAsLandmarkList) {
+  LandmarksSmoothingCalculatorOptions options;
+  options.mutable_velocity_filter()->set_window_size(3);
+  options.mutable_velocity_filter()->set_velocity_scale(10.0);
+  MP_ASSERT_OK_AND_ASSIGN(auto list_filter,
+                          InitializeLandmarksFilter(options));
+  MP_ASSERT_OK_AND_ASSIGN(auto array_filter,
+                          InitializeLandmarksFilter(options));
+
+  for (int t = 0; t < 5; ++t) {
+    const absl::Duration timestamp = absl::Milliseconds(33 * t);
+    LandmarkList in_landmarks;
+    for (int i = 0; i < 3; ++i) {
+      Landmark* landmark = in_landmarks.add_landmark();
+      landmark->set_x(10 * i + t * t);
+      landmark->set_y(10 * i - 2 * t);
+      landmark->set_z(0.5f * t * i);
+      landmark->set_presence(0.5f);
+    }
+
+    LandmarkList out_landmarks;
+    MP_ASSERT_OK(list_filter->Apply(in_landmarks, timestamp,
+                                    /*object_scale_opt=*/absl::nullopt,
+                                    out_landmarks));
+    LandmarkArray out_array;
+    MP_ASSERT_OK(array_filter->Apply(ToLandmarkArray(in_landmarks), timestamp,
+                                     /*object_scale_opt=*/absl::nullopt,
+                                     out_array));
+
+    const LandmarkList out_array_landmarks = ToLandmarkList(out_array);
+    EXPECT_EQ(out_array_landmarks.SerializeAsString(),
+              out_landmarks.SerializeAsString());
+  }
+}
+
 }  // namespace
 }  // namespace landmarks_smoothing
 }  // namespace mediapipe
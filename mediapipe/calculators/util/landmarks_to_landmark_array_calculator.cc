@@ -0,0 +1,72 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/landmark_array.h"
+
+namespace mediapipe {
+namespace api2 {
+
+// Converts a NormalizedLandmarkList or LandmarkList to a LandmarkArray.
+//
+// Calculators that transform landmark coordinates (e.g.
+// LandmarkProjectionCalculator, LandmarkLetterboxRemovalCalculator,
+// LandmarksRefinementCalculator and LandmarksSmoothingCalculator) accept
+// LandmarkArray in place of the landmark protos. Use this calculator where
+// landmarks enter a chain of such calculators and
+// LandmarkArrayToLandmarksCalculator where they leave it.
+//
+// Inputs:
+//   LANDMARKS: A NormalizedLandmarkList or LandmarkList.
+//
+// Outputs:
+//   LANDMARK_ARRAY: A LandmarkArray with the same landmarks.
+//
+// Example config:
+//   node {
+//     calculator: "LandmarksToLandmarkArrayCalculator"
+//     input_stream: "LANDMARKS:landmarks"
+//     output_stream: "LANDMARK_ARRAY:landmark_array"
+//   }
+class LandmarksToLandmarkArrayCalculator : public Node {
+ public:
+  static constexpr Input<OneOf<NormalizedLandmarkList, LandmarkList>>
+      kInLandmarks{"LANDMARKS"};
+  static constexpr Output<LandmarkArray> kOutLandmarkArray{"LANDMARK_ARRAY"};
+
+  MEDIAPIPE_NODE_CONTRACT(kInLandmarks, kOutLandmarkArray);
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (kInLandmarks(cc).IsEmpty()) {
+      return absl::OkStatus();
+    }
+    kOutLandmarkArray(cc).Send(kInLandmarks(cc).Visit(
+        [](const auto& landmarks) { return ToLandmarkArray(landmarks); }));
+    return absl::OkStatus();
+  }
+};
+MEDIAPIPE_REGISTER_NODE(LandmarksToLandmarkArrayCalculator);
+
+}  // namespace api2
+}  // namespace mediapipe
@@ -0,0 +1,400 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
+#include "mediapipe/calculators/video/prefetching_video_decoder_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/counter.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_buffer_pool.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/image_frame_buffer_pool_service.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/tool/status_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kVideoPrestreamTag[] = "VIDEO_PRESTREAM";
+constexpr char kVideoTag[] = "VIDEO";
+constexpr char kInputFilePathTag[] = "INPUT_FILE_PATH";
+constexpr char kSeeksCounter[] = "PrefetchingVideoDecoderCalculator-Seeks";
+
+ImageFormat::Format GetImageFormat(int num_channels) {
+  switch (num_channels) {
+    case 1:
+      return ImageFormat::GRAY8;
+    case 3:
+      return ImageFormat::SRGB;
+    case 4:
+      return ImageFormat::SRGBA;
+    default:
+      return ImageFormat::UNKNOWN;
+  }
+}
+
+// Tells which frames a PacketResamplerCalculator with the given options may
+// output, i.e. the frames closest to its output timestamps, assuming that
+// frames come at a constant input frame rate.
+class FrameSelector {
+ public:
+  FrameSelector(const PacketResamplerCalculatorOptions& options,
+                double input_frame_rate)
+      : resample_(options.frame_rate() > 0 && options.jitter() == 0 &&
+                  !options.use_input_frame_rate()),
+        period_us_(resample_ ? 1e6 / options.frame_rate() : 0),
+        half_input_period_us_(input_frame_rate > 0 ? 5e5 / input_frame_rate
+                                                   : 0),
+        base_us_(options.has_base_timestamp()
+                     ? std::optional<int64_t>(options.base_timestamp())
+                     : std::nullopt),
+        // The resampler keeps up to one period of input around its limits.
+        start_us_(options.has_start_time()
+                      ? options.start_time() - static_cast<int64_t>(period_us_)
+                      : std::numeric_limits<int64_t>::min()),
+        end_us_(options.has_end_time()
+                    ? options.end_time() + static_cast<int64_t>(period_us_)
+                    : std::numeric_limits<int64_t>::max()) {}
+
+  bool IsPastEnd(int64_t timestamp_us) const { return timestamp_us > end_us_; }
+
+  // Returns whether the frame at `timestamp_us` is needed. Must be called for
+  // increasing timestamps.
+  bool IsNeeded(int64_t timestamp_us) {
+    if (timestamp_us < start_us_) return false;
+    if (!resample_) return true;
+    const double frame_us = timestamp_us + half_input_period_us_;
+    if (!std::isfinite(next_slot_us_)) {
+      // Output timestamps are aligned with the base timestamp, or else with
+      // the first frame.
+      next_slot_us_ =
+          base_us_.has_value()
+              ? *base_us_ + std::ceil((timestamp_us - half_input_period_us_ -
+                                       *base_us_) /
+                                      period_us_) *
+                                period_us_
+              : timestamp_us;
+    }
+    if (frame_us < next_slot_us_) return false;
+    while (next_slot_us_ <= frame_us) next_slot_us_ += period_us_;
+    return true;
+  }
+
+  // Returns the earliest timestamp of the next needed frame.
+  int64_t NextNeeded() const {
+    if (!resample_ || !std::isfinite(next_slot_us_)) return start_us_;
+    return static_cast<int64_t>(next_slot_us_ - half_input_period_us_);
+  }
+
+  // Returns how far past the needed frame at `timestamp_us` the next needed
+  // frame is, or 0 if it may be the very next frame.
+  int64_t GapAfter(int64_t timestamp_us) const {
+    if (!resample_ || !std::isfinite(next_slot_us_)) return 0;
+    const int64_t next_us = NextNeeded();
+    return next_us > timestamp_us ? next_us - timestamp_us : 0;
+  }
+
+ private:
+  const bool resample_;
+  const double period_us_;
+  const double half_input_period_us_;
+  const std::optional<int64_t> base_us_;
+  const int64_t start_us_;
+  const int64_t end_us_;
+  double next_slot_us_ = -std::numeric_limits<double>::infinity();
+};
+
+}  // namespace
+
+// Decodes a video file like OpenCvVideoDecoderCalculator, but on a separate
+// thread that decodes up to `prefetch_queue_size` frames ahead of the graph.
+//
+// If the frames feed a PacketResamplerCalculator, set its options in
+// `resampler_options` to skip the frames it would drop: they are demuxed and
+// decoded, as video codecs need them to decode the following frames, but are
+// neither color converted nor copied. Gaps of at least `min_seek_gap_us`
+// between needed frames, as well as the part of the video before the
+// resampler's start_time, are skipped by seeking, which restarts decoding
+// from the preceding keyframe.
+//
+// Output frames come from the graph's frame pool (see
+// CalculatorContext::AllocateImageFrame).
+//
+// Input Side Packets:
+//   INPUT_FILE_PATH: The input file path.
+//
+// Output Streams:
+//   VIDEO: Output video frames (ImageFrame).
+//   VIDEO_PRESTREAM:
+//       Optional video header information output at
+//       Timestamp::PreStream() for the corresponding stream.
+//
+// Example config:
+// node {
+//   calculator: "PrefetchingVideoDecoderCalculator"
+//   input_side_packet: "INPUT_FILE_PATH:input_file_path"
+//   output_stream: "VIDEO:video_frames"
+//   output_stream: "VIDEO_PRESTREAM:video_header"
+//   options {
+//     [mediapipe.PrefetchingVideoDecoderCalculatorOptions.ext] {
+//       resampler_options { frame_rate: 5 }
+//     }
+//   }
+// }
+// node {
+//   calculator: "PacketResamplerCalculator"
+//   input_stream: "DATA:video_frames"
+//   input_stream: "VIDEO_HEADER:video_header"
+//   output_stream: "DATA:sampled_frames"
+//   output_stream: "VIDEO_HEADER:sampled_header"
+//   options {
+//     [mediapipe.PacketResamplerCalculatorOptions.ext] { frame_rate: 5 }
+//   }
+// }
+class PrefetchingVideoDecoderCalculator : public CalculatorBase {
+ public:
+  ~PrefetchingVideoDecoderCalculator() override { StopDecoding(); }
+
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->InputSidePackets().Tag(kInputFilePathTag).Set<std::string>();
+    cc->Outputs().Tag(kVideoTag).Set<ImageFrame>();
+    if (cc->Outputs().HasTag(kVideoPrestreamTag)) {
+      cc->Outputs().Tag(kVideoPrestreamTag).Set<VideoHeader>();
+    }
+    cc->UseService(kImageFrameBufferPoolService).Optional();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    const auto& options =
+        cc->Options<PrefetchingVideoDecoderCalculatorOptions>();
+    RET_CHECK_GT(options.prefetch_queue_size(), 0);
+    prefetch_queue_size_ = options.prefetch_queue_size();
+    min_seek_gap_us_ = options.min_seek_gap_us();
+    seeks_counter_ = cc->GetCounter(kSeeksCounter);
+
+    const std::string& input_file_path =
+        cc->InputSidePackets().Tag(kInputFilePathTag).Get<std::string>();
+    cap_ = std::make_unique<cv::VideoCapture>(input_file_path);
+    if (!cap_->isOpened()) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Fail to open video file at " << input_file_path;
+    }
+    const int width = static_cast<int>(cap_->get(cv::CAP_PROP_FRAME_WIDTH));
+    const int height = static_cast<int>(cap_->get(cv::CAP_PROP_FRAME_HEIGHT));
+    const double fps = cap_->get(cv::CAP_PROP_FPS);
+    const int frame_count =
+        static_cast<int>(cap_->get(cv::CAP_PROP_FRAME_COUNT));
+    // cv::CAP_PROP_FORMAT is unreliable, so the first frame tells the number
+    // of channels.
+    cv::Mat frame;
+    if (!ReadFrame(frame)) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Fail to read any frames from the video file at "
+             << input_file_path;
+    }
+    format_ = GetImageFormat(frame.channels());
+    if (format_ == ImageFormat::UNKNOWN) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Unsupported video format of the video file at "
+             << input_file_path;
+    }
+    if (fps <= 0 || frame_count <= 0 || width <= 0 || height <= 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Fail to make video header due to the incorrect metadata from "
+                "the video file at "
+             << input_file_path;
+    }
+    if (cc->Outputs().HasTag(kVideoPrestreamTag)) {
+      auto header = std::make_unique<VideoHeader>();
+      header->format = format_;
+      header->width = width;
+      header->height = height;
+      header->frame_rate = fps;
+      header->duration = frame_count / fps;
+      cc->Outputs()
+          .Tag(kVideoPrestreamTag)
+          .Add(header.release(), Timestamp::PreStream());
+      cc->Outputs().Tag(kVideoPrestreamTag).Close();
+    }
+    // Rewind to the very first frame.
+    cap_->set(cv::CAP_PROP_POS_AVI_RATIO, 0);
+
+    auto pool_service = cc->Service(kImageFrameBufferPoolService);
+    if (pool_service.IsAvailable()) {
+      frame_pool_ = &pool_service.GetObject();
+    } else {
+      owned_frame_pool_ = std::make_unique<ImageFrameBufferPool>();
+      frame_pool_ = owned_frame_pool_.get();
+    }
+    selector_ = std::make_unique<FrameSelector>(options.resampler_options(),
+                                                fps);
+
+    decode_thread_ =
+        std::make_unique<ThreadPool>("video_decode", /*num_threads=*/1);
+    decode_thread_->StartWorkers();
+    decode_thread_->Schedule([this] { DecodeFrames(); });
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    Timestamp timestamp;
+    std::unique_ptr<ImageFrame> image_frame;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          this, &PrefetchingVideoDecoderCalculator::HasFrameOrDone));
+      if (frames_.empty()) {
+        return decode_status_.ok() ? tool::StatusStop() : decode_status_;
+      }
+      timestamp = frames_.front().first;
+      image_frame = std::move(frames_.front().second);
+      frames_.pop_front();
+    }
+    cc->Outputs().Tag(kVideoTag).Add(image_frame.release(), timestamp);
+    return absl::OkStatus();
+  }
+
+  absl::Status Close(CalculatorContext* cc) override {
+    StopDecoding();
+    return absl::OkStatus();
+  }
+
+ private:
+  // Sometimes an empty frame is returned even though there are more frames.
+  bool GrabFrame() { return cap_->grab() || cap_->grab(); }
+  bool ReadFrame(cv::Mat& frame) {
+    return GrabFrame() && cap_->retrieve(frame) && !frame.empty();
+  }
+
+  void SeekTo(int64_t timestamp_us) {
+    seeks_counter_->Increment();
+    cap_->set(cv::CAP_PROP_POS_MSEC, timestamp_us / 1000.0);
+  }
+
+  // Runs on `decode_thread_` until the end of the video, or until
+  // StopDecoding() is called.
+  void DecodeFrames() {
+    const absl::Status status = DecodeFramesUntilDone();
+    absl::MutexLock lock(&mutex_);
+    decode_status_ = status;
+    decoding_done_ = true;
+  }
+
+  absl::Status DecodeFramesUntilDone() {
+    Timestamp prev_timestamp = Timestamp::Unset();
+    if (selector_->NextNeeded() > 0) SeekTo(selector_->NextNeeded());
+    cv::Mat frame;
+    while (true) {
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(
+            this, &PrefetchingVideoDecoderCalculator::HasRoomOrStopped));
+        if (stop_decoding_) return absl::OkStatus();
+      }
+      if (!GrabFrame()) return absl::OkStatus();
+      // Use microsecond as the unit of time.
+      const Timestamp timestamp(
+          static_cast<int64_t>(cap_->get(cv::CAP_PROP_POS_MSEC) * 1000));
+      if (selector_->IsPastEnd(timestamp.Value())) return absl::OkStatus();
+      // Frames not after the previous one are discarded, as in
+      // OpenCvVideoDecoderCalculator.
+      if (timestamp <= prev_timestamp ||
+          !selector_->IsNeeded(timestamp.Value())) {
+        continue;
+      }
+      if (!cap_->retrieve(frame) || frame.empty()) continue;
+      MP_ASSIGN_OR_RETURN(
+          std::unique_ptr<ImageFrame> image_frame,
+          frame_pool_->GetFrame(format_, frame.cols, frame.rows,
+                                /*alignment_boundary=*/1));
+      cv::Mat output_mat = formats::MatView(image_frame.get());
+      if (format_ == ImageFormat::SRGB) {
+        cv::cvtColor(frame, output_mat, cv::COLOR_BGR2RGB);
+      } else if (format_ == ImageFormat::SRGBA) {
+        cv::cvtColor(frame, output_mat, cv::COLOR_BGRA2RGBA);
+      } else {
+        frame.copyTo(output_mat);
+      }
+      prev_timestamp = timestamp;
+      {
+        absl::MutexLock lock(&mutex_);
+        frames_.emplace_back(timestamp, std::move(image_frame));
+      }
+      if (min_seek_gap_us_ > 0 &&
+          selector_->GapAfter(timestamp.Value()) >= min_seek_gap_us_) {
+        SeekTo(selector_->NextNeeded());
+      }
+    }
+  }
+
+  bool HasFrameOrDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !frames_.empty() || decoding_done_;
+  }
+  bool HasRoomOrStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return frames_.size() < prefetch_queue_size_ || stop_decoding_;
+  }
+
+  // Stops and joins the decoding thread, and releases the video.
+  void StopDecoding() {
+    {
+      absl::MutexLock lock(&mutex_);
+      stop_decoding_ = true;
+    }
+    decode_thread_.reset();
+    if (cap_ && cap_->isOpened()) {
+      cap_->release();
+    }
+  }
+
+  std::unique_ptr<cv::VideoCapture> cap_;
+  ImageFormat::Format format_;
+  size_t prefetch_queue_size_;
+  int64_t min_seek_gap_us_;
+  Counter* seeks_counter_ = nullptr;
+  std::unique_ptr<FrameSelector> selector_;
+  ImageFrameBufferPool* frame_pool_ = nullptr;
+  std::unique_ptr<ImageFrameBufferPool> owned_frame_pool_;
+  std::unique_ptr<ThreadPool> decode_thread_;
+
+  absl::Mutex mutex_;
+  std::deque<std::pair<Timestamp, std::unique_ptr<ImageFrame>>> frames_
+      ABSL_GUARDED_BY(mutex_);
+  bool decoding_done_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stop_decoding_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status decode_status_ ABSL_GUARDED_BY(mutex_);
+};
+
+REGISTER_CALCULATOR(PrefetchingVideoDecoderCalculator);
+}  // namespace mediapipe
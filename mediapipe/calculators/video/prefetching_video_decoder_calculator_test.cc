@@ -0,0 +1,120 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/test_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kVideoTag[] = "VIDEO";
+constexpr char kVideoPrestreamTag[] = "VIDEO_PRESTREAM";
+constexpr char kInputFilePathTag[] = "INPUT_FILE_PATH";
+constexpr char kTestPackageRoot[] = "mediapipe/calculators/video";
+constexpr char kSeeksCounter[] = "PrefetchingVideoDecoderCalculator-Seeks";
+
+// Decodes the 6 second, 30 fps 720p test video with the given options, and
+// stores the number of seeks into `num_seeks` if not null.
+std::vector<Packet> DecodeTestVideo(const std::string& options,
+                                    int64_t* num_seeks = nullptr) {
+  CalculatorRunner runner(
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::StrCat(
+          R"pb(
+            calculator: "PrefetchingVideoDecoderCalculator"
+            input_side_packet: "INPUT_FILE_PATH:input_file_path"
+            output_stream: "VIDEO:video"
+            output_stream: "VIDEO_PRESTREAM:video_prestream"
+            options {
+              [mediapipe.PrefetchingVideoDecoderCalculatorOptions.ext] {)pb",
+          options, "}}")));
+  runner.MutableSidePackets()->Tag(kInputFilePathTag) =
+      MakePacket<std::string>(file::JoinPath(GetTestDataDir(kTestPackageRoot),
+                                             "format_MP4_AVC720P_AAC.video"));
+  MP_EXPECT_OK(runner.Run());
+
+  EXPECT_EQ(runner.Outputs().Tag(kVideoPrestreamTag).packets.size(), 1);
+  if (num_seeks != nullptr) {
+    *num_seeks = runner.GetCounter(kSeeksCounter)->Get();
+  }
+  return runner.Outputs().Tag(kVideoTag).packets;
+}
+
+TEST(PrefetchingVideoDecoderCalculatorTest, DecodesAllFrames) {
+  const std::vector<Packet> packets = DecodeTestVideo("prefetch_queue_size: 2");
+  EXPECT_GE(packets.size(), 180);
+  for (int i = 0; i < packets.size(); ++i) {
+    const ImageFrame& frame = packets[i].Get<ImageFrame>();
+    EXPECT_EQ(frame.Format(), ImageFormat::SRGB);
+    EXPECT_EQ(frame.Width(), 1280);
+    EXPECT_EQ(frame.Height(), 640);
+    if (i > 0) EXPECT_GT(packets[i].Timestamp(), packets[i - 1].Timestamp());
+  }
+}
+
+TEST(PrefetchingVideoDecoderCalculatorTest, DoesNotSeekWithoutResampler) {
+  int64_t num_seeks = -1;
+  const std::vector<Packet> packets = DecodeTestVideo("", &num_seeks);
+  EXPECT_GE(packets.size(), 180);
+  EXPECT_EQ(num_seeks, 0);
+}
+
+TEST(PrefetchingVideoDecoderCalculatorTest, DecodesFramesNeededByResampler) {
+  const std::vector<Packet> packets = DecodeTestVideo(R"pb(
+    resampler_options { frame_rate: 5 }
+    min_seek_gap_us: 0
+  )pb");
+  // One in 6 frames.
+  EXPECT_GE(packets.size(), 29);
+  EXPECT_LE(packets.size(), 31);
+  for (int i = 1; i < packets.size(); ++i) {
+    EXPECT_NEAR((packets[i].Timestamp() - packets[i - 1].Timestamp()).Value(),
+                200000, 34000);
+  }
+}
+
+TEST(PrefetchingVideoDecoderCalculatorTest, SeeksOverLongGaps) {
+  int64_t num_seeks = 0;
+  const std::vector<Packet> packets = DecodeTestVideo(
+      R"pb(
+        resampler_options { frame_rate: 1 start_time: 2000000 }
+        min_seek_gap_us: 500000
+      )pb",
+      &num_seeks);
+  // Frames at 1s (one period before the start time) and then every second.
+  ASSERT_GE(packets.size(), 4);
+  EXPECT_LE(packets.size(), 6);
+  EXPECT_NEAR(packets[0].Timestamp().Value(), 1000000, 34000);
+  // To the start time, and then over every gap but the last.
+  EXPECT_GE(num_seeks, static_cast<int64_t>(packets.size()) - 1);
+  for (int i = 1; i < packets.size(); ++i) {
+    EXPECT_NEAR((packets[i].Timestamp() - packets[i - 1].Timestamp()).Value(),
+                1000000, 34000);
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -14,7 +14,14 @@
 
 #include "mediapipe/framework/calculator_context.h"
 
+#include <cstdint>
+#include <memory>
+
 #include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_buffer_pool.h"
 
 namespace mediapipe {
 
@@ -48,6 +55,24 @@ CounterFactory* CalculatorContext::GetCounterFactory() {
   return calculator_state_->GetCounterFactory();
 }
 
+std::unique_ptr<ImageFrame> CalculatorContext::AllocateImageFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32_t alignment_boundary) {
+  ABSL_CHECK(calculator_state_);
+  bool reused = false;
+  auto frame = calculator_state_->GetImageFrameBufferPool().GetFrame(
+      format, width, height, alignment_boundary, &reused);
+  if (!frame.ok()) {
+    ABSL_LOG_FIRST_N(WARNING, 1)
+        << "Falling back to an unpooled ImageFrame: " << frame.status();
+    ++image_frame_pool_misses_;
+    return std::make_unique<ImageFrame>(format, width, height,
+                                        alignment_boundary);
+  }
+  ++(reused ? image_frame_pool_hits_ : image_frame_pool_misses_);
+  return *std::move(frame);
+}
+
 const PacketSet& CalculatorContext::InputSidePackets() const {
   return calculator_state_->InputSidePackets();
 }
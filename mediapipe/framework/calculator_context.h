@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 
+#include <cstdint>
 #include <memory>
 #include <queue>
 #include <string>
@@ -24,6 +25,8 @@
 #include "absl/status/status.h"
 #include "mediapipe/framework/calculator_state.h"
 #include "mediapipe/framework/counter.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/input_stream_shard.h"
@@ -151,6 +154,17 @@ class CalculatorContext {
     return calculator_state_->GetResources();
   }
 
+  // Allocates a CPU frame whose pixel data is recycled once the frame is
+  // destroyed, e.g. with the last packet holding it. Prefer it over creating
+  // ImageFrames directly for frames output at every timestamp. The pixel data
+  // is not initialized.
+  //
+  // Frames come from the graph's `kImageFrameBufferPoolService`. Pool hits and
+  // misses are reported in the node's CalculatorProfile.
+  std::unique_ptr<ImageFrame> AllocateImageFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32_t alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
   // Enables access to private GetGraphServiceManager() method.
   friend class CalculatorGraph;
 
@@ -203,8 +217,15 @@ class CalculatorContext {
   // The status of the graph run. Only used when Close() is called.
   absl::Status graph_status_;
 
+  // AllocateImageFrame calls served with recycled and new pixel data, since
+  // the profiler last collected them.
+  int64_t image_frame_pool_hits_ = 0;
+  int64_t image_frame_pool_misses_ = 0;
+
   // Accesses CalculatorContext for setting input timestamp.
   friend class CalculatorContextManager;
+  // Collects the image frame pool hits and misses.
+  friend class GraphProfiler;
 };
 
 }  // namespace mediapipe
@@ -44,8 +44,10 @@
 #include "mediapipe/framework/delegating_executor.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/graph_executor_service.h"
 #include "mediapipe/framework/graph_output_stream.h"
 #include "mediapipe/framework/graph_service_manager.h"
+#include "mediapipe/framework/image_frame_buffer_pool_service.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/output_side_packet_impl.h"
@@ -441,6 +443,17 @@ absl::Status CalculatorGraph::InitializeDefaultExecutor(
         mediapipe::NumCPUCores(),
         std::max({validated_graph_->Config().node().size(),
                   validated_graph_->Config().packet_generator().size(), 1}));
+    // Nodes which require to split their own work across the default executor
+    // can keep all cores busy regardless of the size of the graph. Nodes which
+    // only use it if available run on the threads the graph has anyway.
+    for (const auto& node_info : validated_graph_->CalculatorInfos()) {
+      const auto& requests = node_info.Contract().ServiceRequests();
+      const auto it = requests.find(kGraphExecutorService.key);
+      if (it != requests.end() && !it->second.IsOptional()) {
+        num_threads = mediapipe::NumCPUCores();
+        break;
+      }
+    }
   }
   MP_RETURN_IF_ERROR(
       CreateDefaultThreadPool(default_executor_options, num_threads));
@@ -458,6 +471,13 @@ absl::Status CalculatorGraph::Initialize(
       << "validated_graph is not initialized.";
   validated_graph_ = std::move(validated_graph);
 
+  // Nodes share one CPU frame pool unless the application provided one.
+  if (!service_manager_.GetServiceObject(kImageFrameBufferPoolService)) {
+    MP_RETURN_IF_ERROR(service_manager_.SetServiceObject(
+        kImageFrameBufferPoolService,
+        std::make_shared<ImageFrameBufferPool>()));
+  }
+
   MP_RETURN_IF_ERROR(InitializeExecutors());
   MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
   MP_RETURN_IF_ERROR(InitializeStreams());
@@ -701,6 +721,16 @@ absl::Status CalculatorGraph::PrepareGpu() {
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
 absl::Status CalculatorGraph::PrepareServices() {
+  if (!use_application_thread_ &&
+      service_manager_.GetServicePacket(kGraphExecutorService).IsEmpty()) {
+    auto graph_executor = std::make_shared<GraphExecutor>();
+    graph_executor->executor = executors_[""];
+    graph_executor->num_threads = default_executor_num_threads_ > 0
+                                      ? default_executor_num_threads_
+                                      : mediapipe::NumCPUCores();
+    MP_RETURN_IF_ERROR(service_manager_.SetServiceObject(
+        kGraphExecutorService, std::move(graph_executor)));
+  }
   for (const auto& node : nodes_) {
     for (const auto& [key, request] : node->Contract().ServiceRequests()) {
       auto packet = service_manager_.GetServicePacket(request.Service());
@@ -1409,6 +1439,7 @@ absl::Status CalculatorGraph::CreateDefaultThreadPool(
   MP_ASSIGN_OR_RETURN(Executor* executor,
                    ThreadPoolExecutor::Create(extendable_options));
   // clang-format on
+  default_executor_num_threads_ = num_threads;
   return SetExecutorInternal("", std::shared_ptr<Executor>(executor));
 }
 
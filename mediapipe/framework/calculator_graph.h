@@ -43,6 +43,7 @@
 #include "mediapipe/framework/graph_runtime_info.pb.h"
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/graph_service_manager.h"
+#include "mediapipe/framework/image_frame_buffer_pool_service.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/output_side_packet_impl.h"
 #include "mediapipe/framework/output_stream_manager.h"
@@ -442,7 +443,8 @@ class CalculatorGraph {
     if (initialized_) {
       // TODO: check that the graph has not been initialized for
       // all services!
-      if (service.key == kResourcesService.key) {
+      if (service.key == kResourcesService.key ||
+          service.key == kImageFrameBufferPoolService.key) {
         return absl::InternalError(
             "Service objects must be set before graph is initialized.");
       }
@@ -745,6 +747,10 @@ class CalculatorGraph {
   // True if the default executor uses the application thread.
   bool use_application_thread_ = false;
 
+  // Number of threads of the default executor if the graph created it as a
+  // thread pool, 0 otherwise.
+  int default_executor_num_threads_ = 0;
+
   // Condition variable that waits until all input streams that depend on a
   // graph input stream are below the maximum queue size.
   absl::CondVar wait_to_add_packet_cond_var_
@@ -21,7 +21,9 @@
 
 #include "absl/log/absl_check.h"
 #include "absl/strings/str_cat.h"
+#include "mediapipe/framework/formats/image_frame_buffer_pool.h"
 #include "mediapipe/framework/graph_service_manager.h"
+#include "mediapipe/framework/image_frame_buffer_pool_service.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/resources.h"
 #include "mediapipe/framework/resources_service.h"
@@ -43,10 +45,15 @@ CalculatorState::CalculatorState(
       counter_factory_(nullptr) {
   if (graph_service_manager) {
     resources_ = graph_service_manager->GetServiceObject(kResourcesService);
+    image_frame_buffer_pool_ =
+        graph_service_manager->GetServiceObject(kImageFrameBufferPoolService);
   }
   if (!resources_) {
     resources_ = CreateDefaultResources();
   }
+  if (!image_frame_buffer_pool_) {
+    image_frame_buffer_pool_ = std::make_shared<ImageFrameBufferPool>();
+  }
   options_.Initialize(node_config);
   ResetBetweenRuns();
 }
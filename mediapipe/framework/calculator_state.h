@@ -38,6 +38,7 @@
 
 namespace mediapipe {
 
+class ImageFrameBufferPool;
 class ProfilingContext;
 // Holds data that the Calculator needs access to.  This data is not
 // stored in Calculator directly since Calculator will be destroyed after
@@ -104,6 +105,11 @@ class CalculatorState {
   // Returns calculator interface for loading resources.
   const Resources& GetResources() { return *resources_; }
 
+  // Returns the pool recycling CPU frames of the graph.
+  ImageFrameBufferPool& GetImageFrameBufferPool() {
+    return *image_frame_buffer_pool_;
+  }
+
   ////////////////////////////////////////
   // Interface for CalculatorNode.
   ////////////////////////////////////////
@@ -153,6 +159,9 @@ class CalculatorState {
   // Graph/calculator resource loading interface.
   std::shared_ptr<Resources> resources_;
 
+  // Graph-wide pool for CalculatorContext::AllocateImageFrame.
+  std::shared_ptr<ImageFrameBufferPool> image_frame_buffer_pool_;
+
   ////////////////////////////////////////
   // Variables which ARE cleared by ResetBetweenRuns().
   ////////////////////////////////////////
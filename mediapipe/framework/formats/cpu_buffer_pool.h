@@ -0,0 +1,143 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/gpu/multi_pool.h"
+#include "mediapipe/gpu/reusable_pool.h"
+
+namespace mediapipe {
+
+// Describes a CPU memory block. Blocks with identical specs are
+// interchangeable, regardless of the element type and shape of the tensors
+// using them.
+struct CpuBufferSpec {
+  size_t size_bytes = 0;
+  // Alignment in bytes, 0 if no particular alignment is required.
+  int alignment = 0;
+
+  // Hashing required to use CpuBufferSpec as key in buffer pools. See
+  // absl::Hash for details.
+  template <typename H>
+  friend H AbslHashValue(H h, const CpuBufferSpec& spec) {
+    return H::combine(std::move(h), spec.size_bytes, spec.alignment);
+  }
+};
+
+inline bool operator==(const CpuBufferSpec& lhs, const CpuBufferSpec& rhs) {
+  return lhs.size_bytes == rhs.size_bytes && lhs.alignment == rhs.alignment;
+}
+inline bool operator!=(const CpuBufferSpec& lhs, const CpuBufferSpec& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+// Owns a (possibly aligned) CPU memory block.
+class CpuBuffer {
+ public:
+  static absl::StatusOr<std::unique_ptr<CpuBuffer>> Create(
+      const CpuBufferSpec& spec);
+  ~CpuBuffer();
+
+  CpuBuffer(const CpuBuffer&) = delete;
+  CpuBuffer& operator=(const CpuBuffer&) = delete;
+
+  void* data() const { return data_; }
+  const CpuBufferSpec& spec() const { return spec_; }
+
+  // Called by the pool when the buffer is handed out again.
+  void Reuse() { ++reuse_count_; }
+  // Returns true if the buffer has been handed out before.
+  bool reused() const { return reuse_count_ > 0; }
+
+ private:
+  CpuBuffer(const CpuBufferSpec& spec, void* data) : spec_(spec), data_(data) {}
+
+  const CpuBufferSpec spec_;
+  void* const data_;
+  int reuse_count_ = 0;
+};
+
+namespace internal {
+
+// Pools CpuBuffers with identical CpuBufferSpec.
+class CpuBufferSpecPool : public ReusablePool<CpuBuffer> {
+ public:
+  static std::shared_ptr<CpuBufferSpecPool> Create(
+      const CpuBufferSpec& spec, const MultiPoolOptions& options) {
+    return std::shared_ptr<CpuBufferSpecPool>(
+        new CpuBufferSpecPool(spec, options));
+  }
+  static absl::StatusOr<std::unique_ptr<CpuBuffer>> CreateBufferWithoutPool(
+      const CpuBufferSpec& spec) {
+    return CpuBuffer::Create(spec);
+  }
+  const CpuBufferSpec& spec() const { return spec_; }
+
+ protected:
+  CpuBufferSpecPool(const CpuBufferSpec& spec, const MultiPoolOptions& options)
+      : ReusablePool<CpuBuffer>([this] { return CreateBufferWithoutPool(spec_); },
+                                options),
+        spec_(spec) {}
+
+  const CpuBufferSpec spec_;
+};
+
+}  // namespace internal
+
+// Recycles CPU memory of tensors, avoiding an allocation per tensor for
+// calculators that output tensors of the same size for each frame. Retention
+// is controlled by MultiPoolOptions: `keep_count` idle buffers are kept per
+// spec, and pools of the least recently requested specs are dropped once more
+// than `max_pool_count` specs are in use.
+class CpuBufferPool
+    : public MultiPool<internal::CpuBufferSpecPool, CpuBufferSpec,
+                       std::shared_ptr<CpuBuffer>> {
+ public:
+  struct Stats {
+    // Requests served with a recycled buffer.
+    int64_t hits = 0;
+    // Requests that required an allocation.
+    int64_t misses = 0;
+  };
+
+  CpuBufferPool() = default;
+
+  explicit CpuBufferPool(const MultiPoolOptions& options)
+      : MultiPool<internal::CpuBufferSpecPool, CpuBufferSpec,
+                  std::shared_ptr<CpuBuffer>>(options) {}
+
+  absl::StatusOr<std::shared_ptr<CpuBuffer>> GetBuffer(
+      const CpuBufferSpec& spec);
+
+  Stats GetStats() const {
+    return {hits_.load(std::memory_order_relaxed),
+            misses_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
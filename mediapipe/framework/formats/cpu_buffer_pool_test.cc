@@ -0,0 +1,90 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+
+#include <cstdint>
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/gpu/multi_pool.h"
+
+namespace mediapipe {
+namespace {
+
+MultiPoolOptions GetTestMultiPoolOptions() {
+  MultiPoolOptions options;
+  options.min_requests_before_pool = 0;
+  return options;
+}
+
+TEST(CpuBufferPoolTest, ShouldAllocateAlignedBuffer) {
+  CpuBufferPool cpu_buffer_pool(GetTestMultiPoolOptions());
+  MP_ASSERT_OK_AND_ASSIGN(auto buffer,
+                          cpu_buffer_pool.GetBuffer(
+                              {/*size_bytes=*/123, /*alignment=*/64}));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer->data()) % 64, 0);
+}
+
+TEST(CpuBufferPoolTest, ShouldPoolCpuBuffer) {
+  CpuBufferPool cpu_buffer_pool(GetTestMultiPoolOptions());
+  const CpuBufferSpec spec = {/*size_bytes=*/123, /*alignment=*/64};
+
+  void* data = nullptr;
+  // First request allocates a new buffer.
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer, cpu_buffer_pool.GetBuffer(spec));
+    data = buffer->data();
+  }
+  // Second request returns the same buffer.
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer, cpu_buffer_pool.GetBuffer(spec));
+    EXPECT_EQ(buffer->data(), data);
+  }
+  EXPECT_EQ(cpu_buffer_pool.GetStats().hits, 1);
+  EXPECT_EQ(cpu_buffer_pool.GetStats().misses, 1);
+}
+
+TEST(CpuBufferPoolTest, ShouldReturnNewBufferForDifferentSpec) {
+  CpuBufferPool cpu_buffer_pool(GetTestMultiPoolOptions());
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer,
+                            cpu_buffer_pool.GetBuffer(
+                                {/*size_bytes=*/123, /*alignment=*/64}));
+  }
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer,
+                            cpu_buffer_pool.GetBuffer(
+                                {/*size_bytes=*/123, /*alignment=*/0}));
+  }
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer,
+                            cpu_buffer_pool.GetBuffer(
+                                {/*size_bytes=*/567, /*alignment=*/64}));
+  }
+  EXPECT_EQ(cpu_buffer_pool.GetStats().hits, 0);
+  EXPECT_EQ(cpu_buffer_pool.GetStats().misses, 3);
+}
+
+TEST(CpuBufferPoolTest, ShouldNotReuseBufferInUse) {
+  CpuBufferPool cpu_buffer_pool(GetTestMultiPoolOptions());
+  const CpuBufferSpec spec = {/*size_bytes=*/123, /*alignment=*/64};
+  MP_ASSERT_OK_AND_ASSIGN(auto first, cpu_buffer_pool.GetBuffer(spec));
+  MP_ASSERT_OK_AND_ASSIGN(auto second, cpu_buffer_pool.GetBuffer(spec));
+  EXPECT_NE(first->data(), second->data());
+  EXPECT_EQ(cpu_buffer_pool.GetStats().misses, 2);
+}
+
+}  // namespace
+}  // namespace mediapipe
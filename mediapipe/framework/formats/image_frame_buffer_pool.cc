@@ -0,0 +1,74 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_buffer_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Smaller frames all share the same size class.
+constexpr size_t kMinSizeClass = 4096;
+
+}  // namespace
+
+size_t ImageFrameBufferPool::SizeClass(size_t size_bytes) {
+  if (size_bytes <= kMinSizeClass) return kMinSizeClass;
+  // Splits [2^n, 2^(n+1)) into four classes.
+  const int log2 = absl::bit_width(size_bytes - 1) - 1;
+  const size_t step = size_t{1} << (log2 - 2);
+  return (size_bytes + step - 1) / step * step;
+}
+
+absl::StatusOr<std::unique_ptr<ImageFrame>> ImageFrameBufferPool::GetFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32_t alignment_boundary, bool* reused) {
+  RET_CHECK_NE(format, ImageFormat::UNKNOWN);
+  RET_CHECK(absl::has_single_bit(alignment_boundary))
+      << "Alignment must be 1 or a power of 2: " << alignment_boundary;
+  RET_CHECK_GE(width, 0);
+  RET_CHECK_GE(height, 0);
+  // Same row layout as ImageFrame::Reset.
+  int width_step = width * ImageFrame::NumberOfChannelsForFormat(format) *
+                   ImageFrame::ChannelSizeForFormat(format);
+  if (alignment_boundary > 1) {
+    width_step = ((width_step - 1) | (alignment_boundary - 1)) + 1;
+  }
+  const CpuBufferSpec spec = {
+      SizeClass(static_cast<size_t>(height) * width_step),
+      alignment_boundary > 1 ? static_cast<int>(alignment_boundary) : 0};
+  MP_ASSIGN_OR_RETURN(std::shared_ptr<CpuBuffer> buffer,
+                      buffer_pool_.GetBuffer(spec));
+  if (reused != nullptr) *reused = buffer->reused();
+  uint8_t* pixel_data = static_cast<uint8_t*>(buffer->data());
+  return std::make_unique<ImageFrame>(
+      format, width, height, width_step, pixel_data,
+      // Holding the buffer keeps it out of the pool until the frame is gone.
+      [buffer = std::move(buffer)](uint8_t*) mutable { buffer.reset(); });
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,69 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_BUFFER_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/gpu/multi_pool.h"
+
+namespace mediapipe {
+
+// Recycles the pixel data of ImageFrames of any format and dimensions.
+//
+// Pixel data is pooled by size class rather than by exact dimensions: sizes
+// are rounded up to one of four classes per power of two, so that frames of
+// slightly different dimensions or of different formats with a similar byte
+// size share buffers, at the cost of at most 25% unused memory per buffer.
+// Retention follows MultiPoolOptions, see CpuBufferPool.
+//
+// Calculators should allocate frames with CalculatorContext::AllocateImageFrame
+// rather than use this class directly.
+class ImageFrameBufferPool {
+ public:
+  using Stats = CpuBufferPool::Stats;
+
+  ImageFrameBufferPool() = default;
+  explicit ImageFrameBufferPool(const MultiPoolOptions& options)
+      : buffer_pool_(options) {}
+
+  // Returns a frame whose pixel data is returned to the pool when the frame,
+  // or any ImageFrame it is moved to, is destroyed. The pixel data is not
+  // initialized. Sets `reused`, if not null, to whether the pixel data was
+  // recycled.
+  absl::StatusOr<std::unique_ptr<ImageFrame>> GetFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32_t alignment_boundary = ImageFrame::kDefaultAlignmentBoundary,
+      bool* reused = nullptr);
+
+  // Counts of GetFrame calls served with recycled and new pixel data.
+  Stats GetStats() const { return buffer_pool_.GetStats(); }
+
+  // Returns the size of the buffers holding `size_bytes` of pixel data.
+  static size_t SizeClass(size_t size_bytes);
+
+ private:
+  CpuBufferPool buffer_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_BUFFER_POOL_H_
@@ -0,0 +1,91 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_buffer_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/gpu/multi_pool.h"
+
+namespace mediapipe {
+namespace {
+
+MultiPoolOptions GetTestMultiPoolOptions() {
+  MultiPoolOptions options;
+  options.min_requests_before_pool = 0;
+  return options;
+}
+
+TEST(ImageFrameBufferPoolTest, SizeClassesSplitPowersOfTwoInFour) {
+  EXPECT_EQ(ImageFrameBufferPool::SizeClass(1), 4096);
+  EXPECT_EQ(ImageFrameBufferPool::SizeClass(4096), 4096);
+  EXPECT_EQ(ImageFrameBufferPool::SizeClass(4097), 5120);
+  EXPECT_EQ(ImageFrameBufferPool::SizeClass(8192), 8192);
+  EXPECT_EQ(ImageFrameBufferPool::SizeClass(8193), 10240);
+  // 1920x1080 SRGB.
+  EXPECT_EQ(ImageFrameBufferPool::SizeClass(6220800), 6291456);
+}
+
+TEST(ImageFrameBufferPoolTest, FrameHasRequestedLayout) {
+  ImageFrameBufferPool pool(GetTestMultiPoolOptions());
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ImageFrame> frame,
+                          pool.GetFrame(ImageFormat::SRGB, 33, 10));
+  EXPECT_EQ(frame->Format(), ImageFormat::SRGB);
+  EXPECT_EQ(frame->Width(), 33);
+  EXPECT_EQ(frame->Height(), 10);
+  EXPECT_EQ(frame->WidthStep(), 112);
+  EXPECT_TRUE(frame->IsAligned(ImageFrame::kDefaultAlignmentBoundary));
+}
+
+TEST(ImageFrameBufferPoolTest, RecyclesPixelDataOfDestroyedFrames) {
+  ImageFrameBufferPool pool(GetTestMultiPoolOptions());
+  bool reused = true;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ImageFrame> frame,
+      pool.GetFrame(ImageFormat::SRGB, 640, 480,
+                    ImageFrame::kDefaultAlignmentBoundary, &reused));
+  EXPECT_FALSE(reused);
+  const uint8_t* pixel_data = frame->PixelData();
+  frame.reset();
+
+  // A frame of another format and similar size shares the size class.
+  MP_ASSERT_OK_AND_ASSIGN(
+      frame, pool.GetFrame(ImageFormat::SRGBA, 600, 400,
+                           ImageFrame::kDefaultAlignmentBoundary, &reused));
+  EXPECT_TRUE(reused);
+  EXPECT_EQ(frame->PixelData(), pixel_data);
+  EXPECT_EQ(pool.GetStats().hits, 1);
+  EXPECT_EQ(pool.GetStats().misses, 1);
+}
+
+TEST(ImageFrameBufferPoolTest, KeepsPixelDataOfMovedFramesInUse) {
+  ImageFrameBufferPool pool(GetTestMultiPoolOptions());
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ImageFrame> frame,
+                          pool.GetFrame(ImageFormat::GRAY8, 64, 64));
+  ImageFrame moved(std::move(*frame));
+  frame.reset();
+
+  MP_ASSERT_OK_AND_ASSIGN(frame, pool.GetFrame(ImageFormat::GRAY8, 64, 64));
+  EXPECT_NE(frame->PixelData(), moved.PixelData());
+  EXPECT_EQ(pool.GetStats().misses, 2);
+}
+
+}  // namespace
+}  // namespace mediapipe
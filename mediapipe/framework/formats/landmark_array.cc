@@ -0,0 +1,107 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/landmark_array.h"
+
+#include "absl/algorithm/container.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+namespace {
+
+template <typename LandmarkListT>
+LandmarkArray ToLandmarkArrayImpl(const LandmarkListT& landmarks) {
+  const auto& landmark = landmarks.landmark();
+  const bool has_visibility = absl::c_any_of(
+      landmark, [](const auto& lm) { return lm.has_visibility(); });
+  const bool has_presence = absl::c_any_of(
+      landmark, [](const auto& lm) { return lm.has_presence(); });
+
+  LandmarkArray array(landmarks.landmark_size(), has_visibility, has_presence);
+  absl::Span<float> x = array.x();
+  absl::Span<float> y = array.y();
+  absl::Span<float> z = array.z();
+  for (int i = 0; i < landmarks.landmark_size(); ++i) {
+    const auto& lm = landmarks.landmark(i);
+    x[i] = lm.x();
+    y[i] = lm.y();
+    z[i] = lm.z();
+  }
+  if (has_visibility) {
+    absl::Span<float> visibility = array.visibility();
+    for (int i = 0; i < landmarks.landmark_size(); ++i) {
+      visibility[i] = landmarks.landmark(i).visibility();
+    }
+  }
+  if (has_presence) {
+    absl::Span<float> presence = array.presence();
+    for (int i = 0; i < landmarks.landmark_size(); ++i) {
+      presence[i] = landmarks.landmark(i).presence();
+    }
+  }
+  return array;
+}
+
+template <typename LandmarkListT>
+LandmarkListT FromLandmarkArrayImpl(const LandmarkArray& array) {
+  LandmarkListT landmarks;
+  landmarks.mutable_landmark()->Reserve(array.size());
+  absl::Span<const float> x = array.x();
+  absl::Span<const float> y = array.y();
+  absl::Span<const float> z = array.z();
+  for (int i = 0; i < array.size(); ++i) {
+    auto* lm = landmarks.add_landmark();
+    lm->set_x(x[i]);
+    lm->set_y(y[i]);
+    lm->set_z(z[i]);
+    if (array.has_visibility()) lm->set_visibility(array.visibility()[i]);
+    if (array.has_presence()) lm->set_presence(array.presence()[i]);
+  }
+  return landmarks;
+}
+
+}  // namespace
+
+LandmarkArray::LandmarkArray(int size, bool has_visibility, bool has_presence)
+    : size_(size),
+      has_visibility_(has_visibility),
+      has_presence_(has_presence),
+      coordinates_(3 * size),
+      visibility_(has_visibility ? size : 0),
+      presence_(has_presence ? size : 0) {}
+
+LandmarkArray ToLandmarkArray(const NormalizedLandmarkList& landmarks) {
+  return ToLandmarkArrayImpl(landmarks);
+}
+
+LandmarkArray ToLandmarkArray(const LandmarkList& landmarks) {
+  return ToLandmarkArrayImpl(landmarks);
+}
+
+NormalizedLandmarkList ToNormalizedLandmarkList(
+    const LandmarkArray& landmarks) {
+  return FromLandmarkArrayImpl<NormalizedLandmarkList>(landmarks);
+}
+
+LandmarkList ToLandmarkList(const LandmarkArray& landmarks) {
+  return FromLandmarkArrayImpl<LandmarkList>(landmarks);
+}
+
+MEDIAPIPE_REGISTER_TYPE(mediapipe::LandmarkArray, "::mediapipe::LandmarkArray",
+                        nullptr, nullptr);
+
+}  // namespace mediapipe
@@ -0,0 +1,101 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_LANDMARK_ARRAY_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_LANDMARK_ARRAY_H_
+
+#include <vector>
+
+#include "absl/types/span.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+
+namespace mediapipe {
+
+// A flat list of landmarks, for streams between calculators that transform
+// landmark coordinates (projection, letterbox removal, refinement, smoothing).
+// Unlike NormalizedLandmarkList and LandmarkList, copying or creating it
+// doesn't allocate a message per landmark.
+//
+// Coordinates are stored as planes in a single buffer: all x, then all y, then
+// all z coordinates. Visibility and presence are stored only if the landmarks
+// have them. The array doesn't record whether its coordinates are normalized;
+// that is defined by the stream, as for the proto lists.
+//
+// Example:
+//   LandmarkArray landmarks = ToLandmarkArray(normalized_landmark_list);
+//   for (float& x : landmarks.x()) x = 1.0f - x;
+//   NormalizedLandmarkList flipped = ToNormalizedLandmarkList(landmarks);
+class LandmarkArray {
+ public:
+  LandmarkArray() = default;
+  // Creates `size` landmarks with all values set to zero.
+  explicit LandmarkArray(int size, bool has_visibility = false,
+                         bool has_presence = false);
+
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  absl::Span<float> x() { return {coordinates_.data(), Size()}; }
+  absl::Span<const float> x() const { return {coordinates_.data(), Size()}; }
+  absl::Span<float> y() { return {coordinates_.data() + size_, Size()}; }
+  absl::Span<const float> y() const {
+    return {coordinates_.data() + size_, Size()};
+  }
+  absl::Span<float> z() { return {coordinates_.data() + 2 * size_, Size()}; }
+  absl::Span<const float> z() const {
+    return {coordinates_.data() + 2 * size_, Size()};
+  }
+  // The x, y and z planes: `3 * size()` values.
+  absl::Span<float> coordinates() { return absl::MakeSpan(coordinates_); }
+  absl::Span<const float> coordinates() const {
+    return absl::MakeConstSpan(coordinates_);
+  }
+
+  // Visibility and presence are empty if the landmarks don't have them.
+  bool has_visibility() const { return has_visibility_; }
+  absl::Span<float> visibility() { return absl::MakeSpan(visibility_); }
+  absl::Span<const float> visibility() const {
+    return absl::MakeConstSpan(visibility_);
+  }
+  bool has_presence() const { return has_presence_; }
+  absl::Span<float> presence() { return absl::MakeSpan(presence_); }
+  absl::Span<const float> presence() const {
+    return absl::MakeConstSpan(presence_);
+  }
+
+ private:
+  size_t Size() const { return static_cast<size_t>(size_); }
+
+  int size_ = 0;
+  bool has_visibility_ = false;
+  bool has_presence_ = false;
+  std::vector<float> coordinates_;
+  std::vector<float> visibility_;
+  std::vector<float> presence_;
+};
+
+// Conversions from and to the landmark protos.
+//
+// The array stores visibility (presence) if any of the landmarks has it, and
+// landmarks converted from such an array all have visibility (presence) set,
+// to 0 for those that didn't have it. Lists where either all or none of the
+// landmarks have visibility and presence are converted without loss.
+LandmarkArray ToLandmarkArray(const NormalizedLandmarkList& landmarks);
+LandmarkArray ToLandmarkArray(const LandmarkList& landmarks);
+NormalizedLandmarkList ToNormalizedLandmarkList(const LandmarkArray& landmarks);
+LandmarkList ToLandmarkList(const LandmarkArray& landmarks);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_LANDMARK_ARRAY_H_
@@ -0,0 +1,102 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/landmark_array.h"
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(LandmarkArrayTest, CreatesZeroLandmarks) {
+  LandmarkArray landmarks(2, /*has_visibility=*/true);
+  EXPECT_EQ(landmarks.size(), 2);
+  EXPECT_THAT(landmarks.coordinates(), ElementsAre(0, 0, 0, 0, 0, 0));
+  EXPECT_THAT(landmarks.visibility(), ElementsAre(0, 0));
+  EXPECT_FALSE(landmarks.has_presence());
+  EXPECT_THAT(landmarks.presence(), IsEmpty());
+}
+
+TEST(LandmarkArrayTest, StoresCoordinatesAsPlanes) {
+  LandmarkArray landmarks(2);
+  landmarks.x()[0] = 1;
+  landmarks.x()[1] = 2;
+  landmarks.y()[0] = 3;
+  landmarks.y()[1] = 4;
+  landmarks.z()[0] = 5;
+  landmarks.z()[1] = 6;
+  EXPECT_THAT(landmarks.coordinates(), ElementsAre(1, 2, 3, 4, 5, 6));
+}
+
+TEST(LandmarkArrayTest, ConvertsNormalizedLandmarkList) {
+  NormalizedLandmarkList landmarks;
+  for (int i = 0; i < 3; ++i) {
+    NormalizedLandmark* landmark = landmarks.add_landmark();
+    landmark->set_x(0.1f * i);
+    landmark->set_y(0.2f * i);
+    landmark->set_z(0.3f * i);
+    landmark->set_visibility(0.4f * i);
+  }
+
+  const LandmarkArray array = ToLandmarkArray(landmarks);
+  ASSERT_EQ(array.size(), 3);
+  EXPECT_THAT(array.x(), ElementsAre(0.0f, 0.1f, 0.2f));
+  EXPECT_THAT(array.y(), ElementsAre(0.0f, 0.2f, 0.4f));
+  EXPECT_THAT(array.z(), ElementsAre(0.0f, 0.3f, 0.6f));
+  EXPECT_TRUE(array.has_visibility());
+  EXPECT_THAT(array.visibility(), ElementsAre(0.0f, 0.4f, 0.8f));
+  EXPECT_FALSE(array.has_presence());
+
+  const NormalizedLandmarkList converted = ToNormalizedLandmarkList(array);
+  EXPECT_EQ(converted.SerializeAsString(), landmarks.SerializeAsString());
+}
+
+TEST(LandmarkArrayTest, ConvertsLandmarkList) {
+  LandmarkList landmarks;
+  for (int i = 0; i < 2; ++i) {
+    Landmark* landmark = landmarks.add_landmark();
+    landmark->set_x(10 * i);
+    landmark->set_y(20 * i);
+    landmark->set_z(30 * i);
+    landmark->set_presence(0.5f);
+  }
+
+  const LandmarkArray array = ToLandmarkArray(landmarks);
+  EXPECT_FALSE(array.has_visibility());
+  EXPECT_THAT(array.presence(), ElementsAre(0.5f, 0.5f));
+
+  const LandmarkList converted = ToLandmarkList(array);
+  EXPECT_EQ(converted.SerializeAsString(), landmarks.SerializeAsString());
+}
+
+TEST(LandmarkArrayTest, SetsMissingVisibilityToZero) {
+  NormalizedLandmarkList landmarks;
+  landmarks.add_landmark()->set_visibility(0.5f);
+  landmarks.add_landmark();
+
+  const NormalizedLandmarkList converted =
+      ToNormalizedLandmarkList(ToLandmarkArray(landmarks));
+  ASSERT_EQ(converted.landmark_size(), 2);
+  EXPECT_FLOAT_EQ(converted.landmark(0).visibility(), 0.5f);
+  EXPECT_TRUE(converted.landmark(1).has_visibility());
+  EXPECT_FLOAT_EQ(converted.landmark(1).visibility(), 0.0f);
+}
+
+}  // namespace
+}  // namespace mediapipe
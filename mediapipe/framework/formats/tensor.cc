@@ -450,6 +450,10 @@ void Tensor::Move(Tensor* src) {
   element_type_ = src->element_type();
   src->element_type_ = ElementType::kNone;  // Mark as invalidated.
   cpu_buffer_ = std::exchange(src->cpu_buffer_, nullptr);
+  cpu_buffer_release_callback_ =
+      std::exchange(src->cpu_buffer_release_callback_, nullptr);
+  cpu_buffer_pool_ = std::move(src->cpu_buffer_pool_);
+  pooled_cpu_buffer_ = std::move(src->pooled_cpu_buffer_);
   ahwb_tracking_key_ = src->ahwb_tracking_key_;
   mtl_resources_ = std::move(src->mtl_resources_);
   MoveAhwbStuff(src);
@@ -480,11 +484,12 @@ Tensor::Tensor(ElementType element_type, const Shape& shape,
       shape_(shape),
       memory_alignment_(memory_alignment),
       mtl_resources_(std::make_unique<MtlResources>()) {
-#ifdef MEDIAPIPE_TENSOR_USE_AHWB
   if (memory_manager) {
+    cpu_buffer_pool_ = memory_manager->GetCpuBufferPool();
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
     hardware_buffer_pool_ = memory_manager->GetAndroidHardwareBufferPool();
-  }
 #endif  // MEDIAPIPE_TENSOR_USE_AHWB
+  }
 }
 Tensor::Tensor(ElementType element_type, const Shape& shape,
                const QuantizationParameters& quantization_parameters,
@@ -494,24 +499,41 @@ Tensor::Tensor(ElementType element_type, const Shape& shape,
       quantization_parameters_(quantization_parameters),
       memory_alignment_(memory_alignment),
       mtl_resources_(std::make_unique<MtlResources>()) {
-#ifdef MEDIAPIPE_TENSOR_USE_AHWB
   if (memory_manager) {
+    cpu_buffer_pool_ = memory_manager->GetCpuBufferPool();
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
     hardware_buffer_pool_ = memory_manager->GetAndroidHardwareBufferPool();
-  }
 #endif  // MEDIAPIPE_TENSOR_USE_AHWB
+  }
 }
 
+Tensor::Tensor(ElementType element_type, const Shape& shape,
+               const QuantizationParameters& quantization_parameters,
+               void* cpu_buffer, absl::AnyInvocable<void()> release_callback)
+    : element_type_(element_type),
+      shape_(shape),
+      quantization_parameters_(quantization_parameters),
+      valid_(kValidCpu),
+      cpu_buffer_(cpu_buffer),
+      cpu_buffer_release_callback_(std::move(release_callback)),
+      mtl_resources_(std::make_unique<MtlResources>()) {}
+
 #if MEDIAPIPE_METAL_ENABLED
 void Tensor::Invalidate() {
 #if MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_30
   GLuint cleanup_gl_tex = GL_INVALID_INDEX;
   GLuint cleanup_gl_fb = GL_INVALID_INDEX;
 #endif  // MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_30
+  absl::AnyInvocable<void()> release_cpu_buffer;
   {
     absl::MutexLock lock(&view_mutex_);
     // If memory is allocated and not owned by the metal buffer.
     // TODO: Re-design cpu buffer memory management.
-    if (cpu_buffer_ && !mtl_resources_->metal_buffer) {
+    if (cpu_buffer_release_callback_) {
+      // Aliased memory is released once the metal buffer is gone.
+      release_cpu_buffer =
+          std::exchange(cpu_buffer_release_callback_, nullptr);
+    } else if (cpu_buffer_ && !mtl_resources_->metal_buffer) {
       DeallocateVirtualMemory(cpu_buffer_, AlignToPageSize(bytes()));
     }
     cpu_buffer_ = nullptr;
@@ -538,6 +560,7 @@ void Tensor::Invalidate() {
     });
   }
 #endif  // MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_30
+  if (release_cpu_buffer) release_cpu_buffer();
 }
 
 #else
@@ -766,6 +789,16 @@ absl::Status Tensor::AllocateCpuBuffer() const {
     // memory page which should match common alignment requirements.
     cpu_buffer_ = AllocateVirtualMemory(bytes());
 #else
+    if (cpu_buffer_pool_) {
+      MP_ASSIGN_OR_RETURN(
+          pooled_cpu_buffer_,
+          cpu_buffer_pool_->GetBuffer(
+              {/*size_bytes=*/static_cast<size_t>(
+                   std::max(memory_alignment_, bytes())),
+               /*alignment=*/memory_alignment_}));
+      cpu_buffer_ = pooled_cpu_buffer_->data();
+      return absl::OkStatus();
+    }
     if (memory_alignment_ > 0) {
       // TODO b/339271330 - Investigate how aligned memory performs in
       // MP WebAssembly targets.
@@ -785,6 +818,20 @@ void Tensor::FreeCpuBuffer() const {
   if (cpu_buffer_ == nullptr) {
     return;
   }
+  if (cpu_buffer_release_callback_) {
+    // Aliased memory is owned by the creator of the tensor.
+    auto release_callback =
+        std::exchange(cpu_buffer_release_callback_, nullptr);
+    cpu_buffer_ = nullptr;
+    release_callback();
+    return;
+  }
+  if (pooled_cpu_buffer_) {
+    // Returns the buffer to the pool.
+    pooled_cpu_buffer_ = nullptr;
+    cpu_buffer_ = nullptr;
+    return;
+  }
 #if MEDIAPIPE_METAL_ENABLED
   free(cpu_buffer_);
 #else
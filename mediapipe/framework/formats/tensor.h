@@ -29,6 +29,7 @@
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
 #include "mediapipe/framework/formats/tensor/internal.h"
 #include "mediapipe/framework/memory_manager.h"
 // Exports MEDIAPIPE_TENSOR_USE_AHWB macro.
@@ -163,6 +164,15 @@ class Tensor {
   Tensor(ElementType element_type, const Shape& shape,
          const QuantizationParameters& quantization_parameters,
          MemoryManager* memory_manager = nullptr, int memory_alignment = 0);
+  // Creates a CPU tensor that aliases `cpu_buffer` instead of allocating its
+  // own storage. `cpu_buffer` must hold at least `bytes()` bytes of valid
+  // content and must not be modified or freed until `release_callback` is
+  // invoked, which happens once the tensor is destroyed. On Metal builds the
+  // buffer must be page aligned and padded to whole pages to be accessible
+  // through Metal views.
+  Tensor(ElementType element_type, const Shape& shape,
+         const QuantizationParameters& quantization_parameters,
+         void* cpu_buffer, absl::AnyInvocable<void()> release_callback);
 
   // Non-copyable.
   Tensor(const Tensor&) = delete;
@@ -457,6 +467,12 @@ class Tensor {
   mutable absl::Mutex view_mutex_;
 
   mutable void* cpu_buffer_ = nullptr;
+  // Set if `cpu_buffer_` aliases memory owned by the creator of the tensor.
+  mutable absl::AnyInvocable<void()> cpu_buffer_release_callback_;
+  // Recycles CPU storage if the tensor was created with a memory manager.
+  std::shared_ptr<CpuBufferPool> cpu_buffer_pool_;
+  // Set if `cpu_buffer_` is owned by `cpu_buffer_pool_`.
+  mutable std::shared_ptr<CpuBuffer> pooled_cpu_buffer_;
   absl::Status AllocateCpuBuffer() const;
   void FreeCpuBuffer() const;
   // Forward declaration of the MtlResources provides compile-time verification
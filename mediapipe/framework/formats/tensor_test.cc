@@ -5,7 +5,9 @@
 #include <string>
 #include <vector>
 
+#include "mediapipe/framework/memory_manager.h"
 #include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/gpu/multi_pool.h"
 #if !MEDIAPIPE_DISABLE_GPU
 #include "mediapipe/gpu/gl_calculator_helper.h"
 #include "mediapipe/gpu/gpu_buffer_format.h"
@@ -95,6 +97,44 @@ TEST(Cpu, TestViewMove) {
   EXPECT_EQ(v1.buffer<float>(), nullptr);  // NOLINT
 }
 
+TEST(Cpu, TestAliasedCpuBuffer) {
+  std::vector<float> data = {1.0f, 2.0f, 3.0f};
+  int num_releases = 0;
+  {
+    Tensor t1(Tensor::ElementType::kFloat32, Tensor::Shape{1, 3},
+              Tensor::QuantizationParameters(), data.data(),
+              [&num_releases] { ++num_releases; });
+    Tensor t2(std::move(t1));
+    EXPECT_EQ(num_releases, 0);
+    auto view = t2.GetCpuReadView();
+    EXPECT_EQ(view.buffer<float>(), data.data());
+    EXPECT_EQ(view.buffer<float>()[2], 3.0f);
+  }
+  EXPECT_EQ(num_releases, 1);
+}
+
+#if !MEDIAPIPE_METAL_ENABLED
+TEST(Cpu, TestPooledCpuBuffer) {
+  MultiPoolOptions options;
+  options.min_requests_before_pool = 0;
+  MemoryManager memory_manager(options);
+  const void* data = nullptr;
+  {
+    Tensor t1(Tensor::ElementType::kFloat32, Tensor::Shape{1, 3},
+              &memory_manager, /*memory_alignment=*/64);
+    auto view = t1.GetCpuWriteView();
+    data = view.buffer<float>();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % 64, 0);
+  }
+  // A tensor with different element type and shape but the same byte size
+  // reuses the released buffer.
+  Tensor t2(Tensor::ElementType::kInt32, Tensor::Shape{3},
+            &memory_manager, /*memory_alignment=*/64);
+  EXPECT_EQ(t2.GetCpuWriteView().buffer<int32_t>(), data);
+  EXPECT_EQ(memory_manager.GetCpuBufferPool()->GetStats().hits, 1);
+}
+#endif  // !MEDIAPIPE_METAL_ENABLED
+
 }  // namespace mediapipe
 
 int main(int argc, char** argv) {
@@ -0,0 +1,46 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_GRAPH_EXECUTOR_SERVICE_H_
+#define MEDIAPIPE_FRAMEWORK_GRAPH_EXECUTOR_SERVICE_H_
+
+#include <memory>
+
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/graph_service.h"
+
+namespace mediapipe {
+
+// The default executor of a graph, i.e. the executor running all nodes not
+// assigned to another one.
+struct GraphExecutor {
+  std::shared_ptr<Executor> executor;
+  // Number of threads running the tasks of `executor`.
+  int num_threads = 1;
+};
+
+// The service lets calculators split the work of a single Process call across
+// the threads of the graph's default executor, see
+// mediapipe/util/parallel_for.h.
+//
+// CalculatorGraph provides it unless the graph runs on the application thread.
+// When a node requires it, i.e. not as Optional(), and the default executor's
+// number of threads is not configured, the graph sizes its thread pool to the
+// number of CPU cores.
+inline constexpr GraphService<GraphExecutor> kGraphExecutorService(
+    "GraphExecutorService", GraphServiceBase::kDisallowDefaultInitialization);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_GRAPH_EXECUTOR_SERVICE_H_
@@ -0,0 +1,37 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_IMAGE_FRAME_BUFFER_POOL_SERVICE_H_
+#define MEDIAPIPE_FRAMEWORK_IMAGE_FRAME_BUFFER_POOL_SERVICE_H_
+
+#include "mediapipe/framework/formats/image_frame_buffer_pool.h"
+#include "mediapipe/framework/graph_service.h"
+
+namespace mediapipe {
+
+// Graph service recycling the pixel data of CPU frames allocated with
+// CalculatorContext::AllocateImageFrame.
+//
+// CalculatorGraph creates a pool with default options unless one is set
+// before initialization, e.g. to share a pool across graphs:
+//   graph.SetServiceObject(kImageFrameBufferPoolService,
+//                          std::make_shared<ImageFrameBufferPool>(options));
+inline constexpr GraphService<ImageFrameBufferPool>
+    kImageFrameBufferPoolService(
+        "ImageFrameBufferPoolService",
+        GraphServiceBase::kDisallowDefaultInitialization);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_IMAGE_FRAME_BUFFER_POOL_SERVICE_H_
@@ -0,0 +1,38 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/memory_manager.h"
+
+#include <memory>
+
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+#include "mediapipe/gpu/multi_pool.h"
+
+namespace mediapipe {
+
+MemoryManager::MemoryManager()
+    : cpu_buffer_pool_(std::make_shared<CpuBufferPool>()) {
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
+  hardware_buffer_pool_ = std::make_shared<HardwareBufferPool>();
+#endif
+}
+
+MemoryManager::MemoryManager(const MultiPoolOptions& options)
+    : cpu_buffer_pool_(std::make_shared<CpuBufferPool>(options)) {
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
+  hardware_buffer_pool_ = std::make_shared<HardwareBufferPool>(options);
+#endif
+}
+
+}  // namespace mediapipe
@@ -26,6 +26,11 @@
 
 namespace mediapipe {
 
+// See mediapipe/framework/formats/cpu_buffer_pool.h.
+class CpuBufferPool;
+// See mediapipe/gpu/multi_pool.h.
+struct MultiPoolOptions;
+
 // Owns buffer pools to provide access to pooled buffer objects. Access is
 // managed via shared_ptrs to allow clients of buffer objects to control their
 // lifetime.
@@ -52,12 +57,18 @@ namespace mediapipe {
 // 3) Pass Calculator::memory_manager_ to the Tensor class constructor:
 //       Tensor tensor(Tensor::ElementType::kFloat32,
 //                     Tensor::Shape{kTensorSize}, &memory_manager_);
+//
+// CPU tensor storage is recycled through GetCpuBufferPool(), so calculators
+// emitting tensors of the same size for every frame stop allocating once the
+// pool is warm.
 class MemoryManager {
  public:
-  MemoryManager() {
-#ifdef MEDIAPIPE_TENSOR_USE_AHWB
-    hardware_buffer_pool_ = std::make_shared<HardwareBufferPool>();
-#endif
+  MemoryManager();
+  explicit MemoryManager(const MultiPoolOptions& options);
+
+  // Pool recycling the CPU storage of tensors.
+  std::shared_ptr<CpuBufferPool> GetCpuBufferPool() const {
+    return cpu_buffer_pool_;
   }
 
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
@@ -66,12 +77,8 @@ class MemoryManager {
   }
 #endif
 
-#ifdef MEDIAPIPE_TENSOR_USE_AHWB
-  explicit MemoryManager(const MultiPoolOptions& options)
-      : hardware_buffer_pool_(std::make_shared<HardwareBufferPool>(options)) {}
-#endif
-
  private:
+  std::shared_ptr<CpuBufferPool> cpu_buffer_pool_;
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
   std::shared_ptr<HardwareBufferPool> hardware_buffer_pool_;
 #endif
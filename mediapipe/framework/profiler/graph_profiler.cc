@@ -237,6 +237,7 @@ void GraphProfiler::Reset() {
          *(calculator_profile->mutable_input_stream_profiles())) {
       ResetTimeHistogram(input_stream_profile.mutable_latency());
     }
+    calculator_profile->clear_image_frame_pool();
   }
 }
 
@@ -490,6 +491,30 @@ void GraphProfiler::SetCloseRuntime(const CalculatorContext& calculator_context,
   }
 }
 
+void GraphProfiler::AddImageFramePoolRequests(
+    CalculatorContext& calculator_context) {
+  if (calculator_context.image_frame_pool_hits_ == 0 &&
+      calculator_context.image_frame_pool_misses_ == 0) {
+    return;
+  }
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(calculator_context.NodeName());
+  ABSL_CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  BufferPoolProfile* pool_profile =
+      profile_iter->second.mutable_image_frame_pool();
+  pool_profile->set_hits(pool_profile->hits() +
+                         calculator_context.image_frame_pool_hits_);
+  pool_profile->set_misses(pool_profile->misses() +
+                           calculator_context.image_frame_pool_misses_);
+  calculator_context.image_frame_pool_hits_ = 0;
+  calculator_context.image_frame_pool_misses_ = 0;
+}
+
 void GraphProfiler::AddTimeSample(int64_t start_time_usec,
                                   int64_t end_time_usec,
                                   TimeHistogram* histogram) {
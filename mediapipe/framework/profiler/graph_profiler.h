@@ -215,6 +215,7 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
           default:
             break;
         }
+        profiler_->AddImageFramePoolRequests(calculator_context_);
       }
       if (profiler_->is_tracing_) {
         absl::Time time_now = absl::FromUnixMicros(end_time_usec);
@@ -225,7 +226,7 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
 
    private:
     const GraphTrace::EventType calculator_method_;
-    const CalculatorContext& calculator_context_;
+    CalculatorContext& calculator_context_;
     GraphProfiler* profiler_;
     int64_t start_time_usec_;
   };
@@ -292,6 +293,11 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
                        int64_t start_time_usec, int64_t end_time_usec)
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Moves the image frame pool requests counted by `calculator_context` to
+  // the calculator's profile.
+  void AddImageFramePoolRequests(CalculatorContext& calculator_context)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
   // Updates the input streams profiles for the calculator and returns the
   // minimum |source_process_start_usec| of all input packets, excluding empty
   // packets and back-edge packets. Returns -1 if there is no input packets.
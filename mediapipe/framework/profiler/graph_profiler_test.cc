@@ -23,6 +23,8 @@
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
 #include "mediapipe/framework/port/gmock.h"
@@ -1363,6 +1365,61 @@ TEST(GraphProfilerTest, CaptureProfilePopulateConfig) {
                   )pb"))));
 }
 
+// Outputs a frame allocated from the graph's frame pool for each input packet.
+class FrameAllocatingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<ImageFrame>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).Add(
+        cc->AllocateImageFrame(ImageFormat::SRGB, 64, 64).release(),
+        cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(FrameAllocatingCalculator);
+
+TEST(GraphProfilerTest, ReportsImageFramePoolRequests) {
+  CalculatorGraphConfig config;
+  QCHECK(google::protobuf::TextFormat::ParseFromString(R"(
+    profiler_config {
+      enable_profiler: true
+    }
+    input_stream: "input"
+    node {
+      calculator: "FrameAllocatingCalculator"
+      input_stream: "input"
+      output_stream: "frame"
+    }
+    )",
+                                                       &config));
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "frame", [](const Packet&) { return absl::OkStatus(); }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  std::vector<CalculatorProfile> profiles;
+  MP_ASSERT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+  ASSERT_EQ(profiles.size(), 1);
+  const BufferPoolProfile& pool_profile = profiles[0].image_frame_pool();
+  EXPECT_EQ(pool_profile.hits() + pool_profile.misses(), 10);
+  // Frames are released before the next one is allocated, so the pool serves
+  // all but the frames allocated before it is warm.
+  EXPECT_GE(pool_profile.hits(), 7);
+}
+
 TEST_F(GraphProfilerTestPeer, ExecutorRunEarly) {
   // Checks defaults before initialization.
   ASSERT_EQ(GetIsInitialized(), false);
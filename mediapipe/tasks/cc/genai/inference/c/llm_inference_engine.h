@@ -75,11 +75,12 @@ typedef struct {
   // Number of decode steps per sync. Used by GPU only. The default value is 3.
   size_t num_decode_steps_per_sync;
 
-  // Sequence batch size for encoding. Used by GPU only. Number of input tokens
-  // to process at a time for batch processing. Setting this value to 1 means
-  // both the encoding and decoding share the same graph of sequence length
-  // of 1. Setting this value to 0 means the batch size will be optimized
-  // programmatically.
+  // Sequence batch size for encoding. Number of input tokens to process at a
+  // time for batch processing. On GPU, setting this value to 1 means both the
+  // encoding and decoding share the same graph of sequence length of 1. On CPU,
+  // prompts are prefilled in chunks of this many tokens. Setting this value to
+  // 0 means the batch size will be optimized programmatically on GPU, and
+  // prompts are prefilled at once on CPU.
   size_t sequence_batch_size;
 
   // Number of supported lora ranks for the base model. Used by GPU only.
@@ -107,6 +108,22 @@ typedef struct {
   // initialization may finish before weights have finished uploading which
   // might push some of the weight upload time into input processing.
   bool wait_for_weight_uploads;
+
+  // Maximum number of sessions decoded together in one batch. Used by CPU
+  // only. Concurrent sessions join and leave the batch between decode steps.
+  // Setting this value to 0 or 1 runs each session on its own.
+  size_t max_batch_size;
+
+  // Maximum number of prompt tokens whose KV cache is kept across sessions.
+  // Used by CPU only. Prompts sharing a prefix with recent prompts, e.g. a
+  // system prompt, skip prefilling that prefix. Setting this value to 0
+  // disables the cache. Not used when sessions are batched.
+  size_t max_num_prefix_cache_tokens;
+
+  // Optional path to the draft model of speculative decoding, a smaller model
+  // sharing the tokenizer of the main model. Used by CPU only, together with
+  // `num_draft_tokens`.
+  const char* draft_model_path;
 } LlmModelSettings;
 
 // LlmSessionConfig configures how to execute the model.
@@ -37,6 +37,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -50,8 +52,10 @@
 #include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/scoped_file.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_batch_scheduler.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_builder_factory.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/speculative_decoder.h"
 #include "sentencepiece/src/sentencepiece_processor.h"  // from @com_google_sentencepiece
 #include "sentencepiece/src/util.h"  // from @com_google_sentencepiece
 #include "tensorflow/lite/c/common.h"
@@ -79,8 +83,16 @@ struct LlmInferenceEngineCpu_Engine {
   const int start_token_id;
   const std::vector<std::string> stop_tokens;
   const size_t max_num_tokens;
+  // Set if the sessions are decoded in batches.
+  std::unique_ptr<mediapipe::tasks::genai::xnn_utils::LlmBatchScheduler>
+      batch_scheduler;
+  // Set if the sessions are decoded with a draft model.
+  std::unique_ptr<mediapipe::tasks::genai::xnn_utils::SpeculativeDecoder>
+      speculative_decoder;
 
   ~LlmInferenceEngineCpu_Engine() {
+    batch_scheduler.reset();
+    speculative_decoder.reset();
     delete tokenizer;
     delete bytes_to_unicode_mapper;
     delete unicode_to_bytes_mapper;
@@ -170,6 +182,48 @@ std::string MapUnicodeToBytes(
   return converted_output;
 }
 
+// Decodes `token_id`, checks the stop tokens and emits the ready output of
+// `cpu_session`.
+void process_next_token(LlmInferenceEngineCpu_Session* cpu_session,
+                        int token_id) {
+  cpu_session->next_token_id = token_id;
+
+  std::string token = cpu_session->engine->tokenizer->IdToPiece(token_id);
+  if (cpu_session->engine->unicode_to_bytes_mapper != nullptr) {
+    token =
+        MapUnicodeToBytes(token, cpu_session->engine->unicode_to_bytes_mapper);
+  } else {
+    token = absl::StrReplaceAll(token, {{"▁", " "}});
+  }
+  cpu_session->last_10_char.append(token);
+
+  int stop_index;
+  for (const auto& stop_token : cpu_session->engine->stop_tokens) {
+    stop_index = cpu_session->last_10_char.find(stop_token);
+    if (stop_index != std::string::npos) {
+      cpu_session->early_stop = true;
+      cpu_session->last_10_char =
+          cpu_session->last_10_char.substr(0, stop_index);
+      break;
+    }
+  }
+
+  std::string ready_char = "";
+  if (cpu_session->early_stop) {
+    ready_char = cpu_session->last_10_char;
+  } else if (cpu_session->last_10_char.size() > kCheckLastKChars) {
+    ready_char = cpu_session->last_10_char.substr(
+        0, cpu_session->last_10_char.size() - kCheckLastKChars);
+    cpu_session->last_10_char = cpu_session->last_10_char.substr(
+        cpu_session->last_10_char.size() - kCheckLastKChars);
+  }
+  cpu_session->final_output.append(ready_char);
+
+  cpu_session->cpu_callback(ready_char);
+
+  ++cpu_session->timestep;
+}
+
 void* next_token_function(void* args) {
   struct LlmInferenceEngineCpu_Session* cpu_session =
       (struct LlmInferenceEngineCpu_Session*)args;
@@ -219,53 +273,15 @@ void* next_token_function(void* args) {
       cpu_session->early_stop = true;
     }
 
-    cpu_session->next_token_id = token_ids_per_step[0];
-
-    std::string token =
-        cpu_session->engine->tokenizer->IdToPiece(token_ids_per_step[0]);
-    if (cpu_session->engine->unicode_to_bytes_mapper != nullptr) {
-      token = MapUnicodeToBytes(token,
-                                cpu_session->engine->unicode_to_bytes_mapper);
-    } else {
-      token = absl::StrReplaceAll(token, {{"▁", " "}});
-    }
-    cpu_session->last_10_char.append(token);
-
-    int stop_index;
-    for (const auto& stop_token : cpu_session->engine->stop_tokens) {
-      stop_index = cpu_session->last_10_char.find(stop_token);
-      if (stop_index != std::string::npos) {
-        cpu_session->early_stop = true;
-        cpu_session->last_10_char =
-            cpu_session->last_10_char.substr(0, stop_index);
-        break;
-      }
-    }
-
-    std::string ready_char = "";
-    if (cpu_session->early_stop) {
-      ready_char = cpu_session->last_10_char;
-    } else if (cpu_session->last_10_char.size() > kCheckLastKChars) {
-      ready_char = cpu_session->last_10_char.substr(
-          0, cpu_session->last_10_char.size() - kCheckLastKChars);
-      cpu_session->last_10_char = cpu_session->last_10_char.substr(
-          cpu_session->last_10_char.size() - kCheckLastKChars);
-    }
-    cpu_session->final_output.append(ready_char);
-
-    cpu_session->cpu_callback(ready_char);
-
-    ++cpu_session->timestep;
+    process_next_token(cpu_session, token_ids_per_step[0]);
 
     next_token_function(args);
   }
   return nullptr;
 };
 
-void* start_llm_function(void* args) {
-  struct LlmInferenceEngineCpu_Session* cpu_session =
-      (struct LlmInferenceEngineCpu_Session*)args;
-
+std::vector<int> encode_prompt(
+    const LlmInferenceEngineCpu_Session* cpu_session) {
   std::vector<int> prompt_ids = {};
 
   std::string prompt;
@@ -282,6 +298,14 @@ void* start_llm_function(void* args) {
     ABSL_LOG(FATAL) << "Failed to encode input: " << status;
   }
   prompt_ids.insert(prompt_ids.begin(), cpu_session->engine->start_token_id);
+  return prompt_ids;
+}
+
+void* start_llm_function(void* args) {
+  struct LlmInferenceEngineCpu_Session* cpu_session =
+      (struct LlmInferenceEngineCpu_Session*)args;
+
+  std::vector<int> prompt_ids = encode_prompt(cpu_session);
 
   if (std::holds_alternative<mediapipe::tasks::genai::xnn_utils::Llm*>(
           cpu_session->engine->llm)) {
@@ -315,6 +339,110 @@ void* start_llm_function(void* args) {
   return nullptr;
 }
 
+void* start_batched_llm_function(void* args) {
+  struct LlmInferenceEngineCpu_Session* cpu_session =
+      (struct LlmInferenceEngineCpu_Session*)args;
+  std::vector<int> prompt_ids = encode_prompt(cpu_session);
+  cpu_session->timestep = prompt_ids.size();
+  const absl::Status status = cpu_session->engine->batch_scheduler->Run(
+      std::move(prompt_ids), cpu_session->engine->max_num_tokens,
+      [cpu_session](int token_id) {
+        process_next_token(cpu_session, token_id);
+        return !cpu_session->early_stop;
+      });
+  if (!status.ok()) {
+    // Only this session fails, the others keep decoding in their batches.
+    ABSL_LOG(ERROR) << "Failed to generate output: " << status;
+    if (!cpu_session->early_stop) {
+      cpu_session->early_stop = true;
+      cpu_session->final_output.append(cpu_session->last_10_char);
+      cpu_session->cpu_callback(cpu_session->last_10_char);
+    }
+  }
+  return nullptr;
+}
+
+void* start_speculative_llm_function(void* args) {
+  struct LlmInferenceEngineCpu_Session* cpu_session =
+      (struct LlmInferenceEngineCpu_Session*)args;
+  auto* decoder = cpu_session->engine->speculative_decoder.get();
+
+  std::vector<int> prompt_ids = encode_prompt(cpu_session);
+  cpu_session->timestep = prompt_ids.size();
+  ABSL_CHECK_OK(decoder->Reset(std::move(prompt_ids)));
+
+  const auto initial_stats = decoder->stats();
+  const absl::Time start_time = absl::Now();
+  size_t num_decoded_tokens = 0;
+  while (cpu_session->timestep < cpu_session->engine->max_num_tokens &&
+         !cpu_session->early_stop) {
+    auto token_ids = decoder->Step();
+    if (absl::IsOutOfRange(token_ids.status())) {
+      // No room is left to verify the draft tokens.
+      cpu_session->early_stop = true;
+      cpu_session->final_output.append(cpu_session->last_10_char);
+      cpu_session->cpu_callback(cpu_session->last_10_char);
+      break;
+    }
+    if (!token_ids.ok()) {
+      ABSL_LOG(FATAL) << "Failed to generate output: " << token_ids.status();
+    }
+    for (int token_id : *token_ids) {
+      if (cpu_session->early_stop ||
+          cpu_session->timestep >= cpu_session->engine->max_num_tokens) {
+        break;
+      }
+      process_next_token(cpu_session, token_id);
+      ++num_decoded_tokens;
+    }
+  }
+
+  const auto& stats = decoder->stats();
+  const size_t num_drafted_tokens =
+      stats.num_drafted_tokens - initial_stats.num_drafted_tokens;
+  const size_t num_accepted_tokens =
+      stats.num_accepted_tokens - initial_stats.num_accepted_tokens;
+  ABSL_LOG(INFO) << "Speculative decoding: "
+                 << num_decoded_tokens /
+                        absl::ToDoubleSeconds(absl::Now() - start_time)
+                 << " tokens/s, accepted " << num_accepted_tokens << " of "
+                 << num_drafted_tokens << " draft tokens.";
+  return nullptr;
+}
+
+// Creates the draft model of speculative decoding from
+// `model_settings->draft_model_path`.
+absl::StatusOr<std::unique_ptr<mediapipe::tasks::genai::xnn_utils::Llm>>
+CreateXnnDraftLlm(const LlmModelSettings* model_settings) {
+  MP_ASSIGN_OR_RETURN(auto model_file,
+                      mediapipe::tasks::genai::llm_utils::ScopedFile::Open(
+                          model_settings->draft_model_path));
+  MP_ASSIGN_OR_RETURN(auto model_data,
+                      mediapipe::tasks::genai::llm_utils::ModelData::Create(
+                          std::move(model_file)));
+  auto llm_params =
+      mediapipe::tasks::genai::xnn_utils::LlmParams::FromLLMParametersProto(
+          model_data->GetLlmParameters());
+  auto model_type = model_data->GetModelType();
+  RET_CHECK(model_type) << "Failed to get draft model type.";
+  MP_ASSIGN_OR_RETURN(auto backend,
+                      model_data->ReadMetadata(
+                          mediapipe::tasks::genai::llm_utils::kLlmBackendName));
+  RET_CHECK_EQ(backend, "cpu");
+  model_data.reset();
+
+  llm_params.seq_size_T = model_settings->max_num_tokens;
+  llm_params.cache_dir = model_settings->cache_dir;
+  llm_params.draft_size_G = 0;
+  return mediapipe::tasks::genai::xnn_utils::CreateLlm(
+      llm_params,
+      std::make_unique<mediapipe::tasks::genai::xnn_utils::RuntimeConfigs>(),
+      std::make_unique<
+          mediapipe::tasks::genai::xnn_utils::DefaultLlmWeightsLoader>(
+          model_settings->draft_model_path, llm_params),
+      nullptr, *model_type);
+}
+
 absl::StatusOr<std::unique_ptr<LlmInferenceEngineCpu_Engine>>
 CreateXnnLlmCpuEngine(const LlmModelSettings* model_settings) {
   MP_ASSIGN_OR_RETURN(auto model_file,
@@ -355,18 +483,62 @@ CreateXnnLlmCpuEngine(const LlmModelSettings* model_settings) {
 
   llm_params.seq_size_T = model_settings->max_num_tokens;
   llm_params.cache_dir = model_settings->cache_dir;
+  llm_params.prefill_chunk_size = model_settings->sequence_batch_size;
+  const bool enable_batching = model_settings->max_batch_size > 1;
+  if (enable_batching) {
+    llm_params.batch_size_B = model_settings->max_batch_size;
+    llm_params.enable_batch_attention_mask = true;
+  } else {
+    llm_params.max_num_prefix_cache_steps =
+        model_settings->max_num_prefix_cache_tokens;
+  }
+  const bool enable_speculative_decoding =
+      model_settings->num_draft_tokens > 0 &&
+      model_settings->draft_model_path != nullptr;
+  if (enable_speculative_decoding) {
+    RET_CHECK(!enable_batching)
+        << "Speculative decoding doesn't support batched sessions.";
+    // The target model verifies all draft tokens in one forward pass.
+    llm_params.draft_size_G = model_settings->num_draft_tokens;
+  }
+
+  auto runtime_configs =
+      std::make_unique<mediapipe::tasks::genai::xnn_utils::RuntimeConfigs>();
+  // The weights are loaded before the XNNPACK threads are used, so the layers
+  // are loaded on as many threads.
+  llm_params.num_weights_loading_threads = runtime_configs->xnn_num_threads;
 
   auto weight_loader = std::make_unique<
       mediapipe::tasks::genai::xnn_utils::DefaultLlmWeightsLoader>(
       model_settings->model_path, llm_params);
 
-  auto runtime_configs =
-      std::make_unique<mediapipe::tasks::genai::xnn_utils::RuntimeConfigs>();
-
+  const absl::Time create_llm_start = absl::Now();
   MP_ASSIGN_OR_RETURN(auto llm,
                       mediapipe::tasks::genai::xnn_utils::CreateLlm(
                           llm_params, std::move(runtime_configs),
                           std::move(weight_loader), nullptr, *model_type));
+  ABSL_LOG(INFO) << "Created the LLM in "
+                 << absl::ToDoubleMilliseconds(absl::Now() - create_llm_start)
+                 << " ms.";
+
+  std::unique_ptr<mediapipe::tasks::genai::xnn_utils::LlmBatchScheduler>
+      batch_scheduler;
+  if (enable_batching) {
+    // Fails early if the model can't hold sequences of different lengths.
+    MP_RETURN_IF_ERROR(llm->SetBatchStartSteps(
+        std::vector<size_t>(llm_params.batch_size_B, 0)));
+    batch_scheduler = std::make_unique<
+        mediapipe::tasks::genai::xnn_utils::LlmBatchScheduler>(llm.get());
+  }
+  std::unique_ptr<mediapipe::tasks::genai::xnn_utils::SpeculativeDecoder>
+      speculative_decoder;
+  if (enable_speculative_decoding) {
+    MP_ASSIGN_OR_RETURN(auto draft_llm, CreateXnnDraftLlm(model_settings));
+    MP_ASSIGN_OR_RETURN(
+        speculative_decoder,
+        mediapipe::tasks::genai::xnn_utils::SpeculativeDecoder::Create(
+            llm.get(), std::move(draft_llm)));
+  }
 
   auto tokenizer = std::make_unique<sentencepiece::SentencePieceProcessor>();
   MP_RETURN_IF_ERROR(tokenizer->LoadFromSerializedProto(spm_model_content));
@@ -395,6 +567,8 @@ CreateXnnLlmCpuEngine(const LlmModelSettings* model_settings) {
               std::vector<std::string>(llm_params_proto.stop_tokens().begin(),
                                        llm_params_proto.stop_tokens().end()),
           .max_num_tokens = model_settings->max_num_tokens,
+          .batch_scheduler = std::move(batch_scheduler),
+          .speculative_decoder = std::move(speculative_decoder),
       });
 
   return engine;
@@ -654,8 +828,13 @@ void LlmInferenceEngine_Session_PredictAsync(
 
   pthread_t work_id = 0;
   cpu_session->work_id = work_id;
-  pthread_create(&cpu_session->work_id, nullptr, start_llm_function,
-                 cpu_session);
+  void* (*start_function)(void*) = start_llm_function;
+  if (cpu_session->engine->batch_scheduler) {
+    start_function = start_batched_llm_function;
+  } else if (cpu_session->engine->speculative_decoder) {
+    start_function = start_speculative_llm_function;
+  }
+  pthread_create(&cpu_session->work_id, nullptr, start_function, cpu_session);
 }
 
 int LlmInferenceEngine_Session_Clone(
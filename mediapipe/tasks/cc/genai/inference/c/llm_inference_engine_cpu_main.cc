@@ -22,6 +22,11 @@
 // This binary should only be used as an example to run the
 // llm_inference_engine_c_api
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
@@ -35,6 +40,8 @@
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/tasks/cc/genai/inference/c/llm_inference_engine.h"
@@ -63,13 +70,42 @@ ABSL_FLAG(
 ABSL_FLAG(std::optional<uint32_t>, random_seed, std::nullopt,
           "Random seed for sampling tokens.");
 
+ABSL_FLAG(std::optional<std::string>, draft_model_path, std::nullopt,
+          "Path to a smaller model sharing the tokenizer, which drafts tokens "
+          "for speculative decoding.");
+
+ABSL_FLAG(int, num_draft_tokens, 4,
+          "Number of tokens drafted per step when --draft_model_path is set.");
+
 ABSL_FLAG(
     std::optional<std::string>, prompt, std::nullopt,
     "The input prompt to be fed to the model. The flag is not relevant when "
     "running the benchmark, i.e. the input_token_limits value is set.");
 
+ABSL_FLAG(bool, evict_page_cache, false,
+          "Whether to evict the model files from the page cache before "
+          "creating the engine, to measure the creation time of a cold start.");
+
 namespace {
 
+// Evicts the clean pages of the file at `path` from the page cache, so that
+// they are read from storage again when mapped.
+void EvictPageCache(const std::string& path) {
+#ifndef _WIN32
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    ABSL_LOG(WARNING) << "Failed to open " << path;
+    return;
+  }
+  if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0) {
+    ABSL_LOG(WARNING) << "Failed to evict " << path << " from the page cache.";
+  }
+  close(fd);
+#else
+  ABSL_LOG(WARNING) << "Evicting the page cache is not supported.";
+#endif  // !_WIN32
+}
+
 // Only cout the first response
 void async_callback_print(void*, LlmResponseContext* response_context) {
   std::cout << response_context->response_array[0] << std::flush;
@@ -103,10 +139,19 @@ int main(int argc, char** argv) {
   const float temperature = absl::GetFlag(FLAGS_temperature).value_or(0.0f);
   const uint32_t random_seed = absl::GetFlag(FLAGS_random_seed).value_or(0);
 
+  const std::optional<std::string> draft_model_path =
+      absl::GetFlag(FLAGS_draft_model_path);
+
   const LlmModelSettings model_settings = {
       .model_path = model_path.c_str(),
       .cache_dir = cache_dir.c_str(),
       .max_num_tokens = max_tokens,
+      .num_draft_tokens =
+          draft_model_path.has_value()
+              ? static_cast<size_t>(absl::GetFlag(FLAGS_num_draft_tokens))
+              : 0,
+      .draft_model_path =
+          draft_model_path.has_value() ? draft_model_path->c_str() : nullptr,
   };
 
   const LlmSessionConfig session_config = {
@@ -118,9 +163,17 @@ int main(int argc, char** argv) {
 
   ABSL_LOG(INFO) << "Prompt: " << prompt.value();
 
+  if (absl::GetFlag(FLAGS_evict_page_cache)) {
+    EvictPageCache(model_path);
+    if (draft_model_path.has_value()) {
+      EvictPageCache(*draft_model_path);
+    }
+  }
+
   // Create Llm inference engine session.
   void* llm_engine = nullptr;
   char* error_msg = nullptr;
+  const absl::Time create_engine_start = absl::Now();
   int error_code =
       LlmInferenceEngine_CreateEngine(&model_settings, &llm_engine, &error_msg);
   if (error_code) {
@@ -128,6 +181,10 @@ int main(int argc, char** argv) {
     free(error_msg);
     return EXIT_FAILURE;
   }
+  ABSL_LOG(INFO) << "Created the engine in "
+                 << absl::ToDoubleMilliseconds(absl::Now() -
+                                               create_engine_start)
+                 << " ms.";
   void* llm_engine_session = nullptr;
   error_code = LlmInferenceEngine_CreateSession(
       llm_engine, &session_config, &llm_engine_session, &error_msg);
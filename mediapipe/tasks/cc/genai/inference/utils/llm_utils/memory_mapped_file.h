@@ -47,6 +47,11 @@ class MemoryMappedFile {
   static absl::StatusOr<std::unique_ptr<MemoryMappedFile>> CreateMutable(
       absl::string_view path);
 
+  // Hints that [data, data + length) of a mapped file will be accessed soon,
+  // so that its pages are read in asynchronously. Best effort, e.g. a no-op
+  // for memory not mapped from a file.
+  static void Prefetch(const void* data, uint64_t length);
+
   virtual ~MemoryMappedFile() = default;
 
   // Returns the file size in bytes.
@@ -90,6 +90,16 @@ absl::StatusOr<std::unique_ptr<MemoryMappedFile>> MemoryMappedFile::Create(
   return std::make_unique<MemoryMappedFilePosix>(length, data);
 }
 
+// static
+void MemoryMappedFile::Prefetch(const void* data, uint64_t length) {
+  if (length == 0) return;
+  // madvise() takes a page aligned address.
+  const uintptr_t page_size = getpagesize();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(data) + length;
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
 absl::StatusOr<std::unique_ptr<MemoryMappedFile>>
 MemoryMappedFile::CreateMutable(absl::string_view path) {
   MP_ASSIGN_OR_RETURN(auto scoped_file, ScopedFile::OpenWritable(path));
@@ -107,6 +107,15 @@ absl::StatusOr<std::unique_ptr<MemoryMappedFile>> MemoryMappedFile::Create(
                     false);
 }
 
+// static
+void MemoryMappedFile::Prefetch(const void* data, uint64_t length) {
+  if (length == 0) return;
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<void*>(data);
+  range.NumberOfBytes = length;
+  ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+}
+
 absl::StatusOr<std::unique_ptr<MemoryMappedFile>>
 MemoryMappedFile::CreateMutable(absl::string_view path) {
   MP_ASSIGN_OR_RETURN(auto scoped_file, ScopedFile::OpenWritable(path));
@@ -29,6 +29,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
 #include "xnnpack.h"  // from @XNNPACK
 
@@ -59,6 +60,21 @@ absl::StatusOr<std::shared_ptr<Tensor>> BenchmarkWeightAccessor::LoadWeight(
       }
     }
     MP_RETURN_IF_ERROR(result->LoadFromBuffer(real_data.data()));
+  } else if (data_type_ == xnn_datatype_qbint4) {
+    auto q_result = std::make_shared<QBTensor>(dims, block_size_);
+    std::string real_data((q_result->num_elements + 1) / 2, 0xA5);
+    if (rng.has_value()) {
+      std::uniform_int_distribution<int8_t> dist(-127, 126);
+      for (auto& c : real_data) {
+        c = dist(*rng);
+      }
+    }
+    MP_RETURN_IF_ERROR(q_result->LoadFromBuffer(real_data.data()));
+    auto real_scale = std::make_shared<std::vector<uint16_t>>(
+        dims[0] * q_result->num_blocks(), FloatToBFloat16(1.0f));
+    q_result->scale_data =
+        std::shared_ptr<uint16_t>(real_scale, real_scale->data());
+    result = q_result;
   } else {
     std::string real_data;
     auto q_result =
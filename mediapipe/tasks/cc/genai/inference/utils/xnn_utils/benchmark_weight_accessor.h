@@ -33,9 +33,11 @@ class BenchmarkWeightAccessor : public WeightAccessor {
   // data_type is type of the weights, e.g. fp32, qc8 etc. data_type only
   // affects MLP linear weights, weights used in e.g. element-wise multiply are
   // always f32.
+  // `block_size` is the size of the blocks of xnn_datatype_qbint4 weights.
   explicit BenchmarkWeightAccessor(xnn_datatype data_type = xnn_datatype_fp32,
-                                   std::optional<int> seed = std::nullopt)
-      : data_type_(data_type), seed_(seed) {}
+                                   std::optional<int> seed = std::nullopt,
+                                   size_t block_size = 32)
+      : data_type_(data_type), seed_(seed), block_size_(block_size) {}
 
   // Return tensor with expected shape, filled with random data.
   absl::StatusOr<std::shared_ptr<Tensor>> LoadWeight(
@@ -49,6 +51,7 @@ class BenchmarkWeightAccessor : public WeightAccessor {
  protected:
   xnn_datatype data_type_;
   std::optional<int> seed_;
+  size_t block_size_;
 };
 
 // Generate mixed 4/8-bit weights. Following layers are 4-bit, otherwise default
@@ -364,10 +364,17 @@ absl::StatusOr<std::shared_ptr<Tensor>> XnnGraphBuilder::FullConn(
     use_dynamic_quantization =
         runtime_configs_->use_dynamic_quantization.value();
   } else if (weight->datatype == xnn_datatype_qcint8 ||
-             weight->datatype == xnn_datatype_qcint4) {
+             weight->datatype == xnn_datatype_qcint4 ||
+             weight->datatype == xnn_datatype_qbint4) {
     use_dynamic_quantization = true;
   }
   VLOG(3) << "use_dynamic_quantization: " << use_dynamic_quantization;
+  // XNNPACK only multiplies blockwise quantized weights of shape
+  // [output_dim, input_dim] with dynamically quantized inputs.
+  RET_CHECK(weight->datatype != xnn_datatype_qbint4 ||
+            (use_dynamic_quantization && !params.transpose))
+      << "Blockwise quantized weights require dynamic quantization: "
+      << *weight;
   if (use_dynamic_quantization) {
     MP_ASSIGN_OR_RETURN(
         qd_input, IntermediateTensor({input->dims.begin(), input->dims.end()},
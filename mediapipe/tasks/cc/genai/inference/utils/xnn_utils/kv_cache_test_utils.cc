@@ -0,0 +1,47 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/kv_cache_test_utils.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+std::vector<std::shared_ptr<Tensor>> MakeKVCaches(
+    size_t max_seq_len, size_t step_size,
+    const std::vector<std::vector<float>>& values) {
+  std::vector<std::shared_ptr<Tensor>> caches;
+  for (std::vector<float> cache_values : values) {
+    ABSL_CHECK_LE(cache_values.size(), max_seq_len * step_size);
+    cache_values.resize(max_seq_len * step_size, -1);
+    auto cache =
+        std::make_shared<Tensor>(Tensor::DimsType{max_seq_len, step_size});
+    ABSL_CHECK_OK(cache->LoadFromVec(cache_values));
+    caches.push_back(cache);
+  }
+  return caches;
+}
+
+std::vector<float> GetValues(Tensor& cache) {
+  std::vector<float> values;
+  ABSL_CHECK_OK(cache.DumpToVec(values, /*exact_match=*/false));
+  return values;
+}
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
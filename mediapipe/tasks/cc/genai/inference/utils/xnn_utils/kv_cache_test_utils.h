@@ -0,0 +1,40 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_KV_CACHE_TEST_UTILS_H_
+#define MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_KV_CACHE_TEST_UTILS_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+// Helpers for the tests of the KV caches stored outside of the graph, the
+// paged and the prefix KV caches.
+
+// Returns KV caches of shape [max_seq_len, step_size], one per entry of
+// `values`, each holding its values followed by -1.
+std::vector<std::shared_ptr<Tensor>> MakeKVCaches(
+    size_t max_seq_len, size_t step_size,
+    const std::vector<std::vector<float>>& values);
+
+// Returns all values of `cache`.
+std::vector<float> GetValues(Tensor& cache);
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+#endif  // MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_KV_CACHE_TEST_UTILS_H_
@@ -40,6 +40,8 @@
 #include "mediapipe/tasks/cc/genai/inference/common/mdspan.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/paged_kv_cache.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/prefix_kv_cache.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
@@ -52,6 +54,38 @@ namespace {
 using FeedForwardWeights = LlmWeights::FeedForwardWeights;
 using SelfAttentionWeights = LlmWeights::SelfAttentionWeights;
 
+// Returns tokens [start, end) of each batch of `batch_input_ids`.
+std::vector<std::vector<int>> SliceInputIds(
+    absl::Span<const std::vector<int>> batch_input_ids, size_t start,
+    size_t end) {
+  std::vector<std::vector<int>> sliced_ids;
+  sliced_ids.reserve(batch_input_ids.size());
+  for (const auto& input_ids : batch_input_ids) {
+    sliced_ids.emplace_back(input_ids.begin() + start, input_ids.begin() + end);
+  }
+  return sliced_ids;
+}
+
+// Masks out the time steps of each batch before its start step, in
+// `atten_mask` of shape [B, 1, process_seq_len, seq_len].
+absl::Status MaskBatchStartSteps(absl::Span<const size_t> batch_start_steps,
+                                 Tensor& atten_mask) {
+  RET_CHECK_EQ(atten_mask.dims.size(), 4);
+  RET_CHECK_EQ(atten_mask.dims[0], batch_start_steps.size());
+  constexpr float neg_value = 0.8 * std::numeric_limits<float>::lowest();
+  const size_t process_seq_len = atten_mask.dims[2];
+  const size_t seq_len = atten_mask.dims[3];
+  float* row = atten_mask.DataAs<float>();
+  for (size_t start_step : batch_start_steps) {
+    RET_CHECK_LE(start_step, seq_len);
+    for (size_t r = 0; r < process_seq_len; ++r) {
+      std::fill_n(row, start_step, neg_value);
+      row += seq_len;
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<Llm>> Llm::CreateLlm(
@@ -87,6 +121,9 @@ absl::StatusOr<std::unique_ptr<Llm>> Llm::CreatePrefixDecodeLlm(
   RET_CHECK(builder);
   const LlmParams& llm_params = builder->llm_params_;
   RET_CHECK_NE(llm_params.batch_size_B, 0);
+  RET_CHECK(llm_params.prefill_chunk_size == 0 || llm_params.enable_kv_cache)
+          .SetCode(absl::StatusCode::kInvalidArgument)
+      << "Chunked prefill requires the KV cache.";
 
   MP_ASSIGN_OR_RETURN(auto input, builder->NewInput({llm_params.batch_size_B,
                                                      llm_params.seq_size_T,
@@ -140,6 +177,36 @@ absl::StatusOr<std::unique_ptr<Llm>> Llm::CreatePrefixDecodeLlm(
   llm->llm_params_ = llm_params;
   llm->builder_ = builder;
 
+  if (llm_params.enable_kv_cache && llm_params.kv_cache_block_size > 0) {
+    int quantization_bits = 0;
+    switch (llm_params.kv_cache_block_type) {
+      case LlmParams::KVCacheType::FLOAT:
+        break;
+      case LlmParams::KVCacheType::INT8:
+        quantization_bits = 8;
+        break;
+      case LlmParams::KVCacheType::INT4:
+        quantization_bits = 4;
+        break;
+    }
+    MP_ASSIGN_OR_RETURN(
+        llm->kv_cache_block_pool_,
+        KVCacheBlockPool::Create(
+            llm_params.kv_cache_block_size, llm_params.max_num_kv_cache_blocks,
+            llm->KVCacheTensors(), quantization_bits,
+            llm_params.kv_cache_quantization_group_size > 0
+                ? llm_params.kv_cache_quantization_group_size
+                : llm_params.head_dim_H));
+  } else {
+    RET_CHECK(llm_params.kv_cache_block_type == LlmParams::KVCacheType::FLOAT)
+        << "A quantized KV cache requires kv_cache_block_size > 0.";
+  }
+  if (llm_params.enable_kv_cache && llm_params.batch_size_B == 1 &&
+      llm_params.max_num_prefix_cache_steps > 0) {
+    llm->prefix_kv_cache_ =
+        std::make_unique<PrefixKVCache>(llm_params.max_num_prefix_cache_steps);
+  }
+
   return llm;
 }
 
@@ -223,8 +290,63 @@ const std::vector<Llm::KVCache>& Llm::kv_cache() const {
   return context_->kv_cache;
 }
 
+std::vector<std::shared_ptr<Tensor>> Llm::KVCacheTensors() const {
+  std::vector<std::shared_ptr<Tensor>> tensors;
+  tensors.reserve(2 * kv_cache().size());
+  for (const auto& cache : kv_cache()) {
+    tensors.push_back(cache.k_cache);
+    tensors.push_back(cache.v_cache);
+  }
+  return tensors;
+}
+
+absl::Status Llm::SavePagedKVCache() {
+  if (!context_->paged_kv_cache) return absl::OkStatus();
+  const size_t num_steps = TotalTokenSize();
+  // Time steps computed again since the last save, e.g. after SeekTimeStep(),
+  // replace the stored ones.
+  context_->paged_kv_cache->Truncate(
+      std::min(num_saved_kv_cache_steps_, num_steps));
+  MP_RETURN_IF_ERROR(
+      context_->paged_kv_cache->Append(KVCacheTensors(), num_steps));
+  num_saved_kv_cache_steps_ = num_steps;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<size_t> Llm::LoadCachedPrefix(
+    const std::vector<int>& input_ids) {
+  // The last `draft_size_G` + 1 input tokens are always computed, for the
+  // logits.
+  const size_t num_computed = llm_params_.draft_size_G + 1;
+  if (input_ids.size() <= num_computed) return 0;
+  const std::vector<std::shared_ptr<Tensor>> caches = KVCacheTensors();
+  for (const auto& cache : caches) {
+    Tensor::DimsType dims = cache->dims;
+    dims[0] = input_ids.size();
+    cache->Resize(std::move(dims));
+  }
+  MP_ASSIGN_OR_RETURN(
+      const size_t num_cached_steps,
+      prefix_kv_cache_->Lookup(
+          absl::MakeConstSpan(input_ids).first(input_ids.size() - num_computed),
+          caches));
+  batch_prev_ids()[0].assign(input_ids.begin(),
+                             input_ids.begin() + num_cached_steps);
+  // The loaded time steps aren't stored in the blocks of the context yet.
+  num_saved_kv_cache_steps_ = 0;
+  return num_cached_steps;
+}
+
 absl::StatusOr<Llm::Context> Llm::NewContext() const {
   RET_CHECK(runtime_configs_);
+  if (kv_cache_block_pool_) {
+    return Llm::Context{
+        .batch_prev_ids =
+            std::vector<std::vector<int>>(batch_prev_ids().size()),
+        .paged_kv_cache =
+            std::make_shared<PagedKVCache>(kv_cache_block_pool_),
+    };
+  }
   std::shared_ptr<Tensor> new_pivot;
   return Llm::Context{
       .batch_prev_ids = std::vector<std::vector<int>>(batch_prev_ids().size()),
@@ -257,6 +379,26 @@ absl::StatusOr<Llm::Context> Llm::NewContext() const {
 absl::Status Llm::LoadContext(
     absl::Nullable<std::shared_ptr<Context>> context) {
   if (!context || (context_ == context)) return absl::OkStatus();
+  MP_RETURN_IF_ERROR(SavePagedKVCache());
+  if (context->paged_kv_cache) {
+    // The KV cache buffers of the model move to `context`, and are filled with
+    // its stored time steps.
+    context->kv_cache = std::move(kv_cache());
+    context_ = std::move(context);
+    const size_t num_steps = TotalTokenSize();
+    const std::vector<std::shared_ptr<Tensor>> caches = KVCacheTensors();
+    if (num_steps > 0) {
+      for (const auto& cache : caches) {
+        Tensor::DimsType dims = cache->dims;
+        dims[0] = num_steps;
+        cache->Resize(std::move(dims));
+      }
+      MP_RETURN_IF_ERROR(
+          context_->paged_kv_cache->CopyTo(caches, num_steps));
+    }
+    num_saved_kv_cache_steps_ = num_steps;
+    return absl::OkStatus();
+  }
   // There are some metadata we'd like to keep with existing context, also we'd
   // like to use pointer address to distinguish context. So the following logic
   // is: 1) let existing context point to the buffer from new context; 2) move
@@ -316,9 +458,53 @@ absl::Status Llm::AddInputTokens(
   RET_CHECK(!batch_prev_ids().empty());
   const size_t current_seq_len = TotalTokenSize();
 
+  // A new sequence starts from its longest prefix in the prefix cache, and is
+  // cached itself once computed.
+  const bool use_prefix_kv_cache = prefix_kv_cache_ && current_seq_len == 0 &&
+                                   input_seq_len <= llm_params_.seq_size_T;
+  size_t start = 0;
+  if (use_prefix_kv_cache) {
+    MP_ASSIGN_OR_RETURN(start, LoadCachedPrefix(batch_input_ids[0]));
+  }
+
+  // With a causal model, long inputs are processed in chunks, each in its own
+  // graph run. The last chunk keeps at least `draft_size_G` + 1 tokens, for the
+  // logits.
+  if (llm_params_.prefill_chunk_size > 0 &&
+      llm_params_.model_type == LlmParams::ModelType::CAUSAL) {
+    const size_t chunk_size =
+        std::max(llm_params_.prefill_chunk_size, llm_params_.draft_size_G + 1);
+    while (input_seq_len - start > chunk_size + llm_params_.draft_size_G) {
+      MP_RETURN_IF_ERROR(ProcessInputTokens(
+          SliceInputIds(batch_input_ids, start, start + chunk_size)));
+      start += chunk_size;
+    }
+  }
+  if (start == 0) {
+    MP_RETURN_IF_ERROR(ProcessInputTokens(batch_input_ids));
+  } else {
+    MP_RETURN_IF_ERROR(ProcessInputTokens(
+        SliceInputIds(batch_input_ids, start, input_seq_len)));
+  }
+
+  if (use_prefix_kv_cache) {
+    return prefix_kv_cache_->Insert(batch_prev_ids()[0], KVCacheTensors());
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Llm::ProcessInputTokens(
+    absl::Span<const std::vector<int>> batch_input_ids) {
+  const size_t input_seq_len = batch_input_ids.at(0).size();
+  const size_t current_seq_len = TotalTokenSize();
+
   // Let builder re-populate the values of these tensors.
   MP_RETURN_IF_ERROR(builder_->InitAttentionMask(current_seq_len, input_seq_len,
                                                  *atten_masks_));
+  if (!context_->batch_start_steps.empty()) {
+    MP_RETURN_IF_ERROR(
+        MaskBatchStartSteps(context_->batch_start_steps, *atten_masks_));
+  }
   if (!llm_params_.skip_absolute_positional_embeddings) {
     // Initialize the positional embedding data.
     MP_RETURN_IF_ERROR(builder_->InitPosEmbedding(
@@ -377,6 +563,8 @@ absl::Status Llm::AddInputTokens(
     logits_output()->Resize(output_dims);
   }
 
+  num_saved_kv_cache_steps_ =
+      std::min(num_saved_kv_cache_steps_, current_seq_len);
   for (auto& kv_cache : kv_cache()) {
     ABSL_DCHECK(kv_cache.k_slice);
     ABSL_DCHECK(kv_cache.v_slice);
@@ -404,6 +592,22 @@ absl::Status Llm::SeekTimeStep(size_t time_step) {
   return absl::OkStatus();
 }
 
+absl::Status Llm::SetBatchStartSteps(std::vector<size_t> batch_start_steps) {
+  RET_CHECK(llm_params_.enable_batch_attention_mask &&
+            atten_masks_->dims.size() == 4)
+          .SetCode(absl::StatusCode::kFailedPrecondition)
+      << "The model doesn't support one attention mask per batch.";
+  RET_CHECK(llm_params_.skip_absolute_positional_embeddings &&
+            !query_positions_ &&
+            llm_params_.model_type == LlmParams::ModelType::CAUSAL)
+          .SetCode(absl::StatusCode::kFailedPrecondition)
+      << "Batches starting at different time steps require a causal model "
+         "with relative positional embeddings.";
+  RET_CHECK_EQ(batch_start_steps.size(), batch_prev_ids().size());
+  context_->batch_start_steps = std::move(batch_start_steps);
+  return absl::OkStatus();
+}
+
 absl::Status Llm::GetNextToken(std::vector<int>* output_ids) {
   MP_ASSIGN_OR_RETURN(auto logits, ComputeLogits());
 
@@ -491,9 +695,15 @@ LlmBuilder::PreProcess(std::shared_ptr<Tensor> token_embedding,
   constexpr absl::string_view kPosEmbeddingSource = "pos_embedding";
   constexpr absl::string_view kSegmentPosSource = "segment_pos";
   if (is_prefix) {
-    MP_ASSIGN_OR_RETURN(resource.atten_mask, NewInput({llm_params_.seq_size_T,
-                                                       llm_params_.seq_size_T},
-                                                      kAttnMaskSource));
+    Tensor::DimsType atten_mask_dims{llm_params_.seq_size_T,
+                                     llm_params_.seq_size_T};
+    if (llm_params_.enable_batch_attention_mask) {
+      // [B, 1, T, T], broadcast along the heads.
+      atten_mask_dims = {llm_params_.batch_size_B, 1, llm_params_.seq_size_T,
+                         llm_params_.seq_size_T};
+    }
+    MP_ASSIGN_OR_RETURN(resource.atten_mask,
+                        NewInput(atten_mask_dims, kAttnMaskSource));
     MP_ASSIGN_OR_RETURN(resource.segment_pos, NewInput({llm_params_.seq_size_T,
                                                         llm_params_.head_dim_H},
                                                        kSegmentPosSource));
@@ -684,7 +894,21 @@ absl::Status LlmBuilder::InitAttentionMask(size_t current_seq_len,
     MP_RETURN_IF_ERROR(InitAttentionMaskValues(process_seq_len));
   }
 
-  if (llm_params_.enable_dynamic_shape) {
+  if (llm_params_.enable_dynamic_shape && out_attn_mask.dims.size() == 4) {
+    // [B, 1, process_seq_len, S], with the same mask for each batch.
+    const size_t batch_size = out_attn_mask.dims[0];
+    const size_t seq_len = current_seq_len + process_seq_len;
+    out_attn_mask.Resize(
+        Tensor::DimsType{batch_size, 1, process_seq_len, seq_len});
+    float* row = out_attn_mask.DataAs<float>();
+    for (size_t batch = 0; batch < batch_size; ++batch) {
+      for (size_t r = 0; r < process_seq_len; ++r) {
+        std::memcpy(row, attention_mask_values_[r + current_seq_len].data(),
+                    seq_len * sizeof(float));
+        row += seq_len;
+      }
+    }
+  } else if (llm_params_.enable_dynamic_shape) {
     out_attn_mask.Resize(
         Tensor::DimsType{process_seq_len, current_seq_len + process_seq_len});
     for (size_t r = 0; r < out_attn_mask.dims[0]; ++r) {
@@ -825,7 +1049,8 @@ absl::StatusOr<std::vector<std::vector<int>>> LlmBuilder::Sample(
     MP_ASSIGN_OR_RETURN(
         sampler_,
         Sampler::Create(Sampler::Type::kGreedy, /*top_k=*/0, /*top_p=*/0.0,
-                        /*top_temperature=*/0.0, /*seed=*/0));
+                        /*top_temperature=*/0.0, /*seed=*/0,
+                        /*num_threads=*/runtime_configs_->xnn_num_threads));
   }
   return sampler_->Sample(logits);
 }
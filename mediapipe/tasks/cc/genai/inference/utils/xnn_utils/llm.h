@@ -30,6 +30,8 @@
 #include "mediapipe/tasks/cc/genai/inference/common/mdspan.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/paged_kv_cache.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/prefix_kv_cache.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
 
@@ -71,6 +73,12 @@ class Llm : protected xnn_utils::XnnGraph {
     // Previous ids, including prompt.
     std::vector<std::vector<int>> batch_prev_ids;
     std::vector<KVCache> kv_cache;
+    // The first time step each batch attends to, see SetBatchStartSteps().
+    // Empty if all batches start at time step 0.
+    std::vector<size_t> batch_start_steps;
+    // Set if `kv_cache_block_size` is positive. Holds the KV cache while the
+    // context is not loaded, in which case `kv_cache` is empty.
+    std::shared_ptr<PagedKVCache> paged_kv_cache;
   };
 
   // Reduce the number of previous ids to effectively undo the last
@@ -108,7 +116,10 @@ class Llm : protected xnn_utils::XnnGraph {
       std::unique_ptr<LlmWeightsLoader> weight_loader,
       std::unique_ptr<LlmBuilder> builder);
 
-  // Add input token ids at the end of all previously added tokens.
+  // Add input token ids at the end of all previously added tokens. If
+  // `max_num_prefix_cache_steps` is positive, the first tokens of a sequence
+  // skip their longest prefix computed before, e.g. a shared system prompt. If
+  // `prefill_chunk_size` is positive, long inputs are processed in chunks.
   virtual absl::Status AddInputTokens(
       absl::Span<const std::vector<int>> batch_input_ids);
 
@@ -117,6 +128,14 @@ class Llm : protected xnn_utils::XnnGraph {
   // the internal state.
   absl::Status SeekTimeStep(size_t time_step);
 
+  // Sets the first time step each batch attends to. The previous time steps of
+  // a batch are masked out, so that the batches can hold independent sequences
+  // of different lengths, e.g. right-aligned to the current time step. This
+  // requires `enable_batch_attention_mask`, a causal model and relative
+  // positional embeddings, since a sequence then starts at an arbitrary
+  // absolute time step.
+  absl::Status SetBatchStartSteps(std::vector<size_t> batch_start_steps);
+
   // Samples the logits from ComputeLogits() and returns the sampled ids. This
   // also AddInputTokens() with the sampled ids.
   ABSL_DEPRECATED("Use ComputeLogits() and do your own sampling.")
@@ -137,11 +156,15 @@ class Llm : protected xnn_utils::XnnGraph {
   const LlmParams& GetLlmParams() { return llm_params_; }
 
   // Create a new context with internal model parameters. The variables in the
-  // context will have proper batch size, sequence length, etc.
+  // context will have proper batch size, sequence length, etc. If
+  // `kv_cache_block_size` is positive, the context stores its KV cache in
+  // blocks and takes memory as its sequence grows.
   virtual absl::StatusOr<Context> NewContext() const;
 
   // If `context` is non-null, and different from existing context_, load the
-  // context into the model.
+  // context into the model. With paged KV caches, the time steps computed in
+  // the current context are stored into its blocks first, and the blocks of
+  // `context` are then copied into the KV cache buffers of the model.
   virtual absl::Status LoadContext(
       absl::Nullable<std::shared_ptr<Context>> context);
 
@@ -182,6 +205,21 @@ class Llm : protected xnn_utils::XnnGraph {
 
   absl::Status ReshapeInputResource();
 
+  // Runs the model on `batch_input_ids` in one graph run, reshaped for their
+  // length.
+  absl::Status ProcessInputTokens(
+      absl::Span<const std::vector<int>> batch_input_ids);
+
+  // The key and value caches of all layers, in the order of the blocks of
+  // `kv_cache_block_pool_`.
+  std::vector<std::shared_ptr<Tensor>> KVCacheTensors() const;
+  // Stores the time steps computed in the current context into its blocks.
+  absl::Status SavePagedKVCache();
+  // Loads the longest prefix of `input_ids`, the first tokens of a sequence,
+  // from `prefix_kv_cache_` into the KV cache, and returns its length. The last
+  // `draft_size_G` + 1 tokens are never loaded, since their logits are needed.
+  absl::StatusOr<size_t> LoadCachedPrefix(const std::vector<int>& input_ids);
+
   LlmWeights weights_;
   LlmParams llm_params_;
 
@@ -197,6 +235,14 @@ class Llm : protected xnn_utils::XnnGraph {
   std::shared_ptr<Tensor> logits_output_;
   std::shared_ptr<Context> context_;
 
+  // Set if `kv_cache_block_size` is positive.
+  std::shared_ptr<KVCacheBlockPool> kv_cache_block_pool_;
+  // The number of leading time steps of the KV cache already stored in the
+  // blocks of the current context.
+  size_t num_saved_kv_cache_steps_ = 0;
+  // Set if `max_num_prefix_cache_steps` is positive.
+  std::unique_ptr<PrefixKVCache> prefix_kv_cache_;
+
   // Hold a shared_ptr to the LlmBuilder for initializing the input resources
   // as well as performing necessary wiring customizations at decoding time.
   std::shared_ptr<LlmBuilder> builder_;
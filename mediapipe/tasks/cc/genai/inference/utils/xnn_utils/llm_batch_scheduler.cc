@@ -0,0 +1,235 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_batch_scheduler.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+LlmBatchScheduler::LlmBatchScheduler(Llm* llm)
+    : llm_(llm),
+      batch_size_(llm->GetLlmParams().batch_size_B),
+      max_seq_len_(llm->GetLlmParams().seq_size_T),
+      batches_(batch_size_, nullptr),
+      start_steps_(batch_size_, 0),
+      next_ids_(batch_size_, 0) {
+  pthread_create(&thread_id_, nullptr, LoopFunction, this);
+}
+
+LlmBatchScheduler::~LlmBatchScheduler() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+  }
+  pthread_join(thread_id_, nullptr);
+}
+
+absl::Status LlmBatchScheduler::Run(std::vector<int> prompt_ids,
+                                    size_t max_num_tokens,
+                                    TokenCallback callback) {
+  if (prompt_ids.empty()) {
+    return absl::InvalidArgumentError("The prompt is empty.");
+  }
+  if (prompt_ids.size() >= max_seq_len_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The prompt of ", prompt_ids.size(),
+                     " tokens does not fit the timeline of ", max_seq_len_,
+                     " time steps."));
+  }
+  Request request{.prompt_ids = std::move(prompt_ids),
+                  .max_num_tokens = max_num_tokens,
+                  .callback = std::move(callback)};
+  absl::MutexLock lock(&mutex_);
+  pending_.push_back(&request);
+  mutex_.Await(absl::Condition(&request.done));
+  return request.status;
+}
+
+size_t LlmBatchScheduler::num_active() const {
+  absl::MutexLock lock(&mutex_);
+  return num_active_;
+}
+
+size_t LlmBatchScheduler::num_pending() const {
+  absl::MutexLock lock(&mutex_);
+  return pending_.size();
+}
+
+void* LlmBatchScheduler::LoopFunction(void* args) {
+  static_cast<LlmBatchScheduler*>(args)->Loop();
+  return nullptr;
+}
+
+void LlmBatchScheduler::Loop() {
+  while (true) {
+    Request* joining = nullptr;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &LlmBatchScheduler::HasWork));
+      if (stop_) return;
+      // Admits at most one prefill between two decode steps, so that the
+      // sequences already decoding keep their pace. It is the first pending
+      // sequence that fits, which may wait behind none that does not.
+      for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+        if (CanJoin(**it)) {
+          joining = *it;
+          pending_.erase(it);
+          ++num_active_;
+          break;
+        }
+      }
+    }
+    if (joining) {
+      if (absl::Status status = Join(joining); !status.ok()) {
+        Fail(joining, std::move(status));
+      }
+    }
+    if (absl::Status status = Decode(); !status.ok()) {
+      // All active sequences share the failed decode step.
+      for (size_t batch = 0; batch < batch_size_; ++batch) {
+        if (batches_[batch]) Leave(batch, status);
+      }
+    }
+  }
+}
+
+bool LlmBatchScheduler::HasWork() const {
+  return stop_ || num_active_ > 0 || !pending_.empty();
+}
+
+bool LlmBatchScheduler::CanJoin(const Request& request) const {
+  if (num_active_ == 0) return true;
+  if (num_active_ == batch_size_) return false;
+  // The prompt is right-aligned to the current time step, and the sequence is
+  // left at least half of the timeline to decode.
+  const size_t time_step = llm_->TotalTokenSize();
+  return request.prompt_ids.size() <= time_step &&
+         2 * time_step < max_seq_len_;
+}
+
+absl::Status LlmBatchScheduler::Join(Request* request) {
+  const size_t batch =
+      std::find(batches_.begin(), batches_.end(), nullptr) - batches_.begin();
+  RET_CHECK_LT(batch, batch_size_);
+  const size_t prompt_size = request->prompt_ids.size();
+  RET_CHECK_LT(prompt_size, max_seq_len_);
+
+  std::vector<std::vector<int>> batch_input_ids(batch_size_);
+  if (std::count(batches_.begin(), batches_.end(), nullptr) == batch_size_) {
+    // Restarts the timeline, the other batches are padding.
+    std::fill(start_steps_.begin(), start_steps_.end(), 0);
+    for (auto& input_ids : batch_input_ids) {
+      input_ids.assign(prompt_size, 0);
+    }
+    MP_RETURN_IF_ERROR(llm_->SeekTimeStep(0));
+  } else {
+    // The other batches feed their own tokens again.
+    const size_t start_step = llm_->TotalTokenSize() - prompt_size;
+    for (size_t i = 0; i < batch_size_; ++i) {
+      const std::vector<int>& prev_ids = llm_->batch_prev_ids()[i];
+      batch_input_ids[i].assign(prev_ids.begin() + start_step, prev_ids.end());
+    }
+    start_steps_[batch] = start_step;
+    MP_RETURN_IF_ERROR(llm_->SeekTimeStep(start_step));
+  }
+  batch_input_ids[batch] = request->prompt_ids;
+  MP_RETURN_IF_ERROR(llm_->SetBatchStartSteps(start_steps_));
+  MP_RETURN_IF_ERROR(llm_->AddInputTokens(batch_input_ids));
+
+  batches_[batch] = request;
+  request->num_tokens = prompt_size;
+  return Sample({batch});
+}
+
+absl::Status LlmBatchScheduler::Decode() {
+  std::vector<size_t> active_batches;
+  for (size_t i = 0; i < batch_size_; ++i) {
+    if (batches_[i]) active_batches.push_back(i);
+  }
+  if (active_batches.empty()) return absl::OkStatus();
+
+  if (llm_->TotalTokenSize() + 1 >= max_seq_len_) {
+    // The timeline is full, which stops the sequences as if they reached
+    // `max_num_tokens`.
+    for (size_t batch : active_batches) Leave(batch);
+    return absl::OkStatus();
+  }
+  std::vector<std::vector<int>> batch_input_ids(batch_size_,
+                                                std::vector<int>{0});
+  for (size_t batch : active_batches) {
+    batch_input_ids[batch][0] = next_ids_[batch];
+  }
+  MP_RETURN_IF_ERROR(llm_->AddInputTokens(batch_input_ids));
+  return Sample(active_batches);
+}
+
+absl::Status LlmBatchScheduler::Sample(absl::Span<const size_t> batches) {
+  MP_ASSIGN_OR_RETURN(auto logits, llm_->ComputeLogits());
+  // [batch_size, 1, vocab_size]
+  const size_t vocab_size = logits->dims.back();
+  for (size_t batch : batches) {
+    Request* request = batches_[batch];
+    if (request->num_tokens >= request->max_num_tokens) {
+      Leave(batch);
+      continue;
+    }
+    const float* batch_logits = logits->DataAs<float>() + batch * vocab_size;
+    next_ids_[batch] = std::distance(
+        batch_logits,
+        std::max_element(batch_logits, batch_logits + vocab_size));
+    ++request->num_tokens;
+    if (!request->callback(next_ids_[batch]) ||
+        request->num_tokens >= request->max_num_tokens) {
+      Leave(batch);
+    }
+  }
+  return absl::OkStatus();
+}
+
+void LlmBatchScheduler::Leave(size_t batch, absl::Status status) {
+  absl::MutexLock lock(&mutex_);
+  batches_[batch]->status = std::move(status);
+  batches_[batch]->done = true;
+  batches_[batch] = nullptr;
+  --num_active_;
+}
+
+void LlmBatchScheduler::Fail(Request* request, absl::Status status) {
+  const auto it = std::find(batches_.begin(), batches_.end(), request);
+  if (it != batches_.end()) {
+    Leave(it - batches_.begin(), std::move(status));
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  request->status = std::move(status);
+  request->done = true;
+  --num_active_;
+}
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -0,0 +1,114 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_LLM_BATCH_SCHEDULER_H_
+#define MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_LLM_BATCH_SCHEDULER_H_
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+// Greedily decodes concurrent sequences together, each in one batch of an Llm.
+//
+// All batches share the timeline of the Llm. A sequence joins a free batch
+// between two decode steps: its prompt is right-aligned to the current time
+// step and prefilled together with the last tokens of the other batches, which
+// recompute their own KV cache entries. Each decode step then feeds the next
+// token of all batches at once, and a sequence leaves its batch as soon as it
+// stops. Once all batches are free, the timeline restarts at time step 0.
+class LlmBatchScheduler {
+ public:
+  // Receives each decoded token of a sequence, and returns whether to decode
+  // the next one.
+  using TokenCallback = std::function<bool(int token_id)>;
+
+  // `llm` must outlive the scheduler, and support SetBatchStartSteps().
+  explicit LlmBatchScheduler(Llm* llm);
+  ~LlmBatchScheduler();
+
+  LlmBatchScheduler(const LlmBatchScheduler&) = delete;
+  LlmBatchScheduler& operator=(const LlmBatchScheduler&) = delete;
+
+  // Decodes the sequence starting with `prompt_ids`, passing each token to
+  // `callback` on the scheduler thread, until `callback` returns false, the
+  // sequence holds `max_num_tokens` tokens, or the timeline is full. Blocks the
+  // calling thread. Returns an error if the prompt does not fit the timeline,
+  // or if the Llm fails to decode the sequence, which does not affect the
+  // sequences decoded in other batches unless they share the failing step.
+  absl::Status Run(std::vector<int> prompt_ids, size_t max_num_tokens,
+                   TokenCallback callback);
+
+  // The number of sequences in a batch, and waiting for one.
+  size_t num_active() const;
+  size_t num_pending() const;
+
+ private:
+  struct Request {
+    std::vector<int> prompt_ids;
+    size_t max_num_tokens;
+    TokenCallback callback;
+    // The number of tokens of the sequence, including the prompt.
+    size_t num_tokens = 0;
+    bool done = false;
+    absl::Status status;
+  };
+
+  static void* LoopFunction(void* args);
+  void Loop();
+  bool HasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Whether the prompt of `request` can be prefilled at the current time step.
+  bool CanJoin(const Request& request) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  absl::Status Join(Request* request);
+  absl::Status Decode();
+  // Samples and emits the next token of each of `batches`, which leave once
+  // their sequence stops.
+  absl::Status Sample(absl::Span<const size_t> batches);
+  // Ends the sequence of `batch` with `status`.
+  void Leave(size_t batch, absl::Status status = absl::OkStatus());
+  // Ends `request`, which may not have joined a batch yet, with `status`.
+  void Fail(Request* request, absl::Status status);
+
+  Llm* const llm_;
+  const size_t batch_size_;
+  const size_t max_seq_len_;
+  pthread_t thread_id_;
+
+  mutable absl::Mutex mutex_;
+  std::deque<Request*> pending_ ABSL_GUARDED_BY(mutex_);
+  size_t num_active_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stop_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // Only accessed by the scheduler thread: the request decoded in each batch,
+  // or nullptr if the batch is free, and the first time step and the next
+  // token of each batch.
+  std::vector<Request*> batches_;
+  std::vector<size_t> start_steps_;
+  std::vector<int> next_ids_;
+};
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+#endif  // MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_LLM_BATCH_SCHEDULER_H_
@@ -0,0 +1,186 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_batch_scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_test_utils.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::SizeIs;
+
+constexpr size_t kNumDecodedTokens = 8;
+
+class LlmBatchSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    params_ = GetSmallLlmParams();
+    params_.batch_size_B = 2;
+    params_.enable_batch_attention_mask = true;
+    MP_ASSERT_OK_AND_ASSIGN(llm_, CreateSmallLlm(params_));
+    scheduler_ = std::make_unique<LlmBatchScheduler>(llm_.get());
+  }
+
+  // Returns the tokens greedily decoded after `prompt_ids` by the model run on
+  // its own.
+  std::vector<int> DecodeAlone(const std::vector<int>& prompt_ids) {
+    LlmParams params = params_;
+    params.batch_size_B = 1;
+    params.enable_batch_attention_mask = false;
+    auto llm = CreateSmallLlm(params);
+    ABSL_CHECK_OK(llm);
+    return GreedyDecode(**llm, prompt_ids, kNumDecodedTokens);
+  }
+
+  // Returns the tokens decoded by the scheduler after `prompt_ids`.
+  std::vector<int> Run(const std::vector<int>& prompt_ids) {
+    std::vector<int> token_ids;
+    MP_EXPECT_OK(scheduler_->Run(prompt_ids,
+                                 prompt_ids.size() + kNumDecodedTokens,
+                                 [&token_ids](int token_id) {
+                                   token_ids.push_back(token_id);
+                                   return true;
+                                 }));
+    return token_ids;
+  }
+
+  // Waits until `num_pending` sequences wait for a batch.
+  void WaitForPending(size_t num_pending) {
+    while (scheduler_->num_pending() < num_pending) {
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+  }
+
+  LlmParams params_;
+  std::unique_ptr<Llm> llm_;
+  std::unique_ptr<LlmBatchScheduler> scheduler_;
+};
+
+TEST_F(LlmBatchSchedulerTest, DecodesOneSequence) {
+  const std::vector<int> prompt_ids = RandomTokenIds(params_, 6, /*seed=*/0);
+  EXPECT_THAT(Run(prompt_ids), ElementsAreArray(DecodeAlone(prompt_ids)));
+  EXPECT_EQ(scheduler_->num_active(), 0);
+}
+
+TEST_F(LlmBatchSchedulerTest, AdmitsAndRetiresConcurrentSequences) {
+  // More sequences than batches, so that a sequence joins once another one
+  // leaves its batch.
+  const std::vector<std::vector<int>> prompts = {
+      RandomTokenIds(params_, 6, /*seed=*/0),
+      RandomTokenIds(params_, 4, /*seed=*/1),
+      RandomTokenIds(params_, 5, /*seed=*/2),
+  };
+  std::vector<std::vector<int>> outputs(prompts.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < prompts.size(); ++i) {
+    threads.emplace_back([&, i]() { outputs[i] = Run(prompts[i]); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(scheduler_->num_active(), 0);
+  for (size_t i = 0; i < prompts.size(); ++i) {
+    EXPECT_THAT(outputs[i], ElementsAreArray(DecodeAlone(prompts[i])));
+  }
+}
+
+TEST_F(LlmBatchSchedulerTest, RetiresSequenceStoppedByCallback) {
+  const std::vector<int> prompt_ids = RandomTokenIds(params_, 6, /*seed=*/0);
+  std::vector<int> token_ids;
+  MP_EXPECT_OK(scheduler_->Run(prompt_ids,
+                               prompt_ids.size() + kNumDecodedTokens,
+                               [&token_ids](int token_id) {
+                                 token_ids.push_back(token_id);
+                                 return token_ids.size() < 3;
+                               }));
+  EXPECT_THAT(token_ids, SizeIs(3));
+  EXPECT_EQ(scheduler_->num_active(), 0);
+
+  // The batch is free for the next sequence.
+  EXPECT_THAT(Run(prompt_ids), ElementsAreArray(DecodeAlone(prompt_ids)));
+}
+
+TEST_F(LlmBatchSchedulerTest, AdmitsLaterSequenceThatFits) {
+  const std::vector<int> first_ids = RandomTokenIds(params_, 4, /*seed=*/0);
+  // Longer than the timeline while the first sequence decodes.
+  const std::vector<int> long_ids = RandomTokenIds(params_, 20, /*seed=*/1);
+  const std::vector<int> short_ids = RandomTokenIds(params_, 3, /*seed=*/2);
+  std::vector<int> first_output, long_output, short_output;
+  size_t max_num_active = 0;
+  std::thread long_thread, short_thread;
+  MP_EXPECT_OK(scheduler_->Run(
+      first_ids, first_ids.size() + kNumDecodedTokens, [&](int token_id) {
+        if (first_output.empty()) {
+          // Queues the short sequence behind the long one.
+          long_thread = std::thread([&]() { long_output = Run(long_ids); });
+          WaitForPending(1);
+          short_thread = std::thread([&]() {
+            MP_EXPECT_OK(scheduler_->Run(
+                short_ids, short_ids.size() + kNumDecodedTokens,
+                [&](int short_token_id) {
+                  short_output.push_back(short_token_id);
+                  max_num_active =
+                      std::max(max_num_active, scheduler_->num_active());
+                  return true;
+                }));
+          });
+          WaitForPending(2);
+        }
+        first_output.push_back(token_id);
+        return true;
+      }));
+  short_thread.join();
+  long_thread.join();
+
+  // The short sequence decoded alongside the first one.
+  EXPECT_EQ(max_num_active, 2);
+  EXPECT_THAT(first_output, ElementsAreArray(DecodeAlone(first_ids)));
+  EXPECT_THAT(short_output, ElementsAreArray(DecodeAlone(short_ids)));
+  EXPECT_THAT(long_output, ElementsAreArray(DecodeAlone(long_ids)));
+}
+
+TEST_F(LlmBatchSchedulerTest, FailsPromptLongerThanTimeline) {
+  const std::vector<int> prompt_ids =
+      RandomTokenIds(params_, params_.seq_size_T, /*seed=*/0);
+  EXPECT_EQ(scheduler_
+                ->Run(prompt_ids, prompt_ids.size() + kNumDecodedTokens,
+                      [](int) { return true; })
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(scheduler_->num_active(), 0);
+
+  // The scheduler keeps decoding other sequences.
+  const std::vector<int> other_ids = RandomTokenIds(params_, 6, /*seed=*/1);
+  EXPECT_THAT(Run(other_ids), ElementsAreArray(DecodeAlone(other_ids)));
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
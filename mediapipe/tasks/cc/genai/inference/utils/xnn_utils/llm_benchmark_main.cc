@@ -0,0 +1,369 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks the CPU LLM of well known model types with synthetic weights, so
+// that no model file is needed. For each combination of the swept model types,
+// batch sizes, thread counts, prompt lengths and decode lengths, reports as
+// JSON:
+// * prefill_tokens_per_sec: prompt tokens processed per second.
+// * decode_tokens_per_sec: tokens decoded per second after the prompt.
+// * ttft_ms: time to the first token, i.e. prefill plus the first decode step.
+// * rss_mb: resident memory added since before the model was created, i.e.
+//   the model and its buffers (Linux only). Memory of previous models which the
+//   allocator did not return to the system is not attributed.
+// * kv_cache_mb: memory allocated for the KV cache.
+//
+// Example:
+//   llm_benchmark --model_types=GEMMA_2B,PHI_2 --num_layers=4 \
+//     --prompt_lengths=128,512 --decode_lengths=64 --batch_sizes=1,4 \
+//     --num_threads=1,4 --weight_type=INT8
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif  // !_WIN32
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/absl_log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/tasks/cc/genai/inference/proto/llm_params.pb.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/well_known_models.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/benchmark_weight_accessor.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/falcon.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/phi.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/stablelm.h"
+#include "xnnpack.h"  // from @XNNPACK
+
+ABSL_FLAG(std::vector<std::string>, model_types, {"GEMMA_2B"},
+          "The model types to benchmark, among FALCON_RW_1B, "
+          "STABLELM_4E1T_3B, PHI_2 and GEMMA_2B.");
+
+ABSL_FLAG(int, num_layers, 0,
+          "If positive, overrides the number of transformer layers of the "
+          "models, e.g. to benchmark a smaller model.");
+
+ABSL_FLAG(std::string, weight_type, "INT8",
+          "The type of the synthetic weights, among FLOAT32, INT8, INT4 and "
+          "MIXED_INT48.");
+
+ABSL_FLAG(std::vector<std::string>, prompt_lengths, {"128"},
+          "The numbers of prompt tokens to benchmark.");
+
+ABSL_FLAG(std::vector<std::string>, decode_lengths, {"64"},
+          "The numbers of tokens to decode after the prompt.");
+
+ABSL_FLAG(std::vector<std::string>, batch_sizes, {"1"},
+          "The batch sizes to benchmark.");
+
+ABSL_FLAG(std::vector<std::string>, num_threads, {"4"},
+          "The numbers of XNNPACK threads to benchmark.");
+
+ABSL_FLAG(int, num_iterations, 3,
+          "The number of runs of each configuration, after a warm-up run. The "
+          "reported speeds are the averages.");
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+// Loads synthetic weights of the given type.
+class SyntheticLlmWeightsLoader : public LlmWeightsLoader {
+ public:
+  SyntheticLlmWeightsLoader(const LlmParams& params,
+                            std::unique_ptr<WeightAccessor> weight_accessor)
+      : LlmWeightsLoader(nullptr, params) {
+    weight_accessor_ = std::move(weight_accessor);
+  }
+};
+
+absl::StatusOr<std::unique_ptr<WeightAccessor>> CreateWeightAccessor(
+    absl::string_view weight_type) {
+  if (absl::EqualsIgnoreCase(weight_type, "FLOAT32")) {
+    return std::make_unique<BenchmarkWeightAccessor>(xnn_datatype_fp32);
+  } else if (absl::EqualsIgnoreCase(weight_type, "INT8")) {
+    return std::make_unique<BenchmarkWeightAccessor>(xnn_datatype_qcint8);
+  } else if (absl::EqualsIgnoreCase(weight_type, "INT4")) {
+    return std::make_unique<BenchmarkWeightAccessor>(xnn_datatype_qcint4);
+  } else if (absl::EqualsIgnoreCase(weight_type, "MIXED_INT48")) {
+    return std::make_unique<BenchmarkMixedInt48WeightAccessor>();
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unsupported weight type: ", weight_type));
+}
+
+absl::StatusOr<odml::infra::proto::LlmParameters> GetLlmParameters(
+    absl::string_view model_type) {
+  if (absl::EqualsIgnoreCase(model_type, "FALCON_RW_1B")) {
+    return llm_utils::GetFalconRW1BParams();
+  } else if (absl::EqualsIgnoreCase(model_type, "STABLELM_4E1T_3B")) {
+    return llm_utils::GetStablelm4E1T3BParams();
+  } else if (absl::EqualsIgnoreCase(model_type, "PHI_2")) {
+    return llm_utils::GetPhi2Params();
+  } else if (absl::EqualsIgnoreCase(model_type, "GEMMA_2B")) {
+    return llm_utils::GetGemma2BParams();
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unsupported model type: ", model_type));
+}
+
+std::unique_ptr<LlmBuilder> CreateBuilder(
+    absl::string_view model_type, const LlmParams& params,
+    std::unique_ptr<RuntimeConfigs> runtime_configs) {
+  if (absl::EqualsIgnoreCase(model_type, "FALCON_RW_1B")) {
+    return std::make_unique<FalconRW1BBuilder>(params,
+                                               std::move(runtime_configs));
+  } else if (absl::EqualsIgnoreCase(model_type, "STABLELM_4E1T_3B")) {
+    return std::make_unique<Stablelm4E1T3BBuilder>(params,
+                                                   std::move(runtime_configs));
+  } else if (absl::EqualsIgnoreCase(model_type, "PHI_2")) {
+    return std::make_unique<Phi2Builder>(params, std::move(runtime_configs));
+  }
+  return std::make_unique<LlmBuilder>(params, std::move(runtime_configs));
+}
+
+absl::StatusOr<std::vector<size_t>> ParseSizes(
+    const std::vector<std::string>& values) {
+  std::vector<size_t> sizes;
+  for (const std::string& value : values) {
+    size_t size;
+    RET_CHECK(absl::SimpleAtoi(value, &size) && size > 0)
+        << "Expected a positive integer, got: " << value;
+    sizes.push_back(size);
+  }
+  RET_CHECK(!sizes.empty());
+  return sizes;
+}
+
+// Returns the current resident memory of the process in bytes, or 0 if
+// unknown. Unlike the peak resident memory, it can be compared between models
+// created one after the other in the same process.
+int64_t GetRssBytes() {
+#if defined(__linux__) || defined(__ANDROID__)
+  // The second field is the number of resident pages.
+  std::ifstream statm("/proc/self/statm");
+  int64_t size_pages = 0;
+  int64_t resident_pages = 0;
+  if (!(statm >> size_pages >> resident_pages)) return 0;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif  // defined(__linux__) || defined(__ANDROID__)
+}
+
+// Returns the bytes allocated for the KV cache, which does not depend on the
+// number of tokens currently cached.
+size_t GetKVCacheBytes(const Llm& llm) {
+  size_t bytes = 0;
+  for (const Llm::KVCache& kv_cache : llm.kv_cache()) {
+    if (kv_cache.k_cache) bytes += kv_cache.k_cache->data_capacity();
+    if (kv_cache.v_cache) bytes += kv_cache.v_cache->data_capacity();
+  }
+  return bytes;
+}
+
+constexpr double kBytesPerMb = 1024.0 * 1024.0;
+
+struct BenchmarkConfig {
+  std::string model_type;
+  size_t batch_size;
+  size_t num_threads;
+  size_t prompt_length;
+  size_t decode_length;
+};
+
+struct BenchmarkResult {
+  double prefill_tokens_per_sec = 0;
+  double decode_tokens_per_sec = 0;
+  double ttft_ms = 0;
+};
+
+// Prefills random prompts of `config.prompt_length` tokens and greedily
+// decodes `config.decode_length` tokens after them.
+absl::StatusOr<BenchmarkResult> RunOnce(Llm& llm, Sampler& sampler,
+                                        const BenchmarkConfig& config,
+                                        std::mt19937& rng) {
+  std::uniform_int_distribution<int> token_dist(
+      0, llm.GetLlmParams().voc_size_V - 1);
+  std::vector<std::vector<int>> prompts(
+      config.batch_size, std::vector<int>(config.prompt_length));
+  for (std::vector<int>& prompt : prompts) {
+    std::generate(prompt.begin(), prompt.end(),
+                  [&] { return token_dist(rng); });
+  }
+
+  MP_RETURN_IF_ERROR(llm.SeekTimeStep(0));
+  const absl::Time start = absl::Now();
+  MP_RETURN_IF_ERROR(llm.AddInputTokens(prompts));
+  const absl::Time prefill_end = absl::Now();
+  absl::Time first_token_end;
+  for (size_t step = 0; step < config.decode_length; ++step) {
+    MP_ASSIGN_OR_RETURN(auto logits, llm.ComputeLogits());
+    MP_ASSIGN_OR_RETURN(auto ids, sampler.Sample(*logits));
+    if (step == 0) {
+      first_token_end = absl::Now();
+    }
+    MP_RETURN_IF_ERROR(llm.AddInputTokens(ids));
+  }
+  const absl::Time end = absl::Now();
+
+  BenchmarkResult result;
+  result.prefill_tokens_per_sec = config.batch_size * config.prompt_length /
+                                  absl::ToDoubleSeconds(prefill_end - start);
+  result.decode_tokens_per_sec = config.batch_size * config.decode_length /
+                                 absl::ToDoubleSeconds(end - prefill_end);
+  result.ttft_ms = absl::ToDoubleMilliseconds(first_token_end - start);
+  return result;
+}
+
+std::string ToJson(const BenchmarkConfig& config, absl::string_view weight_type,
+                   size_t num_layers, const BenchmarkResult& result,
+                   int64_t rss_bytes, size_t kv_cache_bytes) {
+  return absl::StrCat(
+      "{\"model_type\": \"", config.model_type, "\", \"weight_type\": \"",
+      weight_type, "\", \"num_layers\": ", num_layers,
+      ", \"batch_size\": ", config.batch_size,
+      ", \"num_threads\": ", config.num_threads,
+      ", \"prompt_length\": ", config.prompt_length,
+      ", \"decode_length\": ", config.decode_length,
+      ", \"prefill_tokens_per_sec\": ", result.prefill_tokens_per_sec,
+      ", \"decode_tokens_per_sec\": ", result.decode_tokens_per_sec,
+      ", \"ttft_ms\": ", result.ttft_ms,
+      ", \"rss_mb\": ", rss_bytes / kBytesPerMb,
+      ", \"kv_cache_mb\": ", kv_cache_bytes / kBytesPerMb, "}");
+}
+
+absl::Status RunBenchmarks() {
+  MP_ASSIGN_OR_RETURN(std::vector<size_t> prompt_lengths,
+                      ParseSizes(absl::GetFlag(FLAGS_prompt_lengths)));
+  MP_ASSIGN_OR_RETURN(std::vector<size_t> decode_lengths,
+                      ParseSizes(absl::GetFlag(FLAGS_decode_lengths)));
+  MP_ASSIGN_OR_RETURN(std::vector<size_t> batch_sizes,
+                      ParseSizes(absl::GetFlag(FLAGS_batch_sizes)));
+  MP_ASSIGN_OR_RETURN(std::vector<size_t> num_threads,
+                      ParseSizes(absl::GetFlag(FLAGS_num_threads)));
+  const std::string weight_type =
+      absl::AsciiStrToUpper(absl::GetFlag(FLAGS_weight_type));
+  const int num_iterations = absl::GetFlag(FLAGS_num_iterations);
+  RET_CHECK_GT(num_iterations, 0);
+  // The model is created once per model type, batch size and thread count,
+  // with room for the longest prompt and decode.
+  const size_t seq_size =
+      *std::max_element(prompt_lengths.begin(), prompt_lengths.end()) +
+      *std::max_element(decode_lengths.begin(), decode_lengths.end());
+
+  MP_ASSIGN_OR_RETURN(
+      auto sampler,
+      Sampler::Create(Sampler::Type::kGreedy, /*top_k=*/0, /*top_p=*/0.0,
+                      /*temperature=*/0.0, /*seed=*/0));
+  std::mt19937 rng(/*seed=*/0);
+  std::vector<std::string> results;
+  for (const std::string& model_type : absl::GetFlag(FLAGS_model_types)) {
+    MP_ASSIGN_OR_RETURN(auto llm_parameters, GetLlmParameters(model_type));
+    for (size_t batch_size : batch_sizes) {
+      for (size_t threads : num_threads) {
+        LlmParams params = LlmParams::FromLLMParametersProto(llm_parameters);
+        params.seq_size_T = seq_size;
+        params.batch_size_B = batch_size;
+        params.enable_kv_cache = true;
+        params.enable_dynamic_shape = true;
+        if (absl::GetFlag(FLAGS_num_layers) > 0) {
+          params.num_transformer_M = absl::GetFlag(FLAGS_num_layers);
+        }
+        params.num_weights_loading_threads = threads;
+        auto runtime_configs = std::make_unique<RuntimeConfigs>();
+        runtime_configs->xnn_num_threads = threads;
+        MP_ASSIGN_OR_RETURN(auto weight_accessor,
+                            CreateWeightAccessor(weight_type));
+        // The previous model is destroyed by now.
+        const int64_t baseline_rss_bytes = GetRssBytes();
+        MP_ASSIGN_OR_RETURN(
+            auto llm,
+            Llm::CreateLlm(std::make_unique<SyntheticLlmWeightsLoader>(
+                               params, std::move(weight_accessor)),
+                           CreateBuilder(model_type, params,
+                                         std::move(runtime_configs))));
+
+        for (size_t prompt_length : prompt_lengths) {
+          for (size_t decode_length : decode_lengths) {
+            const BenchmarkConfig config = {
+                .model_type = model_type,
+                .batch_size = batch_size,
+                .num_threads = threads,
+                .prompt_length = prompt_length,
+                .decode_length = decode_length,
+            };
+            // Warms up, e.g. the shapes of the graph.
+            MP_RETURN_IF_ERROR(RunOnce(*llm, *sampler, config, rng).status());
+            BenchmarkResult average;
+            for (int i = 0; i < num_iterations; ++i) {
+              MP_ASSIGN_OR_RETURN(BenchmarkResult result,
+                                  RunOnce(*llm, *sampler, config, rng));
+              average.prefill_tokens_per_sec +=
+                  result.prefill_tokens_per_sec / num_iterations;
+              average.decode_tokens_per_sec +=
+                  result.decode_tokens_per_sec / num_iterations;
+              average.ttft_ms += result.ttft_ms / num_iterations;
+            }
+            results.push_back(ToJson(
+                config, weight_type, params.num_transformer_M, average,
+                GetRssBytes() - baseline_rss_bytes, GetKVCacheBytes(*llm)));
+            ABSL_LOG(INFO) << results.back();
+          }
+        }
+      }
+    }
+  }
+  std::cout << "[\n  " << absl::StrJoin(results, ",\n  ") << "\n]"
+            << std::endl;
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  absl::Status status = mediapipe::tasks::genai::xnn_utils::RunBenchmarks();
+  if (!status.ok()) {
+    ABSL_LOG(ERROR) << status;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -30,6 +31,7 @@
 #include "absl/flags/flag.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
@@ -37,15 +39,18 @@
 #include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/tasks/cc/genai/inference/proto/llm_params.pb.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/well_known_models.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/benchmark_weight_accessor.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/falcon.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_test_utils.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/phi.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/speculative_decoder.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/stablelm.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
 #include "xnnpack.h"  // from @XNNPACK
@@ -62,6 +67,10 @@ ABSL_FLAG(int, num_threads, 4, "The number of threads to use");
 namespace mediapipe::tasks::genai::xnn_utils {
 namespace {
 
+using ::testing::ElementsAreArray;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
 constexpr ::absl::string_view kXnnProfileCsvFile{
 #if __ANDROID__
     "/data/local/tmp/xnn_profile.csv"
@@ -78,42 +87,49 @@ std::unique_ptr<RuntimeConfigs> GetRunTimeConfigsForBenchmark() {
   return runtime_config;
 }
 
+LlmParams GetLlmParamsForBenchmark(
+    const odml::infra::proto::LlmParameters& llm_parameters, size_t seq_size,
+    size_t draft_size, size_t num_layers) {
+  LlmParams params = LlmParams::FromLLMParametersProto(llm_parameters);
+  params.seq_size_T = seq_size;
+  params.enable_kv_cache = true;
+  params.enable_dynamic_shape = true;
+  params.draft_size_G = draft_size;
+  if (num_layers > 0) {
+    params.num_transformer_M = num_layers;
+  }
+  return params;
+}
+
+// Returns the builder of the model specified by --model_type. `draft_size` is
+// the number of draft tokens verified per step, and `num_layers`, if positive,
+// overrides the number of transformer layers, e.g. for a draft model.
 std::pair<std::unique_ptr<xnn_utils::LlmBuilder>, LlmParams>
-GetLlmBuilderAndParamsForBenchmark(size_t seq_size) {
+GetLlmBuilderAndParamsForBenchmark(size_t seq_size, size_t draft_size = 0,
+                                   size_t num_layers = 0) {
   auto model_type_string = absl::GetFlag(FLAGS_model_type);
   if (absl::EqualsIgnoreCase(model_type_string, "FALCON_RW_1B")) {
-    LlmParams params =
-        LlmParams::FromLLMParametersProto(llm_utils::GetFalconRW1BParams());
-    params.seq_size_T = seq_size;
-    params.enable_kv_cache = true;
-    params.enable_dynamic_shape = true;
+    LlmParams params = GetLlmParamsForBenchmark(
+        llm_utils::GetFalconRW1BParams(), seq_size, draft_size, num_layers);
     return {std::make_unique<FalconRW1BBuilder>(
                 params, GetRunTimeConfigsForBenchmark()),
             params};
   } else if (absl::EqualsIgnoreCase(model_type_string, "GEMMA_2B")) {
-    LlmParams params =
-        LlmParams::FromLLMParametersProto(llm_utils::GetGemma2BParams());
-    params.seq_size_T = seq_size;
-    params.enable_kv_cache = true;
-    params.enable_dynamic_shape = true;
+    LlmParams params = GetLlmParamsForBenchmark(
+        llm_utils::GetGemma2BParams(), seq_size, draft_size, num_layers);
     return {
         std::make_unique<LlmBuilder>(params, GetRunTimeConfigsForBenchmark()),
         params};
   } else if (absl::EqualsIgnoreCase(model_type_string, "STABLELM_4E1T_3B")) {
     LlmParams params =
-        LlmParams::FromLLMParametersProto(llm_utils::GetStablelm4E1T3BParams());
-    params.seq_size_T = seq_size;
-    params.enable_kv_cache = true;
-    params.enable_dynamic_shape = true;
+        GetLlmParamsForBenchmark(llm_utils::GetStablelm4E1T3BParams(),
+                                 seq_size, draft_size, num_layers);
     return {std::make_unique<Stablelm4E1T3BBuilder>(
                 params, GetRunTimeConfigsForBenchmark()),
             params};
   } else if (absl::EqualsIgnoreCase(model_type_string, "PHI_2")) {
-    LlmParams params =
-        LlmParams::FromLLMParametersProto(llm_utils::GetPhi2Params());
-    params.seq_size_T = seq_size;
-    params.enable_kv_cache = true;
-    params.enable_dynamic_shape = true;
+    LlmParams params = GetLlmParamsForBenchmark(
+        llm_utils::GetPhi2Params(), seq_size, draft_size, num_layers);
     return {
         std::make_unique<Phi2Builder>(params, GetRunTimeConfigsForBenchmark()),
         params};
@@ -216,6 +232,385 @@ class BenchmarkLlmMixedInt48WeightsLoader : public LlmWeightsLoader {
   }
 };
 
+class BenchmarkLlmBlockwiseInt4WeightsLoader : public LlmWeightsLoader {
+ public:
+  BenchmarkLlmBlockwiseInt4WeightsLoader(const LlmParams& params,
+                                         size_t block_size)
+      : LlmWeightsLoader(nullptr, params) {
+    weight_accessor_ = std::make_unique<BenchmarkWeightAccessor>(
+        xnn_datatype_qbint4, /*seed=*/std::nullopt, block_size);
+  }
+};
+
+TEST(LlmTest, PrefixKVCacheHitMatchesFullPrefill) {
+  LlmParams params = GetSmallLlmParams();
+  const std::vector<int> prompt = RandomTokenIds(params, 20, /*seed=*/0);
+  MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt}));
+  const std::vector<float> expected_logits = GetLogits(*llm);
+
+  params.max_num_prefix_cache_steps = params.seq_size_T;
+  MP_ASSERT_OK_AND_ASSIGN(auto cached_llm, CreateSmallLlm(params));
+  // Caches a prompt sharing the first 12 tokens, whose time steps are then
+  // loaded instead of computed.
+  std::vector<int> other_prompt(prompt.begin(), prompt.begin() + 12);
+  other_prompt.push_back((prompt[12] + 1) % params.voc_size_V);
+  MP_ASSERT_OK(cached_llm->AddInputTokens({other_prompt}));
+  MP_ASSERT_OK(cached_llm->SeekTimeStep(0));
+  MP_ASSERT_OK(cached_llm->AddInputTokens({prompt}));
+  EXPECT_THAT(GetLogits(*cached_llm),
+              Pointwise(FloatNear(kLogitsTolerance), expected_logits));
+
+  // All but the last token are cached now.
+  MP_ASSERT_OK(cached_llm->SeekTimeStep(0));
+  MP_ASSERT_OK(cached_llm->AddInputTokens({prompt}));
+  EXPECT_THAT(GetLogits(*cached_llm),
+              Pointwise(FloatNear(kLogitsTolerance), expected_logits));
+}
+
+TEST(LlmTest, PrefixKVCacheHitComputesDraftTokens) {
+  LlmParams params = GetSmallLlmParams();
+  params.draft_size_G = 2;
+  const std::vector<int> prompt = RandomTokenIds(params, 20, /*seed=*/0);
+  MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt}));
+  const std::vector<float> expected_logits =
+      GetLogits(*llm, params.draft_size_G + 1);
+
+  params.max_num_prefix_cache_steps = params.seq_size_T;
+  MP_ASSERT_OK_AND_ASSIGN(auto cached_llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(cached_llm->AddInputTokens({prompt}));
+  MP_ASSERT_OK(cached_llm->SeekTimeStep(0));
+  // The logits of the last `draft_size_G` + 1 tokens are computed again.
+  MP_ASSERT_OK(cached_llm->AddInputTokens({prompt}));
+  EXPECT_THAT(GetLogits(*cached_llm, params.draft_size_G + 1),
+              Pointwise(FloatNear(kLogitsTolerance), expected_logits));
+}
+
+TEST(LlmTest, PrefixKVCacheHitLoadsStepsBeforeDraftTokens) {
+  LlmParams params = GetSmallLlmParams();
+  params.draft_size_G = 2;
+  params.max_num_prefix_cache_steps = params.seq_size_T;
+  // Only the first token is left to load from the cache.
+  const std::vector<int> prompt =
+      RandomTokenIds(params, params.draft_size_G + 2, /*seed=*/0);
+  MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt}));
+  const std::vector<float> expected_logits =
+      GetLogits(*llm, params.draft_size_G + 1);
+
+  MP_ASSERT_OK(llm->SeekTimeStep(0));
+  MP_ASSERT_OK_AND_ASSIGN(const size_t num_cached_steps,
+                          llm->LoadCachedPrefix(prompt));
+  EXPECT_EQ(num_cached_steps, 1);
+  MP_ASSERT_OK(llm->SeekTimeStep(0));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt}));
+  EXPECT_THAT(GetLogits(*llm, params.draft_size_G + 1),
+              Pointwise(FloatNear(kLogitsTolerance), expected_logits));
+
+  // A prompt of draft tokens only is computed in full.
+  MP_ASSERT_OK(llm->SeekTimeStep(0));
+  EXPECT_THAT(llm->LoadCachedPrefix(
+                  {prompt.begin(), prompt.begin() + params.draft_size_G + 1}),
+              IsOkAndHolds(0u));
+}
+
+TEST(LlmTest, ChunkedPrefillMatchesSinglePrefill) {
+  LlmParams params = GetSmallLlmParams();
+  const std::vector<int> prompt = RandomTokenIds(params, 23, /*seed=*/0);
+  MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt}));
+  const std::vector<float> expected_logits = GetLogits(*llm);
+
+  // 23 tokens are processed in chunks of 5, 5, 5, 5 and 3 tokens.
+  params.prefill_chunk_size = 5;
+  MP_ASSERT_OK_AND_ASSIGN(auto chunked_llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(chunked_llm->AddInputTokens({prompt}));
+  EXPECT_EQ(chunked_llm->TotalTokenSize(), prompt.size());
+  EXPECT_THAT(GetLogits(*chunked_llm),
+              Pointwise(FloatNear(kLogitsTolerance), expected_logits));
+}
+
+TEST(LlmTest, ChunkedPrefillRequiresKVCache) {
+  LlmParams params = GetSmallLlmParams();
+  params.enable_kv_cache = false;
+  params.enable_dynamic_shape = false;
+  params.prefill_chunk_size = 5;
+  EXPECT_FALSE(CreateSmallLlm(params).ok());
+}
+
+TEST(LlmTest, MaskedBatchMatchesSequenceRunAlone) {
+  LlmParams params = GetSmallLlmParams();
+  const std::vector<int> long_ids = RandomTokenIds(params, 12, /*seed=*/0);
+  const std::vector<int> short_ids = RandomTokenIds(params, 5, /*seed=*/1);
+  const int next_long_id = 7;
+  const int next_short_id = 42;
+  MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(llm->AddInputTokens({long_ids}));
+  const std::vector<float> expected_long_logits = GetLogits(*llm);
+  MP_ASSERT_OK(llm->AddInputTokens({{next_long_id}}));
+  const std::vector<float> expected_next_long_logits = GetLogits(*llm);
+  MP_ASSERT_OK(llm->SeekTimeStep(0));
+  MP_ASSERT_OK(llm->AddInputTokens({short_ids}));
+  const std::vector<float> expected_short_logits = GetLogits(*llm);
+  MP_ASSERT_OK(llm->AddInputTokens({{next_short_id}}));
+  const std::vector<float> expected_next_short_logits = GetLogits(*llm);
+
+  params.batch_size_B = 2;
+  params.enable_batch_attention_mask = true;
+  MP_ASSERT_OK_AND_ASSIGN(auto batch_llm, CreateSmallLlm(params));
+  // The short sequence is right-aligned, after padding that is masked out.
+  const size_t start_step = long_ids.size() - short_ids.size();
+  std::vector<int> padded_short_ids(start_step, 0);
+  padded_short_ids.insert(padded_short_ids.end(), short_ids.begin(),
+                          short_ids.end());
+  MP_ASSERT_OK(batch_llm->SetBatchStartSteps({0, start_step}));
+  MP_ASSERT_OK(batch_llm->AddInputTokens({long_ids, padded_short_ids}));
+  std::vector<float> logits = GetLogits(*batch_llm);
+  ASSERT_EQ(logits.size(), 2 * params.voc_size_V);
+  EXPECT_THAT(
+      std::vector<float>(logits.begin(), logits.begin() + params.voc_size_V),
+      Pointwise(FloatNear(kLogitsTolerance), expected_long_logits));
+  EXPECT_THAT(
+      std::vector<float>(logits.begin() + params.voc_size_V, logits.end()),
+      Pointwise(FloatNear(kLogitsTolerance), expected_short_logits));
+
+  MP_ASSERT_OK(batch_llm->AddInputTokens({{next_long_id}, {next_short_id}}));
+  logits = GetLogits(*batch_llm);
+  EXPECT_THAT(
+      std::vector<float>(logits.begin(), logits.begin() + params.voc_size_V),
+      Pointwise(FloatNear(kLogitsTolerance), expected_next_long_logits));
+  EXPECT_THAT(
+      std::vector<float>(logits.begin() + params.voc_size_V, logits.end()),
+      Pointwise(FloatNear(kLogitsTolerance), expected_next_short_logits));
+}
+
+TEST(LlmTest, LoadContextResumesPagedKVCache) {
+  const LlmParams params = GetSmallLlmParams();
+  const std::vector<int> prompt_a = RandomTokenIds(params, 10, /*seed=*/0);
+  const std::vector<int> prompt_b = RandomTokenIds(params, 7, /*seed=*/1);
+  const std::vector<int> next_ids = {3, 14, 15, 92};
+  MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt_b}));
+  MP_ASSERT_OK(llm->AddInputTokens({{next_ids[0]}}));
+  const std::vector<float> expected_b_logits = GetLogits(*llm);
+  MP_ASSERT_OK(llm->SeekTimeStep(0));
+  MP_ASSERT_OK(llm->AddInputTokens({prompt_a}));
+  for (int next_id : next_ids) {
+    MP_ASSERT_OK(llm->AddInputTokens({{next_id}}));
+  }
+  const std::vector<float> expected_a_logits = GetLogits(*llm);
+
+  LlmParams paged_params = params;
+  paged_params.kv_cache_block_size = 4;
+  MP_ASSERT_OK_AND_ASSIGN(auto paged_llm, CreateSmallLlm(paged_params));
+  MP_ASSERT_OK_AND_ASSIGN(Llm::Context context_a, paged_llm->NewContext());
+  auto a = std::make_shared<Llm::Context>(std::move(context_a));
+  MP_ASSERT_OK_AND_ASSIGN(Llm::Context context_b, paged_llm->NewContext());
+  auto b = std::make_shared<Llm::Context>(std::move(context_b));
+
+  // Context A is switched out with 11 time steps, the last block partly full.
+  MP_ASSERT_OK(paged_llm->LoadContext(a));
+  MP_ASSERT_OK(paged_llm->AddInputTokens({prompt_a}));
+  MP_ASSERT_OK(paged_llm->AddInputTokens({{next_ids[0]}}));
+
+  MP_ASSERT_OK(paged_llm->LoadContext(b));
+  EXPECT_EQ(paged_llm->TotalTokenSize(), 0);
+  MP_ASSERT_OK(paged_llm->AddInputTokens({prompt_b}));
+  MP_ASSERT_OK(paged_llm->AddInputTokens({{next_ids[0]}}));
+  EXPECT_THAT(GetLogits(*paged_llm),
+              Pointwise(FloatNear(kLogitsTolerance), expected_b_logits));
+
+  MP_ASSERT_OK(paged_llm->LoadContext(a));
+  EXPECT_EQ(paged_llm->TotalTokenSize(), prompt_a.size() + 1);
+  for (size_t i = 1; i < next_ids.size(); ++i) {
+    MP_ASSERT_OK(paged_llm->AddInputTokens({{next_ids[i]}}));
+  }
+  EXPECT_THAT(GetLogits(*paged_llm),
+              Pointwise(FloatNear(kLogitsTolerance), expected_a_logits));
+}
+
+// Returns the largest absolute difference between `logits` and `expected`,
+// relative to the largest magnitude of `expected`.
+float GetRelativeLogitsError(const std::vector<float>& logits,
+                             const std::vector<float>& expected) {
+  ABSL_CHECK_EQ(logits.size(), expected.size());
+  float max_error = 0;
+  float max_magnitude = 0;
+  for (size_t i = 0; i < logits.size(); ++i) {
+    max_error = std::max(max_error, std::abs(logits[i] - expected[i]));
+    max_magnitude = std::max(max_magnitude, std::abs(expected[i]));
+  }
+  return max_error / max_magnitude;
+}
+
+TEST(LlmTest, QuantizedPagedKVCacheStaysCloseToFloat) {
+  LlmParams params = GetSmallLlmParams();
+  params.kv_cache_block_size = 4;
+  const std::vector<int> prompt_a = RandomTokenIds(params, 10, /*seed=*/0);
+  const std::vector<int> prompt_b = RandomTokenIds(params, 7, /*seed=*/1);
+  const std::vector<int> next_ids = {3, 14, 15, 92};
+  // Returns the logits of context A once resumed after context B, so that the
+  // KV cache of A went through the blocks of `block_type`.
+  auto get_resumed_logits = [&](LlmParams::KVCacheType block_type) {
+    LlmParams block_params = params;
+    block_params.kv_cache_block_type = block_type;
+    absl::StatusOr<std::unique_ptr<Llm>> llm = CreateSmallLlm(block_params);
+    ABSL_CHECK_OK(llm);
+    absl::StatusOr<Llm::Context> context_a = (*llm)->NewContext();
+    ABSL_CHECK_OK(context_a);
+    auto a = std::make_shared<Llm::Context>(*std::move(context_a));
+    absl::StatusOr<Llm::Context> context_b = (*llm)->NewContext();
+    ABSL_CHECK_OK(context_b);
+    auto b = std::make_shared<Llm::Context>(*std::move(context_b));
+
+    ABSL_CHECK_OK((*llm)->LoadContext(a));
+    ABSL_CHECK_OK((*llm)->AddInputTokens({prompt_a}));
+    ABSL_CHECK_OK((*llm)->AddInputTokens({{next_ids[0]}}));
+    ABSL_CHECK_OK((*llm)->LoadContext(b));
+    ABSL_CHECK_OK((*llm)->AddInputTokens({prompt_b}));
+    ABSL_CHECK_OK((*llm)->LoadContext(a));
+    for (size_t i = 1; i < next_ids.size(); ++i) {
+      ABSL_CHECK_OK((*llm)->AddInputTokens({{next_ids[i]}}));
+    }
+    return GetLogits(**llm);
+  };
+
+  const std::vector<float> float_logits =
+      get_resumed_logits(LlmParams::KVCacheType::FLOAT);
+  const float int8_error = GetRelativeLogitsError(
+      get_resumed_logits(LlmParams::KVCacheType::INT8), float_logits);
+  const float int4_error = GetRelativeLogitsError(
+      get_resumed_logits(LlmParams::KVCacheType::INT4), float_logits);
+  // The blocks are quantized, more coarsely in INT4, but the logits stay close.
+  EXPECT_GT(int4_error, 0);
+  EXPECT_LE(int8_error, int4_error);
+  EXPECT_LT(int8_error, 0.1f);
+  EXPECT_LT(int4_error, 0.5f);
+}
+
+// Returns the first `num_tokens` tokens decoded by `decoder` after `prompt`.
+std::vector<int> SpeculativeDecode(SpeculativeDecoder& decoder,
+                                   const std::vector<int>& prompt,
+                                   size_t num_tokens) {
+  ABSL_CHECK_OK(decoder.Reset(prompt));
+  std::vector<int> token_ids;
+  while (token_ids.size() < num_tokens) {
+    absl::StatusOr<std::vector<int>> step_ids = decoder.Step();
+    ABSL_CHECK_OK(step_ids);
+    token_ids.insert(token_ids.end(), step_ids->begin(), step_ids->end());
+  }
+  token_ids.resize(num_tokens);
+  return token_ids;
+}
+
+// A draft model proposing the tokens of `sequence` shifted by `token_offset`
+// in the vocabulary, so that the target accepts all of them if 0, and none of
+// them otherwise.
+class FakeDraftLlm : public Llm {
+ public:
+  FakeDraftLlm(const LlmParams& params, std::vector<int> sequence,
+               int token_offset)
+      : sequence_(std::move(sequence)), token_offset_(token_offset) {
+    llm_params_ = params;
+    context_ = std::make_shared<Context>();
+    batch_prev_ids().resize(1);
+  }
+
+  absl::Status AddInputTokens(
+      absl::Span<const std::vector<int>> batch_input_ids) override {
+    std::vector<int>& prev_ids = batch_prev_ids()[0];
+    prev_ids.insert(prev_ids.end(), batch_input_ids[0].begin(),
+                    batch_input_ids[0].end());
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<std::shared_ptr<Tensor>> ComputeLogits(
+      size_t expected_seq_len) override {
+    std::vector<float> values(llm_params_.voc_size_V);
+    const size_t step = TotalTokenSize();
+    if (step < sequence_.size()) {
+      values[(sequence_[step] + token_offset_) % llm_params_.voc_size_V] = 1.0f;
+    }
+    auto logits = std::make_shared<Tensor>(
+        Tensor::DimsType{1, 1, llm_params_.voc_size_V});
+    MP_RETURN_IF_ERROR(logits->LoadFromVec(values, /*exact_match=*/true));
+    return logits;
+  }
+
+ private:
+  const std::vector<int> sequence_;
+  const int token_offset_;
+};
+
+class SpeculativeDecoderTest : public ::testing::Test {
+ protected:
+  static constexpr size_t kNumDraftTokens = 3;
+  static constexpr size_t kNumDecodedTokens = 12;
+
+  void SetUp() override {
+    params_ = GetSmallLlmParams();
+    prompt_ = RandomTokenIds(params_, 8, /*seed=*/0);
+    MP_ASSERT_OK_AND_ASSIGN(auto llm, CreateSmallLlm(params_));
+    expected_ids_ = GreedyDecode(*llm, prompt_, kNumDecodedTokens);
+
+    LlmParams target_params = params_;
+    target_params.draft_size_G = kNumDraftTokens;
+    MP_ASSERT_OK_AND_ASSIGN(target_, CreateSmallLlm(target_params));
+  }
+
+  // The prompt followed by the tokens greedily decoded by the target.
+  std::vector<int> ExpectedSequence() const {
+    std::vector<int> sequence = prompt_;
+    sequence.insert(sequence.end(), expected_ids_.begin(), expected_ids_.end());
+    return sequence;
+  }
+
+  LlmParams params_;
+  std::vector<int> prompt_;
+  std::vector<int> expected_ids_;
+  std::unique_ptr<Llm> target_;
+};
+
+TEST_F(SpeculativeDecoderTest, MatchesGreedyDecodingIfAllDraftsAccepted) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto decoder,
+      SpeculativeDecoder::Create(
+          target_.get(), std::make_unique<FakeDraftLlm>(
+                             params_, ExpectedSequence(), /*token_offset=*/0)));
+  EXPECT_THAT(SpeculativeDecode(*decoder, prompt_, kNumDecodedTokens),
+              ElementsAreArray(expected_ids_));
+  // Each step decodes the draft tokens and the next token of the target.
+  EXPECT_EQ(decoder->stats().num_steps,
+            kNumDecodedTokens / (kNumDraftTokens + 1));
+  EXPECT_EQ(decoder->stats().num_accepted_tokens,
+            decoder->stats().num_drafted_tokens);
+}
+
+TEST_F(SpeculativeDecoderTest, MatchesGreedyDecodingIfAllDraftsRejected) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto decoder,
+      SpeculativeDecoder::Create(
+          target_.get(), std::make_unique<FakeDraftLlm>(
+                             params_, ExpectedSequence(), /*token_offset=*/1)));
+  EXPECT_THAT(SpeculativeDecode(*decoder, prompt_, kNumDecodedTokens),
+              ElementsAreArray(expected_ids_));
+  // Each step only decodes the next token of the target.
+  EXPECT_EQ(decoder->stats().num_steps, kNumDecodedTokens);
+  EXPECT_EQ(decoder->stats().num_accepted_tokens, 0);
+}
+
+TEST_F(SpeculativeDecoderTest, MatchesGreedyDecodingWithSmallerDraftModel) {
+  LlmParams draft_params = params_;
+  draft_params.num_transformer_M = 1;
+  MP_ASSERT_OK_AND_ASSIGN(auto draft, CreateSmallLlm(draft_params));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto decoder,
+      SpeculativeDecoder::Create(target_.get(), std::move(draft)));
+  EXPECT_THAT(SpeculativeDecode(*decoder, prompt_, kNumDecodedTokens),
+              ElementsAreArray(expected_ids_));
+}
+
 }  // namespace
 
 // Benchmark LLM model specified by --model_type flag (QC8 weights, all
@@ -246,6 +641,148 @@ void BM_Llm_Mixed_INT48(benchmark::State& state) {
   RunBenchmark(*llm, state);
 }
 
+// Benchmark LLM model specified by --model_type flag (blockwise 4-bit weights
+// with the given block size, all default optimization)
+void BM_Llm_Blockwise_INT4(benchmark::State& state) {
+  auto [builder, params] = GetLlmBuilderAndParamsForBenchmark(state.range(0));
+  auto weights_loader =
+      std::make_unique<BenchmarkLlmBlockwiseInt4WeightsLoader>(
+          params, /*block_size=*/state.range(2));
+
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto llm, Llm::CreateLlm(std::move(weights_loader), std::move(builder)));
+  MP_ASSERT_OK(llm->AddInputTokens({{0}}));
+
+  RunBenchmark(*llm, state);
+}
+
+// Benchmark speculative decoding of the model specified by --model_type, e.g.
+// FALCON_RW_1B, STABLELM_4E1T_3B or PHI_2, drafted by the same architecture
+// with `kNumDraftModelLayers` layers (QC8 weights). Reports the decoded tokens
+// per second and the acceptance rate of the draft tokens.
+void BM_Llm_SpeculativeDecode(benchmark::State& state) {
+  constexpr size_t kNumDraftModelLayers = 2;
+  const size_t sequence_length = state.range(0);
+  const size_t prompt_size = state.range(1);
+  const size_t num_draft_tokens = state.range(2);
+  auto [builder, params] =
+      GetLlmBuilderAndParamsForBenchmark(sequence_length, num_draft_tokens);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto target,
+      Llm::CreateLlm(std::make_unique<BenchmarkLlmWeightsLoader>(
+                         params, xnn_datatype_qcint8),
+                     std::move(builder)));
+  auto [draft_builder, draft_params] = GetLlmBuilderAndParamsForBenchmark(
+      sequence_length, /*draft_size=*/0, kNumDraftModelLayers);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto draft,
+      Llm::CreateLlm(std::make_unique<BenchmarkLlmWeightsLoader>(
+                         draft_params, xnn_datatype_qcint8),
+                     std::move(draft_builder)));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto decoder, SpeculativeDecoder::Create(target.get(), std::move(draft)));
+
+  std::mt19937 rng;
+  std::uniform_int_distribution<int> distribution(0, params.voc_size_V - 1);
+  std::vector<int> prompt_ids(prompt_size);
+  std::generate(prompt_ids.begin(), prompt_ids.end(),
+                [&]() { return distribution(rng); });
+
+  int64_t num_token_processed = 0;
+  for (auto s : state) {
+    MP_ASSERT_OK(decoder->Reset(prompt_ids));
+    // Leaves room for the draft tokens verified in the last step.
+    while (decoder->TotalTokenSize() + 2 * num_draft_tokens + 1 <
+           sequence_length) {
+      MP_ASSERT_OK_AND_ASSIGN(std::vector<int> token_ids, decoder->Step());
+      num_token_processed += token_ids.size();
+    }
+  }
+  state.SetItemsProcessed(num_token_processed);
+  state.counters["acceptance_rate"] = decoder->stats().acceptance_rate();
+}
+
+// Benchmark decoding `kNumContexts` sequences of the model specified by
+// --model_type in turns, with their KV caches stored in blocks of the given
+// type (QC8 weights). Each turn switches the context, storing the new time
+// steps of the previous one and copying in the stored ones of the next. Reports
+// the decoded tokens per second, the memory taken by a block and by the blocks
+// of a context, and the float KV cache of the loaded context, which the block
+// type does not change.
+void BM_Llm_PagedKVCache(benchmark::State& state) {
+  constexpr size_t kNumContexts = 4;
+  const size_t sequence_length = state.range(0);
+  const size_t prompt_size = state.range(1);
+  auto [builder, params] = GetLlmBuilderAndParamsForBenchmark(sequence_length);
+  params.kv_cache_block_size = 16;
+  params.kv_cache_block_type =
+      static_cast<LlmParams::KVCacheType>(state.range(2));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto llm, Llm::CreateLlm(std::make_unique<BenchmarkLlmWeightsLoader>(
+                                   params, xnn_datatype_qcint8),
+                               std::move(builder)));
+
+  std::mt19937 rng;
+  std::uniform_int_distribution<int> distribution(0, params.voc_size_V - 1);
+  std::vector<int> prompt_ids(prompt_size);
+  std::generate(prompt_ids.begin(), prompt_ids.end(),
+                [&]() { return distribution(rng); });
+
+  std::vector<int> token_ids;
+  int64_t num_token_processed = 0;
+  size_t num_used_blocks = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    std::vector<std::shared_ptr<Llm::Context>> contexts;
+    for (size_t i = 0; i < kNumContexts; ++i) {
+      MP_ASSERT_OK_AND_ASSIGN(auto context, llm->NewContext());
+      contexts.push_back(std::make_shared<Llm::Context>(std::move(context)));
+      MP_ASSERT_OK(llm->LoadContext(contexts.back()));
+      MP_ASSERT_OK(llm->AddInputTokens({prompt_ids}));
+    }
+    state.ResumeTiming();
+    while (llm->TotalTokenSize() < sequence_length) {
+      for (const auto& context : contexts) {
+        MP_ASSERT_OK(llm->LoadContext(context));
+        MP_ASSERT_OK(llm->GetNextToken(&token_ids));
+        num_token_processed += token_ids.size();
+      }
+    }
+    state.PauseTiming();
+    num_used_blocks = llm->kv_cache_block_pool_->num_used_blocks();
+    // Releases the blocks of the contexts.
+    MP_ASSERT_OK_AND_ASSIGN(auto context, llm->NewContext());
+    MP_ASSERT_OK(
+        llm->LoadContext(std::make_shared<Llm::Context>(std::move(context))));
+    contexts.clear();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(num_token_processed);
+  const size_t block_bytes = llm->kv_cache_block_pool_->block_bytes();
+  state.counters["block_bytes"] = block_bytes;
+  state.counters["context_block_bytes"] =
+      num_used_blocks * block_bytes / kNumContexts;
+  size_t loaded_kv_cache_bytes = 0;
+  for (const auto& tensor : llm->KVCacheTensors()) {
+    loaded_kv_cache_bytes += tensor->data_size();
+  }
+  state.counters["loaded_kv_cache_bytes"] = loaded_kv_cache_bytes;
+}
+
+// Benchmark loading the weights of the model specified by --model_type flag
+// (random QC8 weights) on the given number of threads.
+void BM_Llm_LoadWeights(benchmark::State& state) {
+  auto [builder, params] = GetLlmBuilderAndParamsForBenchmark(
+      /*seq_size=*/512);
+  params.num_weights_loading_threads = state.range(0);
+  BenchmarkLlmWeightsLoader weights_loader(params, xnn_datatype_qcint8,
+                                           /*seed=*/0);
+  for (auto s : state) {
+    MP_ASSERT_OK_AND_ASSIGN(auto weights, weights_loader.LoadWeights());
+    benchmark::DoNotOptimize(weights);
+  }
+}
+
 // Run benchmark for three different cache sizes: 64, 512, 1024.
 BENCHMARK(BM_Llm_QCINT8)
     ->UseRealTime()
@@ -291,5 +828,34 @@ BENCHMARK(BM_Llm_Mixed_INT48)
             /*batch_size=*/48})
     ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
             /*batch_size=*/64});
+BENCHMARK(BM_Llm_Blockwise_INT4)
+    ->UseRealTime()
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*block_size=*/32})
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*block_size=*/64})
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*block_size=*/128});
+BENCHMARK(BM_Llm_SpeculativeDecode)
+    ->UseRealTime()
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*num_draft_tokens=*/2})
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*num_draft_tokens=*/4})
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*num_draft_tokens=*/8});
+BENCHMARK(BM_Llm_PagedKVCache)
+    ->UseRealTime()
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*kv_cache_block_type=*/0})
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*kv_cache_block_type=*/1})
+    ->Args({/*sequence_length=*/512, /*prompt_size=*/128,
+            /*kv_cache_block_type=*/2});
+BENCHMARK(BM_Llm_LoadWeights)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(/*num_weights_loading_threads=*/1)
+    ->Arg(/*num_weights_loading_threads=*/4);
 
 }  // namespace mediapipe::tasks::genai::xnn_utils
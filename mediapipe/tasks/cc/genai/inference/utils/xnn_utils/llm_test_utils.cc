@@ -0,0 +1,88 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_test_utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/well_known_models.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/benchmark_weight_accessor.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+#include "xnnpack.h"  // from @XNNPACK
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+LlmParams GetSmallLlmParams() {
+  LlmParams params =
+      LlmParams::FromLLMParametersProto(llm_utils::GetGemma2BParams());
+  params.num_transformer_M = 2;
+  params.batch_size_B = 1;
+  params.seq_size_T = 64;
+  params.model_dim_D = 32;
+  params.hidden_dim_HD = 64;
+  params.head_dim_H = 8;
+  params.n_heads_N = 4;
+  params.voc_size_V = 100;
+  return params;
+}
+
+absl::StatusOr<std::unique_ptr<Llm>> CreateSmallLlm(const LlmParams& params) {
+  return Llm::CreateLlm(
+      std::make_unique<LlmWeightsLoader>(
+          std::make_unique<BenchmarkWeightAccessor>(xnn_datatype_fp32,
+                                                    /*seed=*/0),
+          params),
+      std::make_unique<LlmBuilder>(params, std::make_unique<RuntimeConfigs>()));
+}
+
+std::vector<int> RandomTokenIds(const LlmParams& params, size_t num_tokens,
+                                int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> distribution(0, params.voc_size_V - 1);
+  std::vector<int> token_ids(num_tokens);
+  std::generate(token_ids.begin(), token_ids.end(),
+                [&]() { return distribution(rng); });
+  return token_ids;
+}
+
+std::vector<float> GetLogits(Llm& llm, size_t num_steps) {
+  absl::StatusOr<std::shared_ptr<Tensor>> logits = llm.ComputeLogits(num_steps);
+  ABSL_CHECK_OK(logits);
+  const float* data = (*logits)->DataAs<float>();
+  return std::vector<float>(data, data + (*logits)->num_elements);
+}
+
+std::vector<int> GreedyDecode(Llm& llm, const std::vector<int>& prompt,
+                              size_t num_tokens) {
+  ABSL_CHECK_OK(llm.AddInputTokens({prompt}));
+  std::vector<int> token_ids;
+  while (token_ids.size() < num_tokens) {
+    const std::vector<float> logits = GetLogits(llm);
+    token_ids.push_back(std::max_element(logits.begin(), logits.end()) -
+                        logits.begin());
+    ABSL_CHECK_OK(llm.AddInputTokens({{token_ids.back()}}));
+  }
+  return token_ids;
+}
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -0,0 +1,54 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_LLM_TEST_UTILS_H_
+#define MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_LLM_TEST_UTILS_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm_weights.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+// The tolerance of the logits of equivalent computations, which may differ in
+// the order of floating point operations.
+inline constexpr float kLogitsTolerance = 1e-4f;
+
+// Returns the params of a small causal model with relative positional
+// embeddings, for the tests comparing the logits of equivalent computations.
+LlmParams GetSmallLlmParams();
+
+// Returns a model with `params` and random float weights, the same for all
+// models of the same shape.
+absl::StatusOr<std::unique_ptr<Llm>> CreateSmallLlm(const LlmParams& params);
+
+// Returns `num_tokens` random ids of the vocabulary of `params`.
+std::vector<int> RandomTokenIds(const LlmParams& params, size_t num_tokens,
+                                int seed);
+
+// Returns the logits of the last `num_steps` time steps added to `llm`.
+std::vector<float> GetLogits(Llm& llm, size_t num_steps = 1);
+
+// Returns the `num_tokens` tokens greedily decoded by `llm`, of batch size 1,
+// after `prompt`.
+std::vector<int> GreedyDecode(Llm& llm, const std::vector<int>& prompt,
+                              size_t num_tokens);
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+#endif  // MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_LLM_TEST_UTILS_H_
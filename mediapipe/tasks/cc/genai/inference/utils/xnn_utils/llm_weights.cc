@@ -18,6 +18,7 @@
 
 #include <cstddef>
 #include <cstring>
+#include <initializer_list>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -25,6 +26,7 @@
 
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
@@ -34,7 +36,9 @@
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/tasks/cc/genai/inference/proto/transformer_params.pb.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/memory_mapped_file.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/pack_weights_cache.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/tflite_weight_accessor.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
@@ -68,6 +72,26 @@ LlmParams::Norm TransformerParametersProtoNormTypeToLlmParamsNormType(
   return LlmParams::Norm::UNSPECIFIED;
 }
 
+// Hints that the data of `tensors`, if mapped from a file, is needed soon.
+void PrefetchTensors(std::initializer_list<const Tensor*> tensors) {
+  for (const Tensor* tensor : tensors) {
+    if (!tensor || !tensor->flat_data) continue;
+    llm_utils::MemoryMappedFile::Prefetch(tensor->flat_data.get(),
+                                          tensor->data_size());
+  }
+}
+
+// Prefetches the linear weights of a layer, which make up most of its size.
+void PrefetchLayer(const LlmWeights::FeedForwardWeights& feed_forward,
+                   const LlmWeights::SelfAttentionWeights& self_attention) {
+  PrefetchTensors({self_attention.q_weight.get(), self_attention.k_weight.get(),
+                   self_attention.v_weight.get(),
+                   self_attention.post_proj_weight.get(),
+                   feed_forward.layer_1_weight.get(),
+                   feed_forward.layer_1_gate_weight.get(),
+                   feed_forward.layer_2_weight.get()});
+}
+
 }  // namespace
 
 // According to norm_type, load necessary weights with given basename.
@@ -449,12 +473,34 @@ absl::StatusOr<LlmWeights> LlmWeightsLoader::LoadWeights() {
   RET_CHECK(weight_accessor_);
 
   LlmWeights result;
-
-  for (int layer_id = 0; layer_id < params_.num_transformer_M; ++layer_id) {
-    MP_ASSIGN_OR_RETURN(auto ff, LoadFeedForward(layer_id));
-    result.ffs.push_back(std::move(ff));
-    MP_ASSIGN_OR_RETURN(auto sa, LoadSelfAttention(layer_id));
-    result.sas.push_back(std::move(sa));
+  result.ffs.resize(params_.num_transformer_M);
+  result.sas.resize(params_.num_transformer_M);
+  auto load_layer = [this, &result](int layer_id) -> absl::Status {
+    MP_ASSIGN_OR_RETURN(result.ffs[layer_id], LoadFeedForward(layer_id));
+    MP_ASSIGN_OR_RETURN(result.sas[layer_id], LoadSelfAttention(layer_id));
+    PrefetchLayer(result.ffs[layer_id], result.sas[layer_id]);
+    return absl::OkStatus();
+  };
+  if (params_.num_weights_loading_threads > 1) {
+    std::vector<absl::Status> statuses(params_.num_transformer_M);
+    {
+      ThreadPool pool("llm_weights",
+                      static_cast<int>(params_.num_weights_loading_threads));
+      pool.StartWorkers();
+      for (int layer_id = 0; layer_id < params_.num_transformer_M;
+           ++layer_id) {
+        pool.Schedule([&statuses, &load_layer, layer_id] {
+          statuses[layer_id] = load_layer(layer_id);
+        });
+      }
+    }
+    for (const absl::Status& status : statuses) {
+      MP_RETURN_IF_ERROR(status);
+    }
+  } else {
+    for (int layer_id = 0; layer_id < params_.num_transformer_M; ++layer_id) {
+      MP_RETURN_IF_ERROR(load_layer(layer_id));
+    }
   }
 
   MP_ASSIGN_OR_RETURN(result.final_norm_weight,
@@ -141,6 +141,51 @@ struct LlmParams {
   // sequence length to avoid computation waste.
   bool enable_dynamic_shape ABSL_DEPRECATED(
       "This is always enabled if enable_kv_cache is true.") = false;
+  // If true, each batch has its own attention mask, so that the batches can
+  // hold independent sequences starting at different time steps. See
+  // Llm::SetBatchStartSteps().
+  bool enable_batch_attention_mask = false;
+
+  // If positive, the contexts created by Llm::NewContext() store their KV cache
+  // in blocks of this many time steps, from a pool shared by the model, rather
+  // than in buffers of their own sized for seq_size_T. At most
+  // `max_num_kv_cache_blocks` blocks are in use at once, unless 0.
+  size_t kv_cache_block_size = 0;
+  size_t max_num_kv_cache_blocks = 0;
+
+  // How the blocks of a paged KV cache store the time steps. INT8 and INT4
+  // store symmetric integers with a float scale per group of
+  // `kv_cache_quantization_group_size` values of a time step, the head
+  // dimension if 0. Only the blocks of the contexts that are not loaded are
+  // quantized: the loaded context decodes from the float KV cache of the
+  // graph, sized for seq_size_T, which Llm keeps in memory either way. So this
+  // trades some accuracy for 4x and 8x (minus the scales) more idle contexts
+  // in the same memory, and does not shrink the memory of a single session.
+  // Requires kv_cache_block_size > 0.
+  enum class KVCacheType {
+    FLOAT = 0,
+    INT8 = 1,
+    INT4 = 2,
+  } kv_cache_block_type = KVCacheType::FLOAT;
+  size_t kv_cache_quantization_group_size = 0;
+
+  // If positive, Llm keeps the KV cache of up to this many time steps of
+  // recent prompts, so that prompts sharing a prefix with them only compute
+  // the rest. The least recently used prompts are evicted first. Requires
+  // batch_size_B == 1.
+  size_t max_num_prefix_cache_steps = 0;
+
+  // If positive, Llm::AddInputTokens() processes inputs of causal models in
+  // chunks of this many tokens, each in its own graph run, so that a long
+  // prompt doesn't take one long run and the peak size of the activations is
+  // bounded. Chunks hold at least `draft_size_G` + 1 tokens. Requires
+  // enable_kv_cache.
+  size_t prefill_chunk_size = 0;
+
+  // If greater than 1, LlmWeightsLoader::LoadWeights() loads the transformer
+  // layers in parallel on this many threads, which requires its
+  // WeightAccessor to be thread-safe.
+  size_t num_weights_loading_threads = 0;
 
   // If provided, the runtime will prepare cache at the provided directory.
   // Otherwise, cache will be prepared besides the original model.
@@ -232,6 +277,10 @@ class LlmWeightsLoader {
       : weight_accessor_(std::move(weight_accessor)), params_(params) {}
   virtual ~LlmWeightsLoader() = default;
 
+  // Loads the weights of all layers. Once a layer is loaded, the pages of its
+  // weights mapped from files are prefetched, so that they are read in while
+  // the following layers are loaded and the graph is built, rather than when
+  // the weights are first packed.
   virtual absl::StatusOr<LlmWeights> LoadWeights();
 
   LlmParams& llm_params() { return params_; }
@@ -29,7 +29,9 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "flatbuffers/buffer.h"
 #include "flatbuffers/flatbuffer_builder.h"
 #include "mediapipe/framework/port/file_helpers.h"
@@ -89,9 +91,17 @@ absl::Status PackWeightsCache::AddUnpackedWeight(
     absl::string_view name, std::shared_ptr<Tensor> weight) {
   RET_CHECK(!name.empty());
   RET_CHECK(weight->Data());
+  absl::MutexLock lock(&kernel_to_name_mutex_);
   RET_CHECK(!kernel_to_name_.contains(weight->Data()));
 
-  kernel_to_name_[weight->Data()] = name;
+  std::string key(name);
+  if (weight->datatype == xnn_datatype_qbint4) {
+    // The packed weight depends on the block size, so that a cache built for
+    // another quantization of the weight must not match.
+    absl::StrAppend(&key, "/block_size:",
+                    static_cast<const QBTensor&>(*weight).block_size);
+  }
+  kernel_to_name_[weight->Data()] = std::move(key);
   return absl::OkStatus();
 }
 
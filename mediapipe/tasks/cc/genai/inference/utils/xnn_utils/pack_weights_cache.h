@@ -25,6 +25,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "flatbuffers/flatbuffer_builder.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/memory_mapped_file.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/graph_builder.h"
@@ -49,6 +50,8 @@ class PackWeightsCache : public XnnWeightsCache {
 
   // Adds an unpacked weight. Across different processes, the same `weight` may
   // be loaded to different memory address, however the `name` would not change.
+  // Blockwise quantized weights are cached under their name and block size.
+  // Thread-safe, so that weights can be loaded in parallel.
   absl::Status AddUnpackedWeight(absl::string_view name,
                                  std::shared_ptr<Tensor> weight);
 
@@ -127,6 +130,9 @@ class PackWeightsCache : public XnnWeightsCache {
   absl::Status error_status_ = absl::OkStatus();
   std::optional<xnn_weights_cache_look_up_key> key_sent_for_double_check_;
 
+  // Guards `kernel_to_name_` while weights are added. The weights are looked
+  // up only once they are all added.
+  absl::Mutex kernel_to_name_mutex_;
   absl::flat_hash_map<const void* /*kernel_ptr*/, std::string /*name*/>
       kernel_to_name_;
   absl::flat_hash_map<absl::string_view /*name*/,
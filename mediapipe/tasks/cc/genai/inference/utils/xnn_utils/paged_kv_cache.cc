@@ -0,0 +1,273 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/paged_kv_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+namespace {
+
+// Quantizes `num_values` values of `src` to symmetric `bits`-bit integers with
+// a scale per group of `group_size` values, into `dst` and `scales`. 4-bit
+// values are packed two per byte, offset by 8.
+void QuantizeGroups(const float* src, size_t num_values, size_t group_size,
+                    int bits, uint8_t* dst, float* scales) {
+  const float max_int = (1 << (bits - 1)) - 1;
+  for (size_t group = 0; group < num_values / group_size; ++group) {
+    const float* group_src = src + group * group_size;
+    float abs_max = 0.0f;
+    for (size_t i = 0; i < group_size; ++i) {
+      abs_max = std::max(abs_max, std::abs(group_src[i]));
+    }
+    const float scale = abs_max / max_int;
+    const float inv_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+    scales[group] = scale;
+    for (size_t i = 0; i < group_size; ++i) {
+      const int value = static_cast<int>(std::clamp(
+          std::round(group_src[i] * inv_scale), -max_int, max_int));
+      const size_t index = group * group_size + i;
+      if (bits == 8) {
+        dst[index] = static_cast<uint8_t>(static_cast<int8_t>(value));
+      } else if (index % 2 == 0) {
+        dst[index / 2] = static_cast<uint8_t>(value + 8);
+      } else {
+        dst[index / 2] |= static_cast<uint8_t>(value + 8) << 4;
+      }
+    }
+  }
+}
+
+// Reverts QuantizeGroups().
+void DequantizeGroups(const uint8_t* src, const float* scales,
+                      size_t num_values, size_t group_size, int bits,
+                      float* dst) {
+  for (size_t index = 0; index < num_values; ++index) {
+    int value;
+    if (bits == 8) {
+      value = static_cast<int8_t>(src[index]);
+    } else {
+      value = ((src[index / 2] >> (4 * (index % 2))) & 0xf) - 8;
+    }
+    dst[index] = value * scales[index / group_size];
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::shared_ptr<KVCacheBlockPool>> KVCacheBlockPool::Create(
+    size_t block_size, size_t max_num_blocks,
+    absl::Span<const std::shared_ptr<Tensor>> caches, int quantization_bits,
+    size_t group_size) {
+  RET_CHECK_GT(block_size, 0);
+  RET_CHECK(quantization_bits == 0 || quantization_bits == 8 ||
+            quantization_bits == 4)
+      << "Unsupported KV cache quantization: " << quantization_bits << " bits.";
+  std::vector<size_t> step_sizes;
+  for (const auto& cache : caches) {
+    RET_CHECK(cache);
+    RET_CHECK(!cache->dims.empty());
+    RET_CHECK_EQ(cache->datatype, xnn_datatype_fp32);
+    step_sizes.push_back(cache->num_elements / cache->dims[0]);
+    if (quantization_bits > 0) {
+      RET_CHECK_GT(group_size, 0);
+      RET_CHECK_EQ(step_sizes.back() % group_size, 0);
+      RET_CHECK(quantization_bits == 8 || group_size % 2 == 0);
+    }
+  }
+  return std::shared_ptr<KVCacheBlockPool>(
+      new KVCacheBlockPool(block_size, max_num_blocks, std::move(step_sizes),
+                           quantization_bits, group_size));
+}
+
+KVCacheBlockPool::KVCacheBlockPool(size_t block_size, size_t max_num_blocks,
+                                   std::vector<size_t> step_sizes,
+                                   int quantization_bits, size_t group_size)
+    : block_size_(block_size),
+      max_num_blocks_(max_num_blocks),
+      step_sizes_(std::move(step_sizes)),
+      quantization_bits_(quantization_bits),
+      group_size_(group_size) {}
+
+absl::StatusOr<int> KVCacheBlockPool::Allocate() {
+  absl::MutexLock lock(&mutex_);
+  if (!free_blocks_.empty()) {
+    const int block = free_blocks_.back();
+    free_blocks_.pop_back();
+    return block;
+  }
+  if (max_num_blocks_ > 0 && blocks_.size() >= max_num_blocks_) {
+    return absl::ResourceExhaustedError(
+        absl::StrCat("All ", max_num_blocks_, " KV cache blocks are in use."));
+  }
+  Block block(step_sizes_.size());
+  for (size_t i = 0; i < step_sizes_.size(); ++i) {
+    const size_t num_values = block_size_ * step_sizes_[i];
+    if (quantization_bits_ == 0) {
+      block[i].values.resize(num_values);
+    } else {
+      block[i].quantized_values.resize(num_values * quantization_bits_ / 8);
+      block[i].scales.resize(num_values / group_size_);
+    }
+  }
+  blocks_.push_back(std::move(block));
+  return blocks_.size() - 1;
+}
+
+void KVCacheBlockPool::Release(int block) {
+  absl::MutexLock lock(&mutex_);
+  ABSL_DCHECK_LT(block, blocks_.size());
+  free_blocks_.push_back(block);
+}
+
+KVCacheBlockPool::Block& KVCacheBlockPool::GetBlock(int block) const {
+  absl::MutexLock lock(&mutex_);
+  ABSL_DCHECK_LT(block, blocks_.size());
+  return blocks_[block];
+}
+
+absl::Status KVCacheBlockPool::Write(
+    int block, size_t offset, absl::Span<const std::shared_ptr<Tensor>> caches,
+    size_t start, size_t num_steps) {
+  RET_CHECK_LE(offset + num_steps, block_size_);
+  Block& tensors = GetBlock(block);
+  RET_CHECK_EQ(caches.size(), tensors.size());
+  for (size_t i = 0; i < caches.size(); ++i) {
+    RET_CHECK_LE(start + num_steps, caches[i]->dims[0]);
+    const size_t step_size = step_sizes_[i];
+    const float* src = caches[i]->DataAs<float>() + start * step_size;
+    BlockTensor& tensor = tensors[i];
+    if (quantization_bits_ == 0) {
+      std::copy(src, src + num_steps * step_size,
+                tensor.values.begin() + offset * step_size);
+    } else {
+      QuantizeGroups(
+          src, num_steps * step_size, group_size_, quantization_bits_,
+          &tensor.quantized_values[offset * step_size * quantization_bits_ / 8],
+          &tensor.scales[offset * step_size / group_size_]);
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status KVCacheBlockPool::Read(
+    int block, size_t num_steps,
+    absl::Span<const std::shared_ptr<Tensor>> caches, size_t start) const {
+  RET_CHECK_LE(num_steps, block_size_);
+  const Block& tensors = GetBlock(block);
+  RET_CHECK_EQ(caches.size(), tensors.size());
+  for (size_t i = 0; i < caches.size(); ++i) {
+    RET_CHECK_LE(start + num_steps, caches[i]->dims[0]);
+    const size_t step_size = step_sizes_[i];
+    float* dst = caches[i]->DataAs<float>() + start * step_size;
+    const BlockTensor& tensor = tensors[i];
+    if (quantization_bits_ == 0) {
+      std::copy(tensor.values.begin(),
+                tensor.values.begin() + num_steps * step_size, dst);
+    } else {
+      DequantizeGroups(tensor.quantized_values.data(), tensor.scales.data(),
+                       num_steps * step_size, group_size_, quantization_bits_,
+                       dst);
+    }
+  }
+  return absl::OkStatus();
+}
+
+size_t KVCacheBlockPool::block_bytes() const {
+  size_t bytes = 0;
+  for (size_t step_size : step_sizes_) {
+    const size_t num_values = block_size_ * step_size;
+    if (quantization_bits_ == 0) {
+      bytes += num_values * sizeof(float);
+    } else {
+      bytes += num_values * quantization_bits_ / 8 +
+               num_values / group_size_ * sizeof(float);
+    }
+  }
+  return bytes;
+}
+
+size_t KVCacheBlockPool::num_used_blocks() const {
+  absl::MutexLock lock(&mutex_);
+  return blocks_.size() - free_blocks_.size();
+}
+
+size_t KVCacheBlockPool::num_allocated_blocks() const {
+  absl::MutexLock lock(&mutex_);
+  return blocks_.size();
+}
+
+PagedKVCache::PagedKVCache(std::shared_ptr<KVCacheBlockPool> pool)
+    : pool_(std::move(pool)) {}
+
+PagedKVCache::~PagedKVCache() { Truncate(0); }
+
+absl::Status PagedKVCache::Append(
+    absl::Span<const std::shared_ptr<Tensor>> caches, size_t end) {
+  const size_t block_size = pool_->block_size();
+  while (num_steps_ < end) {
+    const size_t offset = num_steps_ % block_size;
+    if (offset == 0) {
+      MP_ASSIGN_OR_RETURN(int block, pool_->Allocate());
+      block_table_.push_back(block);
+    }
+    const size_t num_steps = std::min(block_size - offset, end - num_steps_);
+    MP_RETURN_IF_ERROR(pool_->Write(block_table_.back(), offset, caches,
+                                    num_steps_, num_steps));
+    num_steps_ += num_steps;
+  }
+  return absl::OkStatus();
+}
+
+void PagedKVCache::Truncate(size_t num_steps) {
+  if (num_steps >= num_steps_) return;
+  const size_t block_size = pool_->block_size();
+  const size_t num_blocks = (num_steps + block_size - 1) / block_size;
+  for (size_t i = num_blocks; i < block_table_.size(); ++i) {
+    pool_->Release(block_table_[i]);
+  }
+  block_table_.resize(num_blocks);
+  num_steps_ = num_steps;
+}
+
+absl::Status PagedKVCache::CopyTo(
+    absl::Span<const std::shared_ptr<Tensor>> caches, size_t num_steps) const {
+  RET_CHECK_LE(num_steps, num_steps_);
+  const size_t block_size = pool_->block_size();
+  for (size_t start = 0; start < num_steps; start += block_size) {
+    const size_t end = std::min(start + block_size, num_steps);
+    MP_RETURN_IF_ERROR(pool_->Read(block_table_[start / block_size],
+                                   end - start, caches, start));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -0,0 +1,151 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_PAGED_KV_CACHE_H_
+#define MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_PAGED_KV_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+// A pool of fixed-size KV cache blocks, shared by the contexts of a model. A
+// block holds `block_size` time steps of each KV cache tensor of the model,
+// e.g. the key and value caches of all layers. Blocks are allocated on demand
+// and recycled once released, so that the pool grows with the total length of
+// the contexts rather than with their maximum length. Blocks may store the
+// time steps quantized, to fit more contexts in memory. Thread-safe.
+class KVCacheBlockPool {
+ public:
+  // `caches` are the KV cache tensors, of shape [T, ...], whose time steps the
+  // blocks hold. At most `max_num_blocks` blocks are in use at once, unless 0.
+  //
+  // If `quantization_bits` is 8 or 4, the blocks store symmetric integers with
+  // a float scale per group of `group_size` consecutive values of a time step,
+  // e.g. one scale per head and time step if `group_size` is the head
+  // dimension. `group_size` must divide the size of a time step, and be even
+  // for 4 bits.
+  static absl::StatusOr<std::shared_ptr<KVCacheBlockPool>> Create(
+      size_t block_size, size_t max_num_blocks,
+      absl::Span<const std::shared_ptr<Tensor>> caches,
+      int quantization_bits = 0, size_t group_size = 0);
+
+  size_t block_size() const { return block_size_; }
+
+  // Returns the index of a free block, or a ResourceExhausted error if
+  // `max_num_blocks` blocks are in use.
+  absl::StatusOr<int> Allocate();
+
+  // Returns `block` to the pool.
+  void Release(int block);
+
+  // Stores time steps [start, start + num_steps) of the contiguous `caches`
+  // into time steps [offset, offset + num_steps) of `block`.
+  absl::Status Write(int block, size_t offset,
+                     absl::Span<const std::shared_ptr<Tensor>> caches,
+                     size_t start, size_t num_steps);
+
+  // Copies the first `num_steps` time steps of `block` into time steps
+  // [start, start + num_steps) of the contiguous `caches`.
+  absl::Status Read(int block, size_t num_steps,
+                    absl::Span<const std::shared_ptr<Tensor>> caches,
+                    size_t start) const;
+
+  // The memory taken by one block, in bytes.
+  size_t block_bytes() const;
+
+  // The number of blocks in use, and allocated in total.
+  size_t num_used_blocks() const;
+  size_t num_allocated_blocks() const;
+
+ private:
+  // The time steps of one KV cache tensor in a block: `values` if not
+  // quantized, otherwise `quantized_values`, two per byte for 4 bits, and
+  // their `scales`.
+  struct BlockTensor {
+    std::vector<float> values;
+    std::vector<uint8_t> quantized_values;
+    std::vector<float> scales;
+  };
+  using Block = std::vector<BlockTensor>;
+
+  KVCacheBlockPool(size_t block_size, size_t max_num_blocks,
+                   std::vector<size_t> step_sizes, int quantization_bits,
+                   size_t group_size);
+
+  // Returns `block`, which stays in place while other threads allocate more
+  // blocks.
+  Block& GetBlock(int block) const;
+
+  const size_t block_size_;
+  const size_t max_num_blocks_;
+  // The number of values in a time step of each KV cache tensor.
+  const std::vector<size_t> step_sizes_;
+  const int quantization_bits_;
+  const size_t group_size_;
+
+  mutable absl::Mutex mutex_;
+  // A deque keeps the blocks in place as it grows.
+  mutable std::deque<Block> blocks_ ABSL_GUARDED_BY(mutex_);
+  std::vector<int> free_blocks_ ABSL_GUARDED_BY(mutex_);
+};
+
+// The KV cache of one context, stored in blocks of a KVCacheBlockPool. Its
+// block table lists the blocks in time step order: the i-th block holds time
+// steps [i * block_size, (i + 1) * block_size). Blocks are released when the
+// cache is truncated or destroyed.
+class PagedKVCache {
+ public:
+  explicit PagedKVCache(std::shared_ptr<KVCacheBlockPool> pool);
+  ~PagedKVCache();
+
+  PagedKVCache(const PagedKVCache&) = delete;
+  PagedKVCache& operator=(const PagedKVCache&) = delete;
+
+  // The number of time steps stored.
+  size_t num_steps() const { return num_steps_; }
+  const std::vector<int>& block_table() const { return block_table_; }
+
+  // Stores time steps [num_steps(), end) of the contiguous `caches`, which
+  // match the tensors of the pool, allocating blocks as needed.
+  absl::Status Append(absl::Span<const std::shared_ptr<Tensor>> caches,
+                      size_t end);
+
+  // Keeps the first `num_steps` time steps only, if fewer than stored.
+  void Truncate(size_t num_steps);
+
+  // Copies the first `num_steps` stored time steps into the contiguous
+  // `caches`.
+  absl::Status CopyTo(absl::Span<const std::shared_ptr<Tensor>> caches,
+                      size_t num_steps) const;
+
+ private:
+  std::shared_ptr<KVCacheBlockPool> pool_;
+  std::vector<int> block_table_;
+  size_t num_steps_ = 0;
+};
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+#endif  // MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_PAGED_KV_CACHE_H_
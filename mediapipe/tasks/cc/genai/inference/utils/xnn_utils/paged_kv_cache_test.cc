@@ -0,0 +1,215 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/paged_kv_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <numeric>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/kv_cache_test_utils.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+constexpr size_t kMaxSeqLen = 10;
+
+// Returns KV caches of shape [kMaxSeqLen, 2], filled with 0, 1, 2, ...
+// offset by 100 for the second cache.
+std::vector<std::shared_ptr<Tensor>> MakeCaches() {
+  std::vector<std::vector<float>> values(2,
+                                         std::vector<float>(kMaxSeqLen * 2));
+  for (int i = 0; i < 2; ++i) {
+    std::iota(values[i].begin(), values[i].end(), 100 * i);
+  }
+  return MakeKVCaches(kMaxSeqLen, /*step_size=*/2, values);
+}
+
+// Returns KV caches of the shape of MakeCaches(), filled with -1.
+std::vector<std::shared_ptr<Tensor>> MakeEmptyCaches() {
+  return MakeKVCaches(kMaxSeqLen, /*step_size=*/2, {{}, {}});
+}
+
+TEST(PagedKVCacheTest, AllocatesBlocksAsSequenceGrows) {
+  const auto caches = MakeCaches();
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/0,
+                                                   caches));
+  PagedKVCache paged_kv_cache(pool);
+  MP_ASSERT_OK(paged_kv_cache.Append(caches, 3));
+  EXPECT_EQ(pool->num_used_blocks(), 1);
+  MP_ASSERT_OK(paged_kv_cache.Append(caches, 9));
+  EXPECT_EQ(paged_kv_cache.num_steps(), 9);
+  EXPECT_EQ(pool->num_used_blocks(), 3);
+
+  auto copies = MakeEmptyCaches();
+  MP_ASSERT_OK(paged_kv_cache.CopyTo(copies, 5));
+  EXPECT_THAT(GetValues(*copies[0]),
+              ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+                          -1, -1, -1, -1));
+  EXPECT_THAT(GetValues(*copies[1]),
+              ElementsAre(100, 101, 102, 103, 104, 105, 106, 107, 108, 109, -1,
+                          -1, -1, -1, -1, -1, -1, -1, -1, -1));
+}
+
+TEST(PagedKVCacheTest, ReusesReleasedBlocks) {
+  const auto caches = MakeCaches();
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/3,
+                                                   caches));
+  {
+    PagedKVCache paged_kv_cache(pool);
+    MP_ASSERT_OK(paged_kv_cache.Append(caches, 10));
+    paged_kv_cache.Truncate(4);
+    EXPECT_EQ(pool->num_used_blocks(), 1);
+    PagedKVCache other(pool);
+    MP_EXPECT_OK(other.Append(caches, 8));
+    EXPECT_EQ(other.Append(caches, 9).code(),
+              absl::StatusCode::kResourceExhausted);
+  }
+  EXPECT_EQ(pool->num_used_blocks(), 0);
+  EXPECT_EQ(pool->num_allocated_blocks(), 3);
+}
+
+TEST(PagedKVCacheTest, OverwritesTruncatedSteps) {
+  auto caches = MakeCaches();
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/0,
+                                                   caches));
+  PagedKVCache paged_kv_cache(pool);
+  MP_ASSERT_OK(paged_kv_cache.Append(caches, 6));
+  paged_kv_cache.Truncate(2);
+  MP_ASSERT_OK(caches[0]->LoadFromVec(std::vector<float>(kMaxSeqLen * 2, 7)));
+  MP_ASSERT_OK(paged_kv_cache.Append(caches, 3));
+  EXPECT_EQ(paged_kv_cache.num_steps(), 3);
+  EXPECT_EQ(pool->num_used_blocks(), 1);
+
+  auto copies = MakeEmptyCaches();
+  MP_ASSERT_OK(paged_kv_cache.CopyTo(copies, 3));
+  const std::vector<float> values = GetValues(*copies[0]);
+  EXPECT_THAT(std::vector<float>(values.begin(), values.begin() + 8),
+              ElementsAre(0, 1, 2, 3, 7, 7, -1, -1));
+}
+
+TEST(PagedKVCacheTest, AllocatesWhileOtherContextsReadAndWrite) {
+  const auto caches = MakeCaches();
+  MP_ASSERT_OK_AND_ASSIGN(auto pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/0,
+                                                   caches));
+  PagedKVCache paged_kv_cache(pool);
+  MP_ASSERT_OK(paged_kv_cache.Append(caches, kMaxSeqLen));
+  constexpr int kNumIterations = 200;
+  // Keeps growing the pool, while the main thread uses blocks allocated
+  // before.
+  std::thread other_thread([&pool, &caches] {
+    std::vector<std::unique_ptr<PagedKVCache>> others;
+    for (int i = 0; i < kNumIterations; ++i) {
+      others.push_back(std::make_unique<PagedKVCache>(pool));
+      MP_EXPECT_OK(others.back()->Append(caches, kMaxSeqLen));
+    }
+  });
+  for (int i = 0; i < kNumIterations; ++i) {
+    paged_kv_cache.Truncate(i % kMaxSeqLen);
+    MP_EXPECT_OK(paged_kv_cache.Append(caches, kMaxSeqLen));
+    auto copies = MakeEmptyCaches();
+    MP_EXPECT_OK(paged_kv_cache.CopyTo(copies, kMaxSeqLen));
+    for (size_t j = 0; j < caches.size(); ++j) {
+      EXPECT_EQ(GetValues(*copies[j]), GetValues(*caches[j]));
+    }
+  }
+  other_thread.join();
+  EXPECT_EQ(pool->num_used_blocks(), 3);
+  EXPECT_GE(pool->num_allocated_blocks(), kNumIterations * 3);
+}
+
+// Stores all time steps of MakeCaches() in a pool quantized to
+// `quantization_bits` with one scale per time step, and expects them to be
+// read back within `max_error`.
+void ExpectQuantizedRoundTrip(int quantization_bits, float max_error) {
+  const auto caches = MakeCaches();
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto pool, KVCacheBlockPool::Create(/*block_size=*/4,
+                                          /*max_num_blocks=*/0, caches,
+                                          quantization_bits,
+                                          /*group_size=*/2));
+  PagedKVCache paged_kv_cache(pool);
+  MP_ASSERT_OK(paged_kv_cache.Append(caches, kMaxSeqLen));
+
+  auto copies = MakeEmptyCaches();
+  MP_ASSERT_OK(paged_kv_cache.CopyTo(copies, kMaxSeqLen));
+  for (size_t i = 0; i < caches.size(); ++i) {
+    EXPECT_THAT(GetValues(*copies[i]),
+                Pointwise(FloatNear(max_error), GetValues(*caches[i])));
+  }
+}
+
+TEST(PagedKVCacheTest, QuantizesBlocksToInt8) {
+  // The scale of a time step is its largest magnitude over 127, at most
+  // 119 / 127, and the rounding error at most half of it.
+  ExpectQuantizedRoundTrip(/*quantization_bits=*/8, /*max_error=*/0.47f);
+}
+
+TEST(PagedKVCacheTest, QuantizesBlocksToInt4) {
+  // Likewise, with scales of at most 119 / 7.
+  ExpectQuantizedRoundTrip(/*quantization_bits=*/4, /*max_error=*/8.5f);
+}
+
+TEST(PagedKVCacheTest, QuantizedBlocksTakeLessMemory) {
+  const auto caches = MakeCaches();
+  // 2 caches of 4 time steps of 2 values, with a float scale per time step if
+  // quantized.
+  MP_ASSERT_OK_AND_ASSIGN(auto float_pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/0,
+                                                   caches));
+  EXPECT_EQ(float_pool->block_bytes(), 2 * (4 * 2 * 4));
+  MP_ASSERT_OK_AND_ASSIGN(auto int8_pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/0,
+                                                   caches,
+                                                   /*quantization_bits=*/8,
+                                                   /*group_size=*/2));
+  EXPECT_EQ(int8_pool->block_bytes(), 2 * (4 * 2 + 4 * 4));
+  MP_ASSERT_OK_AND_ASSIGN(auto int4_pool,
+                          KVCacheBlockPool::Create(/*block_size=*/4,
+                                                   /*max_num_blocks=*/0,
+                                                   caches,
+                                                   /*quantization_bits=*/4,
+                                                   /*group_size=*/2));
+  EXPECT_EQ(int4_pool->block_bytes(), 2 * (4 * 2 / 2 + 4 * 4));
+
+  EXPECT_FALSE(KVCacheBlockPool::Create(/*block_size=*/4,
+                                        /*max_num_blocks=*/0, caches,
+                                        /*quantization_bits=*/8,
+                                        /*group_size=*/3)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
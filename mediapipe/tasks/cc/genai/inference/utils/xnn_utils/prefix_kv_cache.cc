@@ -0,0 +1,170 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/prefix_kv_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+// Returns copies of time steps [start, end) of `caches`.
+absl::StatusOr<std::vector<std::shared_ptr<Tensor>>> CopySteps(
+    absl::Span<const std::shared_ptr<Tensor>> caches, size_t start,
+    size_t end) {
+  std::vector<std::shared_ptr<Tensor>> copies;
+  copies.reserve(caches.size());
+  for (const auto& cache : caches) {
+    RET_CHECK_LE(end, cache->dims[0]);
+    Tensor::DimsType dims = cache->dims;
+    dims[0] = end - start;
+    auto copy = std::make_shared<Tensor>(std::move(dims), cache->datatype);
+    MP_RETURN_IF_ERROR(
+        copy->LoadFromBuffer(cache->Slice(0, start, end)->Data()));
+    copies.push_back(std::move(copy));
+  }
+  return copies;
+}
+
+// Returns the length of the common prefix of `a` and `b`.
+size_t CommonPrefixLength(absl::Span<const int> a, absl::Span<const int> b) {
+  return std::mismatch(a.begin(), a.begin() + std::min(a.size(), b.size()),
+                       b.begin())
+             .first -
+         a.begin();
+}
+
+}  // namespace
+
+PrefixKVCache::PrefixKVCache(size_t max_num_steps)
+    : max_num_steps_(max_num_steps) {}
+
+PrefixKVCache::~PrefixKVCache() = default;
+
+absl::StatusOr<size_t> PrefixKVCache::Lookup(
+    absl::Span<const int> token_ids,
+    absl::Span<const std::shared_ptr<Tensor>> caches) {
+  const Node* node = &root_;
+  size_t num_matched = 0;
+  while (num_matched < token_ids.size()) {
+    auto it = node->children.find(token_ids[num_matched]);
+    if (it == node->children.end()) break;
+    Node* child = it->second.get();
+    const size_t length =
+        CommonPrefixLength(child->tokens, token_ids.subspan(num_matched));
+    RET_CHECK_EQ(caches.size(), child->caches.size());
+    for (size_t i = 0; i < caches.size(); ++i) {
+      MP_RETURN_IF_ERROR(
+          caches[i]
+              ->Slice(0, num_matched, num_matched + length)
+              ->LoadFromBuffer(child->caches[i]->Data()));
+    }
+    child->last_used = ++clock_;
+    num_matched += length;
+    if (length < child->tokens.size()) break;
+    node = child;
+  }
+  return num_matched;
+}
+
+absl::Status PrefixKVCache::Insert(
+    absl::Span<const int> token_ids,
+    absl::Span<const std::shared_ptr<Tensor>> caches) {
+  Node* node = &root_;
+  size_t num_matched = 0;
+  while (num_matched < token_ids.size()) {
+    auto it = node->children.find(token_ids[num_matched]);
+    if (it == node->children.end()) {
+      auto child = std::make_unique<Node>();
+      child->parent = node;
+      child->tokens.assign(token_ids.begin() + num_matched, token_ids.end());
+      MP_ASSIGN_OR_RETURN(child->caches,
+                          CopySteps(caches, num_matched, token_ids.size()));
+      child->last_used = ++clock_;
+      num_steps_ += child->tokens.size();
+      node->children[token_ids[num_matched]] = std::move(child);
+      break;
+    }
+    Node* child = it->second.get();
+    const size_t length =
+        CommonPrefixLength(child->tokens, token_ids.subspan(num_matched));
+    if (length < child->tokens.size()) {
+      MP_ASSIGN_OR_RETURN(child, Split(child, length));
+    }
+    child->last_used = ++clock_;
+    num_matched += length;
+    node = child;
+  }
+  Evict();
+  return absl::OkStatus();
+}
+
+absl::StatusOr<PrefixKVCache::Node*> PrefixKVCache::Split(Node* node,
+                                                          size_t length) {
+  // Copies the time steps first, so that the tree is unchanged on failure.
+  MP_ASSIGN_OR_RETURN(std::vector<std::shared_ptr<Tensor>> upper_caches,
+                      CopySteps(node->caches, 0, length));
+  MP_ASSIGN_OR_RETURN(std::vector<std::shared_ptr<Tensor>> lower_caches,
+                      CopySteps(node->caches, length, node->tokens.size()));
+
+  Node* parent = node->parent;
+  std::unique_ptr<Node> lower = std::move(parent->children[node->tokens[0]]);
+  auto upper = std::make_unique<Node>();
+  upper->parent = parent;
+  upper->tokens.assign(lower->tokens.begin(), lower->tokens.begin() + length);
+  upper->last_used = lower->last_used;
+  upper->caches = std::move(upper_caches);
+  lower->caches = std::move(lower_caches);
+  lower->tokens.erase(lower->tokens.begin(), lower->tokens.begin() + length);
+  lower->parent = upper.get();
+  upper->children[lower->tokens[0]] = std::move(lower);
+
+  Node* result = upper.get();
+  parent->children[result->tokens[0]] = std::move(upper);
+  return result;
+}
+
+void PrefixKVCache::Evict() {
+  while (num_steps_ > max_num_steps_) {
+    Node* lru_leaf = nullptr;
+    std::vector<Node*> stack = {&root_};
+    while (!stack.empty()) {
+      Node* node = stack.back();
+      stack.pop_back();
+      if (node != &root_ && node->children.empty() &&
+          (!lru_leaf || node->last_used < lru_leaf->last_used)) {
+        lru_leaf = node;
+      }
+      for (auto& [token, child] : node->children) {
+        stack.push_back(child.get());
+      }
+    }
+    if (!lru_leaf) return;
+    num_steps_ -= lru_leaf->tokens.size();
+    lru_leaf->parent->children.erase(lru_leaf->tokens[0]);
+  }
+}
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
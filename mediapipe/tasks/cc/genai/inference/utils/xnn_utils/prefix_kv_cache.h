@@ -0,0 +1,87 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_PREFIX_KV_CACHE_H_
+#define MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_PREFIX_KV_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+// Caches the KV cache of token sequences, e.g. prompts sharing a system
+// prompt, in a radix tree keyed by token ids. Sequences sharing a prefix share
+// the nodes, and thus the memory, of that prefix. A lookup returns the longest
+// cached prefix of a sequence, whose time steps then don't need to be
+// computed again. The least recently used sequences are evicted to keep at
+// most `max_num_steps` time steps cached. Not thread-safe.
+class PrefixKVCache {
+ public:
+  explicit PrefixKVCache(size_t max_num_steps);
+  ~PrefixKVCache();
+
+  PrefixKVCache(const PrefixKVCache&) = delete;
+  PrefixKVCache& operator=(const PrefixKVCache&) = delete;
+
+  // Returns the length of the longest cached prefix of `token_ids`, and copies
+  // its time steps into the contiguous KV cache tensors `caches`, of shape
+  // [T, ...].
+  absl::StatusOr<size_t> Lookup(
+      absl::Span<const int> token_ids,
+      absl::Span<const std::shared_ptr<Tensor>> caches);
+
+  // Caches the first `token_ids.size()` time steps of `caches`, which hold the
+  // KV cache of `token_ids`.
+  absl::Status Insert(absl::Span<const int> token_ids,
+                      absl::Span<const std::shared_ptr<Tensor>> caches);
+
+  // The number of time steps cached.
+  size_t num_steps() const { return num_steps_; }
+
+ private:
+  struct Node {
+    Node* parent = nullptr;
+    // The token ids on the edge from the parent, and their time steps of each
+    // KV cache tensor.
+    std::vector<int> tokens;
+    std::vector<std::shared_ptr<Tensor>> caches;
+    absl::flat_hash_map<int, std::unique_ptr<Node>> children;
+    uint64_t last_used = 0;
+  };
+
+  // Splits the edge to `node` after `length` tokens, and returns the new node
+  // ending there.
+  absl::StatusOr<Node*> Split(Node* node, size_t length);
+
+  // Evicts the least recently used leaves until at most `max_num_steps_` time
+  // steps are cached.
+  void Evict();
+
+  const size_t max_num_steps_;
+  Node root_;
+  size_t num_steps_ = 0;
+  uint64_t clock_ = 0;
+};
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+#endif  // MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_PREFIX_KV_CACHE_H_
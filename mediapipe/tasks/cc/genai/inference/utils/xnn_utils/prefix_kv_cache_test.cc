@@ -0,0 +1,89 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/prefix_kv_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/kv_cache_test_utils.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr size_t kMaxSeqLen = 8;
+
+// Returns a KV cache of shape [kMaxSeqLen, 1] whose time steps hold `values`,
+// followed by -1.
+std::vector<std::shared_ptr<Tensor>> MakeCaches(std::vector<float> values) {
+  return MakeKVCaches(kMaxSeqLen, /*step_size=*/1, {std::move(values)});
+}
+
+TEST(PrefixKVCacheTest, LooksUpLongestCachedPrefix) {
+  PrefixKVCache prefix_kv_cache(/*max_num_steps=*/100);
+  MP_ASSERT_OK(
+      prefix_kv_cache.Insert({1, 2, 3, 4}, MakeCaches({10, 20, 30, 40})));
+  // Splits the cached sequence after the shared prefix {1, 2}.
+  MP_ASSERT_OK(prefix_kv_cache.Insert({1, 2, 5}, MakeCaches({10, 20, 50})));
+  EXPECT_EQ(prefix_kv_cache.num_steps(), 5);
+
+  auto caches = MakeCaches({});
+  MP_ASSERT_OK_AND_ASSIGN(size_t num_matched,
+                          prefix_kv_cache.Lookup({1, 2, 3, 6}, caches));
+  EXPECT_EQ(num_matched, 3);
+  EXPECT_THAT(GetValues(*caches[0]),
+              ElementsAre(10, 20, 30, -1, -1, -1, -1, -1));
+
+  caches = MakeCaches({});
+  MP_ASSERT_OK_AND_ASSIGN(num_matched,
+                          prefix_kv_cache.Lookup({1, 2, 5, 6}, caches));
+  EXPECT_EQ(num_matched, 3);
+  EXPECT_THAT(GetValues(*caches[0]),
+              ElementsAre(10, 20, 50, -1, -1, -1, -1, -1));
+
+  MP_ASSERT_OK_AND_ASSIGN(num_matched, prefix_kv_cache.Lookup({7}, caches));
+  EXPECT_EQ(num_matched, 0);
+}
+
+TEST(PrefixKVCacheTest, EvictsLeastRecentlyUsedSequences) {
+  PrefixKVCache prefix_kv_cache(/*max_num_steps=*/5);
+  MP_ASSERT_OK(prefix_kv_cache.Insert({1, 2, 3}, MakeCaches({10, 20, 30})));
+  MP_ASSERT_OK(prefix_kv_cache.Insert({1, 2, 4}, MakeCaches({10, 20, 40})));
+  auto caches = MakeCaches({});
+  MP_ASSERT_OK(prefix_kv_cache.Lookup({1, 2, 3}, caches).status());
+  // Each insertion exceeds the budget, evicting {1, 2, 4}, which was used
+  // less recently than {1, 2, 3}, and then {5, 6}.
+  MP_ASSERT_OK(prefix_kv_cache.Insert({5, 6}, MakeCaches({50, 60})));
+  EXPECT_EQ(prefix_kv_cache.num_steps(), 5);
+  MP_ASSERT_OK(
+      prefix_kv_cache.Insert({1, 2, 3, 7}, MakeCaches({10, 20, 30, 70})));
+  EXPECT_EQ(prefix_kv_cache.num_steps(), 4);
+
+  MP_ASSERT_OK_AND_ASSIGN(size_t num_matched,
+                          prefix_kv_cache.Lookup({1, 2, 4}, caches));
+  EXPECT_EQ(num_matched, 2);
+  MP_ASSERT_OK_AND_ASSIGN(num_matched, prefix_kv_cache.Lookup({5, 6}, caches));
+  EXPECT_EQ(num_matched, 0);
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -22,19 +22,72 @@
 #include <utility>
 #include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
 
 namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+// Returns the index of the first largest of `logits`.
+int Argmax(const float* logits, size_t size) {
+  // Independent maxima per lane let the compiler vectorize the reduction.
+  constexpr size_t kNumLanes = 8;
+  float lane_max[kNumLanes];
+  std::fill(lane_max, lane_max + kNumLanes, logits[0]);
+  size_t i = 0;
+  for (; i + kNumLanes <= size; i += kNumLanes) {
+    for (size_t lane = 0; lane < kNumLanes; ++lane) {
+      lane_max[lane] = std::max(lane_max[lane], logits[i + lane]);
+    }
+  }
+  float max_logit = *std::max_element(lane_max, lane_max + kNumLanes);
+  for (; i < size; ++i) {
+    max_logit = std::max(max_logit, logits[i]);
+  }
+  return std::find(logits, logits + size, max_logit) - logits;
+}
+
+// Whether `a` ranks before `b`: a larger logit, or the smaller id on a tie.
+bool RanksBefore(const std::pair<float, int>& a,
+                 const std::pair<float, int>& b) {
+  return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+// Sets `top` to the `k` largest of `logits` and their ids, in descending
+// order. Only the candidates are kept, in a heap whose top is the smallest of
+// them, so most logits are rejected by one comparison with it.
+void SelectTopK(const float* logits, size_t size, int k,
+                std::vector<std::pair<float, int>>& top) {
+  top.clear();
+  for (int id = 0; id < k; ++id) {
+    top.emplace_back(logits[id], id);
+  }
+  std::make_heap(top.begin(), top.end(), RanksBefore);
+  float threshold = top.front().first;
+  for (size_t id = k; id < size; ++id) {
+    if (logits[id] <= threshold) continue;
+    std::pop_heap(top.begin(), top.end(), RanksBefore);
+    top.back() = {logits[id], static_cast<int>(id)};
+    std::push_heap(top.begin(), top.end(), RanksBefore);
+    threshold = top.front().first;
+  }
+  std::sort_heap(top.begin(), top.end(), RanksBefore);
+}
+
+}  // namespace
 
 absl::StatusOr<std::unique_ptr<Sampler>> Sampler::Create(Type type, int top_k,
                                                          float top_p,
                                                          float temperature,
-                                                         int seed) {
+                                                         int seed,
+                                                         int num_threads) {
   if (type == Type::kTopK || type == Type::kTopP) {
     RET_CHECK_GT(top_k, 1).SetCode(absl::StatusCode::kInvalidArgument)
         << "top_k must be > 1";
@@ -49,7 +102,8 @@ absl::StatusOr<std::unique_ptr<Sampler>> Sampler::Create(Type type, int top_k,
     RET_CHECK_LE(top_p, 1.0).SetCode(absl::StatusCode::kInvalidArgument)
         << "top_p must be between 0 and 1";
   }
-  return absl::WrapUnique(new Sampler(type, top_k, top_p, temperature, seed));
+  return absl::WrapUnique(
+      new Sampler(type, top_k, top_p, temperature, seed, num_threads));
 }
 
 absl::StatusOr<std::vector<std::vector<int>>> Sampler::Sample(
@@ -63,136 +117,109 @@ absl::StatusOr<std::vector<std::vector<int>>> Sampler::Sample(
     case Type::kGreedy:
       return SampleGreedy(logits);
     case Type::kTopK:
-      return SampleTopK(logits);
+      return SampleTopKTopP(logits, top_k_, /*top_p=*/false);
     case Type::kTopP:
-      return SampleTopP(logits);
+      return SampleTopKTopP(
+          logits, top_k_ > 0 ? top_k_ : static_cast<int>(logits.dims[2]),
+          /*top_p=*/true);
     default:
       return absl::InvalidArgumentError("Unsupported sampler type");
   }
 };
 
-Sampler::Sampler(Type type, int top_k, float top_p, float temperature, int seed)
+Sampler::Sampler(Type type, int top_k, float top_p, float temperature, int seed,
+                 int num_threads)
     : type_(type),
       top_k_(top_k),
       top_p_(top_p),
       temperature_(temperature),
-      generator_(std::make_unique<std::mt19937>(seed)) {}
-
-absl::StatusOr<std::vector<std::vector<int>>> Sampler::SampleGreedy(
-    const Tensor& logits) {
-  size_t batch_size = logits.dims[0];
-  size_t draft_size = logits.dims[1];
-  size_t vocab_size = logits.dims[2];
+      generator_(std::make_unique<std::mt19937>(seed)),
+      num_threads_(num_threads) {}
 
-  const float* float_logits = logits.DataAs<float>();
-  std::vector<std::vector<int>> outputs;
-  outputs.reserve(batch_size);
-  // select the token with the highest logit directly.
-  for (int batch = 0; batch < batch_size; ++batch) {
-    outputs.push_back(std::vector<int>());
-    outputs[batch].reserve(draft_size);
-    for (int draft = 0; draft < draft_size; ++draft) {
-      // the index of the first logit for a single token
-      int token_index =
-          (batch * draft_size * vocab_size) + (draft * vocab_size);
-      float max_logit = float_logits[token_index];
-      int max_id = 0;
-      for (int v = 0; v < vocab_size; ++v) {
-        float prob = float_logits[token_index + v];
-        if (prob > max_logit) {
-          max_logit = prob;
-          max_id = v;
-        }
-      }
-      outputs[batch].push_back(max_id);
+void Sampler::ForEachRow(size_t num_rows,
+                         absl::FunctionRef<void(size_t row)> fn) {
+  if (num_threads_ <= 1 || num_rows <= 1) {
+    for (size_t row = 0; row < num_rows; ++row) {
+      fn(row);
     }
+    return;
   }
-  return outputs;
-};
+  if (!pool_) {
+    pool_ = std::make_unique<ThreadPool>("sampler", num_threads_);
+    pool_->StartWorkers();
+  }
+  absl::BlockingCounter pending_rows(num_rows);
+  for (size_t row = 0; row < num_rows; ++row) {
+    pool_->Schedule([&fn, &pending_rows, row] {
+      fn(row);
+      pending_rows.DecrementCount();
+    });
+  }
+  pending_rows.Wait();
+}
 
-absl::StatusOr<std::vector<std::vector<int>>> Sampler::SampleTopK(
+absl::StatusOr<std::vector<std::vector<int>>> Sampler::SampleGreedy(
     const Tensor& logits) {
   const size_t batch_size = logits.dims[0];
   const size_t draft_size = logits.dims[1];
   const size_t vocab_size = logits.dims[2];
   const float* flat_data = logits.DataAs<float>();
 
-  std::vector<std::vector<int>> outputs;
-  outputs.reserve(batch_size);
-  for (int batch = 0; batch < batch_size; ++batch) {
-    outputs.push_back(std::vector<int>());
-    outputs[batch].reserve(draft_size);
-    for (int draft = 0; draft < draft_size; ++draft) {
-      // the index of the first logit for a single token
-      int token_index =
-          (batch * draft_size * vocab_size) + (draft * vocab_size);
-      std::vector<std::pair<float, int>> logits_ids;
-      logits_ids.reserve(vocab_size);
-      for (int v = 0; v < vocab_size; ++v) {
-        float logit = flat_data[token_index + v];
-        logits_ids.push_back(std::make_pair(logit, v));
-      }
-      MP_RETURN_IF_ERROR(SelectTopK(logits_ids, top_k_));
-      // No need to normalize logits here, sampler takes care of that.
-      MP_RETURN_IF_ERROR(ScaledSoftmax(logits_ids, /*normalize=*/false));
-      MP_ASSIGN_OR_RETURN(int sample_idx, DoSampling(logits_ids));
-      outputs[batch].push_back(sample_idx);
-    }
-  }
+  std::vector<std::vector<int>> outputs(batch_size,
+                                        std::vector<int>(draft_size));
+  // select the token with the highest logit directly.
+  ForEachRow(batch_size * draft_size, [&](size_t row) {
+    outputs[row / draft_size][row % draft_size] =
+        Argmax(flat_data + row * vocab_size, vocab_size);
+  });
   return outputs;
-}
+};
 
-absl::StatusOr<std::vector<std::vector<int>>> Sampler::SampleTopP(
-    const Tensor& logits) {
+absl::StatusOr<std::vector<std::vector<int>>> Sampler::SampleTopKTopP(
+    const Tensor& logits, int k, bool top_p) {
   const size_t batch_size = logits.dims[0];
   const size_t draft_size = logits.dims[1];
   const size_t vocab_size = logits.dims[2];
-  const int k = top_k_ > 0 ? top_k_ : vocab_size;
   const float* flat_data = logits.DataAs<float>();
+  RET_CHECK_GT(k, 0);
+  if (k > vocab_size) {
+    return absl::InvalidArgumentError(
+        "Top k value must be smaller than the number of logits.");
+  }
 
-  std::vector<std::vector<int>> outputs;
-  outputs.reserve(batch_size);
-  for (int batch = 0; batch < batch_size; ++batch) {
-    outputs.push_back(std::vector<int>());
-    outputs[batch].reserve(draft_size);
-    for (int draft = 0; draft < draft_size; ++draft) {
-      // the index of the first logit for a single token
-      int token_index =
-          (batch * draft_size * vocab_size) + (draft * vocab_size);
-      std::vector<std::pair<float, int>> logits_ids;
-      logits_ids.reserve(vocab_size);
-      for (int v = 0; v < vocab_size; ++v) {
-        float logit = flat_data[token_index + v];
-        logits_ids.push_back(std::make_pair(logit, v));
-      }
-      MP_RETURN_IF_ERROR(SelectTopK(logits_ids, k));
-      MP_RETURN_IF_ERROR(ScaledSoftmax(logits_ids, /*normalize=*/true));
-      MP_RETURN_IF_ERROR(SelectTopP(logits_ids, top_p_));
-      MP_ASSIGN_OR_RETURN(int sample_idx, DoSampling(logits_ids));
-      outputs[batch].push_back(sample_idx);
+  const size_t num_rows = batch_size * draft_size;
+  if (row_candidates_.size() < num_rows) {
+    row_candidates_.resize(num_rows);
+  }
+  auto process_row = [&](size_t row) -> absl::Status {
+    std::vector<std::pair<float, int>>& candidates = row_candidates_[row];
+    SelectTopK(flat_data + row * vocab_size, vocab_size, k, candidates);
+    if (!top_p) {
+      // No need to normalize logits here, sampler takes care of that.
+      return ScaledSoftmax(candidates, /*normalize=*/false);
     }
+    MP_RETURN_IF_ERROR(ScaledSoftmax(candidates, /*normalize=*/true));
+    return SelectTopP(candidates, top_p_);
+  };
+  std::vector<absl::Status> statuses(num_rows);
+  ForEachRow(num_rows,
+             [&](size_t row) { statuses[row] = process_row(row); });
+  for (const absl::Status& status : statuses) {
+    MP_RETURN_IF_ERROR(status);
   }
-  return outputs;
-}
 
-absl::Status Sampler::SelectTopK(std::vector<std::pair<float, int>>& logits_ids,
-                                 int k) {
-  if (k > logits_ids.size()) {
-    return absl::InvalidArgumentError(
-        "Top k value must be smaller than the number of logits.");
+  // The samples are drawn in order, so that each row gets the same random
+  // numbers regardless of the threads.
+  std::vector<std::vector<int>> outputs(batch_size);
+  for (size_t row = 0; row < num_rows; ++row) {
+    MP_ASSIGN_OR_RETURN(int sample_idx, DoSampling(row_candidates_[row]));
+    outputs[row / draft_size].push_back(sample_idx);
   }
-  std::partial_sort(
-      logits_ids.begin(), logits_ids.begin() + k, logits_ids.end(),
-      [](const std::pair<float, int>& a, const std::pair<float, int>& b) {
-        // reverse order.
-        return a.first > b.first;
-      });
-  logits_ids.resize(k);
-  return absl::OkStatus();
+  return outputs;
 }
 
 absl::Status Sampler::SelectTopP(std::vector<std::pair<float, int>>& logits_ids,
-                                 float p) {
+                                 float p) const {
   int included = 0;
   float prob_sum = 0.0;
   for (const auto& [logit, _] : logits_ids) {
@@ -210,7 +237,7 @@ absl::Status Sampler::SelectTopP(std::vector<std::pair<float, int>>& logits_ids,
 }
 
 absl::Status Sampler::ScaledSoftmax(
-    std::vector<std::pair<float, int>>& logits_ids, bool normalize) {
+    std::vector<std::pair<float, int>>& logits_ids, bool normalize) const {
   float scale = 1 / (temperature_ ? temperature_ : 1.0);
   double sum = 0.0;
   float max_logit = logits_ids[0].first;
@@ -229,14 +256,13 @@ absl::Status Sampler::ScaledSoftmax(
 }
 
 absl::StatusOr<int> Sampler::DoSampling(
-    std::vector<std::pair<float, int>>& logits_ids) {
-  std::vector<float> probs;
-  probs.reserve(logits_ids.size());
+    const std::vector<std::pair<float, int>>& logits_ids) {
+  probs_.clear();
   for (const auto& [logit, _] : logits_ids) {
-    probs.push_back(logit);
+    probs_.push_back(logit);
   }
   // Probabilities are normalized by `discrete_distribution`.
-  std::discrete_distribution<> dist(probs.begin(), probs.end());
+  std::discrete_distribution<> dist(probs_.begin(), probs_.end());
   int sample_idx = dist(*generator_);
   return logits_ids[sample_idx].second;
 }
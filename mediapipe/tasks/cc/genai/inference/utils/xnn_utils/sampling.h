@@ -17,13 +17,16 @@
 
 #include <sys/stat.h>
 
+#include <cstddef>
 #include <memory>
 #include <random>
 #include <utility>
 #include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
 
 namespace mediapipe::tasks::genai::xnn_utils {
@@ -45,10 +48,15 @@ class Sampler {
   //   applying softmax. Finally, the top p are selected from the probabilities
   //   such that sum of p_i is greater than or equal to top_p. Lastly, a sample
   //   is drawn from the resulting distribution.
+  // If `num_threads` > 1, the rows of the logits, i.e. each batch and
+  // sequence position, are processed in parallel on that many threads. The
+  // samples are still drawn in order, so the results for a given seed don't
+  // depend on the number of threads.
   static absl::StatusOr<std::unique_ptr<Sampler>> Create(Type type, int top_k,
                                                          float top_p,
                                                          float temperature,
-                                                         int seed);
+                                                         int seed,
+                                                         int num_threads = 1);
   // Given an input tensor of shape `(Batch, seq_len, vocab_size)`, runs
   // the configured sampling algorithm to find a winning class. The results are
   // reported as a 2D vector of integer indices where the first axis corresponds
@@ -56,29 +64,39 @@ class Sampler {
   absl::StatusOr<std::vector<std::vector<int>>> Sample(const Tensor& logits);
 
  private:
-  Sampler(Type type, int top_k, float top_p, float temperature, int seed);
+  Sampler(Type type, int top_k, float top_p, float temperature, int seed,
+          int num_threads);
   absl::StatusOr<std::vector<std::vector<int>>> SampleGreedy(
       const Tensor& logits);
-  absl::StatusOr<std::vector<std::vector<int>>> SampleTopK(
-      const Tensor& logits);
-  absl::StatusOr<std::vector<std::vector<int>>> SampleTopP(
-      const Tensor& logits);
-  absl::Status SelectTopK(std::vector<std::pair<float, int>>& logits_ids,
-                          int k);
+  // Samples from the top `k` logits, and if `top_p` is set, from the fewest of
+  // them whose probabilities add up to `top_p`.
+  absl::StatusOr<std::vector<std::vector<int>>> SampleTopKTopP(
+      const Tensor& logits, int k, bool top_p);
   // `logits_ids` must be sorted and normalized.
   absl::Status SelectTopP(std::vector<std::pair<float, int>>& logits_ids,
-                          float p);
+                          float p) const;
   // `logits_ids` must be sorted.
   absl::Status ScaledSoftmax(std::vector<std::pair<float, int>>& logits_ids,
-                             bool normalize);
+                             bool normalize) const;
   absl::StatusOr<int> DoSampling(
-      std::vector<std::pair<float, int>>& logits_ids);
+      const std::vector<std::pair<float, int>>& logits_ids);
+  // Runs `fn` for each row in [0, num_rows), in parallel if `num_threads_` >
+  // 1.
+  void ForEachRow(size_t num_rows, absl::FunctionRef<void(size_t row)> fn);
 
   Type type_;
   int top_k_;
   float top_p_;
   float temperature_;
   std::unique_ptr<std::mt19937> generator_;
+  const int num_threads_;
+  // Created on the first Sample() of more than one row.
+  std::unique_ptr<ThreadPool> pool_;
+
+  // Scratch buffers reused across Sample() calls: the candidate logits and ids
+  // of each row, and their probabilities to draw from.
+  std::vector<std::vector<std::pair<float, int>>> row_candidates_;
+  std::vector<float> probs_;
 };
 
 }  // namespace mediapipe::tasks::genai::xnn_utils
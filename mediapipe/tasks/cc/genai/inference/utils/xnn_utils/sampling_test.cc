@@ -0,0 +1,127 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+using ::testing::AnyOf;
+using ::testing::Each;
+using ::testing::ElementsAre;
+
+constexpr size_t kVocabSize = 1000;
+
+// Returns logits of shape [batch_size, seq_len, kVocabSize] drawn uniformly
+// from [-1, 1], except for `high_logits` of each row.
+std::shared_ptr<Tensor> MakeLogits(
+    size_t batch_size, size_t seq_len,
+    const std::vector<std::pair<int, float>>& high_logits = {}) {
+  std::mt19937 rng(/*seed=*/0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> values(batch_size * seq_len * kVocabSize);
+  for (float& value : values) {
+    value = dist(rng);
+  }
+  for (size_t row = 0; row < batch_size * seq_len; ++row) {
+    for (const auto& [id, logit] : high_logits) {
+      values[row * kVocabSize + id] = logit;
+    }
+  }
+  auto logits = std::make_shared<Tensor>(
+      Tensor::DimsType{batch_size, seq_len, kVocabSize});
+  ABSL_CHECK_OK(logits->LoadFromVec(values));
+  return logits;
+}
+
+TEST(SamplerTest, GreedyReturnsArgmax) {
+  auto logits = MakeLogits(/*batch_size=*/2, /*seq_len=*/2, {{123, 5.0f}});
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto sampler,
+      Sampler::Create(Sampler::Type::kGreedy, /*top_k=*/0, /*top_p=*/0.0,
+                      /*temperature=*/0.0, /*seed=*/0));
+  MP_ASSERT_OK_AND_ASSIGN(auto ids, sampler->Sample(*logits));
+  EXPECT_THAT(ids, ElementsAre(ElementsAre(123, 123), ElementsAre(123, 123)));
+}
+
+TEST(SamplerTest, TopKSamplesFromTopLogits) {
+  auto logits = MakeLogits(/*batch_size=*/4, /*seq_len=*/1,
+                           {{7, 3.0f}, {42, 3.5f}, {99, 2.5f}});
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto sampler,
+      Sampler::Create(Sampler::Type::kTopK, /*top_k=*/3, /*top_p=*/0.0,
+                      /*temperature=*/1.0, /*seed=*/0));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(auto ids, sampler->Sample(*logits));
+    EXPECT_THAT(ids, Each(ElementsAre(AnyOf(7, 42, 99))));
+  }
+}
+
+TEST(SamplerTest, TopPSamplesFromNucleus) {
+  // Tokens 7 and 42 hold almost all of the probability mass.
+  auto logits =
+      MakeLogits(/*batch_size=*/4, /*seq_len=*/1, {{7, 20.0f}, {42, 20.0f}});
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto sampler,
+      Sampler::Create(Sampler::Type::kTopP, /*top_k=*/40, /*top_p=*/0.9,
+                      /*temperature=*/1.0, /*seed=*/0));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(auto ids, sampler->Sample(*logits));
+    EXPECT_THAT(ids, Each(ElementsAre(AnyOf(7, 42))));
+  }
+}
+
+TEST(SamplerTest, SamplesDoNotDependOnNumThreads) {
+  auto logits = MakeLogits(/*batch_size=*/8, /*seq_len=*/2);
+  for (Sampler::Type type : {Sampler::Type::kTopK, Sampler::Type::kTopP}) {
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto sampler,
+        Sampler::Create(type, /*top_k=*/40, /*top_p=*/0.9,
+                        /*temperature=*/1.0, /*seed=*/1));
+    MP_ASSERT_OK_AND_ASSIGN(
+        auto parallel_sampler,
+        Sampler::Create(type, /*top_k=*/40, /*top_p=*/0.9,
+                        /*temperature=*/1.0, /*seed=*/1, /*num_threads=*/4));
+    for (int i = 0; i < 3; ++i) {
+      MP_ASSERT_OK_AND_ASSIGN(auto ids, sampler->Sample(*logits));
+      MP_ASSERT_OK_AND_ASSIGN(auto parallel_ids,
+                              parallel_sampler->Sample(*logits));
+      EXPECT_EQ(ids, parallel_ids);
+    }
+  }
+}
+
+TEST(SamplerTest, FailsIfTopKExceedsVocabSize) {
+  auto logits = MakeLogits(/*batch_size=*/1, /*seq_len=*/1);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto sampler,
+      Sampler::Create(Sampler::Type::kTopK, /*top_k=*/kVocabSize + 1,
+                      /*top_p=*/0.0, /*temperature=*/1.0, /*seed=*/0));
+  EXPECT_FALSE(sampler->Sample(*logits).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -0,0 +1,122 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/speculative_decoder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+absl::StatusOr<std::unique_ptr<SpeculativeDecoder>> SpeculativeDecoder::Create(
+    Llm* target, std::unique_ptr<Llm> draft) {
+  RET_CHECK(target);
+  RET_CHECK(draft);
+  const LlmParams& target_params = target->GetLlmParams();
+  const LlmParams& draft_params = draft->GetLlmParams();
+  RET_CHECK_GT(target_params.draft_size_G, 0)
+      << "The target model must verify the draft tokens in one pass.";
+  RET_CHECK_EQ(draft_params.draft_size_G, 0);
+  RET_CHECK_EQ(target_params.batch_size_B, 1);
+  RET_CHECK_EQ(draft_params.batch_size_B, 1);
+  RET_CHECK_EQ(target_params.voc_size_V, draft_params.voc_size_V)
+      << "The target and draft models must share the vocabulary.";
+  MP_ASSIGN_OR_RETURN(
+      auto sampler,
+      Sampler::Create(Sampler::Type::kGreedy, /*top_k=*/0, /*top_p=*/0.0,
+                      /*temperature=*/0.0, /*seed=*/0));
+  return std::unique_ptr<SpeculativeDecoder>(
+      new SpeculativeDecoder(target, std::move(draft), std::move(sampler)));
+}
+
+SpeculativeDecoder::SpeculativeDecoder(Llm* target, std::unique_ptr<Llm> draft,
+                                       std::unique_ptr<Sampler> sampler)
+    : target_(target),
+      draft_(std::move(draft)),
+      num_draft_tokens_(target->GetLlmParams().draft_size_G),
+      sampler_(std::move(sampler)) {}
+
+absl::Status SpeculativeDecoder::Reset(std::vector<int> prompt_ids) {
+  RET_CHECK(!prompt_ids.empty());
+  ids_ = std::move(prompt_ids);
+  MP_RETURN_IF_ERROR(target_->SeekTimeStep(0));
+  return draft_->SeekTimeStep(0);
+}
+
+absl::StatusOr<std::vector<int>> SpeculativeDecoder::Draft() {
+  std::vector<int> draft_ids;
+  draft_ids.reserve(num_draft_tokens_);
+  std::vector<int> input_ids(ids_.begin() + draft_->TotalTokenSize(),
+                             ids_.end());
+  while (true) {
+    MP_RETURN_IF_ERROR(draft_->AddInputTokens({input_ids}));
+    MP_ASSIGN_OR_RETURN(auto logits, draft_->ComputeLogits());
+    MP_ASSIGN_OR_RETURN(auto sampled_ids, sampler_->Sample(*logits));
+    draft_ids.push_back(sampled_ids[0][0]);
+    // The last draft token is only needed by the target.
+    if (draft_ids.size() == num_draft_tokens_) return draft_ids;
+    input_ids = {draft_ids.back()};
+  }
+}
+
+absl::StatusOr<std::vector<int>> SpeculativeDecoder::Step() {
+  RET_CHECK_LT(target_->TotalTokenSize(), ids_.size());
+  MP_ASSIGN_OR_RETURN(std::vector<int> draft_ids, Draft());
+
+  // The tokens not fed to the target yet, at least one, followed by the draft
+  // tokens. The logits of the last `num_draft_tokens_` + 1 inputs predict the
+  // token after each of them.
+  std::vector<int> input_ids(ids_.begin() + target_->TotalTokenSize(),
+                             ids_.end());
+  input_ids.insert(input_ids.end(), draft_ids.begin(), draft_ids.end());
+  MP_RETURN_IF_ERROR(target_->AddInputTokens({input_ids}));
+  MP_ASSIGN_OR_RETURN(auto logits,
+                      target_->ComputeLogits(num_draft_tokens_ + 1));
+  MP_ASSIGN_OR_RETURN(auto sampled_ids, sampler_->Sample(*logits));
+  const std::vector<int>& target_ids = sampled_ids[0];
+  RET_CHECK_EQ(target_ids.size(), num_draft_tokens_ + 1);
+
+  size_t num_accepted = 0;
+  while (num_accepted < num_draft_tokens_ &&
+         draft_ids[num_accepted] == target_ids[num_accepted]) {
+    ++num_accepted;
+  }
+  std::vector<int> output_ids(draft_ids.begin(),
+                              draft_ids.begin() + num_accepted);
+  output_ids.push_back(target_ids[num_accepted]);
+  ids_.insert(ids_.end(), output_ids.begin(), output_ids.end());
+
+  // Both models keep the KV cache up to the last accepted draft token. The
+  // next token of the target is fed with the next step.
+  MP_RETURN_IF_ERROR(target_->SeekTimeStep(ids_.size() - 1));
+  MP_RETURN_IF_ERROR(draft_->SeekTimeStep(
+      std::min(draft_->TotalTokenSize(), ids_.size() - 1)));
+
+  ++stats_.num_steps;
+  stats_.num_drafted_tokens += num_draft_tokens_;
+  stats_.num_accepted_tokens += num_accepted;
+  return output_ids;
+}
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
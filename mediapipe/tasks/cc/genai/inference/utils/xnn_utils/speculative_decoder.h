@@ -0,0 +1,92 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_SPECULATIVE_DECODER_H_
+#define MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_SPECULATIVE_DECODER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/llm.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/sampling.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+
+// Decodes a sequence with a target Llm, using a smaller draft Llm of the same
+// vocabulary to speed it up. Each step, the draft proposes `draft_size_G`
+// tokens of the target one by one, and the target verifies them all in one
+// forward pass. The longest prefix matching the target's own greedy choices is
+// accepted, followed by the target's next token, so the output is the same as
+// greedy decoding with the target alone. The KV caches of both models are
+// rolled back past the rejected tokens.
+class SpeculativeDecoder {
+ public:
+  struct Stats {
+    size_t num_steps = 0;
+    size_t num_drafted_tokens = 0;
+    size_t num_accepted_tokens = 0;
+
+    // The fraction of drafted tokens accepted by the target.
+    double acceptance_rate() const {
+      return num_drafted_tokens == 0
+                 ? 0.0
+                 : static_cast<double>(num_accepted_tokens) /
+                       num_drafted_tokens;
+    }
+  };
+
+  // `target` must be created with a positive `draft_size_G` and outlive the
+  // decoder. `draft` must be created with `draft_size_G` of 0. Both must have
+  // a batch size of 1.
+  static absl::StatusOr<std::unique_ptr<SpeculativeDecoder>> Create(
+      Llm* target, std::unique_ptr<Llm> draft);
+
+  // Starts a new sequence from `prompt_ids`. The prompt is prefilled by the
+  // next Step().
+  absl::Status Reset(std::vector<int> prompt_ids);
+
+  // Decodes the next tokens of the sequence: the accepted draft tokens
+  // followed by the next token of the target, i.e. 1 to `draft_size_G` + 1
+  // tokens.
+  absl::StatusOr<std::vector<int>> Step();
+
+  // The number of tokens of the sequence, including the prompt.
+  size_t TotalTokenSize() const { return ids_.size(); }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  SpeculativeDecoder(Llm* target, std::unique_ptr<Llm> draft,
+                     std::unique_ptr<Sampler> sampler);
+
+  // Returns `draft_size_G` tokens proposed by the draft after `ids_`.
+  absl::StatusOr<std::vector<int>> Draft();
+
+  Llm* const target_;
+  const std::unique_ptr<Llm> draft_;
+  const size_t num_draft_tokens_;
+  const std::unique_ptr<Sampler> sampler_;
+
+  // The prompt and the decoded tokens. The last tokens, at least one, are not
+  // fed to the target yet.
+  std::vector<int> ids_;
+  Stats stats_;
+};
+
+}  // namespace mediapipe::tasks::genai::xnn_utils
+
+#endif  // MEDIAPIPE_TASKS_GENAI_INFERENCE_UTILS_XNN_UTILS_SPECULATIVE_DECODER_H_
@@ -15,9 +15,11 @@
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/tflite_weight_accessor.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -30,6 +32,7 @@
 #include "flatbuffers/vector.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/llm_utils/memory_mapped_file.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
 #include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "xnnpack.h"  // from @XNNPACK
@@ -133,6 +136,11 @@ absl::StatusOr<std::shared_ptr<Tensor>> TfLiteWeightAccessor::LoadWeight(
         absl::StrCat("Scale tensor not found: ", scale_tensor_name));
   }
   std::shared_ptr<Tensor> scale_tensor = weights_.at(scale_tensor_name);
+  if (qtensor->datatype == xnn_datatype_qcint4 &&
+      scale_tensor->num_elements != expected_dims[dim_scale_if_any]) {
+    return LoadBlockwiseWeight(tensor_name, *qtensor, std::move(expected_dims),
+                               dim_scale_if_any, *scale_tensor);
+  }
   RET_CHECK_EQ(expected_dims[dim_scale_if_any], scale_tensor->num_elements);
   switch (qtensor->datatype) {
     case xnn_datatype_qcint8:
@@ -158,6 +166,41 @@ absl::StatusOr<std::shared_ptr<Tensor>> TfLiteWeightAccessor::LoadWeight(
   return result;
 }
 
+absl::StatusOr<std::shared_ptr<Tensor>>
+TfLiteWeightAccessor::LoadBlockwiseWeight(absl::string_view tensor_name,
+                                          const Tensor& qtensor,
+                                          Tensor::DimsType expected_dims,
+                                          size_t dim_scale_if_any,
+                                          const Tensor& scale_tensor) const {
+  RET_CHECK_EQ(expected_dims.size(), 2) << tensor_name;
+  RET_CHECK_EQ(dim_scale_if_any, 0)
+      << "Blockwise quantized weights must be of shape [output_dim, "
+         "input_dim]: "
+      << tensor_name;
+  RET_CHECK_EQ(scale_tensor.datatype, xnn_datatype_fp32) << tensor_name;
+  const size_t num_channels = expected_dims[0];
+  RET_CHECK_EQ(scale_tensor.num_elements % num_channels, 0) << tensor_name;
+  const size_t num_blocks = scale_tensor.num_elements / num_channels;
+  RET_CHECK_EQ(expected_dims[1] % num_blocks, 0) << tensor_name;
+  const size_t block_size = expected_dims[1] / num_blocks;
+  // XNNPACK's blockwise kernels process blocks of a multiple of 32 values.
+  RET_CHECK_EQ(block_size % 32, 0)
+      << "Unsupported block size " << block_size << " of " << tensor_name;
+
+  auto result =
+      std::make_shared<QBTensor>(std::move(expected_dims), block_size);
+  result->flat_data = qtensor.flat_data;
+  // XNNPACK takes bfloat16 scales.
+  auto scales = std::make_shared<std::vector<uint16_t>>(num_channels *
+                                                        num_blocks);
+  const float* float_scales = scale_tensor.DataAs<float>();
+  for (size_t i = 0; i < scales->size(); ++i) {
+    (*scales)[i] = FloatToBFloat16(float_scales[i]);
+  }
+  result->scale_data = std::shared_ptr<uint16_t>(scales, scales->data());
+  return result;
+}
+
 absl::StatusOr<std::shared_ptr<Tensor>>
 TfLiteWeightAccessor::LoadTransposedWeight(absl::string_view tensor_name,
                                            Tensor::DimsType expected_dims,
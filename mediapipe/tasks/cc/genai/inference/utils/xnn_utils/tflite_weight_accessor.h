@@ -38,7 +38,10 @@ class TfLiteWeightAccessor : public WeightAccessor {
   explicit TfLiteWeightAccessor(absl::string_view filename);
   ~TfLiteWeightAccessor() override = default;
 
-  // Returns Tensor wrapping the data buffer from tflite model. Possible errors:
+  // Returns Tensor wrapping the data buffer from tflite model. An int4 weight
+  // with more scales than channels is blockwise quantized: its scales, of
+  // shape [channels, num_blocks], split the rows into blocks of equal size.
+  // Possible errors:
   // * NOT_FOUND: the given tensor_name cannot be found in model.
   absl::StatusOr<std::shared_ptr<Tensor>> LoadWeight(
       absl::string_view tensor_name, Tensor::DimsType expected_dims,
@@ -53,6 +56,13 @@ class TfLiteWeightAccessor : public WeightAccessor {
  private:
   void BuildWeightsMapFromTfliteModel(char* data);
 
+  // Returns a QBTensor of `qtensor`, with `scale_tensor` converted to
+  // bfloat16.
+  absl::StatusOr<std::shared_ptr<Tensor>> LoadBlockwiseWeight(
+      absl::string_view tensor_name, const Tensor& qtensor,
+      Tensor::DimsType expected_dims, size_t dim_scale_if_any,
+      const Tensor& scale_tensor) const;
+
   std::shared_ptr<const tflite::Model> tflite_model_;
   absl::flat_hash_map<absl::string_view /*tensor_name*/,
                       std::shared_ptr<Tensor>>
@@ -0,0 +1,131 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/tflite_weight_accessor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "flatbuffers/flatbuffer_builder.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "xnnpack.h"  // from @XNNPACK
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+constexpr char kWeightName[] = "weight";
+constexpr size_t kNumChannels = 2;
+constexpr size_t kInputDim = 64;
+
+// Returns an accessor of a TfLite model holding the int4 weight `kWeightName`
+// of shape [kNumChannels, kInputDim] and its `num_scales` float scales. As in
+// large models, the buffers are stored after the flatbuffer, at an offset from
+// the start of the file.
+std::unique_ptr<TfLiteWeightAccessor> MakeAccessor(size_t num_scales) {
+  const std::string weight(kNumChannels * kInputDim / 2, '\x9a');
+  std::vector<float> scales(num_scales);
+  for (size_t i = 0; i < num_scales; ++i) {
+    scales[i] = 0.25f * (i + 1);
+  }
+  const std::string scale_bytes(reinterpret_cast<const char*>(scales.data()),
+                                scales.size() * sizeof(float));
+
+  // The buffers are placed at fixed offsets past the flatbuffer, which is much
+  // smaller than that.
+  constexpr size_t kWeightOffset = 4096;
+  const size_t scale_offset = kWeightOffset + weight.size();
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<flatbuffers::Offset<tflite::Buffer>> buffers = {
+      tflite::CreateBuffer(builder),
+      tflite::CreateBuffer(builder, /*data=*/0, kWeightOffset, weight.size()),
+      tflite::CreateBuffer(builder, /*data=*/0, scale_offset,
+                           scale_bytes.size()),
+  };
+  const std::vector<int32_t> weight_shape = {kNumChannels, kInputDim};
+  const std::vector<int32_t> scale_shape = {static_cast<int32_t>(num_scales)};
+  std::vector<flatbuffers::Offset<tflite::Tensor>> tensors = {
+      tflite::CreateTensorDirect(builder, &weight_shape,
+                                 tflite::TensorType_INT4, /*buffer=*/1,
+                                 kWeightName),
+      tflite::CreateTensorDirect(
+          builder, &scale_shape, tflite::TensorType_FLOAT32, /*buffer=*/2,
+          absl::StrCat(kWeightName, kQuantizedScaleSuffix).c_str()),
+  };
+  std::vector<flatbuffers::Offset<tflite::SubGraph>> subgraphs = {
+      tflite::CreateSubGraphDirect(builder, &tensors)};
+  builder.Finish(tflite::CreateModelDirect(builder, TFLITE_SCHEMA_VERSION,
+                                           /*operator_codes=*/nullptr,
+                                           &subgraphs, /*description=*/nullptr,
+                                           &buffers));
+  EXPECT_LT(builder.GetSize(), kWeightOffset);
+
+  auto file = std::make_shared<std::string>(
+      reinterpret_cast<const char*>(builder.GetBufferPointer()),
+      builder.GetSize());
+  file->resize(kWeightOffset);
+  file->append(weight);
+  file->append(scale_bytes);
+  return std::make_unique<TfLiteWeightAccessor>(
+      std::shared_ptr<const tflite::Model>(file,
+                                           tflite::GetModel(file->data())),
+      file->data());
+}
+
+TEST(TfLiteWeightAccessorTest, LoadsChannelwiseInt4Weight) {
+  auto accessor = MakeAccessor(/*num_scales=*/kNumChannels);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto weight, accessor->LoadWeight(kWeightName, {kNumChannels, kInputDim},
+                                        /*dim_scale_if_any=*/0));
+  EXPECT_EQ(weight->datatype, xnn_datatype_qcint4);
+  EXPECT_NE(std::dynamic_pointer_cast<QCTensor>(weight), nullptr);
+}
+
+TEST(TfLiteWeightAccessorTest, DetectsBlockwiseInt4Weight) {
+  // Two blocks of 32 values per channel.
+  auto accessor = MakeAccessor(/*num_scales=*/kNumChannels * 2);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto weight, accessor->LoadWeight(kWeightName, {kNumChannels, kInputDim},
+                                        /*dim_scale_if_any=*/0));
+  EXPECT_EQ(weight->datatype, xnn_datatype_qbint4);
+  auto blockwise_weight = std::dynamic_pointer_cast<QBTensor>(weight);
+  ASSERT_NE(blockwise_weight, nullptr);
+  EXPECT_EQ(blockwise_weight->block_size, 32);
+  EXPECT_EQ(blockwise_weight->num_blocks(), 2);
+  for (size_t i = 0; i < kNumChannels * 2; ++i) {
+    EXPECT_EQ(BFloat16ToFloat(blockwise_weight->scale_data.get()[i]),
+              0.25f * (i + 1));
+  }
+}
+
+TEST(TfLiteWeightAccessorTest, RejectsUnsupportedBlockSize) {
+  // Four blocks of 16 values per channel.
+  auto accessor = MakeAccessor(/*num_scales=*/kNumChannels * 4);
+  EXPECT_FALSE(accessor
+                   ->LoadWeight(kWeightName, {kNumChannels, kInputDim},
+                                /*dim_scale_if_any=*/0)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -18,6 +18,7 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <random>
 #include <utility>
 #include <vector>
@@ -75,6 +76,21 @@ absl::StatusOr<std::vector<uint8_t>> UnpackInt8ToInt4(
   return output;
 }
 
+uint16_t FloatToBFloat16(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  if (std::isnan(value)) return static_cast<uint16_t>(bits >> 16) | 0x40;
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+float BFloat16ToFloat(uint16_t value) {
+  const uint32_t bits = static_cast<uint32_t>(value) << 16;
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
 absl::StatusOr<std::vector<float>> PositionEmbedding(int seq_length,
                                                      int embedding_dim,
                                                      float min_timescale,
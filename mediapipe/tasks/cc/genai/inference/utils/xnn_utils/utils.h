@@ -106,6 +106,11 @@ absl::StatusOr<std::vector<uint8_t>> PackInt4ToInt8(absl::Span<uint8_t> vec);
 absl::StatusOr<std::vector<uint8_t>> UnpackInt8ToInt4(
     absl::Span<uint8_t> packed_vec);
 
+// Converts between float and bfloat16, the upper 16 bits of a float, rounding
+// to the nearest even value.
+uint16_t FloatToBFloat16(float value);
+float BFloat16ToFloat(uint16_t value);
+
 absl::StatusOr<std::vector<float>> PositionEmbedding(
     int seq_length, int embedding_dim, float min_timescale = 1.0f,
     float max_timescale = 10000.0f);
@@ -0,0 +1,62 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+float FromBits(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+TEST(BFloat16Test, KeepsExactValues) {
+  EXPECT_EQ(FloatToBFloat16(1.0f), 0x3f80);
+  EXPECT_EQ(FloatToBFloat16(-2.0f), 0xc000);
+  EXPECT_EQ(FloatToBFloat16(0.0f), 0x0000);
+  EXPECT_EQ(BFloat16ToFloat(0x3f80), 1.0f);
+  EXPECT_EQ(BFloat16ToFloat(FloatToBFloat16(0.375f)), 0.375f);
+}
+
+TEST(BFloat16Test, RoundsToNearest) {
+  EXPECT_EQ(FloatToBFloat16(FromBits(0x3f807fff)), 0x3f80);
+  EXPECT_EQ(FloatToBFloat16(FromBits(0x3f808001)), 0x3f81);
+}
+
+TEST(BFloat16Test, RoundsTiesToEven) {
+  // Halfway between 0x3f80 and 0x3f81, rounded to the even 0x3f80.
+  EXPECT_EQ(FloatToBFloat16(FromBits(0x3f808000)), 0x3f80);
+  // Halfway between 0x3f81 and 0x3f82, rounded to the even 0x3f82.
+  EXPECT_EQ(FloatToBFloat16(FromBits(0x3f818000)), 0x3f82);
+}
+
+TEST(BFloat16Test, KeepsNaN) {
+  EXPECT_TRUE(std::isnan(BFloat16ToFloat(
+      FloatToBFloat16(std::numeric_limits<float>::quiet_NaN()))));
+  // A NaN whose payload is only in the lower bits doesn't round to infinity.
+  EXPECT_TRUE(
+      std::isnan(BFloat16ToFloat(FloatToBFloat16(FromBits(0x7f800001)))));
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
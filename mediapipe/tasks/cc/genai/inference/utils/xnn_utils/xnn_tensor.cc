@@ -634,5 +634,58 @@ std::shared_ptr<Tensor> QCTensor::Slice(size_t index, size_t offset) {
   return result;
 }
 
+void QBTensor::AllocateBufferIfNeeded() {
+  Tensor::AllocateBufferIfNeeded();
+  if (!scale_data) {
+    auto real_buffer = std::make_shared<std::vector<uint16_t>>();
+    real_buffer->resize(dims[0] * num_blocks());
+    scale_data = std::shared_ptr<uint16_t>(real_buffer, real_buffer->data());
+  }
+}
+
+absl::Status QBTensor::DefineWeight(xnn_subgraph& subgraph, uint32_t flags) {
+  uint32_t assigned_tensor_id;
+  RET_CHECK_EQ(xnn_status_success,
+               xnn_define_blockwise_quantized_tensor_value(
+                   &subgraph, datatype, zero_point, scale_data.get(),
+                   dims.size(), /*channel_dim=*/0, block_size, dims.data(),
+                   Data(), XNN_INVALID_VALUE_ID, flags, &assigned_tensor_id))
+      << *this;
+  RET_CHECK_NE(assigned_tensor_id, XNN_INVALID_VALUE_ID);
+  map_subgraph_to_tensor_id[&subgraph] = assigned_tensor_id;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::shared_ptr<Tensor>> QBTensor::ConvertToF32() {
+  RET_CHECK_EQ(dims[1] % 2, 0);
+  auto result = std::make_shared<Tensor>(dims, xnn_datatype_fp32);
+  MP_RETURN_IF_ERROR(result->LoadFromVec({}, /*exact_match=*/false));
+  float* scaled_data = result->DataAs<float>();
+  const uint8_t* quantized_data = static_cast<const uint8_t*>(Data());
+  for (size_t i = 0; i < dims[0]; ++i) {
+    for (size_t j = 0; j < dims[1]; ++j) {
+      const float scale = BFloat16ToFloat(
+          scale_data.get()[i * num_blocks() + j / block_size]);
+      const uint8_t packed = quantized_data[(i * dims[1] + j) / 2];
+      const int32_t value = j % 2 == 0 ? packed & 0x0f : packed >> 4;
+      *scaled_data = (value - zero_point) * scale;
+      ++scaled_data;
+    }
+  }
+  return result;
+}
+
+std::shared_ptr<Tensor> QBTensor::Slice(size_t index, size_t offset) {
+  ABSL_CHECK_EQ(index, 0);
+  auto result = std::make_shared<QBTensor>(DimsType{1, dims[1]}, block_size);
+  result->flat_data = std::shared_ptr<char>(
+      flat_data, flat_data.get() + ElementSize(dims[1] * offset));
+  result->scale_data = std::shared_ptr<uint16_t>(
+      scale_data, scale_data.get() + num_blocks() * offset);
+  result->zero_point = zero_point;
+  result->elements_capacity = result->num_elements;
+  return result;
+}
+
 }  // namespace xnn_utils
 }  // namespace mediapipe::tasks::genai
@@ -132,6 +132,11 @@ struct Tensor {
   // Access the tensor data.
   virtual void* Data();
   const void* Data() const;
+  // The size of the tensor data in bytes.
+  size_t data_size() const { return ElementSize(num_elements); }
+  // The size of the tensor buffer in bytes, which exceeds `data_size()` once
+  // the tensor is resized to fewer elements.
+  size_t data_capacity() const { return ElementSize(elements_capacity); }
 
   // Access the tensor data as certain type.
   template <typename T>
@@ -268,6 +273,40 @@ struct QCTensor : public Tensor {
   friend std::ostream& operator<<(std::ostream& os, const QCTensor& tensor);
 };
 
+// Blockwise Quantized, 4-bit. A weight of shape [channels, input_dim], e.g. of
+// a fully connected layer, whose rows are split into blocks of `block_size`
+// values, each with its own scale. Finer scales than QCTensor's keep int4
+// weights accurate on larger models. Can only be the weight of a fully
+// connected layer with a dynamically quantized input.
+struct QBTensor : public Tensor {
+  QBTensor(DimsType in_dims, size_t block_size_)
+      : Tensor(std::move(in_dims), xnn_datatype_qbint4),
+        block_size(block_size_) {
+    ABSL_CHECK_EQ(dims.size(), 2);
+    ABSL_CHECK_GT(block_size, 0);
+    ABSL_CHECK_EQ(dims[1] % block_size, 0);
+  }
+
+  void AllocateBufferIfNeeded() override;
+  size_t ElementSize(size_t num_elements) const override {
+    return (num_elements + 1) / 2;
+  }
+
+  absl::Status DefineWeight(xnn_subgraph& subgraph, uint32_t flags) override;
+
+  absl::StatusOr<std::shared_ptr<Tensor>> ConvertToF32() override;
+
+  std::shared_ptr<Tensor> Slice(size_t index, size_t offset) override;
+
+  // The number of blocks of a row.
+  size_t num_blocks() const { return dims[1] / block_size; }
+
+  // bfloat16 scales of shape [channels, num_blocks()], as XNNPACK expects.
+  std::shared_ptr<uint16_t> scale_data;
+  size_t block_size;
+  int32_t zero_point = 8;
+};
+
 std::ostream& operator<<(std::ostream& os, const QCTensor& tensor);
 
 // Interface to access weights. The interface allows e.g. benchmark test to
@@ -0,0 +1,108 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/xnn_tensor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/genai/inference/utils/xnn_utils/utils.h"
+
+namespace mediapipe::tasks::genai::xnn_utils {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+constexpr size_t kNumChannels = 2;
+constexpr size_t kBlockSize = 32;
+// An odd number of blocks per row.
+constexpr size_t kNumBlocks = 3;
+constexpr size_t kInputDim = kBlockSize * kNumBlocks;
+
+// Returns the int4 value at (channel, i) of the test tensor.
+int32_t QuantizedValue(size_t channel, size_t i) {
+  return (channel * 5 + i * 3) % 16;
+}
+
+// Returns the scale of block `block` of `channel` of the test tensor, exactly
+// representable in bfloat16.
+float Scale(size_t channel, size_t block) {
+  return 0.5f * (channel * kNumBlocks + block + 1);
+}
+
+// Returns a QBTensor of shape [kNumChannels, kInputDim] holding
+// QuantizedValue() with Scale() per block.
+std::shared_ptr<QBTensor> MakeQBTensor() {
+  auto tensor = std::make_shared<QBTensor>(
+      Tensor::DimsType{kNumChannels, kInputDim}, kBlockSize);
+  tensor->AllocateBufferIfNeeded();
+  EXPECT_EQ(tensor->num_blocks(), kNumBlocks);
+  uint8_t* data = tensor->DataAs<uint8_t>();
+  for (size_t channel = 0; channel < kNumChannels; ++channel) {
+    for (size_t i = 0; i < kInputDim; i += 2) {
+      data[(channel * kInputDim + i) / 2] =
+          QuantizedValue(channel, i) | (QuantizedValue(channel, i + 1) << 4);
+    }
+    for (size_t block = 0; block < kNumBlocks; ++block) {
+      tensor->scale_data.get()[channel * kNumBlocks + block] =
+          FloatToBFloat16(Scale(channel, block));
+    }
+  }
+  return tensor;
+}
+
+// Returns the expected float values of `channel` of the test tensor.
+std::vector<float> ExpectedRow(size_t channel) {
+  std::vector<float> row;
+  for (size_t i = 0; i < kInputDim; ++i) {
+    row.push_back((QuantizedValue(channel, i) - 8) *
+                  Scale(channel, i / kBlockSize));
+  }
+  return row;
+}
+
+std::vector<float> GetValues(const Tensor& tensor) {
+  const float* data = tensor.DataAs<float>();
+  return std::vector<float>(data, data + tensor.num_elements);
+}
+
+TEST(QBTensorTest, ConvertToF32AppliesScalePerBlock) {
+  auto tensor = MakeQBTensor();
+  MP_ASSERT_OK_AND_ASSIGN(auto f32_tensor, tensor->ConvertToF32());
+  ASSERT_EQ(f32_tensor->dims, (Tensor::DimsType{kNumChannels, kInputDim}));
+  std::vector<float> expected = ExpectedRow(0);
+  std::vector<float> row_1 = ExpectedRow(1);
+  expected.insert(expected.end(), row_1.begin(), row_1.end());
+  EXPECT_THAT(GetValues(*f32_tensor), ElementsAreArray(expected));
+}
+
+TEST(QBTensorTest, SliceSelectsRowAndItsScales) {
+  auto tensor = MakeQBTensor();
+  for (size_t channel = 0; channel < kNumChannels; ++channel) {
+    auto slice = std::dynamic_pointer_cast<QBTensor>(tensor->Slice(0, channel));
+    ASSERT_NE(slice, nullptr);
+    EXPECT_EQ(slice->dims, (Tensor::DimsType{1, kInputDim}));
+    EXPECT_EQ(slice->block_size, kBlockSize);
+    MP_ASSERT_OK_AND_ASSIGN(auto f32_slice, slice->ConvertToF32());
+    EXPECT_THAT(GetValues(*f32_slice), ElementsAreArray(ExpectedRow(channel)));
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe::tasks::genai::xnn_utils
@@ -111,130 +111,218 @@ float GetTensorElement(const Shape& input_shape, const float* tensors_buffer,
                         x * input_shape.channels + c];
 }
 
+// Tensor pixels and weight used to linearly interpolate one output row or
+// column.
+struct InterpolationIndex {
+  int i0;
+  int i1;
+  float t;
+};
+
+// Maps output coordinates to tensor coordinates such that the first and last
+// pixels of the tensor and the output are aligned.
+std::vector<InterpolationIndex> GetInterpolationIndices(int input_size,
+                                                        int output_size) {
+  const float scale =
+      output_size > 1 ? (input_size - 1) / static_cast<float>(output_size - 1)
+                      : 0.f;
+  std::vector<InterpolationIndex> indices(output_size);
+  for (int i = 0; i < output_size; ++i) {
+    const float position = i * scale;
+    InterpolationIndex& index = indices[i];
+    index.i0 = static_cast<int>(std::max(std::floor(position), 0.f));
+    index.i1 =
+        static_cast<int>(std::min(std::ceil(position), input_size - 1.f));
+    index.t = std::max(std::min(position - index.i0, 1.f), 0.f);
+  }
+  return indices;
+}
+
+// Returns the category of a pixel given its (activated) confidence scores.
+uint8_t GetCategory(absl::Span<const float> confidence_scores) {
+  if (confidence_scores.size() == 1) {
+    // if the input tensor is a single mask, it is assumed to be a binary
+    // foreground segmentation mask. For such a mask, instead of a true
+    // argmax, we simply use 0.5 as the cutoff, assigning 0 (foreground) or
+    // 255 (background) based on whether the confidence value reaches this
+    // cutoff or not, respectively.
+    return confidence_scores[0] > 0.5f ? 0 : kUnLabeledPixelValue;
+  }
+  return std::max_element(confidence_scores.begin(), confidence_scores.end()) -
+         confidence_scores.begin();
+}
+
+// Computes the category mask in two row-parallel passes. The first pass finds
+// the category of each tensor pixel. The second pass upsamples these
+// categories: an output pixel whose four surrounding tensor pixels agree on
+// the category gets that category, as any convex combination of their scores
+// has the same argmax. Only output pixels on category boundaries interpolate
+// all channels of the tensor. This replaces per-pixel interpolation of every
+// channel, which dominated the cost for multi-class models.
 Image ProcessForCategoryMaskCpu(const Shape& input_shape,
                                 const Shape& output_shape,
                                 const SegmenterOptions& options,
                                 const float* tensors_buffer) {
-  const float width_scale =
-      (input_shape.width - 1) / static_cast<float>(output_shape.width - 1);
-  const float height_scale =
-      (input_shape.height - 1) / static_cast<float>(output_shape.height - 1);
+  const int input_channels = input_shape.channels;
+  // Only process the activation function if it is SIGMOID. If NONE,
+  // we do nothing for activation, If SOFTMAX, it is required
+  // to have input_channels > 1, and for input_channels > 1, we don't need
+  // activation to find the maximum value.
+  const bool apply_sigmoid = options.activation() == SegmenterOptions::SIGMOID;
+
+  // Categories at tensor resolution.
+  std::vector<uint8_t> categories(input_shape.height * input_shape.width);
+  cv::parallel_for_(
+      cv::Range(0, input_shape.height), [&](const cv::Range& range) {
+        std::vector<float> confidence_scores(input_channels);
+        absl::Span<float> confidence_scores_span(confidence_scores);
+        for (int y = range.start; y < range.end; ++y) {
+          for (int x = 0; x < input_shape.width; ++x) {
+            const int index = y * input_shape.width + x;
+            const auto scores = absl::MakeConstSpan(
+                &tensors_buffer[index * input_channels], input_channels);
+            if (apply_sigmoid) {
+              Sigmoid(scores, confidence_scores_span);
+              categories[index] = GetCategory(confidence_scores_span);
+            } else {
+              categories[index] = GetCategory(scores);
+            }
+          }
+        }
+      });
 
   // Category mask Image.
   ImageFrameSharedPtr image_frame_ptr = std::make_shared<ImageFrame>(
       ImageFormat::GRAY8, output_shape.width, output_shape.height, 1);
   Image category_mask(image_frame_ptr);
-
-  // Fill in the maximum category in the category mask image.
   cv::Mat category_mask_mat_view =
       mediapipe::formats::MatView(image_frame_ptr.get());
-  const int input_channels = input_shape.channels;
-  category_mask_mat_view.forEach<uint8_t>([&tensors_buffer, &input_shape,
-                                           &width_scale, &height_scale,
-                                           &input_channels,
-                                           &options](uint8_t& pixel,
-                                                     const int position[]) {
-    std::vector<float> confidence_scores(input_channels);
-    int y0 =
-        static_cast<int>(std::max(std::floor(position[0] * height_scale), 0.f));
-    int x0 =
-        static_cast<int>(std::max(std::floor(position[1] * width_scale), 0.f));
-    int y1 = static_cast<int>(std::min(std::ceil(position[0] * height_scale),
-                                       input_shape.height - 1.f));
-    int x1 = static_cast<int>(std ::min(std::ceil(position[1] * width_scale),
-                                        input_shape.width - 1.f));
-    float t0 = std::max(std::min(position[0] * height_scale - y0, 1.f), 0.f);
-    float t1 = std::max(std::min(position[1] * width_scale - x0, 1.f), 0.f);
-    for (int i = 0; i < input_channels; ++i) {
-      confidence_scores[i] = BilinearInterpolate(
-          GetTensorElement(input_shape, tensors_buffer, x0, y0, i),
-          GetTensorElement(input_shape, tensors_buffer, x0, y1, i),
-          GetTensorElement(input_shape, tensors_buffer, x1, y0, i),
-          GetTensorElement(input_shape, tensors_buffer, x1, y1, i), t0, t1);
-    }
-    absl::Span<float> confidence_scores_span(confidence_scores.data(),
-                                             confidence_scores.size());
-
-    // Only process the activation function if it is SIGMOID. If NONE,
-    // we do nothing for activation, If SOFTMAX, it is required
-    // to have input_channels > 1, and for input_channels > 1, we don't need
-    // activation to find the maximum value.
-    if (options.activation() == SegmenterOptions::SIGMOID) {
-      Sigmoid(confidence_scores_span, confidence_scores_span);
-    }
-    if (input_channels == 1) {
-      // if the input tensor is a single mask, it is assumed to be a binary
-      // foreground segmentation mask. For such a mask, instead of a true
-      // argmax, we simply use 0.5 as the cutoff, assigning 0 (foreground) or
-      // 255 (background) based on whether the confidence value reaches this
-      // cutoff or not, respectively.
-      pixel = confidence_scores[0] > 0.5f ? 0 : kUnLabeledPixelValue;
-    } else {
-      const int maximum_category_idx =
-          std::max_element(confidence_scores.begin(), confidence_scores.end()) -
-          confidence_scores.begin();
-      pixel = maximum_category_idx;
-    }
-  });
+
+  const std::vector<InterpolationIndex> x_indices =
+      GetInterpolationIndices(input_shape.width, output_shape.width);
+  const std::vector<InterpolationIndex> y_indices =
+      GetInterpolationIndices(input_shape.height, output_shape.height);
+  cv::parallel_for_(
+      cv::Range(0, output_shape.height), [&](const cv::Range& range) {
+        std::vector<float> confidence_scores(input_channels);
+        absl::Span<float> confidence_scores_span(confidence_scores);
+        for (int y = range.start; y < range.end; ++y) {
+          const InterpolationIndex& y_index = y_indices[y];
+          const uint8_t* categories_row0 =
+              &categories[y_index.i0 * input_shape.width];
+          const uint8_t* categories_row1 =
+              &categories[y_index.i1 * input_shape.width];
+          uint8_t* mask_row = category_mask_mat_view.ptr<uint8_t>(y);
+          for (int x = 0; x < output_shape.width; ++x) {
+            const InterpolationIndex& x_index = x_indices[x];
+            const uint8_t category = categories_row0[x_index.i0];
+            if (categories_row0[x_index.i1] == category &&
+                categories_row1[x_index.i0] == category &&
+                categories_row1[x_index.i1] == category) {
+              mask_row[x] = category;
+              continue;
+            }
+            for (int i = 0; i < input_channels; ++i) {
+              confidence_scores[i] = BilinearInterpolate(
+                  GetTensorElement(input_shape, tensors_buffer, x_index.i0,
+                                   y_index.i0, i),
+                  GetTensorElement(input_shape, tensors_buffer, x_index.i0,
+                                   y_index.i1, i),
+                  GetTensorElement(input_shape, tensors_buffer, x_index.i1,
+                                   y_index.i0, i),
+                  GetTensorElement(input_shape, tensors_buffer, x_index.i1,
+                                   y_index.i1, i),
+                  y_index.t, x_index.t);
+            }
+            if (apply_sigmoid) {
+              Sigmoid(confidence_scores_span, confidence_scores_span);
+            }
+            mask_row[x] = GetCategory(confidence_scores_span);
+          }
+        }
+      });
   return category_mask;
 }
 
+// Computes the first `num_masks` confidence masks. Activation is applied at
+// tensor resolution in a row-parallel pass that writes each channel to its own
+// plane, and only the requested planes are resized to the output size.
 std::vector<Image> ProcessForConfidenceMaskCpu(const Shape& input_shape,
                                                const Shape& output_shape,
                                                const SegmenterOptions& options,
-                                               const float* tensors_buffer) {
-  std::function<void(absl::Span<const float> values,
-                     absl::Span<float> activated_values)>
-      activation_fn;
-  switch (options.activation()) {
-    case SegmenterOptions::SIGMOID:
-      activation_fn = &Sigmoid;
-      break;
-    case SegmenterOptions::SOFTMAX:
-      activation_fn = &StableSoftmax;
-      break;
-    case SegmenterOptions::NONE:
-      // Just copying for NONE activation.
-      activation_fn = [](absl::Span<const float> values,
-                         absl::Span<float> activated_values) {
-        std::copy(values.begin(), values.end(), activated_values.begin());
-      };
-      break;
-  }
+                                               const float* tensors_buffer,
+                                               int num_masks) {
+  const int input_channels = input_shape.channels;
+  const bool resize = output_shape.height != input_shape.height ||
+                      output_shape.width != input_shape.width;
 
-  // TODO Use libyuv for resizing instead.
+  // Masks at tensor resolution, which are output directly if no resizing is
+  // needed.
   std::vector<Image> confidence_masks;
   std::vector<cv::Mat> confidence_mask_mats;
-  confidence_masks.reserve(input_shape.channels);
-  confidence_mask_mats.reserve(input_shape.channels);
-  for (int i = 0; i < input_shape.channels; ++i) {
-    confidence_masks.push_back(Image(std::make_shared<ImageFrame>(
-        ImageFormat::VEC32F1, input_shape.width, input_shape.height, 1)));
-    confidence_mask_mats.push_back(mediapipe::formats::MatView(
-        confidence_masks.back().GetImageFrameSharedPtr().get()));
+  confidence_mask_mats.reserve(num_masks);
+  for (int i = 0; i < num_masks; ++i) {
+    if (resize) {
+      confidence_mask_mats.emplace_back(input_shape.height, input_shape.width,
+                                        CV_32FC1);
+    } else {
+      confidence_masks.push_back(Image(std::make_shared<ImageFrame>(
+          ImageFormat::VEC32F1, input_shape.width, input_shape.height, 1)));
+      confidence_mask_mats.push_back(mediapipe::formats::MatView(
+          confidence_masks.back().GetImageFrameSharedPtr().get()));
+    }
   }
 
   // Applies activation function.
-  const int tensor_size = input_shape.height * input_shape.width;
-  std::vector<float> activated_values(input_shape.channels);
-  absl::Span<float> activated_values_span(activated_values);
-  for (int i = 0; i < tensor_size; ++i) {
-    activation_fn(absl::MakeConstSpan(&tensors_buffer[i * input_shape.channels],
-                                      input_shape.channels),
-                  activated_values_span);
-    for (int j = 0; j < input_shape.channels; ++j) {
-      confidence_mask_mats[j].at<float>(
-          i / input_shape.width, i % input_shape.width) = activated_values[j];
-    }
-  }
-  if (output_shape.height == input_shape.height &&
-      output_shape.width == input_shape.width) {
+  cv::parallel_for_(
+      cv::Range(0, input_shape.height), [&](const cv::Range& range) {
+        std::vector<float> activated_values(input_channels);
+        absl::Span<float> activated_values_span(activated_values);
+        for (int y = range.start; y < range.end; ++y) {
+          const float* tensor_row =
+              &tensors_buffer[y * input_shape.width * input_channels];
+          switch (options.activation()) {
+            case SegmenterOptions::SOFTMAX:
+              for (int x = 0; x < input_shape.width; ++x) {
+                StableSoftmax(
+                    absl::MakeConstSpan(&tensor_row[x * input_channels],
+                                        input_channels),
+                    activated_values_span);
+                for (int i = 0; i < num_masks; ++i) {
+                  confidence_mask_mats[i].ptr<float>(y)[x] =
+                      activated_values[i];
+                }
+              }
+              break;
+            case SegmenterOptions::SIGMOID:
+              for (int i = 0; i < num_masks; ++i) {
+                float* mask_row = confidence_mask_mats[i].ptr<float>(y);
+                for (int x = 0; x < input_shape.width; ++x) {
+                  const float value = tensor_row[x * input_channels + i];
+                  mask_row[x] = 1. / (1 + std::exp(-value));
+                }
+              }
+              break;
+            case SegmenterOptions::NONE:
+              // Just copying for NONE activation.
+              for (int i = 0; i < num_masks; ++i) {
+                float* mask_row = confidence_mask_mats[i].ptr<float>(y);
+                for (int x = 0; x < input_shape.width; ++x) {
+                  mask_row[x] = tensor_row[x * input_channels + i];
+                }
+              }
+              break;
+          }
+        }
+      });
+  if (!resize) {
     return confidence_masks;
   }
+  // TODO Use libyuv for resizing instead.
   std::vector<Image> resized_confidence_masks;
-  resized_confidence_masks.reserve(confidence_mask_mats.size());
+  resized_confidence_masks.reserve(num_masks);
   // Resizes segmented masks to required output size.
-  for (int i = 0; i < confidence_mask_mats.size(); i++) {
+  for (int i = 0; i < num_masks; i++) {
     // Pre-allocates ImageFrame memory to avoid copying from cv::Mat
     // afterward.
     ImageFrameSharedPtr image_frame_ptr = std::make_shared<ImageFrame>(
@@ -460,12 +548,14 @@ absl::Status TensorsToSegmentationCalculator::Process(
   }
 
   if (cc->Outputs().HasTag("CONFIDENCE_MASK")) {
+    // Only masks of connected outputs are computed.
     std::vector<Image> confidence_masks = ProcessForConfidenceMaskCpu(
         input_shape,
         {/* height= */ output_height,
          /* width= */ output_width,
          /* channels= */ input_shape.channels},
-        options_.segmenter_options(), tensors_buffer);
+        options_.segmenter_options(), tensors_buffer,
+        std::min(kConfidenceMaskOut(cc).Count(), input_shape.channels));
     for (int i = 0; i < confidence_masks.size(); ++i) {
       kConfidenceMaskOut(cc)[i].Send(std::move(confidence_masks[i]));
     }
@@ -492,7 +582,7 @@ std::vector<Image> TensorsToSegmentationCalculator::GetSegmentationResultCpu(
   } else {
     return ProcessForConfidenceMaskCpu(input_shape, output_shape,
                                        options_.segmenter_options(),
-                                       tensors_buffer);
+                                       tensors_buffer, input_shape.channels);
   }
 }
 
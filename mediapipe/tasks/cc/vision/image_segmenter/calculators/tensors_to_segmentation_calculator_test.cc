@@ -14,7 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -361,4 +363,93 @@ TEST(TensorsToSegmentationCalculatorTest, SucceedsCategoryMaskResize) {
                                             expected_index, buffer_indices)));
 }
 
+TEST(TensorsToSegmentationCalculatorTest,
+     CategoryMaskResizeMatchesInterpolatedScores) {
+  CalculatorRunner runner(
+      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig::Node>(
+          R"pb(
+            calculator: "mediapipe.tasks.TensorsToSegmentationCalculator"
+            input_stream: "TENSORS:tensors"
+            input_stream: "OUTPUT_SIZE:size"
+            output_stream: "CATEGORY_MASK:segmentation"
+            options {
+              [mediapipe.tasks.TensorsToSegmentationCalculatorOptions.ext] {
+                segmenter_options { activation: SOFTMAX }
+              }
+            }
+          )pb"));
+
+  const int input_height = 3;
+  const int input_width = 4;
+  const int channels = 3;
+  const int output_height = 7;
+  const int output_width = 11;
+  // Distinct scores with category boundaries between tensor pixels.
+  auto tensors = std::make_unique<std::vector<Tensor>>();
+  tensors->emplace_back(Tensor::ElementType::kFloat32,
+                        Tensor::Shape{input_height, input_width, channels});
+  std::vector<float> scores(input_height * input_width * channels);
+  for (int i = 0; i < scores.size(); ++i) {
+    scores[i] = static_cast<float>((i * 37) % 101) / 7.f;
+  }
+  {
+    auto view = tensors->back().GetCpuWriteView();
+    std::copy(scores.begin(), scores.end(), view.buffer<float>());
+  }
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      mediapipe::Adopt(tensors.release()).At(Timestamp(0)));
+  runner.MutableInputs()
+      ->Tag("OUTPUT_SIZE")
+      .packets.push_back(mediapipe::MakePacket<std::pair<int, int>>(
+                             std::make_pair(output_width, output_height))
+                             .At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& packets =
+      runner.Outputs().Tag("CATEGORY_MASK").packets;
+  ASSERT_EQ(packets.size(), 1);
+  const auto& category_mask = packets[0].Get<Image>();
+  ASSERT_EQ(category_mask.width(), output_width);
+  ASSERT_EQ(category_mask.height(), output_height);
+  auto image_frame_ptr = category_mask.GetImageFrameSharedPtr();
+
+  // Reference: argmax of the bilinearly interpolated scores of every pixel.
+  const float x_scale =
+      (input_width - 1) / static_cast<float>(output_width - 1);
+  const float y_scale =
+      (input_height - 1) / static_cast<float>(output_height - 1);
+  auto score_at = [&](int x, int y, int c) {
+    return scores[(y * input_width + x) * channels + c];
+  };
+  for (int y = 0; y < output_height; ++y) {
+    const uint8_t* mask_row =
+        image_frame_ptr->PixelData() + y * image_frame_ptr->WidthStep();
+    const int y0 = static_cast<int>(std::floor(y * y_scale));
+    const int y1 = static_cast<int>(
+        std::min(std::ceil(y * y_scale), input_height - 1.f));
+    const float ty = y * y_scale - y0;
+    for (int x = 0; x < output_width; ++x) {
+      const int x0 = static_cast<int>(std::floor(x * x_scale));
+      const int x1 = static_cast<int>(
+          std::min(std::ceil(x * x_scale), input_width - 1.f));
+      const float tx = x * x_scale - x0;
+      int expected_category = 0;
+      float max_score = -std::numeric_limits<float>::infinity();
+      for (int c = 0; c < channels; ++c) {
+        const float left = score_at(x0, y0, c) +
+                           (score_at(x0, y1, c) - score_at(x0, y0, c)) * ty;
+        const float right = score_at(x1, y0, c) +
+                            (score_at(x1, y1, c) - score_at(x1, y0, c)) * ty;
+        const float score = left + (right - left) * tx;
+        if (score > max_score) {
+          max_score = score;
+          expected_category = c;
+        }
+      }
+      EXPECT_EQ(mask_row[x], expected_category)
+          << "at (" << x << ", " << y << ")";
+    }
+  }
+}
+
 }  // namespace mediapipe
@@ -76,7 +76,10 @@ import MediaPipeTasksGenAIC
             max_top_k: options.maxTopk,
             llm_activation_data_type: kLlmActivationDataTypeDefault,
             num_draft_tokens: 0,
-            wait_for_weight_uploads: options.waitForWeightUploads)
+            wait_for_weight_uploads: options.waitForWeightUploads,
+            max_batch_size: 0,
+            max_num_prefix_cache_tokens: 0,
+            draft_model_path: nil)
           return try LlmTaskRunner(modelSettings: modelSetting)
         }
       }
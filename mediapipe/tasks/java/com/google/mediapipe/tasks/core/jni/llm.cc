@@ -77,6 +77,9 @@ LlmModelSettings ParseModelSettings(void* bytes, int size) {
   output.llm_activation_data_type = kLlmActivationDataTypeDefault;
   output.num_draft_tokens = 0;
   output.wait_for_weight_uploads = false;
+  output.max_batch_size = 0;
+  output.max_num_prefix_cache_tokens = 0;
+  output.draft_model_path = nullptr;
   return output;
 }
 
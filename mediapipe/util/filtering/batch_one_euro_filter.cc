@@ -0,0 +1,156 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/filtering/batch_one_euro_filter.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr double kEpsilon = 0.000001;
+constexpr int kUninitializedTimestamp = -1;
+
+// Same range check as LowPassFilter::SetAlpha.
+bool IsValidAlpha(float alpha) { return !(alpha < 0.0f || alpha > 1.0f); }
+
+}  // namespace
+
+BatchOneEuroFilter::BatchOneEuroFilter(int size, double frequency,
+                                       double min_cutoff, double beta,
+                                       double derivate_cutoff)
+    : last_time_(kUninitializedTimestamp),
+      raw_values_(size),
+      filtered_values_(size),
+      filtered_derivatives_(size) {
+  if (frequency <= kEpsilon) {
+    ABSL_LOG(ERROR) << "frequency should be > 0";
+  } else {
+    frequency_ = frequency;
+  }
+  if (min_cutoff <= kEpsilon) {
+    ABSL_LOG(ERROR) << "min_cutoff should be > 0";
+  } else {
+    min_cutoff_ = min_cutoff;
+  }
+  beta_ = beta;
+  if (derivate_cutoff <= kEpsilon) {
+    ABSL_LOG(ERROR) << "derivate_cutoff should be > 0";
+  } else {
+    derivate_cutoff_ = derivate_cutoff;
+  }
+  alphas_.assign(size, GetAlpha(min_cutoff));
+  derivative_alpha_ = GetAlpha(derivate_cutoff);
+}
+
+void BatchOneEuroFilter::Apply(absl::Duration timestamp, double value_scale,
+                               absl::Span<float> values) {
+  ABSL_DCHECK_EQ(values.size(), raw_values_.size());
+  const int64_t new_timestamp = absl::ToInt64Nanoseconds(timestamp);
+  if (last_time_ >= new_timestamp) {
+    // Results are unpredictable in this case, so nothing to do but
+    // return same values.
+    ABSL_LOG(WARNING) << "New timestamp is equal or less than the last one.";
+    return;
+  }
+
+  // update the sampling frequency based on timestamps
+  if (last_time_ != 0 && new_timestamp != 0) {
+    static constexpr double kNanoSecondsToSecond = 1e-9;
+    frequency_ = 1.0 / ((new_timestamp - last_time_) * kNanoSecondsToSecond);
+  }
+  last_time_ = new_timestamp;
+
+  const float derivative_alpha = GetAlpha(derivate_cutoff_);
+  if (IsValidAlpha(derivative_alpha)) {
+    derivative_alpha_ = derivative_alpha;
+  } else {
+    ABSL_LOG(ERROR) << "alpha: " << derivative_alpha
+                    << " should be in [0.0, 1.0] range";
+  }
+
+  const int size = values.size();
+  if (!initialized_) {
+    // The first value passes through, its derivative is zero and the value
+    // filters take the alpha of the minimum cutoff.
+    const float alpha = GetAlpha(min_cutoff_);
+    for (int i = 0; i < size; ++i) {
+      raw_values_[i] = values[i];
+      filtered_values_[i] = values[i];
+      filtered_derivatives_[i] = 0.0f;
+      if (IsValidAlpha(alpha)) alphas_[i] = alpha;
+    }
+    initialized_ = true;
+    return;
+  }
+
+  // The expressions below mirror OneEuroFilter and LowPassFilter, including
+  // their float/double conversions, so that results are identical. There are
+  // no calls in the loop and it works on raw pointers, which lets the compiler
+  // vectorize it.
+  const double te = 1.0 / frequency_;
+  const double frequency = frequency_;
+  const double min_cutoff = min_cutoff_;
+  const double beta = beta_;
+  const float derivative_alpha_f = derivative_alpha_;
+  const double one_minus_derivative_alpha = 1.0 - derivative_alpha_;
+  float* raw_values = raw_values_.data();
+  float* filtered_values = filtered_values_.data();
+  float* filtered_derivatives = filtered_derivatives_.data();
+  float* alphas = alphas_.data();
+  float* data = values.data();
+  int num_invalid_alphas = 0;
+  for (int i = 0; i < size; ++i) {
+    const float value = data[i];
+    // estimate the current variation per second
+    const float dvalue =
+        (static_cast<double>(value) - raw_values[i]) * value_scale * frequency;
+    const float edvalue = derivative_alpha_f * dvalue +
+                          one_minus_derivative_alpha * filtered_derivatives[i];
+    filtered_derivatives[i] = edvalue;
+    // use it to update the cutoff frequency
+    const double cutoff = min_cutoff + beta * std::fabs(edvalue);
+    const double tau = 1.0 / (2 * M_PI * cutoff);
+    const float alpha = 1.0 / (1.0 + tau / te);
+    const bool valid_alpha = IsValidAlpha(alpha);
+    num_invalid_alphas += valid_alpha ? 0 : 1;
+    const float new_alpha = valid_alpha ? alpha : alphas[i];
+    alphas[i] = new_alpha;
+    // filter the given value
+    const float result =
+        new_alpha * value + (1.0 - new_alpha) * filtered_values[i];
+    raw_values[i] = value;
+    filtered_values[i] = result;
+    data[i] = result;
+  }
+  if (num_invalid_alphas > 0) {
+    ABSL_LOG(ERROR) << num_invalid_alphas
+                    << " alphas were not in [0.0, 1.0] range";
+  }
+}
+
+double BatchOneEuroFilter::GetAlpha(double cutoff) const {
+  double te = 1.0 / frequency_;
+  double tau = 1.0 / (2 * M_PI * cutoff);
+  return 1.0 / (1.0 + tau / te);
+}
+
+}  // namespace mediapipe
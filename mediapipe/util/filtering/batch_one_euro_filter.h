@@ -0,0 +1,63 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_FILTERING_BATCH_ONE_EURO_FILTER_H_
+#define MEDIAPIPE_UTIL_FILTERING_BATCH_ONE_EURO_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace mediapipe {
+
+// Filters a fixed number of values that are sampled at the same timestamps
+// and share a value scale, e.g. all coordinates of a set of landmarks. Every
+// value is filtered exactly as by its own OneEuroFilter, but the filter state
+// is kept in contiguous arrays and all values are updated in one loop.
+class BatchOneEuroFilter {
+ public:
+  BatchOneEuroFilter(int size, double frequency, double min_cutoff,
+                     double beta, double derivate_cutoff);
+
+  // Filters `values` in place. `values` must hold `size()` elements.
+  void Apply(absl::Duration timestamp, double value_scale,
+             absl::Span<float> values);
+
+  int size() const { return raw_values_.size(); }
+
+ private:
+  double GetAlpha(double cutoff) const;
+
+  double frequency_ = 0.0;
+  double min_cutoff_ = 0.0;
+  double beta_ = 0.0;
+  double derivate_cutoff_ = 0.0;
+  int64_t last_time_;
+  // Whether the low pass filters have seen a value.
+  bool initialized_ = false;
+
+  // State of the value low pass filters.
+  std::vector<float> raw_values_;
+  std::vector<float> filtered_values_;
+  std::vector<float> alphas_;
+  // State of the derivative low pass filters, which share their alpha.
+  std::vector<float> filtered_derivatives_;
+  float derivative_alpha_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_FILTERING_BATCH_ONE_EURO_FILTER_H_
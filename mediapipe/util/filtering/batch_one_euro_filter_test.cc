@@ -0,0 +1,60 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/filtering/batch_one_euro_filter.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/util/filtering/one_euro_filter.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(BatchOneEuroFilterTest, MatchesOneEuroFilter) {
+  constexpr int kSize = 7;
+  BatchOneEuroFilter batch_filter(kSize, /*frequency=*/30.0,
+                                  /*min_cutoff=*/0.05, /*beta=*/80.0,
+                                  /*derivate_cutoff=*/1.0);
+  std::vector<OneEuroFilter> filters;
+  for (int i = 0; i < kSize; ++i) {
+    filters.emplace_back(/*frequency=*/30.0, /*min_cutoff=*/0.05,
+                         /*beta=*/80.0, /*derivate_cutoff=*/1.0);
+  }
+
+  // Irregular timestamps, including one that is not increasing.
+  const std::vector<int64_t> timestamps_ms = {0, 33, 66, 66, 120, 130, 200};
+  for (int t = 0; t < timestamps_ms.size(); ++t) {
+    const absl::Duration timestamp = absl::Milliseconds(timestamps_ms[t]);
+    const double value_scale = 1.0 / (1.0 + 0.1 * t);
+    std::vector<float> values(kSize);
+    for (int i = 0; i < kSize; ++i) {
+      values[i] = 10.0f * std::sin(0.3f * t + i) + i;
+    }
+    std::vector<float> expected(kSize);
+    for (int i = 0; i < kSize; ++i) {
+      expected[i] = filters[i].Apply(timestamp, value_scale, values[i]);
+    }
+    batch_filter.Apply(timestamp, value_scale, absl::MakeSpan(values));
+    for (int i = 0; i < kSize; ++i) {
+      EXPECT_FLOAT_EQ(values[i], expected[i]) << "at " << t << ", " << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,142 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/filtering/batch_relative_velocity_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace mediapipe {
+
+BatchRelativeVelocityFilter::BatchRelativeVelocityFilter(
+    int size, size_t window_size, float velocity_scale,
+    DistanceEstimationMode distance_mode)
+    : size_(size),
+      window_size_(window_size),
+      velocity_scale_(velocity_scale),
+      distance_mode_(distance_mode),
+      last_values_(size),
+      filtered_values_(size),
+      alphas_(size, 1.0f),
+      window_durations_(window_size),
+      window_distances_(window_size * size),
+      distances_(size),
+      cumulative_distances_(size) {}
+
+void BatchRelativeVelocityFilter::Apply(absl::Duration timestamp,
+                                        float value_scale,
+                                        absl::Span<float> values) {
+  ABSL_DCHECK_EQ(values.size(), static_cast<size_t>(size_));
+  const int64_t new_timestamp = absl::ToInt64Nanoseconds(timestamp);
+  if (last_timestamp_ >= new_timestamp) {
+    // Results are unpredictable in this case, so nothing to do but
+    // return same values.
+    ABSL_LOG(WARNING) << "New timestamp is equal or less than the last one.";
+    return;
+  }
+
+  if (last_timestamp_ == -1) {
+    // The first values pass through.
+    std::copy(values.begin(), values.end(), last_values_.begin());
+    std::copy(values.begin(), values.end(), filtered_values_.begin());
+    last_value_scale_ = value_scale;
+    last_timestamp_ = new_timestamp;
+    return;
+  }
+
+  // Raw pointers let the compiler vectorize the loops below.
+  float* data = values.data();
+  float* last_values = last_values_.data();
+  float* distances = distances_.data();
+  float* cumulative_distances = cumulative_distances_.data();
+  const float last_value_scale = last_value_scale_;
+
+  ABSL_DCHECK(distance_mode_ == DistanceEstimationMode::kLegacyTransition ||
+              distance_mode_ == DistanceEstimationMode::kForceCurrentScale);
+  if (distance_mode_ == DistanceEstimationMode::kLegacyTransition) {
+    for (int i = 0; i < size_; ++i) {
+      distances[i] = data[i] * value_scale - last_values[i] * last_value_scale;
+    }
+  } else {
+    for (int i = 0; i < size_; ++i) {
+      distances[i] = value_scale * (data[i] - last_values[i]);
+    }
+  }
+
+  // Window elements taken into account only depend on durations, which are
+  // the same for all values.
+  const int64_t duration = new_timestamp - last_timestamp_;
+  int64_t cumulative_duration = duration;
+  // Define max cumulative duration assuming
+  // 30 frames per second is a good frame rate, so assuming 30 values
+  // per second or 1 / 30 of a second is a good duration per window element
+  constexpr int64_t kAssumedMaxDuration = 1000000000 / 30;
+  const int64_t max_cumulative_duration =
+      (1 + window_size_) * kAssumedMaxDuration;
+  std::copy(distances_.begin(), distances_.end(),
+            cumulative_distances_.begin());
+  for (size_t k = 0; k < window_size_; ++k) {
+    const int slot = (window_head_ + k) % window_size_;
+    if (cumulative_duration + window_durations_[slot] >
+        max_cumulative_duration) {
+      // This helps in cases when durations are large and outdated
+      // window elements have bad impact on filtering results
+      break;
+    }
+    cumulative_duration += window_durations_[slot];
+    const float* window_distances = &window_distances_[slot * size_];
+    for (int i = 0; i < size_; ++i) {
+      cumulative_distances[i] += window_distances[i];
+    }
+  }
+
+  constexpr double kNanoSecondsToSecond = 1e-9;
+  const double cumulative_seconds = cumulative_duration * kNanoSecondsToSecond;
+  const float velocity_scale = velocity_scale_;
+  float* alphas = alphas_.data();
+  float* filtered_values = filtered_values_.data();
+  for (int i = 0; i < size_; ++i) {
+    const float velocity = cumulative_distances[i] / cumulative_seconds;
+    const float alpha =
+        1.0f - 1.0f / (1.0f + velocity_scale * std::abs(velocity));
+    // Same range check as LowPassFilter::SetAlpha.
+    const float new_alpha = (alpha < 0.0f || alpha > 1.0f) ? alphas[i] : alpha;
+    alphas[i] = new_alpha;
+    const float value = data[i];
+    const float result =
+        new_alpha * value + (1.0 - new_alpha) * filtered_values[i];
+    filtered_values[i] = result;
+    last_values[i] = value;
+    data[i] = result;
+  }
+
+  // Pushes the new window element, replacing the oldest one.
+  if (window_size_ > 0) {
+    window_head_ = (window_head_ + window_size_ - 1) % window_size_;
+    window_durations_[window_head_] = duration;
+    std::copy(distances_.begin(), distances_.end(),
+              window_distances_.begin() + window_head_ * size_);
+  }
+  last_value_scale_ = value_scale;
+  last_timestamp_ = new_timestamp;
+}
+
+}  // namespace mediapipe
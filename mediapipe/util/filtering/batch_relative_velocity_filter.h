@@ -0,0 +1,77 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_FILTERING_BATCH_RELATIVE_VELOCITY_FILTER_H_
+#define MEDIAPIPE_UTIL_FILTERING_BATCH_RELATIVE_VELOCITY_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "mediapipe/util/filtering/relative_velocity_filter.h"
+
+namespace mediapipe {
+
+// Filters a fixed number of values that are sampled at the same timestamps
+// and share a value scale, e.g. all coordinates of a set of landmarks. Every
+// value is filtered exactly as by its own RelativeVelocityFilter, but the
+// filter state is kept in contiguous arrays: the window durations, which are
+// the same for all values, are stored once and the window distances are stored
+// as one row of values per window element.
+class BatchRelativeVelocityFilter {
+ public:
+  using DistanceEstimationMode = RelativeVelocityFilter::DistanceEstimationMode;
+
+  BatchRelativeVelocityFilter(int size, size_t window_size,
+                              float velocity_scale,
+                              DistanceEstimationMode distance_mode =
+                                  DistanceEstimationMode::kDefault);
+
+  // Filters `values` in place. `values` must hold `size()` elements.
+  void Apply(absl::Duration timestamp, float value_scale,
+             absl::Span<float> values);
+
+  int size() const { return size_; }
+
+ private:
+  const int size_;
+  const size_t window_size_;
+  const float velocity_scale_;
+  const DistanceEstimationMode distance_mode_;
+
+  float last_value_scale_ = 1.0f;
+  int64_t last_timestamp_ = -1;
+  std::vector<float> last_values_;
+  // Output of the low pass filters.
+  std::vector<float> filtered_values_;
+  std::vector<float> alphas_;
+
+  // Ring buffer of `window_size_` elements, the newest one at `window_head_`.
+  // Like RelativeVelocityFilter, the window starts out with elements of zero
+  // distance and duration.
+  int window_head_ = 0;
+  std::vector<int64_t> window_durations_;
+  // `window_size_` rows of `size_` distances.
+  std::vector<float> window_distances_;
+
+  // Scratch buffers.
+  std::vector<float> distances_;
+  std::vector<float> cumulative_distances_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_FILTERING_BATCH_RELATIVE_VELOCITY_FILTER_H_
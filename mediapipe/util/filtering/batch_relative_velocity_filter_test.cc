@@ -0,0 +1,77 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/filtering/batch_relative_velocity_filter.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/util/filtering/relative_velocity_filter.h"
+
+namespace mediapipe {
+namespace {
+
+using DistanceEstimationMode = RelativeVelocityFilter::DistanceEstimationMode;
+
+void ExpectMatchesRelativeVelocityFilter(int window_size,
+                                         DistanceEstimationMode mode) {
+  constexpr int kSize = 7;
+  constexpr float kVelocityScale = 10.0f;
+  BatchRelativeVelocityFilter batch_filter(kSize, window_size, kVelocityScale,
+                                           mode);
+  std::vector<RelativeVelocityFilter> filters(
+      kSize, RelativeVelocityFilter(window_size, kVelocityScale, mode));
+
+  // Irregular timestamps, including one that is not increasing and a gap
+  // that exceeds the assumed maximum window duration.
+  const std::vector<int64_t> timestamps_ms = {0,   33,  66,  66, 100,
+                                              300, 333, 366, 400, 433};
+  for (int t = 0; t < timestamps_ms.size(); ++t) {
+    const absl::Duration timestamp = absl::Milliseconds(timestamps_ms[t]);
+    const float value_scale = 1.0f / (1.0f + 0.1f * t);
+    std::vector<float> values(kSize);
+    for (int i = 0; i < kSize; ++i) {
+      values[i] = 10.0f * std::sin(0.3f * t + i) + i;
+    }
+    std::vector<float> expected(kSize);
+    for (int i = 0; i < kSize; ++i) {
+      expected[i] = filters[i].Apply(timestamp, value_scale, values[i]);
+    }
+    batch_filter.Apply(timestamp, value_scale, absl::MakeSpan(values));
+    for (int i = 0; i < kSize; ++i) {
+      EXPECT_FLOAT_EQ(values[i], expected[i]) << "at " << t << ", " << i;
+    }
+  }
+}
+
+TEST(BatchRelativeVelocityFilterTest, MatchesLegacyTransition) {
+  ExpectMatchesRelativeVelocityFilter(
+      /*window_size=*/5, DistanceEstimationMode::kLegacyTransition);
+}
+
+TEST(BatchRelativeVelocityFilterTest, MatchesForceCurrentScale) {
+  ExpectMatchesRelativeVelocityFilter(
+      /*window_size=*/5, DistanceEstimationMode::kForceCurrentScale);
+}
+
+TEST(BatchRelativeVelocityFilterTest, MatchesWithoutWindow) {
+  ExpectMatchesRelativeVelocityFilter(/*window_size=*/0,
+                                      DistanceEstimationMode::kDefault);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -14,8 +14,11 @@
 
 #include "mediapipe/util/frame_buffer/frame_buffer_util.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -24,9 +27,9 @@
 #include "mediapipe/framework/formats/frame_buffer.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/port/status_macros.h"
-#include "mediapipe/util/frame_buffer/float_buffer.h"
 #include "mediapipe/util/frame_buffer/gray_buffer.h"
 #include "mediapipe/util/frame_buffer/rgb_buffer.h"
+#include "mediapipe/util/frame_buffer/simd/kernels.h"
 #include "mediapipe/util/frame_buffer/yuv_buffer.h"
 
 namespace mediapipe {
@@ -288,40 +291,125 @@ absl::StatusOr<RgbBuffer> CreateRgbBuffer(const FrameBuffer& buffer) {
                    buffer.plane(0).stride().row_stride_bytes, alpha);
 }
 
+// SIMD kernel helpers.
+//------------------------------------------------------------------------------
+//
+// Resize, rotate, YUV to RGB and float conversion run on the SIMD kernels
+// selected for the running CPU. Their results match the Halide
+// implementations, which are still used for the remaining operations and for
+// buffer layouts the kernels do not cover.
+
+// Returns a view over the single interleaved plane of a grayscale or RGB[A]
+// buffer.
+absl::StatusOr<simd::Plane> GetInterleavedPlane(const FrameBuffer& buffer) {
+  MP_ASSIGN_OR_RETURN(int channels, NumberOfChannels(buffer));
+  const int row_stride = buffer.plane(0).stride().row_stride_bytes;
+  return simd::Plane{const_cast<uint8_t*>(buffer.plane(0).buffer()),
+                     buffer.dimension().width, buffer.dimension().height,
+                     row_stride > 0 ? row_stride
+                                    : buffer.dimension().width * channels,
+                     channels};
+}
+
+// Returns the view over the region [x0, x1] x [y0, y1] of `plane`.
+simd::Plane CropPlane(const simd::Plane& plane, int x0, int y0, int x1,
+                      int y1) {
+  return {plane.data + y0 * plane.row_stride + x0 * plane.channels,
+          x1 - x0 + 1, y1 - y0 + 1, plane.row_stride, plane.channels};
+}
+
+// Resizes `input` into `output`, which must have the same number of channels.
+void ResizePlane(const simd::Plane& input, const simd::Plane& output) {
+  simd::GetKernels().resize_bilinear(
+      input, static_cast<float>(input.width) / output.width,
+      static_cast<float>(input.height) / output.height, output);
+}
+
+// A YUV buffer described as interleaved planes: the Y plane, followed by
+// either the UV plane of NV12/NV21 as one 2-channel plane or the separate U
+// and V planes of YV12/YV21.
+struct YuvPlaneViews {
+  std::vector<simd::Plane> planes;
+  // Whether U precedes V in memory; only relevant for semi-planar buffers.
+  bool u_first = true;
+};
+
+// Returns the plane views of `buffer`, or std::nullopt if its chroma layout is
+// neither semi-planar nor planar with tightly packed samples.
+absl::StatusOr<std::optional<YuvPlaneViews>> GetYuvPlaneViews(
+    const FrameBuffer& buffer) {
+  MP_ASSIGN_OR_RETURN(FrameBuffer::YuvData yuv_data,
+                      FrameBuffer::GetYuvDataFromFrameBuffer(buffer));
+  const int width = buffer.dimension().width;
+  const int height = buffer.dimension().height;
+  const int uv_width = (width + 1) / 2;
+  const int uv_height = (height + 1) / 2;
+  YuvPlaneViews views;
+  views.planes.push_back({const_cast<uint8_t*>(yuv_data.y_buffer), width,
+                          height, yuv_data.y_row_stride, 1});
+  const std::ptrdiff_t uv_distance = yuv_data.v_buffer - yuv_data.u_buffer;
+  if (yuv_data.uv_pixel_stride == 2 &&
+      (uv_distance == 1 || uv_distance == -1)) {
+    views.u_first = uv_distance == 1;
+    views.planes.push_back(
+        {const_cast<uint8_t*>(std::min(yuv_data.u_buffer, yuv_data.v_buffer)),
+         uv_width, uv_height, yuv_data.uv_row_stride, 2});
+  } else if (yuv_data.uv_pixel_stride == 1) {
+    views.planes.push_back({const_cast<uint8_t*>(yuv_data.u_buffer), uv_width,
+                            uv_height, yuv_data.uv_row_stride, 1});
+    views.planes.push_back({const_cast<uint8_t*>(yuv_data.v_buffer), uv_width,
+                            uv_height, yuv_data.uv_row_stride, 1});
+  } else {
+    return std::nullopt;
+  }
+  return views;
+}
+
+// Returns whether the planes of `input` can be transformed one by one into
+// the planes of `output`.
+bool AreYuvPlaneViewsCompatible(const std::optional<YuvPlaneViews>& input,
+                                const std::optional<YuvPlaneViews>& output) {
+  return input.has_value() && output.has_value() &&
+         input->planes.size() == output->planes.size() &&
+         (input->planes.size() == 3 || input->u_first == output->u_first);
+}
+
+// Resizes each plane of `input` into the matching plane of `output`. Like the
+// Halide generator, the chroma planes use the scale factors of the Y plane.
+void ResizeYuvPlanes(const std::vector<simd::Plane>& input,
+                     const std::vector<simd::Plane>& output) {
+  const float scale_x = static_cast<float>(input[0].width) / output[0].width;
+  const float scale_y = static_cast<float>(input[0].height) / output[0].height;
+  for (int i = 0; i < input.size(); ++i) {
+    simd::GetKernels().resize_bilinear(input[i], scale_x, scale_y, output[i]);
+  }
+}
+
 // Grayscale transformation functions.
 //------------------------------------------------------------------------------
 
 absl::Status CropGrayscale(const FrameBuffer& buffer, int x0, int y0, int x1,
                            int y1, FrameBuffer* output_buffer) {
-  MP_ASSIGN_OR_RETURN(auto input, CreateGrayBuffer(buffer));
-  MP_ASSIGN_OR_RETURN(auto output, CreateGrayBuffer(*output_buffer));
-  bool success_crop = input.Crop(x0, y0, x1, y1);
-  if (!success_crop) {
-    return absl::UnknownError("Halide grayscale crop operation failed.");
-  }
-  bool success_resize = input.Resize(&output);
-  if (!success_resize) {
-    return absl::UnknownError("Halide grayscale resize operation failed.");
-  }
+  MP_ASSIGN_OR_RETURN(simd::Plane input, GetInterleavedPlane(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane output, GetInterleavedPlane(*output_buffer));
+  ResizePlane(CropPlane(input, x0, y0, x1, y1), output);
   return absl::OkStatus();
 }
 
 absl::Status ResizeGrayscale(const FrameBuffer& buffer,
                              FrameBuffer* output_buffer) {
-  MP_ASSIGN_OR_RETURN(auto input, CreateGrayBuffer(buffer));
-  MP_ASSIGN_OR_RETURN(auto output, CreateGrayBuffer(*output_buffer));
-  return input.Resize(&output)
-             ? absl::OkStatus()
-             : absl::UnknownError("Halide grayscale resize operation failed.");
+  MP_ASSIGN_OR_RETURN(simd::Plane input, GetInterleavedPlane(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane output, GetInterleavedPlane(*output_buffer));
+  ResizePlane(input, output);
+  return absl::OkStatus();
 }
 
 absl::Status RotateGrayscale(const FrameBuffer& buffer, int angle_deg,
                              FrameBuffer* output_buffer) {
-  MP_ASSIGN_OR_RETURN(auto input, CreateGrayBuffer(buffer));
-  MP_ASSIGN_OR_RETURN(auto output, CreateGrayBuffer(*output_buffer));
-  return input.Rotate(angle_deg % 360, &output)
-             ? absl::OkStatus()
-             : absl::UnknownError("Halide grayscale rotate operation failed.");
+  MP_ASSIGN_OR_RETURN(simd::Plane input, GetInterleavedPlane(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane output, GetInterleavedPlane(*output_buffer));
+  simd::GetKernels().rotate(input, angle_deg % 360, output);
+  return absl::OkStatus();
 }
 
 absl::Status FlipHorizontallyGrayscale(const FrameBuffer& buffer,
@@ -348,6 +436,13 @@ absl::Status FlipVerticallyGrayscale(const FrameBuffer& buffer,
 //------------------------------------------------------------------------------
 
 absl::Status ResizeRgb(const FrameBuffer& buffer, FrameBuffer* output_buffer) {
+  MP_ASSIGN_OR_RETURN(simd::Plane input_plane, GetInterleavedPlane(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane output_plane,
+                      GetInterleavedPlane(*output_buffer));
+  if (input_plane.channels == output_plane.channels) {
+    ResizePlane(input_plane, output_plane);
+    return absl::OkStatus();
+  }
   MP_ASSIGN_OR_RETURN(auto input, CreateRgbBuffer(buffer));
   MP_ASSIGN_OR_RETURN(auto output, CreateRgbBuffer(*output_buffer));
   return input.Resize(&output)
@@ -375,6 +470,13 @@ absl::Status ConvertRgb(const FrameBuffer& buffer, FrameBuffer* output_buffer) {
 
 absl::Status CropRgb(const FrameBuffer& buffer, int x0, int y0, int x1, int y1,
                      FrameBuffer* output_buffer) {
+  MP_ASSIGN_OR_RETURN(simd::Plane input_plane, GetInterleavedPlane(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane output_plane,
+                      GetInterleavedPlane(*output_buffer));
+  if (input_plane.channels == output_plane.channels) {
+    ResizePlane(CropPlane(input_plane, x0, y0, x1, y1), output_plane);
+    return absl::OkStatus();
+  }
   MP_ASSIGN_OR_RETURN(auto input, CreateRgbBuffer(buffer));
   MP_ASSIGN_OR_RETURN(auto output, CreateRgbBuffer(*output_buffer));
   bool success_crop = input.Crop(x0, y0, x1, y1);
@@ -410,6 +512,13 @@ absl::Status FlipVerticallyRgb(const FrameBuffer& buffer,
 
 absl::Status RotateRgb(const FrameBuffer& buffer, int angle,
                        FrameBuffer* output_buffer) {
+  MP_ASSIGN_OR_RETURN(simd::Plane input_plane, GetInterleavedPlane(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane output_plane,
+                      GetInterleavedPlane(*output_buffer));
+  if (input_plane.channels == output_plane.channels) {
+    simd::GetKernels().rotate(input_plane, angle % 360, output_plane);
+    return absl::OkStatus();
+  }
   MP_ASSIGN_OR_RETURN(auto input, CreateRgbBuffer(buffer));
   MP_ASSIGN_OR_RETURN(auto output, CreateRgbBuffer(*output_buffer));
   return input.Rotate(angle % 360, &output)
@@ -419,15 +528,10 @@ absl::Status RotateRgb(const FrameBuffer& buffer, int angle,
 
 absl::Status ToFloatTensorRgb(const FrameBuffer& buffer, float scale,
                               float offset, Tensor& tensor) {
-  MP_ASSIGN_OR_RETURN(auto input, CreateRgbBuffer(buffer));
-  MP_ASSIGN_OR_RETURN(int channels, NumberOfChannels(buffer));
+  MP_ASSIGN_OR_RETURN(simd::Plane input, GetInterleavedPlane(buffer));
   auto view = tensor.GetCpuWriteView();
-  float* data = view.buffer<float>();
-  FloatBuffer output(data, buffer.dimension().width, buffer.dimension().height,
-                     channels);
-  return input.ToFloat(scale, offset, &output)
-             ? absl::OkStatus()
-             : absl::UnknownError("Halide rgb[a] to float conversion failed.");
+  simd::GetKernels().to_float(input, scale, offset, view.buffer<float>());
+  return absl::OkStatus();
 }
 
 // Yuv transformation functions.
@@ -435,6 +539,19 @@ absl::Status ToFloatTensorRgb(const FrameBuffer& buffer, float scale,
 
 absl::Status CropYuv(const FrameBuffer& buffer, int x0, int y0, int x1, int y1,
                      FrameBuffer* output_buffer) {
+  MP_ASSIGN_OR_RETURN(auto input_views, GetYuvPlaneViews(buffer));
+  MP_ASSIGN_OR_RETURN(auto output_views, GetYuvPlaneViews(*output_buffer));
+  // Odd crop origins misalign the Y and chroma grids and take the Halide path.
+  if (AreYuvPlaneViewsCompatible(input_views, output_views) &&
+      x0 % 2 == 0 && y0 % 2 == 0) {
+    std::vector<simd::Plane>& planes = input_views->planes;
+    planes[0] = CropPlane(planes[0], x0, y0, x1, y1);
+    for (int i = 1; i < planes.size(); ++i) {
+      planes[i] = CropPlane(planes[i], x0 / 2, y0 / 2, x1 / 2, y1 / 2);
+    }
+    ResizeYuvPlanes(planes, output_views->planes);
+    return absl::OkStatus();
+  }
   MP_ASSIGN_OR_RETURN(auto input, CreateYuvBuffer(buffer));
   MP_ASSIGN_OR_RETURN(auto output, CreateYuvBuffer(*output_buffer));
   bool success_crop = input.Crop(x0, y0, x1, y1);
@@ -449,6 +566,12 @@ absl::Status CropYuv(const FrameBuffer& buffer, int x0, int y0, int x1, int y1,
 }
 
 absl::Status ResizeYuv(const FrameBuffer& buffer, FrameBuffer* output_buffer) {
+  MP_ASSIGN_OR_RETURN(auto input_views, GetYuvPlaneViews(buffer));
+  MP_ASSIGN_OR_RETURN(auto output_views, GetYuvPlaneViews(*output_buffer));
+  if (AreYuvPlaneViewsCompatible(input_views, output_views)) {
+    ResizeYuvPlanes(input_views->planes, output_views->planes);
+    return absl::OkStatus();
+  }
   MP_ASSIGN_OR_RETURN(auto input, CreateYuvBuffer(buffer));
   MP_ASSIGN_OR_RETURN(auto output, CreateYuvBuffer(*output_buffer));
   return input.Resize(&output)
@@ -458,6 +581,15 @@ absl::Status ResizeYuv(const FrameBuffer& buffer, FrameBuffer* output_buffer) {
 
 absl::Status RotateYuv(const FrameBuffer& buffer, int angle_deg,
                        FrameBuffer* output_buffer) {
+  MP_ASSIGN_OR_RETURN(auto input_views, GetYuvPlaneViews(buffer));
+  MP_ASSIGN_OR_RETURN(auto output_views, GetYuvPlaneViews(*output_buffer));
+  if (AreYuvPlaneViewsCompatible(input_views, output_views)) {
+    for (int i = 0; i < input_views->planes.size(); ++i) {
+      simd::GetKernels().rotate(input_views->planes[i], angle_deg % 360,
+                                output_views->planes[i]);
+    }
+    return absl::OkStatus();
+  }
   MP_ASSIGN_OR_RETURN(auto input, CreateYuvBuffer(buffer));
   MP_ASSIGN_OR_RETURN(auto output, CreateYuvBuffer(*output_buffer));
   return input.Rotate(angle_deg % 360, &output)
@@ -491,12 +623,25 @@ absl::Status ConvertYuv(const FrameBuffer& buffer, FrameBuffer* output_buffer) {
   MP_ASSIGN_OR_RETURN(auto input, CreateYuvBuffer(buffer));
   if (output_buffer->format() == FrameBuffer::Format::kRGBA ||
       output_buffer->format() == FrameBuffer::Format::kRGB) {
-    MP_ASSIGN_OR_RETURN(auto output, CreateRgbBuffer(*output_buffer));
     bool half_sampling = false;
     if (buffer.dimension().width / 2 == output_buffer->dimension().width &&
         buffer.dimension().height / 2 == output_buffer->dimension().height) {
       half_sampling = true;
     }
+    if (half_sampling || AreBufferDimsEqual(buffer, *output_buffer)) {
+      MP_ASSIGN_OR_RETURN(FrameBuffer::YuvData yuv_data,
+                          FrameBuffer::GetYuvDataFromFrameBuffer(buffer));
+      MP_ASSIGN_OR_RETURN(simd::Plane output,
+                          GetInterleavedPlane(*output_buffer));
+      simd::GetKernels().yuv_to_rgb(
+          {yuv_data.y_buffer, yuv_data.u_buffer, yuv_data.v_buffer,
+           buffer.dimension().width, buffer.dimension().height,
+           yuv_data.y_row_stride, yuv_data.uv_row_stride,
+           yuv_data.uv_pixel_stride},
+          half_sampling, output);
+      return absl::OkStatus();
+    }
+    MP_ASSIGN_OR_RETURN(auto output, CreateRgbBuffer(*output_buffer));
     success_convert = input.Convert(half_sampling, &output);
   } else if (output_buffer->format() == FrameBuffer::Format::kGRAY) {
     if (buffer.plane(0).stride().row_stride_bytes == buffer.dimension().width) {
@@ -0,0 +1,29 @@
+"""Compiler options for the per instruction set frame buffer kernels."""
+
+# x86-64 configurations built with GCC or Clang.
+_X86_64_CONFIGS = [
+    "//mediapipe:android_x86_64",
+    "//mediapipe:ios_x86_64",
+    "//mediapipe:linux",
+    "//mediapipe:macos_x86_64",
+]
+
+def simd_kernel_copts(x86_64_copts = [], msvc_copts = []):
+    """Returns the copts of a kernel library targeting one instruction set.
+
+    The kernels are written as plain loops and rely on the auto-vectorizer,
+    so they are always built with full optimization.
+
+    Args:
+      x86_64_copts: flags enabling the instruction set with GCC or Clang on
+        x86-64, e.g. ["-mavx2"].
+      msvc_copts: flags enabling the instruction set with MSVC, e.g.
+        ["/arch:AVX2"].
+
+    Returns:
+      A select() over the supported platforms.
+    """
+    copts = {config: ["-O3"] + x86_64_copts for config in _X86_64_CONFIGS}
+    copts["//mediapipe:windows"] = ["/O2"] + msvc_copts
+    copts["//conditions:default"] = ["-O3"]
+    return select(copts)
@@ -0,0 +1,181 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/frame_buffer/simd/kernels.h"
+
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/util/frame_buffer/simd/kernels_impl.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define MEDIAPIPE_FRAME_BUFFER_SIMD_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace mediapipe {
+namespace frame_buffer {
+namespace simd {
+
+namespace {
+
+#ifdef MEDIAPIPE_FRAME_BUFFER_SIMD_X86
+
+struct X86Features {
+  bool sse4 = false;
+  bool avx2 = false;
+  bool avx512 = false;
+};
+
+void Cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#if defined(_MSC_VER)
+  int values[4];
+  __cpuidex(values, leaf, subleaf);
+  for (int i = 0; i < 4; ++i) registers[i] = static_cast<uint32_t>(values[i]);
+#else
+  __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2],
+                registers[3]);
+#endif
+}
+
+// Returns the register state enabled by the OS (XCR0).
+uint64_t GetEnabledXState() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+X86Features DetectX86Features() {
+  // Register indices and feature bits, see the Intel SDM, CPUID instruction.
+  constexpr int kEbx = 1, kEcx = 2;
+  constexpr uint32_t kSse41Bit = 1u << 19;
+  constexpr uint32_t kOsxsaveBit = 1u << 27;
+  constexpr uint32_t kAvxBit = 1u << 28;
+  constexpr uint32_t kAvx2Bit = 1u << 5;
+  constexpr uint32_t kAvx512FBit = 1u << 16;
+  constexpr uint32_t kAvx512BwBit = 1u << 30;
+  // XMM and YMM state; additionally opmask and ZMM state for AVX-512.
+  constexpr uint64_t kAvxXState = 0x6;
+  constexpr uint64_t kAvx512XState = 0xE6;
+
+  X86Features features;
+  uint32_t registers[4];
+  Cpuid(0, 0, registers);
+  const uint32_t max_leaf = registers[0];
+  if (max_leaf < 1) return features;
+
+  Cpuid(1, 0, registers);
+  features.sse4 = registers[kEcx] & kSse41Bit;
+  const bool avx_enabled_by_os =
+      (registers[kEcx] & kOsxsaveBit) && (registers[kEcx] & kAvxBit) &&
+      (GetEnabledXState() & kAvxXState) == kAvxXState;
+  if (!avx_enabled_by_os || max_leaf < 7) return features;
+
+  Cpuid(7, 0, registers);
+  features.avx2 = registers[kEbx] & kAvx2Bit;
+  features.avx512 = features.avx2 && (registers[kEbx] & kAvx512FBit) &&
+                    (registers[kEbx] & kAvx512BwBit) &&
+                    (GetEnabledXState() & kAvx512XState) == kAvx512XState;
+  return features;
+}
+
+#endif  // MEDIAPIPE_FRAME_BUFFER_SIMD_X86
+
+bool IsSupportedByCpu(Isa isa) {
+  switch (isa) {
+    case Isa::kGeneric:
+      return true;
+#ifdef MEDIAPIPE_FRAME_BUFFER_SIMD_X86
+    case Isa::kSse4:
+    case Isa::kAvx2:
+    case Isa::kAvx512: {
+      static const X86Features features = DetectX86Features();
+      return isa == Isa::kSse4   ? features.sse4
+             : isa == Isa::kAvx2 ? features.avx2
+                                 : features.avx512;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+const Kernels* GetCompiledKernels(Isa isa) {
+  switch (isa) {
+    case Isa::kGeneric:
+      return GetGenericKernels();
+    case Isa::kSse4:
+      return GetSse4Kernels();
+    case Isa::kAvx2:
+      return GetAvx2Kernels();
+    case Isa::kAvx512:
+      return GetAvx512Kernels();
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+absl::string_view IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kGeneric:
+      return "generic";
+    case Isa::kSse4:
+      return "sse4";
+    case Isa::kAvx2:
+      return "avx2";
+    case Isa::kAvx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+bool IsIsaSupported(Isa isa) {
+  return GetCompiledKernels(isa) != nullptr && IsSupportedByCpu(isa);
+}
+
+Isa GetBestIsa() {
+  static const Isa best_isa = [] {
+    for (Isa isa : {Isa::kAvx512, Isa::kAvx2, Isa::kSse4}) {
+      if (IsIsaSupported(isa)) return isa;
+    }
+    return Isa::kGeneric;
+  }();
+  return best_isa;
+}
+
+const Kernels& GetKernels(Isa isa) {
+  ABSL_CHECK(IsIsaSupported(isa))
+      << "Unsupported instruction set: " << IsaName(isa);
+  return *GetCompiledKernels(isa);
+}
+
+const Kernels& GetKernels() {
+  static const Kernels& kernels = GetKernels(GetBestIsa());
+  return kernels;
+}
+
+}  // namespace simd
+}  // namespace frame_buffer
+}  // namespace mediapipe
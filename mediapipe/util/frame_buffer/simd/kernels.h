@@ -0,0 +1,111 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_FRAME_BUFFER_SIMD_KERNELS_H_
+#define MEDIAPIPE_UTIL_FRAME_BUFFER_SIMD_KERNELS_H_
+
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+namespace mediapipe {
+namespace frame_buffer {
+namespace simd {
+
+// Instruction sets the frame buffer kernels are compiled for.
+//
+// Each kernel is compiled once per instruction set and the best one supported
+// by the running CPU is selected at runtime, so a single binary runs on any
+// CPU of its architecture. kGeneric uses the baseline instruction set of the
+// target (e.g. SSE2 on x86-64, NEON on arm64) and is always available. arm64
+// has no variant of its own, as NEON is already part of its baseline.
+enum class Isa {
+  kGeneric = 0,
+  kSse4 = 1,
+  kAvx2 = 2,
+  kAvx512 = 3,
+};
+
+// Returns the name of the instruction set, e.g. "avx2".
+absl::string_view IsaName(Isa isa);
+
+// Returns whether the kernels for `isa` are compiled into this binary and are
+// supported by the running CPU.
+bool IsIsaSupported(Isa isa);
+
+// Returns the best instruction set supported by this binary and the running
+// CPU.
+Isa GetBestIsa();
+
+// A view over an interleaved 8-bit image plane, e.g. RGB, RGBA, gray or the
+// interleaved UV plane of NV12/NV21. Pixels are tightly packed within a row;
+// rows are `row_stride` bytes apart.
+struct Plane {
+  uint8_t* data;
+  int width;
+  int height;
+  int row_stride;
+  // Number of interleaved channels, i.e. bytes per pixel.
+  int channels;
+};
+
+// A view over a YUV 4:2:0 image. Covers NV12/NV21 (semi-planar, uv pixel
+// stride 2) and I420/YV12 (planar, uv pixel stride 1).
+struct YuvPlanes {
+  const uint8_t* y;
+  const uint8_t* u;
+  const uint8_t* v;
+  int width;
+  int height;
+  int y_row_stride;
+  int uv_row_stride;
+  int uv_pixel_stride;
+};
+
+// The kernels compiled for one instruction set. The results are identical
+// across instruction sets and match the Halide implementations in
+// mediapipe/util/frame_buffer/halide.
+struct Kernels {
+  Isa isa;
+
+  // Converts `src` to RGB or RGBA (`dst.channels` 3 or 4, alpha set to 255)
+  // using the full-range JFIF coefficients. When `halve` is true, `dst` has
+  // half the dimensions of `src` and every other luminance value is skipped.
+  void (*yuv_to_rgb)(const YuvPlanes& src, bool halve, const Plane& dst);
+
+  // Resizes `src` into `dst` with bilinear interpolation, where source
+  // coordinates are output coordinates multiplied by `scale_x` and `scale_y`.
+  // Both planes must have the same number of channels.
+  void (*resize_bilinear)(const Plane& src, float scale_x, float scale_y,
+                          const Plane& dst);
+
+  // Rotates `src` counter-clockwise by `angle` degrees (0, 90, 180 or 270)
+  // into `dst`. Both planes must have the same number of channels.
+  void (*rotate)(const Plane& src, int angle, const Plane& dst);
+
+  // Writes `src * scale + offset` as tightly packed floats into `dst`.
+  void (*to_float)(const Plane& src, float scale, float offset, float* dst);
+};
+
+// Returns the kernels for `isa`, which must be supported.
+const Kernels& GetKernels(Isa isa);
+
+// Returns the kernels for GetBestIsa().
+const Kernels& GetKernels();
+
+}  // namespace simd
+}  // namespace frame_buffer
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_FRAME_BUFFER_SIMD_KERNELS_H_
@@ -0,0 +1,332 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for the frame buffer SIMD kernels against the Halide and OpenCV
+// implementations of the same operations.
+//
+// Kernel benchmarks take the instruction set and the input resolution as
+// arguments, Halide and OpenCV benchmarks the input resolution only. Only the
+// instruction sets supported by the running CPU are registered.
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/util/frame_buffer/float_buffer.h"
+#include "mediapipe/util/frame_buffer/rgb_buffer.h"
+#include "mediapipe/util/frame_buffer/simd/kernels.h"
+#include "mediapipe/util/frame_buffer/yuv_buffer.h"
+
+namespace mediapipe {
+namespace frame_buffer {
+namespace simd {
+namespace {
+
+struct Resolution {
+  int width;
+  int height;
+};
+
+// VGA, 720p and 1080p camera frames.
+constexpr Resolution kResolutions[] = {{640, 480}, {1280, 720}, {1920, 1080}};
+constexpr int kNumResolutions = sizeof(kResolutions) / sizeof(kResolutions[0]);
+
+// Resize benchmarks downscale to a typical model input size.
+constexpr int kResizedSize = 256;
+
+// Float conversion maps [0, 255] to [-1, 1].
+constexpr float kScale = 2.0f / 255.0f;
+constexpr float kOffset = -1.0f;
+
+std::vector<uint8_t> RandomBytes(int size) {
+  std::mt19937 rng(0 /*seed*/);
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) byte = dist(rng);
+  return bytes;
+}
+
+// Returns the size of an NV21 image, which is also used for I420 benchmarks.
+int YuvSize(const Resolution& resolution) {
+  return YuvBuffer::ByteSize(resolution.width, resolution.height);
+}
+
+void SetPixelsProcessed(benchmark::State& state,
+                        const Resolution& resolution) {
+  state.SetItemsProcessed(state.iterations() * resolution.width *
+                          resolution.height);
+}
+
+// Registers the supported instruction sets times the resolutions.
+void SimdArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"isa", "resolution"});
+  for (Isa isa : {Isa::kGeneric, Isa::kSse4, Isa::kAvx2, Isa::kAvx512}) {
+    if (!IsIsaSupported(isa)) continue;
+    for (int i = 0; i < kNumResolutions; ++i) {
+      benchmark->Args({static_cast<int>(isa), i});
+    }
+  }
+}
+
+// Registers the resolutions.
+void ResolutionArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("resolution")->DenseRange(0, kNumResolutions - 1);
+}
+
+const Kernels& GetBenchmarkKernels(benchmark::State& state) {
+  const Isa isa = static_cast<Isa>(state.range(0));
+  state.SetLabel(std::string(IsaName(isa)));
+  return GetKernels(isa);
+}
+
+// YUV to RGB.
+
+void BM_SimdNv21ToRgb(benchmark::State& state) {
+  const Kernels& kernels = GetBenchmarkKernels(state);
+  const Resolution resolution = kResolutions[state.range(1)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(YuvSize(resolution));
+  std::vector<uint8_t> output(width * height * 3);
+  const uint8_t* vu = input.data() + width * height;
+  const YuvPlanes planes = {input.data(), /*u=*/vu + 1, /*v=*/vu,
+                            width,        height,       width,
+                            width,        /*uv_pixel_stride=*/2};
+  const Plane output_plane = {output.data(), width, height, width * 3, 3};
+  for (auto _ : state) {
+    kernels.yuv_to_rgb(planes, /*halve=*/false, output_plane);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_SimdNv21ToRgb)->Apply(SimdArgs);
+
+void BM_SimdI420ToRgb(benchmark::State& state) {
+  const Kernels& kernels = GetBenchmarkKernels(state);
+  const Resolution resolution = kResolutions[state.range(1)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(YuvSize(resolution));
+  std::vector<uint8_t> output(width * height * 3);
+  const uint8_t* u = input.data() + width * height;
+  const uint8_t* v = u + (width / 2) * (height / 2);
+  const YuvPlanes planes = {input.data(), u,         v,
+                            width,        height,    width,
+                            width / 2,    /*uv_pixel_stride=*/1};
+  const Plane output_plane = {output.data(), width, height, width * 3, 3};
+  for (auto _ : state) {
+    kernels.yuv_to_rgb(planes, /*halve=*/false, output_plane);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_SimdI420ToRgb)->Apply(SimdArgs);
+
+void BM_HalideNv21ToRgb(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(YuvSize(resolution));
+  std::vector<uint8_t> output(width * height * 3);
+  YuvBuffer input_buffer(input.data(), width, height, YuvBuffer::NV21);
+  RgbBuffer output_buffer(output.data(), width, height, /*alpha=*/false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        input_buffer.Convert(/*halve=*/false, &output_buffer));
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_HalideNv21ToRgb)->Apply(ResolutionArgs);
+
+void BM_OpenCvNv21ToRgb(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(YuvSize(resolution));
+  std::vector<uint8_t> output(width * height * 3);
+  const cv::Mat input_mat(height * 3 / 2, width, CV_8UC1, input.data());
+  cv::Mat output_mat(height, width, CV_8UC3, output.data());
+  for (auto _ : state) {
+    cv::cvtColor(input_mat, output_mat, cv::COLOR_YUV2RGB_NV21);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_OpenCvNv21ToRgb)->Apply(ResolutionArgs);
+
+// Bilinear RGB resize.
+
+void BM_SimdResizeRgb(benchmark::State& state) {
+  const Kernels& kernels = GetBenchmarkKernels(state);
+  const Resolution resolution = kResolutions[state.range(1)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<uint8_t> output(kResizedSize * kResizedSize * 3);
+  const Plane input_plane = {input.data(), width, height, width * 3, 3};
+  const Plane output_plane = {output.data(), kResizedSize, kResizedSize,
+                              kResizedSize * 3, 3};
+  const float scale_x = static_cast<float>(width) / kResizedSize;
+  const float scale_y = static_cast<float>(height) / kResizedSize;
+  for (auto _ : state) {
+    kernels.resize_bilinear(input_plane, scale_x, scale_y, output_plane);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_SimdResizeRgb)->Apply(SimdArgs);
+
+void BM_HalideResizeRgb(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<uint8_t> output(kResizedSize * kResizedSize * 3);
+  RgbBuffer input_buffer(input.data(), width, height, /*alpha=*/false);
+  RgbBuffer output_buffer(output.data(), kResizedSize, kResizedSize,
+                          /*alpha=*/false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(input_buffer.Resize(&output_buffer));
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_HalideResizeRgb)->Apply(ResolutionArgs);
+
+void BM_OpenCvResizeRgb(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<uint8_t> output(kResizedSize * kResizedSize * 3);
+  const cv::Mat input_mat(height, width, CV_8UC3, input.data());
+  cv::Mat output_mat(kResizedSize, kResizedSize, CV_8UC3, output.data());
+  for (auto _ : state) {
+    cv::resize(input_mat, output_mat, output_mat.size(), 0, 0,
+               cv::INTER_LINEAR);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_OpenCvResizeRgb)->Apply(ResolutionArgs);
+
+// RGB rotation by 90 degrees.
+
+void BM_SimdRotateRgb(benchmark::State& state) {
+  const Kernels& kernels = GetBenchmarkKernels(state);
+  const Resolution resolution = kResolutions[state.range(1)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<uint8_t> output(width * height * 3);
+  const Plane input_plane = {input.data(), width, height, width * 3, 3};
+  const Plane output_plane = {output.data(), height, width, height * 3, 3};
+  for (auto _ : state) {
+    kernels.rotate(input_plane, 90, output_plane);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_SimdRotateRgb)->Apply(SimdArgs);
+
+void BM_HalideRotateRgb(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<uint8_t> output(width * height * 3);
+  RgbBuffer input_buffer(input.data(), width, height, /*alpha=*/false);
+  RgbBuffer output_buffer(output.data(), height, width, /*alpha=*/false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(input_buffer.Rotate(90, &output_buffer));
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_HalideRotateRgb)->Apply(ResolutionArgs);
+
+void BM_OpenCvRotateRgb(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<uint8_t> output(width * height * 3);
+  const cv::Mat input_mat(height, width, CV_8UC3, input.data());
+  cv::Mat output_mat(width, height, CV_8UC3, output.data());
+  for (auto _ : state) {
+    cv::rotate(input_mat, output_mat, cv::ROTATE_90_COUNTERCLOCKWISE);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_OpenCvRotateRgb)->Apply(ResolutionArgs);
+
+// RGB to normalized float.
+
+void BM_SimdRgbToFloat(benchmark::State& state) {
+  const Kernels& kernels = GetBenchmarkKernels(state);
+  const Resolution resolution = kResolutions[state.range(1)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<float> output(width * height * 3);
+  const Plane input_plane = {input.data(), width, height, width * 3, 3};
+  for (auto _ : state) {
+    kernels.to_float(input_plane, kScale, kOffset, output.data());
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_SimdRgbToFloat)->Apply(SimdArgs);
+
+void BM_HalideRgbToFloat(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<float> output(width * height * 3);
+  RgbBuffer input_buffer(input.data(), width, height, /*alpha=*/false);
+  FloatBuffer output_buffer(output.data(), width, height, /*channels=*/3);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        input_buffer.ToFloat(kScale, kOffset, &output_buffer));
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_HalideRgbToFloat)->Apply(ResolutionArgs);
+
+void BM_OpenCvRgbToFloat(benchmark::State& state) {
+  const Resolution resolution = kResolutions[state.range(0)];
+  const int width = resolution.width;
+  const int height = resolution.height;
+  std::vector<uint8_t> input = RandomBytes(width * height * 3);
+  std::vector<float> output(width * height * 3);
+  const cv::Mat input_mat(height, width, CV_8UC3, input.data());
+  cv::Mat output_mat(height, width, CV_32FC3, output.data());
+  for (auto _ : state) {
+    input_mat.convertTo(output_mat, CV_32FC3, kScale, kOffset);
+    benchmark::ClobberMemory();
+  }
+  SetPixelsProcessed(state, resolution);
+}
+BENCHMARK(BM_OpenCvRgbToFloat)->Apply(ResolutionArgs);
+
+}  // namespace
+}  // namespace simd
+}  // namespace frame_buffer
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -0,0 +1,30 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Frame buffer kernels compiled for the baseline instruction set.
+
+#include "mediapipe/util/frame_buffer/simd/kernels.h"
+#include "mediapipe/util/frame_buffer/simd/kernels_impl.h"
+
+namespace mediapipe {
+namespace frame_buffer {
+namespace simd {
+
+const Kernels* GetGenericKernels() {
+  return &KernelsImpl<Isa::kGeneric>::Get();
+}
+
+}  // namespace simd
+}  // namespace frame_buffer
+}  // namespace mediapipe
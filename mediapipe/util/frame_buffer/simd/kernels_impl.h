@@ -0,0 +1,449 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Portable implementation of the frame buffer kernels.
+//
+// This header is included by one translation unit per instruction set, each
+// compiled with the matching target flags (e.g. -mavx2). The kernels are
+// written so that the compiler vectorizes them for that target: inner loops
+// run over small fixed-size blocks of contiguous, non-aliasing arrays and the
+// work that does not vectorize (gathers, interleaving) is split out of them.
+//
+// Everything here is a member of KernelsImpl<kIsa> so that every translation
+// unit gets its own instantiations. Do not call non-inlined helpers with
+// external linkage (including std:: function templates) from this file: the
+// linker may pick a copy compiled for a different instruction set.
+
+#ifndef MEDIAPIPE_UTIL_FRAME_BUFFER_SIMD_KERNELS_IMPL_H_
+#define MEDIAPIPE_UTIL_FRAME_BUFFER_SIMD_KERNELS_IMPL_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "mediapipe/util/frame_buffer/simd/kernels.h"
+
+namespace mediapipe {
+namespace frame_buffer {
+namespace simd {
+
+template <Isa kIsa>
+class KernelsImpl {
+ public:
+  static const Kernels& Get() {
+    static const Kernels kernels = {
+        /*isa=*/kIsa,
+        /*yuv_to_rgb=*/&YuvToRgb,
+        /*resize_bilinear=*/&ResizeBilinear,
+        /*rotate=*/&Rotate,
+        /*to_float=*/&ToFloat,
+    };
+    return kernels;
+  }
+
+ private:
+  // Number of pixels processed per block. Large enough to fill the widest
+  // vectors several times, small enough for the scratch rows to stay in L1.
+  static constexpr int kBlockSize = 256;
+
+  static inline uint8_t ClampToUint8(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+  }
+
+  static inline int Min(int a, int b) { return a < b ? a : b; }
+
+  // YUV to RGB.
+  //----------------------------------------------------------------------------
+
+  // Integer math versions of the full-range JFIF YUV-RGB coefficients,
+  // identical to halide/yuv_rgb_generator.cc:
+  //   R = Y' + 1.40200*(V-128)
+  //   G = Y' - 0.34414*(U-128) - 0.71414*(V-128)
+  //   B = Y' + 1.77200*(U-128)
+  // The chroma terms are computed once per chroma sample and fit in int16.
+  template <int kUvPixelStride>
+  static inline void ChromaTerms(const uint8_t* __restrict u,
+                                 const uint8_t* __restrict v, int count,
+                                 int16_t* __restrict r_term,
+                                 int16_t* __restrict g_term,
+                                 int16_t* __restrict b_term) {
+    for (int i = 0; i < count; ++i) {
+      const int32_t uc = static_cast<int32_t>(u[i * kUvPixelStride]) - 128;
+      const int32_t vc = static_cast<int32_t>(v[i * kUvPixelStride]) - 128;
+      r_term[i] = static_cast<int16_t>((91881 * vc + 32768) >> 16);
+      g_term[i] =
+          static_cast<int16_t>(-((22544 * uc + 46802 * vc + 32768) >> 16));
+      b_term[i] = static_cast<int16_t>((116130 * uc + 32768) >> 16);
+    }
+  }
+
+  // Interleaves planar R, G, B rows into RGB or RGBA.
+  template <int kChannels>
+  static inline void Interleave(const uint8_t* __restrict r,
+                                const uint8_t* __restrict g,
+                                const uint8_t* __restrict b, int count,
+                                uint8_t* __restrict dst) {
+    for (int i = 0; i < count; ++i) {
+      dst[i * kChannels + 0] = r[i];
+      dst[i * kChannels + 1] = g[i];
+      dst[i * kChannels + 2] = b[i];
+      if (kChannels == 4) dst[i * kChannels + 3] = 255;
+    }
+  }
+
+  // Converts one row. Output pixel x uses luminance y[x * kYStep] and chroma
+  // sample x / kPixelsPerChroma.
+  template <int kUvPixelStride, int kChannels, bool kHalve>
+  static void YuvToRgbRow(const uint8_t* __restrict y,
+                          const uint8_t* __restrict u,
+                          const uint8_t* __restrict v, int width,
+                          uint8_t* __restrict dst) {
+    constexpr int kYStep = kHalve ? 2 : 1;
+    constexpr int kPixelsPerChroma = kHalve ? 1 : 2;
+    int16_t r_term[kBlockSize], g_term[kBlockSize], b_term[kBlockSize];
+    uint8_t r[kBlockSize], g[kBlockSize], b[kBlockSize];
+    for (int x0 = 0; x0 < width; x0 += kBlockSize) {
+      const int count = Min(kBlockSize, width - x0);
+      const int chroma_count =
+          (count + kPixelsPerChroma - 1) / kPixelsPerChroma;
+      const int c0 = x0 / kPixelsPerChroma;
+      ChromaTerms<kUvPixelStride>(u + c0 * kUvPixelStride,
+                                  v + c0 * kUvPixelStride, chroma_count,
+                                  r_term, g_term, b_term);
+      const uint8_t* __restrict y_block = y + x0 * kYStep;
+      if (kHalve) {
+        for (int i = 0; i < count; ++i) {
+          const int luma = y_block[i * kYStep];
+          r[i] = ClampToUint8(luma + r_term[i]);
+          g[i] = ClampToUint8(luma + g_term[i]);
+          b[i] = ClampToUint8(luma + b_term[i]);
+        }
+      } else {
+        // Two luminance values share each chroma sample. The trailing odd
+        // pixel, if any, is handled below.
+        const int pairs = count / 2;
+        for (int i = 0; i < pairs; ++i) {
+          const int luma0 = y_block[2 * i];
+          const int luma1 = y_block[2 * i + 1];
+          r[2 * i] = ClampToUint8(luma0 + r_term[i]);
+          r[2 * i + 1] = ClampToUint8(luma1 + r_term[i]);
+          g[2 * i] = ClampToUint8(luma0 + g_term[i]);
+          g[2 * i + 1] = ClampToUint8(luma1 + g_term[i]);
+          b[2 * i] = ClampToUint8(luma0 + b_term[i]);
+          b[2 * i + 1] = ClampToUint8(luma1 + b_term[i]);
+        }
+        if (count & 1) {
+          const int luma = y_block[count - 1];
+          r[count - 1] = ClampToUint8(luma + r_term[pairs]);
+          g[count - 1] = ClampToUint8(luma + g_term[pairs]);
+          b[count - 1] = ClampToUint8(luma + b_term[pairs]);
+        }
+      }
+      Interleave<kChannels>(r, g, b, count, dst + x0 * kChannels);
+    }
+  }
+
+  template <int kUvPixelStride, int kChannels, bool kHalve>
+  static void YuvToRgbImage(const YuvPlanes& src, const Plane& dst) {
+    constexpr int kYStep = kHalve ? 2 : 1;
+    for (int row = 0; row < dst.height; ++row) {
+      const int uv_row = kHalve ? row : row / 2;
+      YuvToRgbRow<kUvPixelStride, kChannels, kHalve>(
+          src.y + row * kYStep * src.y_row_stride,
+          src.u + uv_row * src.uv_row_stride,
+          src.v + uv_row * src.uv_row_stride, dst.width,
+          dst.data + row * dst.row_stride);
+    }
+  }
+
+  // Converts rows with an arbitrary chroma pixel stride.
+  template <int kChannels, bool kHalve>
+  static void YuvToRgbImageStrided(const YuvPlanes& src, const Plane& dst) {
+    constexpr int kYStep = kHalve ? 2 : 1;
+    constexpr int kPixelsPerChroma = kHalve ? 1 : 2;
+    for (int row = 0; row < dst.height; ++row) {
+      const int uv_row = kHalve ? row : row / 2;
+      const uint8_t* y = src.y + row * kYStep * src.y_row_stride;
+      const uint8_t* u = src.u + uv_row * src.uv_row_stride;
+      const uint8_t* v = src.v + uv_row * src.uv_row_stride;
+      uint8_t* out = dst.data + row * dst.row_stride;
+      for (int x = 0; x < dst.width; ++x) {
+        const int c = (x / kPixelsPerChroma) * src.uv_pixel_stride;
+        int16_t r_term, g_term, b_term;
+        ChromaTerms<1>(u + c, v + c, 1, &r_term, &g_term, &b_term);
+        const int luma = y[x * kYStep];
+        out[x * kChannels + 0] = ClampToUint8(luma + r_term);
+        out[x * kChannels + 1] = ClampToUint8(luma + g_term);
+        out[x * kChannels + 2] = ClampToUint8(luma + b_term);
+        if (kChannels == 4) out[x * kChannels + 3] = 255;
+      }
+    }
+  }
+
+  template <int kChannels, bool kHalve>
+  static void YuvToRgbDispatch(const YuvPlanes& src, const Plane& dst) {
+    switch (src.uv_pixel_stride) {
+      case 1:
+        YuvToRgbImage<1, kChannels, kHalve>(src, dst);
+        break;
+      case 2:
+        YuvToRgbImage<2, kChannels, kHalve>(src, dst);
+        break;
+      default:
+        YuvToRgbImageStrided<kChannels, kHalve>(src, dst);
+        break;
+    }
+  }
+
+  static void YuvToRgb(const YuvPlanes& src, bool halve, const Plane& dst) {
+    if (dst.channels == 4) {
+      halve ? YuvToRgbDispatch<4, true>(src, dst)
+            : YuvToRgbDispatch<4, false>(src, dst);
+    } else {
+      halve ? YuvToRgbDispatch<3, true>(src, dst)
+            : YuvToRgbDispatch<3, false>(src, dst);
+    }
+  }
+
+  // Bilinear resize.
+  //----------------------------------------------------------------------------
+
+  // Interpolates between `a` and `b` with an 8-bit weight in [0, 256),
+  // rounding to nearest with ties towards `a`. This reproduces the results of
+  // halide/common.cc resize_bilinear_int, whose 16.16 fixed-point weights only
+  // affect the result through their top 8 bits, while keeping the arithmetic
+  // in 16 bits.
+  static inline uint8_t Lerp(uint32_t a, uint32_t b, uint32_t weight) {
+    return static_cast<uint8_t>((a * (256 - weight) + b * weight + 127) >> 8);
+  }
+
+  // Source index and 8-bit weight of each output coordinate, following the
+  // 16.16 fixed-point math of resize_bilinear_int, with the second index
+  // clamped to the edge like Halide's repeat_edge.
+  static void ComputeTaps(int dst_size, int src_size, float scale, int* index0,
+                          int* index1, uint8_t* weight) {
+    const int step = static_cast<int>(scale * 65536);
+    for (int i = 0; i < dst_size; ++i) {
+      const int position = i * step;
+      const int index = Min(position / 65536, src_size - 1);
+      index0[i] = index;
+      index1[i] = Min(index + 1, src_size - 1);
+      weight[i] = static_cast<uint8_t>((position % 65536) >> 8);
+    }
+  }
+
+  template <int kChannels>
+  static void ResizeRowHorizontally(const uint8_t* __restrict src,
+                                    const int* __restrict index0,
+                                    const int* __restrict index1,
+                                    const uint8_t* __restrict weight,
+                                    int width, uint8_t* __restrict dst) {
+    for (int x = 0; x < width; ++x) {
+      const uint8_t* p0 = src + index0[x] * kChannels;
+      const uint8_t* p1 = src + index1[x] * kChannels;
+      for (int c = 0; c < kChannels; ++c) {
+        dst[x * kChannels + c] = Lerp(p0[c], p1[c], weight[x]);
+      }
+    }
+  }
+
+  static void ResizeRowVertically(const uint8_t* __restrict row0,
+                                  const uint8_t* __restrict row1,
+                                  uint32_t weight, int count,
+                                  uint8_t* __restrict dst) {
+    const uint16_t w1 = static_cast<uint16_t>(weight);
+    const uint16_t w0 = static_cast<uint16_t>(256 - weight);
+    for (int i = 0; i < count; ++i) {
+      const uint16_t sum = row0[i] * w0 + row1[i] * w1 + 127;
+      dst[i] = static_cast<uint8_t>(sum >> 8);
+    }
+  }
+
+  template <int kChannels>
+  static void ResizeBilinearImpl(const Plane& src, float scale_x,
+                                 float scale_y, const Plane& dst) {
+    const int row_size = dst.width * kChannels;
+    int* taps = new int[2 * dst.width + 2 * dst.height];
+    int* x_index0 = taps;
+    int* x_index1 = x_index0 + dst.width;
+    int* y_index0 = x_index1 + dst.width;
+    int* y_index1 = y_index0 + dst.height;
+    // Two horizontally resized rows, followed by the horizontal and vertical
+    // weights.
+    uint8_t* scratch = new uint8_t[2 * row_size + dst.width + dst.height];
+    uint8_t* rows[2] = {scratch, scratch + row_size};
+    uint8_t* x_weight = scratch + 2 * row_size;
+    uint8_t* y_weight = x_weight + dst.width;
+    ComputeTaps(dst.width, src.width, scale_x, x_index0, x_index1, x_weight);
+    ComputeTaps(dst.height, src.height, scale_y, y_index0, y_index1, y_weight);
+    // Source row held by each of `rows`.
+    int cached_rows[2] = {-1, -1};
+
+    // Returns the horizontally resized source row, reusing a cached one when
+    // consecutive output rows sample the same source rows (upscaling).
+    auto get_row = [&](int src_row, int avoid_slot) -> const uint8_t* {
+      for (int slot = 0; slot < 2; ++slot) {
+        if (cached_rows[slot] == src_row) return rows[slot];
+      }
+      const int slot = avoid_slot == 0 ? 1 : 0;
+      ResizeRowHorizontally<kChannels>(src.data + src_row * src.row_stride,
+                                       x_index0, x_index1, x_weight, dst.width,
+                                       rows[slot]);
+      cached_rows[slot] = src_row;
+      return rows[slot];
+    };
+
+    for (int y = 0; y < dst.height; ++y) {
+      const uint8_t* row0 = get_row(y_index0[y], /*avoid_slot=*/-1);
+      const int slot0 = row0 == rows[0] ? 0 : 1;
+      const uint8_t* row1 = get_row(y_index1[y], slot0);
+      ResizeRowVertically(row0, row1, y_weight[y], row_size,
+                          dst.data + y * dst.row_stride);
+    }
+    delete[] scratch;
+    delete[] taps;
+  }
+
+  static void ResizeBilinear(const Plane& src, float scale_x, float scale_y,
+                             const Plane& dst) {
+    switch (dst.channels) {
+      case 1:
+        return ResizeBilinearImpl<1>(src, scale_x, scale_y, dst);
+      case 2:
+        return ResizeBilinearImpl<2>(src, scale_x, scale_y, dst);
+      case 3:
+        return ResizeBilinearImpl<3>(src, scale_x, scale_y, dst);
+      case 4:
+        return ResizeBilinearImpl<4>(src, scale_x, scale_y, dst);
+    }
+  }
+
+  // Rotation.
+  //----------------------------------------------------------------------------
+
+  // Side of the square tiles 90 and 270 degree rotations are processed in, so
+  // that both the source rows and destination rows of a tile stay in cache.
+  static constexpr int kTileSize = 32;
+
+  template <int kChannels>
+  static inline void CopyPixel(const uint8_t* __restrict src,
+                               uint8_t* __restrict dst) {
+    for (int c = 0; c < kChannels; ++c) dst[c] = src[c];
+  }
+
+  // Rotates by 90 (kClockwise = false) or 270 degrees. Output pixel (x, y)
+  // is source pixel (width - 1 - y, x) for 90 degrees and
+  // (y, height - 1 - x) for 270 degrees, as in halide/common.cc rotate().
+  template <int kChannels, bool kClockwise>
+  static void RotateQuarter(const Plane& src, const Plane& dst) {
+    for (int y0 = 0; y0 < dst.height; y0 += kTileSize) {
+      const int y1 = Min(y0 + kTileSize, dst.height);
+      for (int x0 = 0; x0 < dst.width; x0 += kTileSize) {
+        const int x1 = Min(x0 + kTileSize, dst.width);
+        for (int y = y0; y < y1; ++y) {
+          uint8_t* __restrict out = dst.data + y * dst.row_stride;
+          if (kClockwise) {
+            // Walks up source column y.
+            const uint8_t* in = src.data + y * kChannels;
+            for (int x = x0; x < x1; ++x) {
+              CopyPixel<kChannels>(
+                  in + (src.height - 1 - x) * src.row_stride,
+                  out + x * kChannels);
+            }
+          } else {
+            // Walks down source column width - 1 - y.
+            const uint8_t* in = src.data + (src.width - 1 - y) * kChannels;
+            for (int x = x0; x < x1; ++x) {
+              CopyPixel<kChannels>(in + x * src.row_stride,
+                                   out + x * kChannels);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  template <int kChannels>
+  static void RotateHalf(const Plane& src, const Plane& dst) {
+    for (int y = 0; y < dst.height; ++y) {
+      const uint8_t* __restrict in =
+          src.data + (src.height - 1 - y) * src.row_stride +
+          (src.width - 1) * kChannels;
+      uint8_t* __restrict out = dst.data + y * dst.row_stride;
+      for (int x = 0; x < dst.width; ++x) {
+        CopyPixel<kChannels>(in - x * kChannels, out + x * kChannels);
+      }
+    }
+  }
+
+  template <int kChannels>
+  static void RotateImpl(const Plane& src, int angle, const Plane& dst) {
+    switch (angle) {
+      case 90:
+        return RotateQuarter<kChannels, false>(src, dst);
+      case 180:
+        return RotateHalf<kChannels>(src, dst);
+      case 270:
+        return RotateQuarter<kChannels, true>(src, dst);
+      default:
+        for (int y = 0; y < dst.height; ++y) {
+          std::memcpy(dst.data + y * dst.row_stride,
+                      src.data + y * src.row_stride, dst.width * kChannels);
+        }
+    }
+  }
+
+  static void Rotate(const Plane& src, int angle, const Plane& dst) {
+    switch (dst.channels) {
+      case 1:
+        return RotateImpl<1>(src, angle, dst);
+      case 2:
+        return RotateImpl<2>(src, angle, dst);
+      case 3:
+        return RotateImpl<3>(src, angle, dst);
+      case 4:
+        return RotateImpl<4>(src, angle, dst);
+    }
+  }
+
+  // Float conversion.
+  //----------------------------------------------------------------------------
+
+  // Computes in double precision: the product of an 8-bit value and a float is
+  // exact, so this rounds once like the fused multiply-add Halide emits.
+  static void ToFloat(const Plane& src, float scale, float offset,
+                      float* dst) {
+    const double scale_d = scale, offset_d = offset;
+    const int row_size = src.width * src.channels;
+    for (int y = 0; y < src.height; ++y) {
+      const uint8_t* __restrict in = src.data + y * src.row_stride;
+      float* __restrict out = dst + y * row_size;
+      for (int i = 0; i < row_size; ++i) {
+        out[i] = static_cast<float>(in[i] * scale_d + offset_d);
+      }
+    }
+  }
+};
+
+// Returns the kernels compiled for each instruction set, or nullptr if they
+// are not compiled into this binary. Defined in kernels_<isa>.cc.
+const Kernels* GetGenericKernels();
+const Kernels* GetSse4Kernels();
+const Kernels* GetAvx2Kernels();
+const Kernels* GetAvx512Kernels();
+
+}  // namespace simd
+}  // namespace frame_buffer
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_FRAME_BUFFER_SIMD_KERNELS_IMPL_H_
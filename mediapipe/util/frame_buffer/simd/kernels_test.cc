@@ -0,0 +1,309 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/frame_buffer/simd/kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace frame_buffer {
+namespace simd {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+std::vector<uint8_t> RandomBytes(int size, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) byte = distribution(rng);
+  return bytes;
+}
+
+// Reference implementations, written directly from the Halide generators in
+// mediapipe/util/frame_buffer/halide.
+//------------------------------------------------------------------------------
+
+uint8_t ReferenceLerp(int a, int b, int weight16) {
+  const int weight = weight16 >> 8;
+  return (a * (256 - weight) + b * weight + 127) >> 8;
+}
+
+void ReferenceYuvToRgb(const YuvPlanes& src, bool halve, const Plane& dst) {
+  for (int y = 0; y < dst.height; ++y) {
+    for (int x = 0; x < dst.width; ++x) {
+      const int yx = halve ? 2 * x : x, yy = halve ? 2 * y : y;
+      const int uvx = halve ? x : x / 2, uvy = halve ? y : y / 2;
+      const int luma = src.y[yy * src.y_row_stride + yx];
+      const int uv_offset = uvy * src.uv_row_stride + uvx * src.uv_pixel_stride;
+      const int u = src.u[uv_offset] - 128;
+      const int v = src.v[uv_offset] - 128;
+      const int rgb[3] = {
+          luma + ((91881 * v + 32768) >> 16),
+          luma - ((22544 * u + 46802 * v + 32768) >> 16),
+          luma + ((116130 * u + 32768) >> 16),
+      };
+      uint8_t* out = dst.data + y * dst.row_stride + x * dst.channels;
+      for (int c = 0; c < 3; ++c) out[c] = std::clamp(rgb[c], 0, 255);
+      if (dst.channels == 4) out[3] = 255;
+    }
+  }
+}
+
+void ReferenceResize(const Plane& src, float scale_x, float scale_y,
+                     const Plane& dst) {
+  const int fx = static_cast<int>(scale_x * 65536);
+  const int fy = static_cast<int>(scale_y * 65536);
+  auto at = [&](int x, int y, int c) {
+    x = std::clamp(x, 0, src.width - 1);
+    y = std::clamp(y, 0, src.height - 1);
+    return src.data[y * src.row_stride + x * src.channels + c];
+  };
+  for (int y = 0; y < dst.height; ++y) {
+    const int yi = y * fy / 65536, yr = y * fy % 65536;
+    for (int x = 0; x < dst.width; ++x) {
+      const int xi = x * fx / 65536, xr = x * fx % 65536;
+      for (int c = 0; c < dst.channels; ++c) {
+        const int row0 = ReferenceLerp(at(xi, yi, c), at(xi + 1, yi, c), xr);
+        const int row1 =
+            ReferenceLerp(at(xi, yi + 1, c), at(xi + 1, yi + 1, c), xr);
+        dst.data[y * dst.row_stride + x * dst.channels + c] =
+            ReferenceLerp(row0, row1, yr);
+      }
+    }
+  }
+}
+
+void ReferenceRotate(const Plane& src, int angle, const Plane& dst) {
+  for (int y = 0; y < dst.height; ++y) {
+    for (int x = 0; x < dst.width; ++x) {
+      int sx = x, sy = y;
+      if (angle == 90) {
+        sx = src.width - 1 - y;
+        sy = x;
+      } else if (angle == 180) {
+        sx = src.width - 1 - x;
+        sy = src.height - 1 - y;
+      } else if (angle == 270) {
+        sx = y;
+        sy = src.height - 1 - x;
+      }
+      for (int c = 0; c < dst.channels; ++c) {
+        dst.data[y * dst.row_stride + x * dst.channels + c] =
+            src.data[sy * src.row_stride + sx * src.channels + c];
+      }
+    }
+  }
+}
+
+// Tests.
+//------------------------------------------------------------------------------
+
+std::vector<Isa> SupportedIsas() {
+  std::vector<Isa> isas;
+  for (Isa isa : {Isa::kGeneric, Isa::kSse4, Isa::kAvx2, Isa::kAvx512}) {
+    if (IsIsaSupported(isa)) isas.push_back(isa);
+  }
+  return isas;
+}
+
+class KernelsTest : public ::testing::TestWithParam<Isa> {
+ protected:
+  const Kernels& kernels() { return GetKernels(GetParam()); }
+};
+
+TEST(KernelsDispatchTest, BestIsaIsSupported) {
+  EXPECT_TRUE(IsIsaSupported(Isa::kGeneric));
+  EXPECT_TRUE(IsIsaSupported(GetBestIsa()));
+  EXPECT_EQ(GetKernels().isa, GetBestIsa());
+}
+
+enum class YuvLayout { kNV12, kNV21, kI420 };
+
+struct YuvToRgbParam {
+  YuvLayout layout;
+  int width;
+  int height;
+  bool halve;
+  int channels;
+};
+
+TEST_P(KernelsTest, YuvToRgbMatchesReference) {
+  const YuvToRgbParam params[] = {
+      {YuvLayout::kNV12, 640, 480, false, 3},
+      {YuvLayout::kNV21, 641, 33, false, 4},
+      {YuvLayout::kI420, 37, 21, false, 3},
+      {YuvLayout::kNV21, 640, 480, true, 3},
+      {YuvLayout::kI420, 102, 50, true, 4},
+      {YuvLayout::kNV12, 1, 1, false, 4},
+  };
+  for (const YuvToRgbParam& param : params) {
+    SCOPED_TRACE(param.width);
+    const int y_row_stride = param.width + 3;
+    const int uv_width = (param.width + 1) / 2;
+    const int uv_height = (param.height + 1) / 2;
+    const int uv_row_stride = 2 * uv_width + 5;
+    std::vector<uint8_t> y_plane =
+        RandomBytes(y_row_stride * param.height, /*seed=*/1);
+    std::vector<uint8_t> uv_planes =
+        RandomBytes(2 * uv_row_stride * uv_height, /*seed=*/2);
+    YuvPlanes yuv = {y_plane.data(),
+                     nullptr,
+                     nullptr,
+                     param.width,
+                     param.height,
+                     y_row_stride,
+                     uv_row_stride,
+                     /*uv_pixel_stride=*/2};
+    switch (param.layout) {
+      case YuvLayout::kNV12:
+        yuv.u = uv_planes.data();
+        yuv.v = uv_planes.data() + 1;
+        break;
+      case YuvLayout::kNV21:
+        yuv.v = uv_planes.data();
+        yuv.u = uv_planes.data() + 1;
+        break;
+      case YuvLayout::kI420:
+        yuv.u = uv_planes.data();
+        yuv.v = uv_planes.data() + uv_row_stride * uv_height;
+        yuv.uv_pixel_stride = 1;
+        break;
+    }
+
+    const int out_width = param.halve ? param.width / 2 : param.width;
+    const int out_height = param.halve ? param.height / 2 : param.height;
+    const int out_row_stride = out_width * param.channels + 7;
+    std::vector<uint8_t> expected(out_row_stride * out_height, 0);
+    std::vector<uint8_t> actual(out_row_stride * out_height, 0);
+    ReferenceYuvToRgb(yuv, param.halve,
+                      {expected.data(), out_width, out_height, out_row_stride,
+                       param.channels});
+    kernels().yuv_to_rgb(yuv, param.halve,
+                         {actual.data(), out_width, out_height, out_row_stride,
+                          param.channels});
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+TEST_P(KernelsTest, ResizeBilinearMatchesReference) {
+  const int sizes[][4] = {
+      {640, 480, 224, 224}, {33, 17, 100, 51}, {300, 200, 299, 201},
+      {8, 8, 3, 5},         {1, 1, 4, 4},
+  };
+  for (int channels = 1; channels <= 4; ++channels) {
+    for (const auto& size : sizes) {
+      SCOPED_TRACE(channels);
+      SCOPED_TRACE(size[0]);
+      const int src_row_stride = size[0] * channels + 1;
+      std::vector<uint8_t> src =
+          RandomBytes(src_row_stride * size[1], /*seed=*/channels);
+      const Plane src_plane = {src.data(), size[0], size[1], src_row_stride,
+                               channels};
+      const float scale_x = static_cast<float>(size[0]) / size[2];
+      const float scale_y = static_cast<float>(size[1]) / size[3];
+      std::vector<uint8_t> expected(size[2] * size[3] * channels);
+      std::vector<uint8_t> actual(expected.size());
+      ReferenceResize(src_plane, scale_x, scale_y,
+                      {expected.data(), size[2], size[3], size[2] * channels,
+                       channels});
+      kernels().resize_bilinear(
+          src_plane, scale_x, scale_y,
+          {actual.data(), size[2], size[3], size[2] * channels, channels});
+      EXPECT_EQ(actual, expected);
+    }
+  }
+}
+
+TEST_P(KernelsTest, ResizeBilinearMatchesHalideResults) {
+  // Same input and expected values as FrameBufferUtil.RgbResize.
+  uint8_t src[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+                   18};
+  uint8_t dst[36];
+  kernels().resize_bilinear({src, 3, 2, 9, 3}, 3.0f / 4, 2.0f / 3,
+                            {dst, 4, 3, 12, 3});
+  EXPECT_THAT(dst, ElementsAreArray({1,  2,  3,  3,  4,  5,  5,  6,  7,
+                                     7,  8,  9,  7,  8,  9,  9,  10, 11,
+                                     11, 12, 13, 13, 14, 15, 10, 11, 12,
+                                     12, 13, 14, 14, 15, 16, 16, 17, 18}));
+}
+
+TEST_P(KernelsTest, RotateMatchesReference) {
+  for (int channels = 1; channels <= 4; ++channels) {
+    for (int angle : {0, 90, 180, 270}) {
+      SCOPED_TRACE(channels);
+      SCOPED_TRACE(angle);
+      constexpr int kWidth = 67, kHeight = 45;
+      const int src_row_stride = kWidth * channels + 2;
+      std::vector<uint8_t> src =
+          RandomBytes(src_row_stride * kHeight, /*seed=*/angle);
+      const Plane src_plane = {src.data(), kWidth, kHeight, src_row_stride,
+                               channels};
+      const bool swap = angle == 90 || angle == 270;
+      const int dst_width = swap ? kHeight : kWidth;
+      const int dst_height = swap ? kWidth : kHeight;
+      const int dst_row_stride = dst_width * channels + 3;
+      std::vector<uint8_t> expected(dst_row_stride * dst_height, 0);
+      std::vector<uint8_t> actual(expected.size(), 0);
+      ReferenceRotate(src_plane, angle,
+                      {expected.data(), dst_width, dst_height, dst_row_stride,
+                       channels});
+      kernels().rotate(src_plane, angle,
+                       {actual.data(), dst_width, dst_height, dst_row_stride,
+                        channels});
+      EXPECT_EQ(actual, expected);
+    }
+  }
+}
+
+TEST_P(KernelsTest, ToFloat) {
+  constexpr int kWidth = 123, kHeight = 7, kChannels = 3;
+  constexpr int kRowStride = kWidth * kChannels + 4;
+  constexpr float kScale = 1.0f / 127.5f, kOffset = -1.0f;
+  std::vector<uint8_t> src = RandomBytes(kRowStride * kHeight, /*seed=*/3);
+  std::vector<float> expected, actual(kWidth * kHeight * kChannels);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int i = 0; i < kWidth * kChannels; ++i) {
+      expected.push_back(std::fma(src[y * kRowStride + i], kScale, kOffset));
+    }
+  }
+  kernels().to_float({src.data(), kWidth, kHeight, kRowStride, kChannels},
+                     kScale, kOffset, actual.data());
+  EXPECT_EQ(actual, expected);
+
+  uint8_t small[] = {1, 2, 3, 4, 5, 6};
+  float small_result[6];
+  kernels().to_float({small, 2, 1, 6, 3}, 0.1f, 0.1f, small_result);
+  EXPECT_THAT(small_result, ElementsAre(0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    KernelsTests, KernelsTest, ::testing::ValuesIn(SupportedIsas()),
+    [](const ::testing::TestParamInfo<Isa>& info) {
+      return std::string(IsaName(info.param));
+    });
+
+}  // namespace
+}  // namespace simd
+}  // namespace frame_buffer
+}  // namespace mediapipe
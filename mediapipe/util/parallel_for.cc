@@ -0,0 +1,112 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/graph_executor_service.h"
+
+namespace mediapipe {
+
+namespace {
+
+// ParallelForRows splits rows into ranges of at least this many elements.
+constexpr int kMinElementsPerRange = 1 << 16;
+
+// Splitting into more ranges than threads balances the load when some threads
+// are slowed down by other nodes.
+constexpr int kRangesPerThread = 4;
+
+// The state shared by the calling thread and the tasks of a ParallelFor call.
+//
+// Tasks may start after the call returned, but then find no range left and
+// never touch `fn_`: a range is only claimed while it is pending, i.e. while
+// the calling thread waits.
+class ParallelForState {
+ public:
+  ParallelForState(int size, int num_ranges,
+                   absl::FunctionRef<void(int, int)> fn)
+      : size_(size),
+        num_ranges_(num_ranges),
+        fn_(fn),
+        pending_ranges_(num_ranges) {}
+
+  // Claims and runs ranges until none is left.
+  void RunRanges() {
+    for (int i = next_range_.fetch_add(1, std::memory_order_relaxed);
+         i < num_ranges_;
+         i = next_range_.fetch_add(1, std::memory_order_relaxed)) {
+      const int begin = static_cast<int64_t>(size_) * i / num_ranges_;
+      const int end = static_cast<int64_t>(size_) * (i + 1) / num_ranges_;
+      fn_(begin, end);
+      pending_ranges_.DecrementCount();
+    }
+  }
+
+  // Waits until all ranges are done.
+  void Wait() { pending_ranges_.Wait(); }
+
+ private:
+  const int size_;
+  const int num_ranges_;
+  const absl::FunctionRef<void(int, int)> fn_;
+  std::atomic<int> next_range_ = 0;
+  absl::BlockingCounter pending_ranges_;
+};
+
+}  // namespace
+
+void ParallelFor(const GraphExecutor* executor, int size, int min_range_size,
+                 absl::FunctionRef<void(int begin, int end)> fn) {
+  if (size <= 0) return;
+  const int num_threads =
+      executor != nullptr && executor->executor != nullptr
+          ? executor->num_threads
+          : 1;
+  const int num_ranges = std::min(size / std::max(min_range_size, 1),
+                                  num_threads * kRangesPerThread);
+  if (num_threads <= 1 || num_ranges <= 1) {
+    fn(0, size);
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>(size, num_ranges, fn);
+  // The calling thread is usually one of the executor's threads.
+  const int num_tasks = std::min(num_threads, num_ranges) - 1;
+  for (int i = 0; i < num_tasks; ++i) {
+    executor->executor->Schedule([state] { state->RunRanges(); });
+  }
+  state->RunRanges();
+  state->Wait();
+}
+
+void ParallelForRows(const GraphExecutor* executor, int rows, int row_size,
+                     absl::FunctionRef<void(int begin, int end)> fn) {
+  ParallelFor(executor, rows, kMinElementsPerRange / std::max(row_size, 1),
+              fn);
+}
+
+const GraphExecutor* GetGraphExecutor(CalculatorContext* cc) {
+  auto service = cc->Service(kGraphExecutorService);
+  return service.IsAvailable() ? &service.GetObject() : nullptr;
+}
+
+}  // namespace mediapipe
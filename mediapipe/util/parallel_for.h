@@ -0,0 +1,51 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_PARALLEL_FOR_H_
+#define MEDIAPIPE_UTIL_PARALLEL_FOR_H_
+
+#include "absl/functional/function_ref.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/graph_executor_service.h"
+
+namespace mediapipe {
+
+// Runs `fn(begin, end)` over consecutive ranges covering [0, size), in
+// parallel on the calling thread and the threads of `executor`, and returns
+// once all ranges are done. Ranges hold at least `min_range_size` elements
+// so that small workloads are not split into tasks costing more than they
+// save. Runs `fn(0, size)` on the calling thread if `executor` is null.
+//
+// The calling thread processes ranges too and never waits for a task to be
+// started, so ParallelFor can be called from a task running on `executor`
+// itself, e.g. from CalculatorBase::Process. The speedup is bounded by the
+// threads of `executor` not busy with other nodes.
+void ParallelFor(const GraphExecutor* executor, int size, int min_range_size,
+                 absl::FunctionRef<void(int begin, int end)> fn);
+
+// Runs `fn(begin_row, end_row)` over the rows of an image with `row_size`
+// elements per row, see ParallelFor. Splits the rows into ranges large enough
+// to amortize the task overhead for simple per-pixel operations.
+void ParallelForRows(const GraphExecutor* executor, int rows, int row_size,
+                     absl::FunctionRef<void(int begin, int end)> fn);
+
+// Returns the executor to pass to ParallelFor from a calculator, or null if the
+// graph does not provide kGraphExecutorService. The calculator must request
+// the service in GetContract:
+//   cc->UseService(kGraphExecutorService).Optional();
+const GraphExecutor* GetGraphExecutor(CalculatorContext* cc);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_PARALLEL_FOR_H_
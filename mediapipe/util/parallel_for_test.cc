@@ -0,0 +1,219 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/graph_executor_service.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/tool/sink.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+GraphExecutor MakeGraphExecutor(int num_threads) {
+  return {std::make_shared<ThreadPoolExecutor>(num_threads), num_threads};
+}
+
+TEST(ParallelForTest, RunsEveryIndexOnce) {
+  const GraphExecutor executor = MakeGraphExecutor(4);
+  std::vector<std::atomic<int>> counts(1000);
+  ParallelFor(&executor, counts.size(), /*min_range_size=*/10,
+              [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) ++counts[i];
+              });
+  for (int i = 0; i < counts.size(); ++i) {
+    EXPECT_EQ(counts[i], 1) << "at index " << i;
+  }
+}
+
+TEST(ParallelForTest, RangesHoldAtLeastMinRangeSize) {
+  const GraphExecutor executor = MakeGraphExecutor(4);
+  absl::Mutex mutex;
+  std::vector<std::pair<int, int>> ranges;
+  ParallelFor(&executor, 1000, /*min_range_size=*/300,
+              [&](int begin, int end) {
+                absl::MutexLock lock(&mutex);
+                ranges.emplace_back(begin, end);
+              });
+  ASSERT_EQ(ranges.size(), 3);
+  for (const auto& [begin, end] : ranges) {
+    EXPECT_GE(end - begin, 300);
+  }
+}
+
+TEST(ParallelForTest, RunsInlineWithoutExecutor) {
+  std::vector<std::pair<int, int>> ranges;
+  ParallelFor(/*executor=*/nullptr, 1000, /*min_range_size=*/1,
+              [&](int begin, int end) { ranges.emplace_back(begin, end); });
+  EXPECT_THAT(ranges, ElementsAre(Pair(0, 1000)));
+}
+
+TEST(ParallelForTest, CompletesFromTheOnlyThreadOfTheExecutor) {
+  // The only thread runs the ParallelFor call, so none of its tasks can start
+  // before the call returns.
+  auto thread_pool = std::make_shared<ThreadPoolExecutor>(1);
+  const GraphExecutor executor = {thread_pool, /*num_threads=*/4};
+  std::atomic<int> sum = 0;
+  absl::Notification done;
+  thread_pool->Schedule([&] {
+    ParallelFor(&executor, 100, /*min_range_size=*/1, [&](int begin, int end) {
+      for (int i = begin; i < end; ++i) sum += i;
+    });
+    done.Notify();
+  });
+  done.WaitForNotification();
+  EXPECT_EQ(sum, 4950);
+}
+
+// Sums [0, N) with ParallelFor, where N is the input packet.
+class ParallelSumCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int64_t>();
+    cc->UseService(kGraphExecutorService).Optional();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    RET_CHECK(GetGraphExecutor(cc) != nullptr);
+    std::atomic<int64_t> sum = 0;
+    ParallelFor(GetGraphExecutor(cc), cc->Inputs().Index(0).Get<int>(),
+                /*min_range_size=*/1, [&](int begin, int end) {
+                  for (int i = begin; i < end; ++i) sum += i;
+                });
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int64_t>(sum).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(ParallelSumCalculator);
+
+TEST(ParallelForTest, CalculatorUsesGraphExecutor) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "n"
+    output_stream: "sum"
+    node {
+      calculator: "ParallelSumCalculator"
+      input_stream: "n"
+      output_stream: "sum"
+    }
+  )pb");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("sum", &config, &output_packets);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(
+      graph.AddPacketToInputStream("n", MakePacket<int>(1000).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(output_packets.size(), 1);
+  EXPECT_EQ(output_packets[0].Get<int64_t>(), 499500);
+}
+
+// Outputs the number of threads of the graph's default executor, which it
+// requests optionally or not.
+template <bool kOptional>
+class GraphExecutorThreadsCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<int>();
+    auto& request = cc->UseService(kGraphExecutorService);
+    if (kOptional) request.Optional();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    RET_CHECK(GetGraphExecutor(cc) != nullptr);
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(GetGraphExecutor(cc)->num_threads)
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+using OptionalGraphExecutorThreadsCalculator =
+    GraphExecutorThreadsCalculator</*kOptional=*/true>;
+using RequiredGraphExecutorThreadsCalculator =
+    GraphExecutorThreadsCalculator</*kOptional=*/false>;
+REGISTER_CALCULATOR(OptionalGraphExecutorThreadsCalculator);
+REGISTER_CALCULATOR(RequiredGraphExecutorThreadsCalculator);
+
+// Returns the number of threads of the default executor of a graph running
+// `calculator`, and the number of nodes of the graph.
+std::pair<int, int> GetGraphExecutorThreads(const std::string& calculator) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(
+      absl::Substitute(R"pb(
+                         input_stream: "in"
+                         output_stream: "num_threads"
+                         node {
+                           calculator: "$0"
+                           input_stream: "in"
+                           output_stream: "num_threads"
+                         }
+                       )pb",
+                       calculator));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("num_threads", &config, &output_packets);
+
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(config));
+  ABSL_CHECK_OK(graph.StartRun({}));
+  ABSL_CHECK_OK(
+      graph.AddPacketToInputStream("in", MakePacket<int>(0).At(Timestamp(0))));
+  ABSL_CHECK_OK(graph.CloseAllInputStreams());
+  ABSL_CHECK_OK(graph.WaitUntilDone());
+  ABSL_CHECK_EQ(output_packets.size(), 1);
+  return {output_packets[0].Get<int>(), config.node_size()};
+}
+
+TEST(ParallelForTest, RequiredGraphExecutorUsesAllCores) {
+  EXPECT_EQ(
+      GetGraphExecutorThreads("RequiredGraphExecutorThreadsCalculator").first,
+      NumCPUCores());
+}
+
+TEST(ParallelForTest, OptionalGraphExecutorKeepsDefaultThreads) {
+  const auto [num_threads, num_nodes] =
+      GetGraphExecutorThreads("OptionalGraphExecutorThreadsCalculator");
+  EXPECT_EQ(num_threads, std::min(NumCPUCores(), num_nodes));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,151 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/sharded_graph_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The packets of each output stream of one shard.
+using ShardOutputs = std::map<std::string, std::vector<Packet>>;
+
+absl::Status RunShard(const CalculatorGraphConfig& base_config,
+                      const std::map<std::string, Packet>& base_side_packets,
+                      const ShardedGraphRunnerOptions& options,
+                      const TimeShard& shard, ShardOutputs& outputs) {
+  CalculatorGraphConfig config = base_config;
+  std::map<std::string, Packet> side_packets = base_side_packets;
+  MP_RETURN_IF_ERROR(options.prepare_shard(shard, config, side_packets));
+
+  CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config));
+  for (const auto& [stream, policy] : options.output_streams) {
+    std::vector<Packet>* packets = &outputs[stream];
+    MP_RETURN_IF_ERROR(
+        graph.ObserveOutputStream(stream, [packets](const Packet& packet) {
+          packets->push_back(packet);
+          return absl::OkStatus();
+        }));
+  }
+  MP_RETURN_IF_ERROR(graph.StartRun(side_packets));
+  if (options.feed_shard) {
+    absl::Status status = options.feed_shard(shard, graph);
+    if (!status.ok()) {
+      graph.Cancel();
+      graph.WaitUntilDone().IgnoreError();
+      return status;
+    }
+  }
+  MP_RETURN_IF_ERROR(graph.CloseAllInputStreams());
+  return graph.WaitUntilDone();
+}
+
+// Returns whether `shard` of `num_shards` keeps `timestamp` under
+// ShardMergePolicy::kTrimToShard.
+bool IsInShard(const TimeShard& shard, int num_shards, Timestamp timestamp) {
+  const bool is_first = shard.index == 0;
+  const bool is_last = shard.index == num_shards - 1;
+  if (timestamp < shard.start) return is_first;
+  if (timestamp >= shard.end) return is_last;
+  return true;
+}
+
+}  // namespace
+
+std::vector<TimeShard> SplitTimeline(const ShardedGraphRunnerOptions& options) {
+  std::vector<TimeShard> shards(options.num_shards);
+  const int64_t start = options.start.Value();
+  const int64_t duration = options.end.Value() - start;
+  for (int i = 0; i < options.num_shards; ++i) {
+    TimeShard& shard = shards[i];
+    shard.index = i;
+    shard.start = Timestamp(start + duration * i / options.num_shards);
+    shard.end = Timestamp(start + duration * (i + 1) / options.num_shards);
+    shard.warmup_start =
+        Timestamp(std::max(start, shard.start.Value() - options.warmup_us));
+  }
+  return shards;
+}
+
+absl::StatusOr<std::map<std::string, std::vector<Packet>>> RunShardedGraph(
+    const CalculatorGraphConfig& config,
+    const std::map<std::string, Packet>& side_packets,
+    const ShardedGraphRunnerOptions& options) {
+  RET_CHECK_GT(options.num_shards, 0);
+  RET_CHECK(options.start.IsRangeValue() && options.end.IsRangeValue() &&
+            options.start < options.end)
+      << "Invalid timeline [" << options.start << ", " << options.end << ").";
+  RET_CHECK_GE(options.warmup_us, 0);
+  RET_CHECK(options.prepare_shard) << "prepare_shard is required.";
+
+  const std::vector<TimeShard> shards = SplitTimeline(options);
+  std::vector<ShardOutputs> shard_outputs(shards.size());
+  std::vector<absl::Status> shard_statuses(shards.size());
+  {
+    ThreadPool pool("sharded_graph",
+                    options.max_parallel_graphs > 0
+                        ? std::min(options.max_parallel_graphs,
+                                   options.num_shards)
+                        : options.num_shards);
+    pool.StartWorkers();
+    for (int i = 0; i < shards.size(); ++i) {
+      pool.Schedule([&, i] {
+        shard_statuses[i] = RunShard(config, side_packets, options, shards[i],
+                                     shard_outputs[i]);
+      });
+    }
+    // The pool waits for all shards on destruction.
+  }
+  for (int i = 0; i < shards.size(); ++i) {
+    if (!shard_statuses[i].ok()) {
+      return absl::Status(
+          shard_statuses[i].code(),
+          absl::StrCat("Shard ", i, " [", shards[i].start.DebugString(), ", ",
+                       shards[i].end.DebugString(),
+                       "): ", shard_statuses[i].message()));
+    }
+  }
+
+  std::map<std::string, std::vector<Packet>> outputs;
+  for (const auto& [stream, policy] : options.output_streams) {
+    std::vector<Packet>& packets = outputs[stream];
+    for (int i = 0; i < shards.size(); ++i) {
+      for (Packet& packet : shard_outputs[i][stream]) {
+        if (policy == ShardMergePolicy::kKeepAll ||
+            IsInShard(shards[i], shards.size(), packet.Timestamp())) {
+          packets.push_back(std::move(packet));
+        }
+      }
+    }
+  }
+  return outputs;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,101 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_SHARDED_GRAPH_RUNNER_H_
+#define MEDIAPIPE_UTIL_SHARDED_GRAPH_RUNNER_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/calculator_framework.h"
+
+namespace mediapipe {
+
+// A segment of the timeline processed by one graph instance.
+struct TimeShard {
+  // Index of the shard, in timeline order.
+  int index = 0;
+  // The shard outputs the packets in [start, end).
+  Timestamp start;
+  Timestamp end;
+  // The graph processes input from `warmup_start` on, so that stateful
+  // calculators have caught up by `start`. Equals `start` for the first shard.
+  Timestamp warmup_start;
+};
+
+// How the packets of one output stream are stitched across shards.
+enum class ShardMergePolicy {
+  // Keeps the packets each shard outputs in [start, end), so that the
+  // outputs of warm-up periods are dropped. The first shard also keeps its
+  // packets before `start`, e.g. headers at Timestamp::PreStream(), and the
+  // last shard its packets from `end` on, e.g. at Timestamp::PostStream().
+  kTrimToShard,
+  // Keeps all the packets of all shards, in shard order, e.g. to be reduced
+  // by the caller.
+  kKeepAll,
+};
+
+struct ShardedGraphRunnerOptions {
+  // The timeline to process, split into `num_shards` segments of equal
+  // duration.
+  Timestamp start;
+  Timestamp end;
+  int num_shards = 1;
+
+  // Duration, in microseconds, of input each shard processes before its
+  // segment.
+  int64_t warmup_us = 0;
+
+  // Maximum number of graphs running at once. Defaults to `num_shards`.
+  int max_parallel_graphs = 0;
+
+  // The output streams to collect, with how to stitch them.
+  std::map<std::string, ShardMergePolicy> output_streams;
+
+  // Restricts the graph of `shard` to its warm-up and output range, e.g. by
+  // setting the start and end time of its video decoder, either in `config`
+  // or in `side_packets`. Required.
+  std::function<absl::Status(const TimeShard& shard,
+                             CalculatorGraphConfig& config,
+                             std::map<std::string, Packet>& side_packets)>
+      prepare_shard;
+
+  // Optionally feeds the input streams of the graph of `shard`, after
+  // StartRun(). The runner closes all input streams afterwards.
+  std::function<absl::Status(const TimeShard& shard, CalculatorGraph& graph)>
+      feed_shard;
+};
+
+// Returns the shards covering [options.start, options.end).
+std::vector<TimeShard> SplitTimeline(const ShardedGraphRunnerOptions& options);
+
+// Processes a timeline with one graph instance per shard, running in parallel,
+// and returns the stitched packets of each output stream.
+//
+// Speeds up offline jobs over long inputs, whose graphs process frames
+// sequentially. Stateful calculators, e.g. motion analysis or smoothing,
+// start each shard from scratch, so `warmup_us` must cover the input they need
+// to produce the same output as a single graph. A shard fails the whole run.
+absl::StatusOr<std::map<std::string, std::vector<Packet>>> RunShardedGraph(
+    const CalculatorGraphConfig& config,
+    const std::map<std::string, Packet>& side_packets,
+    const ShardedGraphRunnerOptions& options);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_SHARDED_GRAPH_RUNNER_H_
@@ -0,0 +1,201 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/sharded_graph_runner.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/status_util.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
+
+constexpr int64_t kStepUs = 1000;
+
+// Outputs the index of each step in [START, END), at the step's timestamp.
+class StepSourceCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->InputSidePackets().Tag("START").Set<int64_t>();
+    cc->InputSidePackets().Tag("END").Set<int64_t>();
+    cc->Outputs().Index(0).Set<int64_t>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    next_ = cc->InputSidePackets().Tag("START").Get<int64_t>();
+    end_ = cc->InputSidePackets().Tag("END").Get<int64_t>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (next_ >= end_) return tool::StatusStop();
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int64_t>(next_ / kStepUs).At(Timestamp(next_)));
+    next_ += kStepUs;
+    return absl::OkStatus();
+  }
+
+ private:
+  int64_t next_ = 0;
+  int64_t end_ = 0;
+};
+REGISTER_CALCULATOR(StepSourceCalculator);
+
+// Outputs the sum of the last 3 inputs, as an example of stateful calculator.
+class WindowSumCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int64_t>();
+    cc->Outputs().Index(0).Set<int64_t>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    window_.push_back(cc->Inputs().Index(0).Get<int64_t>());
+    if (window_.size() > 3) window_.pop_front();
+    int64_t sum = 0;
+    for (int64_t value : window_) sum += value;
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int64_t>(sum).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+
+ private:
+  std::deque<int64_t> window_;
+};
+REGISTER_CALCULATOR(WindowSumCalculator);
+
+CalculatorGraphConfig GetConfig() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    output_stream: "sum"
+    node {
+      calculator: "StepSourceCalculator"
+      input_side_packet: "START:start"
+      input_side_packet: "END:end"
+      output_stream: "step"
+    }
+    node {
+      calculator: "WindowSumCalculator"
+      input_stream: "step"
+      output_stream: "sum"
+    }
+  )pb");
+}
+
+ShardedGraphRunnerOptions GetOptions(int num_shards, int64_t warmup_us) {
+  ShardedGraphRunnerOptions options;
+  options.start = Timestamp(0);
+  options.end = Timestamp(100 * kStepUs);
+  options.num_shards = num_shards;
+  options.warmup_us = warmup_us;
+  options.output_streams["sum"] = ShardMergePolicy::kTrimToShard;
+  options.prepare_shard = [](const TimeShard& shard, CalculatorGraphConfig&,
+                             std::map<std::string, Packet>& side_packets) {
+    side_packets["start"] = MakePacket<int64_t>(shard.warmup_start.Value());
+    side_packets["end"] = MakePacket<int64_t>(shard.end.Value());
+    return absl::OkStatus();
+  };
+  return options;
+}
+
+std::vector<int64_t> GetSums(const std::vector<Packet>& packets) {
+  std::vector<int64_t> sums;
+  for (const Packet& packet : packets) sums.push_back(packet.Get<int64_t>());
+  return sums;
+}
+
+TEST(ShardedGraphRunnerTest, SplitsTimelineWithWarmup) {
+  const std::vector<TimeShard> shards =
+      SplitTimeline(GetOptions(/*num_shards=*/3, /*warmup_us=*/5000));
+  ASSERT_THAT(shards, SizeIs(3));
+  EXPECT_EQ(shards[0].warmup_start, Timestamp(0));
+  EXPECT_EQ(shards[0].start, Timestamp(0));
+  EXPECT_EQ(shards[0].end, Timestamp(33333));
+  EXPECT_EQ(shards[1].warmup_start, Timestamp(28333));
+  EXPECT_EQ(shards[1].start, Timestamp(33333));
+  EXPECT_EQ(shards[1].end, Timestamp(66666));
+  EXPECT_EQ(shards[2].start, Timestamp(66666));
+  EXPECT_EQ(shards[2].end, Timestamp(100000));
+}
+
+TEST(ShardedGraphRunnerTest, MatchesSingleGraphWithEnoughWarmup) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto expected,
+      RunShardedGraph(GetConfig(), {}, GetOptions(/*num_shards=*/1, 0)));
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto outputs, RunShardedGraph(GetConfig(), {},
+                                    GetOptions(/*num_shards=*/4,
+                                               /*warmup_us=*/2 * kStepUs)));
+
+  ASSERT_THAT(expected["sum"], SizeIs(100));
+  EXPECT_EQ(GetSums(outputs["sum"]), GetSums(expected["sum"]));
+  for (int i = 0; i < outputs["sum"].size(); ++i) {
+    EXPECT_EQ(outputs["sum"][i].Timestamp(), Timestamp(i * kStepUs));
+  }
+}
+
+TEST(ShardedGraphRunnerTest, DiffersAtBoundariesWithoutWarmup) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto outputs,
+      RunShardedGraph(GetConfig(), {}, GetOptions(/*num_shards=*/4, 0)));
+  ASSERT_THAT(outputs["sum"], SizeIs(100));
+  // The second shard starts at step 25 without the two previous steps.
+  EXPECT_EQ(outputs["sum"][25].Get<int64_t>(), 25);
+  EXPECT_EQ(outputs["sum"][26].Get<int64_t>(), 25 + 26);
+  EXPECT_EQ(outputs["sum"][27].Get<int64_t>(), 25 + 26 + 27);
+}
+
+TEST(ShardedGraphRunnerTest, KeepsWarmupOutputs) {
+  ShardedGraphRunnerOptions options =
+      GetOptions(/*num_shards=*/2, /*warmup_us=*/2 * kStepUs);
+  options.output_streams["sum"] = ShardMergePolicy::kKeepAll;
+  MP_ASSERT_OK_AND_ASSIGN(auto outputs,
+                          RunShardedGraph(GetConfig(), {}, options));
+  ASSERT_THAT(outputs["sum"], SizeIs(102));
+  EXPECT_EQ(outputs["sum"][50].Timestamp(), Timestamp(48 * kStepUs));
+  EXPECT_THAT(GetSums({outputs["sum"][49], outputs["sum"][50]}),
+              ElementsAre(47 + 48 + 49, 48));
+}
+
+TEST(ShardedGraphRunnerTest, ReportsFailingShard) {
+  ShardedGraphRunnerOptions options = GetOptions(/*num_shards=*/2, 0);
+  options.prepare_shard = [prepare_shard = options.prepare_shard](
+                              const TimeShard& shard,
+                              CalculatorGraphConfig& config,
+                              std::map<std::string, Packet>& side_packets) {
+    if (shard.index == 1) return absl::InternalError("no input");
+    return prepare_shard(shard, config, side_packets);
+  };
+  const auto outputs = RunShardedGraph(GetConfig(), {}, options);
+  EXPECT_THAT(outputs.status().message(), HasSubstr("Shard 1"));
+  EXPECT_THAT(outputs.status().message(), HasSubstr("no input"));
+}
+
+}  // namespace
+}  // namespace mediapipe